@@ -10,9 +10,10 @@
  */
 
 
-#include <GL/gl.h>           // OpenGL
-#include <FTGL/ftgl.h>       // Fontes dans OpenGL
+#include <gl_headers.hpp>    // OpenGL et fontes (FTGL), sans fenêtre
 #include <math.h>       
+#include <stdio.h>           // snprintf
+#include <soft_canvas.hpp>   // SoftCanvas
 
 #define FONT_PATH "ressources/Consolas.ttf"
 #define FONT_SIZE 12
@@ -89,13 +90,13 @@ class Axis
 {
 public:
   /** Creation */
-  Axis() : _title("X"), _range({-1.0,1.0,3,9}) { init_font(); };
+  Axis() : _title("X"), _range({-1.0,1.0,3,9}), _font(nullptr) {};
   Axis( const std::string& title,
 	const Range& range= {-1.0, 1.0, 2, 10} ) :
     _title(title),
-    _range(range) { init_font(); };
+    _range(range), _font(nullptr) {};
 
-  /** Init Fonts */
+  /** Init Fonts, at first OpenGL render (render_soft has its own font) */
   void init_font()
   {
     //Axis::
@@ -113,6 +114,7 @@ public:
   /** Draw Axis with OpenGL */
   void render ( double scale_x =  FONT_SCALE, double scale_y = FONT_SCALE)
   {
+    if( not _font ) init_font();
     // Couleur Noire
     glColor4d(0.0, 0.0, 0.0, 1.0);
 
@@ -182,6 +184,59 @@ public:
     glPopMatrix(); // POS
   }
 
+  /** Draw Axis in 'canvas' (no OpenGL) */
+  void render_soft( SoftCanvas& canvas,
+                    double scale_x = FONT_SCALE, double scale_y = FONT_SCALE )
+  {
+    canvas.color( 0.0, 0.0, 0.0 );
+
+    // Axis
+    canvas.line_width( 2.0 );
+    canvas.begin( SoftCanvas::LINES );
+    canvas.vertex( _range._min, 0.0 );
+    canvas.vertex( _range._max, 0.0 );
+    canvas.end();
+
+    // Major and Minor Ticks
+    double delta_major = (_range._max - _range._min) / (double) (_range._major);
+    double delta_minor = delta_major / (double) _range._minor;
+
+    canvas.begin( SoftCanvas::LINES );
+    for( unsigned int i = 0; i < _range._major+1; ++i) {
+      canvas.vertex( _range._min + delta_major*i, 0.0 );
+      canvas.vertex( _range._min + delta_major*i, -DIM_MAJOR * scale_y );
+    }
+    canvas.end();
+
+    canvas.line_width( 0.5 );
+    canvas.begin( SoftCanvas::LINES );
+    for( unsigned int i = 0; i < _range._major; ++i) {
+      for( unsigned int j = 1; j < _range._minor; ++j) {
+        canvas.vertex( _range._min + delta_major*i + delta_minor*j, 0.0 );
+        canvas.vertex( _range._min + delta_major*i + delta_minor*j, -DIM_MAJOR/2.0*scale_y );
+      }
+    }
+    canvas.end();
+
+    // Label
+    canvas.push_matrix();
+    canvas.translate( _range._max, 2*DIM_MAJOR*scale_y );
+    canvas.scale( scale_x, scale_y );
+    canvas.text( _title );
+    canvas.pop_matrix();
+
+    // Major
+    for( unsigned int i = 0; i < _range._major+1; ++i) {
+      char tick_str[10];
+      snprintf( tick_str, sizeof(tick_str), "%.3g", _range._min + delta_major*i);
+      canvas.push_matrix();
+      canvas.translate( _range._min + delta_major*i, -3*DIM_MAJOR*scale_y );
+      canvas.scale( scale_x, scale_y );
+      canvas.text( tick_str );
+      canvas.pop_matrix();
+    }
+  }
+
   /** get Range */
   Range& get_range() {return _range;}; 
 private:
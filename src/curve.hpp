@@ -15,15 +15,34 @@
  *
  * WARNING : 'samples' are considered taken from a growing time_serie.
  * I've added 'add_data' which does not suppose a time serie.
+ *
+ * Samples are stored in a contiguous SampleStore (sample_store.hpp),
+ * mirrored in a Vertex Buffer Object (gl_buffer.hpp) : render() only
+ * uploads the Samples added since the previous render, and draws them with
+ * one call. get_samples() gives access to them without copy.
+ * set_capacity( n ) keeps only the last n Samples (sliding window) : the
+ * oldest are evicted in O(1), the _bbox follows the window (SlidingMinMax).
+ * Without capacity, _bbox is only extended by new Samples.
+ * Time series also feed a min/max pyramid (minmax_pyramid.hpp) : when
+ * there are more Samples than pixels, render() draws the level whose
+ * buckets fit in a pixel (constant time, spikes still visible).
+ * add_sample costs about 100-110 ns per Sample, with or without
+ * capacity (test-036, 1e7 Samples).
  */
 
 #include <list>
+#include <vector>
 #include <iostream>
 #include <math.h>
 #include <functional>
+#include <limits>                    // std::numeric_limits
 
 #include <visugl.hpp>
 #include <plotter.hpp>
+#include <gl_buffer.hpp>             // utils::gl::VertexBuffer
+#include <sample_store.hpp>          // SampleStore, SlidingMinMax
+#include <minmax_pyramid.hpp>        // MinMaxPyramid
+#include <soft_canvas.hpp>           // SoftCanvas
 
 // ***************************************************************************
 // ********************************************************************* Curve
@@ -37,6 +56,7 @@ public:
     double y;
     double z;
   };
+  static_assert( sizeof(Sample) == 3 * sizeof(GLdouble), "Sample is a vertex" );
 
   /** Color */
   using Color = struct {
@@ -47,7 +67,8 @@ public:
   // ********************************************************* Curve::creation
   // OK
   /** Creation */
-  Curve() : Plotter(), _fg_col{1,0,0}, _line_width(1.f) // red,thin
+  Curve() : Plotter(), _time_serie(true),
+            _fg_col{1,0,0}, _line_width(1.f) // red,thin
   {}
   virtual ~Curve()
   {
@@ -58,7 +79,8 @@ public:
   // OK
   Curve( const Curve& c)
     : Plotter( c._bbox.x_min, c._bbox.x_max, c._bbox.y_min, c._bbox.y_max ),
-      _data(c._data),
+      _data(c._data), _vbo(), _lod(c._lod), _time_serie(c._time_serie),
+      _x_window(c._x_window), _y_window(c._y_window),
       _fg_col( c._fg_col ), _line_width( c._line_width )
   {}
   
@@ -67,8 +89,33 @@ public:
   void clear()
   {
     _data.clear();
+    _vbo.reset();
+    _lod.clear();
+    _time_serie = true;
+    _x_window.clear();
+    _y_window.clear();
     set_bbox( {0.0, 1.0, 0.0, 1.0} );
   }
+  // ***************************************************** Curve::set_capacity
+  /**
+   * Keep only the last 'capacity' Samples (0 : all of them).
+   * The oldest Samples are evicted if needed, and _bbox recomputed.
+   */
+  void set_capacity( size_t capacity )
+  {
+    _data.set_capacity( capacity );
+    _vbo.reset();
+    _lod.set_capacity( capacity );
+    if( _time_serie ) _lod.rebuild( _data );
+    _x_window.clear();
+    _y_window.clear();
+    if( _data.empty() ) return;
+    _bbox = {_data.front().x, _data.front().x, _data.front().y, _data.front().y};
+    for( size_t i = 0; i < _data.size(); ++i) {
+      _extend_bbox( _data.first_index() + i, _data[i] );
+    }
+  }
+  size_t get_capacity() const { return _data.capacity(); }
   // ******************************************************* Curve::add_sample
   /** 
    * Add a point to the Curve and adjust _bbox 
@@ -96,25 +143,10 @@ public:
   virtual void add_sample( const Sample sample)
   {
     //std::cout << "Curve::add_sample" << std::endl;
-    // First sample ?
-    if (_data.size() == 0 ) {
-      //std::cout << "add_sample : NEW" << std::endl;
-      _data.push_back( sample );
-      _bbox.x_min = sample.x;
-      _bbox.x_max = sample.x;
-      _bbox.y_min = sample.y;
-      _bbox.y_max = sample.y;
-    }
-    else {
+    // First sample or after the last point
+    if (_data.size() == 0 or sample.x > get_bbox().x_max) {
       //std::cout << "add_sample : ADD" << std::endl;
-      // Check it is after the last point
-      if (sample.x > get_bbox().x_max) {
-	//std::cout << "add_sample : OK"  << std::endl;
-	_data.push_back( sample );
-	_bbox.x_max = sample.x;
-	if (sample.y > get_bbox().y_max) _bbox.y_max = sample.y;
-	if (sample.y < get_bbox().y_min) _bbox.y_min = sample.y;
-      }
+      _push( sample );
     }
   }
   /** Add any data (not as a time serie) to Curve and adust _bbox */
@@ -122,25 +154,18 @@ public:
   virtual void add_data( const Sample sample)
   {
     //std::cout << "Curve::add_data" << std::endl;
-    // First sample ?
-    if (_data.size() == 0 ) {
-      //std::cout << "add_sample : NEW" << std::endl;
-      _data.push_back( sample );
-      _bbox.x_min = sample.x;
-      _bbox.x_max = sample.x;
-      _bbox.y_min = sample.y;
-      _bbox.y_max = sample.y;
-    }
-    else {
-      //std::cout << "add_sample : ADD" << std::endl;
-      _data.push_back( sample );
-      
-      // Adjust BBox
-      if (sample.x > get_bbox().x_max) _bbox.x_max = sample.x;
-      if (sample.x < get_bbox().x_min) _bbox.x_min = sample.x;
-      if (sample.y > get_bbox().y_max) _bbox.y_max = sample.y;
-      if (sample.y < get_bbox().y_min) _bbox.y_min = sample.y;
+    // not a time serie any more
+    if( _time_serie ) {
+      _time_serie = false;
+      _lod.clear();
+      // x of the window are not increasing any more
+      if( _data.capacity() > 0 ) {
+        for( size_t i = 0; i < _data.size(); ++i) {
+          _x_window.push( _data.first_index() + i, _data[i].x );
+        }
+      }
     }
+    _push( sample );
   }
   // *************************************************** Curve::add_time_serie
   // OK
@@ -185,20 +210,129 @@ public:
     glEnable (GL_LINE_SMOOTH);
     glLineWidth( _line_width );
 
-    glBegin(GL_LINE_STRIP);
-    for( auto& pt: _data) {
-      glVertex3d( pt.x, pt.y, pt.z );
+    draw_samples( screen_ratio_x );
+  }
+  /** Draw curve in 'canvas' */
+  virtual void render_soft( SoftCanvas& canvas,
+                            float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  {
+    canvas.color( _fg_col.r, _fg_col.g, _fg_col.b );
+    canvas.line_width( _line_width );
+    size_t k = level_for( screen_ratio_x );
+    if( k > 0 ) _lod.trim( _data );
+    draw_strip( canvas, k == 0 ? _data : _lod.level( k ).data );
+  }
+  // ******************************************************* Curve::draw_strip
+  /**
+   * GL_LINE_STRIP through 'data', uploaded in 'vbo'.
+   * When the current context is not one of a Window (raw GLFW window, no
+   * glewInit) : immediate mode.
+   */
+  static void draw_strip( SampleStore<Sample>& data,
+                          utils::gl::VertexBuffer& vbo )
+  {
+    if( utils::gl::ContextGroup::current() ) {
+      vbo.sync( (const GLdouble*) data.storage(), data.storage_size(), data.dirty() );
+      data.clean();
+      vbo.draw( GL_LINE_STRIP, data.offset(), data.size() );
+    }
+    else {
+      glBegin(GL_LINE_STRIP);
+      for( auto& pt: data) {
+        glVertex3d( pt.x, pt.y, pt.z );
+      }
+      glEnd();
+    }
+  }
+  static void draw_strip( SoftCanvas& canvas, const SampleStore<Sample>& data )
+  {
+    canvas.begin( SoftCanvas::LINE_STRIP );
+    for( auto& pt: data) {
+      canvas.vertex( pt.x, pt.y );
     }
-    glEnd();
-    
+    canvas.end();
+  }
+  // ***************************************************** Curve::draw_samples
+  /**
+   * Samples as a GL_LINE_STRIP, or the coarsest level of _lod with
+   * buckets not wider than a pixel ('screen_ratio_x' : x per pixel).
+   */
+  void draw_samples( float screen_ratio_x )
+  {
+    size_t k = level_for( screen_ratio_x );
+    if( k == 0 ) {
+      draw_strip( _data, _vbo );
+    }
+    else {
+      _lod.trim( _data );
+      auto& lvl = _lod.level( k );
+      draw_strip( lvl.data, lvl.vbo );
+    }
+  }
+  /** Level of _lod to draw, 0 for the Samples themselves */
+  size_t level_for( float screen_ratio_x ) const
+  {
+    if( not _time_serie or _data.size() < 2 ) return 0;
+    double dx = (_data.back().x - _data.front().x) / (_data.size() - 1);
+    return dx > 0.0 ? _lod.level_for( screen_ratio_x / dx ) : 0;
   }
   // ******************************************************** Curve::attributs
-  std::list<Sample> get_samples() const { return _data; }
+  /** Samples, oldest first, contiguous (no copy) */
+  const SampleStore<Sample>& get_samples() const { return _data; }
   Color get_color() const { return _fg_col; }
 
 protected:
-  /** Data are a list of Samples*/
-  std::list<Sample> _data;
+  // ******************************************************** Curve::internals
+  /** Store 'sample' (evicting the oldest if needed) and adjust _bbox */
+  void _push( const Sample& sample )
+  {
+    size_t idx = _data.first_index() + _data.size();
+    if( _data.empty() ) {
+      _bbox = {sample.x, sample.x, sample.y, sample.y};
+    }
+    _data.push_back( sample );
+    if( _time_serie ) {
+      _lod.add( sample );
+      // only a window (capacity) evicts Samples
+      if( _data.capacity() > 0 ) _lod.evict( _data );
+    }
+    _extend_bbox( idx, sample );
+  }
+  /** Adjust _bbox with Sample of absolute index 'idx', the last one */
+  void _extend_bbox( size_t idx, const Sample& sample )
+  {
+    if( _data.capacity() == 0 ) {
+      if (sample.x > get_bbox().x_max) _bbox.x_max = sample.x;
+      if (sample.x < get_bbox().x_min) _bbox.x_min = sample.x;
+      if (sample.y > get_bbox().y_max) _bbox.y_max = sample.y;
+      if (sample.y < get_bbox().y_min) _bbox.y_min = sample.y;
+      return;
+    }
+    // sliding window
+    _y_window.push( idx, sample.y );
+    _y_window.evict( _data.first_index() );
+    _bbox.y_min = _y_window.min();
+    _bbox.y_max = _y_window.max();
+    if( _time_serie ) {
+      _bbox.x_min = _data.front().x;
+      _bbox.x_max = _data.back().x;
+    }
+    else {
+      _x_window.push( idx, sample.x );
+      _x_window.evict( _data.first_index() );
+      _bbox.x_min = _x_window.min();
+      _bbox.x_max = _x_window.max();
+    }
+  }
+
+  /** Data are a contiguous FIFO of Samples, mirrored on the GPU */
+  SampleStore<Sample> _data;
+  utils::gl::VertexBuffer _vbo;
+  /** Min/max levels, if Samples are a time serie (no add_data) */
+  MinMaxPyramid<Sample> _lod;
+  bool _time_serie;
+  /** Extrema of the window, with a capacity */
+  SlidingMinMax _x_window, _y_window;
   /** Color for the Curve */
   Color _fg_col;
   /** Line Width */
@@ -244,7 +378,7 @@ public:
   }
   // ******************************************************Curve::copycreation
   CurveMean( const CurveMean& c)
-    : Curve(c), _mean_mode( c._mean_mode), _mean_data( c._mean_data ),
+    : Curve(c), _mean_mode( c._mean_mode), _mean_data( c._mean_data ), _mean_vbo(),
       _mean_length( c._mean_length ), _mean_nb_point( c._mean_nb_point ),
       _mean_x( c._mean_x ), _mean_y( c._mean_y )
   {}
@@ -258,8 +392,16 @@ public:
   void recompute_means()
   {
 	_mean_data.clear();
+	_mean_vbo.reset();
 	// _mean_length so as to have around 100 pts on curve
 	_mean_length = _data.size() / 100;
+	// and on the window, with a capacity
+	if( _data.capacity() > 0 and _mean_length > 0 ) {
+	  _mean_data.set_capacity( _data.capacity() / _mean_length );
+	}
+	else {
+	  _mean_data.set_capacity( 0 );
+	}
 
 	// then recompute means
 	_mean_x = 0.0;
@@ -317,25 +459,32 @@ public:
     glEnable (GL_LINE_SMOOTH);
     glLineWidth( _line_width );
 
-    glBegin(GL_LINE_STRIP);
 	if( _mean_mode ) {
-	  for( auto& pt: _mean_data) {
-		glVertex3d( pt.x, pt.y, pt.z );
-	  }
+	  draw_strip( _mean_data, _mean_vbo );
 	}
 	else {
-	  for( auto& pt: _data) {
-		glVertex3d( pt.x, pt.y, pt.z );
-	  }
+	  draw_samples( screen_ratio_x );
 	}
-    glEnd();
+  }
+  virtual void render_soft( SoftCanvas& canvas,
+                            float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  {
+    if( _mean_mode ) {
+      canvas.color( _fg_col.r, _fg_col.g, _fg_col.b );
+      canvas.line_width( _line_width );
+      draw_strip( canvas, _mean_data );
+    }
+    else {
+      Curve::render_soft( canvas, screen_ratio_x, screen_ratio_y );
+    }
   }
   
   // **************************************************** CurveMean::attributs
 protected:
   bool _mean_mode;
-  /** Mean Data are a list of Samples*/
-  std::list<Sample> _mean_data;
+  /** Mean Data are a FIFO of Samples, mirrored on the GPU */
+  SampleStore<Sample> _mean_data;
+  utils::gl::VertexBuffer _mean_vbo;
   /** Mean parameters and variables */
   int _mean_length, _mean_nb_point;
   double _mean_x, _mean_y;
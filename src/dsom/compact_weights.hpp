@@ -0,0 +1,331 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef DSOM_COMPACT_WEIGHTS_HPP
+#define DSOM_COMPACT_WEIGHTS_HPP
+
+/**
+ * Weights of a whole DSOM map in one buffer, with reduced precision.
+ *  - DOUBLE : as in the neurons
+ *  - FLOAT  : single precision
+ *  - INT16  : w = offset + scale * q, q in [-32767, 32767],
+ *             offset and scale are computed on the whole map
+ *
+ * Distances are computed on the compact form (float accumulation), the
+ * input being converted once per query.
+ * CompactSearch uses it as a backend of Network::computeWinner.
+ *
+ * It trades accuracy for search speed and for smaller, faster to load
+ * binary saves (Network::write_compact). It does not reduce the memory
+ * of a Network : the neurons keep their double weights, CompactSearch
+ * adds its copy to them, and Network::read_compact expands the weights
+ * back to double.
+ */
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdint>                  // int16_t
+#include <limits>                   // max dbl
+#include <cmath>                    // sqrt, lrint
+
+#include <dsom/neuron.hpp>
+#include <dsom/winner_search.hpp>
+
+// ********************************************************************* Model
+namespace Model
+{
+// ********************************************************************** DSOM
+namespace DSOM
+{
+enum class Precision { DOUBLE, FLOAT, INT16 };
+inline std::string str_precision( Precision p )
+{
+  switch( p ) {
+  case Precision::DOUBLE: return "double";
+  case Precision::FLOAT: return "float";
+  case Precision::INT16: return "int16";
+  }
+  return "unknown";
+}
+// ***************************************************************************
+// ************************************************************ CompactWeights
+// ***************************************************************************
+class CompactWeights
+{
+public:
+  using TWeight = Neuron::TWeight;
+  using TWeightRef = Eigen::Ref<const TWeight>;
+  using Neurons = std::vector<Neuron *>;
+  static constexpr int QMAX = 32767;
+  /** First word of the binary form ("DSCW") */
+  static constexpr int32_t MAGIC = 0x57435344;
+public:
+  // ************************************************ CompactWeights::creation
+  CompactWeights( Precision p = Precision::FLOAT ) :
+    _precision(p), _nb(0), _dim(0), _offset(0.0), _scale(1.0)
+  {}
+  /** Copy all weights of the neurons (and set scale/offset for INT16) */
+  void build( const Neurons& v_neur )
+  {
+    _nb = v_neur.size();
+    _dim = (_nb > 0) ? v_neur[0]->weights.size() : 0;
+    _w_double.clear();
+    _w_float.clear();
+    _w_int16.clear();
+    switch( _precision ) {
+    case Precision::DOUBLE: _w_double.resize( _nb * _dim ); break;
+    case Precision::FLOAT: _w_float.resize( _nb * _dim ); break;
+    case Precision::INT16: _w_int16.resize( _nb * _dim ); break;
+    }
+
+    if( _precision == Precision::INT16 ) {
+      double w_min = std::numeric_limits<double>::max();
+      double w_max = std::numeric_limits<double>::lowest();
+      for( auto& n: v_neur ) {
+        w_min = std::min( w_min, n->weights.minCoeff() );
+        w_max = std::max( w_max, n->weights.maxCoeff() );
+      }
+      _offset = (_nb > 0) ? (w_min + w_max) / 2.0 : 0.0;
+      _scale = (w_max > w_min) ? (w_max - w_min) / (2.0 * QMAX) : 1.0;
+    }
+    for( unsigned int i = 0; i < _nb; ++i) {
+      set( i, v_neur[i]->weights );
+    }
+  }
+  // ****************************************************** CompactWeights::io
+  /** Store weights of neuron idx (INT16 saturates outside the range) */
+  void set( unsigned int idx, const TWeightRef& w )
+  {
+    for( unsigned int d = 0; d < _dim; ++d) {
+      switch( _precision ) {
+      case Precision::DOUBLE:
+        _w_double[idx*_dim+d] = w(d);
+        break;
+      case Precision::FLOAT:
+        _w_float[idx*_dim+d] = (float) w(d);
+        break;
+      case Precision::INT16: {
+        long q = lrint( (w(d) - _offset) / _scale );
+        q = std::max( (long) -QMAX, std::min( (long) QMAX, q ));
+        _w_int16[idx*_dim+d] = (int16_t) q;
+        break;
+      }
+      }
+    }
+  }
+  /** Weights of neuron idx, back in double */
+  TWeight get( unsigned int idx ) const
+  {
+    TWeight w( _dim );
+    for( unsigned int d = 0; d < _dim; ++d) {
+      switch( _precision ) {
+      case Precision::DOUBLE: w(d) = _w_double[idx*_dim+d]; break;
+      case Precision::FLOAT: w(d) = _w_float[idx*_dim+d]; break;
+      case Precision::INT16: w(d) = _offset + _scale * _w_int16[idx*_dim+d]; break;
+      }
+    }
+    return w;
+  }
+  // ************************************************ CompactWeights::distance
+  /**
+   * Index of the neuron closest to 'input' (lowest index if ties),
+   * 'dist' is set to its euclidean distance.
+   */
+  unsigned int find( const TWeight& input, double& dist ) const
+  {
+    compute_sq( input );
+    unsigned int best = 0;
+    for( unsigned int i = 1; i < _nb; ++i) {
+      if( _acc[i] < _acc[best] ) best = i;
+    }
+    dist = unscale( _acc[best] );
+    return best;
+  }
+  /** Euclidean distance from 'input' to all neurons */
+  void distances( const TWeight& input, Eigen::VectorXd& dist ) const
+  {
+    compute_sq( input );
+    dist.resize( _nb );
+    for( unsigned int i = 0; i < _nb; ++i) {
+      dist(i) = unscale( _acc[i] );
+    }
+  }
+  // ************************************************** CompactWeights::binary
+  /** Binary save: MAGIC, precision, nb, dim, offset, scale, weights */
+  void write( std::ostream& os ) const
+  {
+    int32_t header[4] = { MAGIC, (int32_t) _precision, (int32_t) _nb, (int32_t) _dim };
+    os.write( (const char*) header, sizeof(header) );
+    os.write( (const char*) &_offset, sizeof(_offset) );
+    os.write( (const char*) &_scale, sizeof(_scale) );
+    switch( _precision ) {
+    case Precision::DOUBLE:
+      os.write( (const char*) _w_double.data(), _w_double.size() * sizeof(double) );
+      break;
+    case Precision::FLOAT:
+      os.write( (const char*) _w_float.data(), _w_float.size() * sizeof(float) );
+      break;
+    case Precision::INT16:
+      os.write( (const char*) _w_int16.data(), _w_int16.size() * sizeof(int16_t) );
+      break;
+    }
+  }
+  /**
+   * Binary read, return false (and leave this unchanged) if the header is
+   * not valid (magic, precision, sizes, INT16 scale) or the stream is not
+   * complete.
+   */
+  bool read( std::istream& is )
+  {
+    int32_t header[4];
+    double offset, scale;
+    is.read( (char*) header, sizeof(header) );
+    is.read( (char*) &offset, sizeof(offset) );
+    is.read( (char*) &scale, sizeof(scale) );
+    if( not is or header[0] != MAGIC ) return false;
+    if( header[1] < (int32_t) Precision::DOUBLE or
+        header[1] > (int32_t) Precision::INT16 ) return false;
+    if( header[2] < 0 or header[3] < 0 ) return false;
+    if( not std::isfinite( offset ) or not std::isfinite( scale ) or
+        scale <= 0.0 ) return false;
+
+    Precision precision = (Precision) header[1];
+    size_t size = (size_t) header[2] * (size_t) header[3];
+    std::vector<double> w_double;
+    std::vector<float> w_float;
+    std::vector<int16_t> w_int16;
+    switch( precision ) {
+    case Precision::DOUBLE:
+      w_double.resize( size );
+      is.read( (char*) w_double.data(), size * sizeof(double) );
+      break;
+    case Precision::FLOAT:
+      w_float.resize( size );
+      is.read( (char*) w_float.data(), size * sizeof(float) );
+      break;
+    case Precision::INT16:
+      w_int16.resize( size );
+      is.read( (char*) w_int16.data(), size * sizeof(int16_t) );
+      break;
+    }
+    if( not is ) return false;
+
+    _precision = precision;
+    _nb = header[2];
+    _dim = header[3];
+    _offset = offset;
+    _scale = scale;
+    _w_double.swap( w_double );
+    _w_float.swap( w_float );
+    _w_int16.swap( w_int16 );
+    return true;
+  }
+  // ********************************************** CompactWeights::attributes
+  Precision precision() const { return _precision; }
+  unsigned int size() const { return _nb; }
+  unsigned int dim() const { return _dim; }
+  double get_offset() const { return _offset; }
+  double get_scale() const { return _scale; }
+protected:
+  /** Squared distances in _acc (in quantized units for INT16) */
+  void compute_sq( const TWeight& input ) const
+  {
+    _acc.resize( _nb );
+    if( _precision == Precision::DOUBLE ) {
+      for( unsigned int i = 0; i < _nb; ++i) {
+        _acc[i] = WinnerSearch::sq_dist( &_w_double[i*_dim], input.data(), _dim );
+      }
+      return;
+    }
+    // input converted once
+    _x.resize( _dim );
+    for( unsigned int d = 0; d < _dim; ++d) {
+      if( _precision == Precision::INT16 )
+        _x[d] = (float) ((input(d) - _offset) / _scale);
+      else
+        _x[d] = (float) input(d);
+    }
+    const float* x = _x.data();
+    if( _precision == Precision::FLOAT ) {
+      const float* w = _w_float.data();
+      for( unsigned int i = 0; i < _nb; ++i, w += _dim) {
+        float acc = 0.0f;
+        for( unsigned int d = 0; d < _dim; ++d) {
+          float diff = w[d] - x[d];
+          acc += diff * diff;
+        }
+        _acc[i] = acc;
+      }
+    }
+    else {
+      const int16_t* w = _w_int16.data();
+      for( unsigned int i = 0; i < _nb; ++i, w += _dim) {
+        float acc = 0.0f;
+        for( unsigned int d = 0; d < _dim; ++d) {
+          float diff = (float) w[d] - x[d];
+          acc += diff * diff;
+        }
+        _acc[i] = acc;
+      }
+    }
+  }
+  /** Euclidean distance from a squared distance of compute_sq */
+  double unscale( double sq ) const
+  {
+    if( _precision == Precision::INT16 ) return sqrt( sq ) * _scale;
+    return sqrt( sq );
+  }
+  /** Precision of the storage */
+  Precision _precision;
+  /** Nb of neurons and dimension of weights */
+  unsigned int _nb, _dim;
+  /** INT16 : w = _offset + _scale * q */
+  double _offset, _scale;
+  /** Weights, neuron after neuron (only one is used) */
+  std::vector<double> _w_double;
+  std::vector<float> _w_float;
+  std::vector<int16_t> _w_int16;
+  /** Buffers for queries */
+  mutable std::vector<float> _x;
+  mutable std::vector<double> _acc;
+};
+// ***************************************************************************
+// ************************************************************* CompactSearch
+// ***************************************************************************
+/**
+ * Winner search on a reduced precision copy of the weights.
+ * The winner may differ from the exact one when two neurons are closer
+ * than the precision.
+ */
+class CompactSearch : public WinnerSearch
+{
+public:
+  CompactSearch( Precision p = Precision::FLOAT ) : _cw(p) {}
+  WinnerSearch* clone() const { return new CompactSearch( *this ); }
+  std::string name() const { return "compact-" + str_precision( _cw.precision() ); }
+  void update( unsigned int idx, const TWeightRef& w )
+  {
+    if( _built ) _cw.set( idx, w );
+  }
+  void distances( const Neurons& v_neur, const TWeight& input,
+                  Eigen::VectorXd& dist )
+  {
+    if( not _built ) {
+      build( v_neur );
+      _built = true;
+    }
+    _cw.distances( input, dist );
+  }
+  const CompactWeights& get_weights() const { return _cw; }
+protected:
+  void build( const Neurons& v_neur ) { _cw.build( v_neur ); }
+  unsigned int find( const TWeight& input, double& dist )
+  {
+    return _cw.find( input, dist );
+  }
+  CompactWeights _cw;
+};
+
+}; // namespace DSOM
+}; // namespace Model
+
+#endif // DSOM_COMPACT_WEIGHTS_HPP
@@ -12,8 +12,14 @@
 #include <limits>                   // max dbl
 #include <algorithm>    // std::max
 
+#include <memory>                   // std::unique_ptr
+#include <map>                      // std::map
+
 #include <dsom/neuron.hpp>
 #include <dsom/utils.hpp>
+#include <dsom/winner_search.hpp>
+#include <dsom/compact_weights.hpp>
+#include <parallel.hpp>             // utils::parallel::for_range
 
 #include "rapidjson/prettywriter.h" // rapidjson
 #include "rapidjson/document.h"     // rapidjson's DOM-style API
@@ -121,7 +127,8 @@ public:
   Network( const Network& n ) :
     _rnd(n._rnd), _nb_link(n._nb_link), _size_grid(n._size_grid),
     _winner_neur(n._winner_neur), _winner_dist(n._winner_dist),
-    _max_dist_neurone(n._max_dist_neurone), _max_dist_input(n._max_dist_input)
+    _max_dist_neurone(n._max_dist_neurone), _max_dist_input(n._max_dist_input),
+    _search( n._search ? n._search->clone() : nullptr )
   {
     for (auto it = n.v_neur.begin(); it != n.v_neur.end(); ++it) {
       Neuron *neur = new Neuron( **it );
@@ -187,6 +194,7 @@ public:
 	  v_neur[i*_size_grid+j]->weights = v;
 	}
       }
+      if( _search ) _search->invalidate();
     }
     else {
       std::cerr << "TODO initialise with dim_weight != 2 ....\n";
@@ -285,6 +293,10 @@ public:
   // *********************************************************** Network::play
   double computeWinner( Eigen::VectorXd &input )
   {
+	if( _search ) {
+	  _winner_neur = _search->search( v_neur, input, _winner_dist );
+	  return _winner_dist;
+	}
 	_winner_dist = std::numeric_limits<double>::max();
   
 	for( unsigned int i=0; i<v_neur.size(); i++) {
@@ -301,8 +313,13 @@ public:
   {
 	Eigen::VectorXd output(v_neur.size());
   
-	for( unsigned int i=0; i<v_neur.size(); i++) {
-	  output[i] = v_neur[i]->computeDistanceInput( input );
+	if( _search ) {
+	  _search->distances( v_neur, input, output );
+	}
+	else {
+	  for( unsigned int i=0; i<v_neur.size(); i++) {
+	    output[i] = v_neur[i]->computeDistanceInput( input );
+	  }
 	}
 	_winner_dist = output.minCoeff( &_winner_neur );
 
@@ -348,6 +365,7 @@ public:
 	  std::cout << " " << delta << "\tdW=" << utils::eigen::str_vec(delta_weight) << "\n";
 	}      
 	v_neur[(*i_neigh).index]->add_to_weights( delta_weight );
+	if( _search ) _search->update( (*i_neigh).index, v_neur[(*i_neigh).index]->weights );
       }
       if( verb ) {
 	std::cout << "********\n";
@@ -367,9 +385,94 @@ public:
 	  std::cout << "delta=" << delta << "\ndW=" << delta_weight << "\n";
 	}      
 	v_neur[indn]->add_to_weights( delta_weight );
+	if( _search ) _search->update( indn, v_neur[indn]->weights );
       }
     }
   }
+  // ********************************************************** Network::batch
+  /**
+   * Mini-batch learning on a block of inputs.
+   * Winners of all inputs are computed with the weights at the start of
+   * the block (in parallel over inputs), _max_dist_input is updated with
+   * all of them, then the SUM of the deltaW of all inputs is applied once
+   * (in parallel over neurons), as the same online steps would with frozen
+   * weights. A neuron whose total gain (sum of the coefficients of
+   * (input - w)) exceeds 1 moves to the weighted mean of its inputs instead
+   * (as in batch-SOM) : large blocks do not overshoot.
+   * As in deltaW, only the neighbours of the winners are adapted on a
+   * NON-regular grid.
+   */
+  void learnBatch( std::vector<Eigen::VectorXd>& inputs, double eps, double ela,
+                   unsigned int nb_thread = 1 )
+  {
+    unsigned int nb_in = inputs.size();
+    if( nb_in == 0 ) return;
+
+    // Distance of all inputs to all neurons, and winners
+    Eigen::MatrixXd dist( nb_in, v_neur.size() );
+    std::vector<unsigned int> win( nb_in );
+    std::vector<double> win_dist( nb_in ), max_dist( nb_in );
+    utils::parallel::for_range( 0, nb_in, nb_thread,
+                                [&] (unsigned int begin, unsigned int end) {
+      for( unsigned int t = begin; t < end; ++t) {
+        for( unsigned int i = 0; i < v_neur.size(); ++i) {
+          dist(t,i) = v_neur[i]->computeDistanceInput( inputs[t] );
+        }
+        Eigen::MatrixXd::Index idx;
+        win_dist[t] = dist.row(t).minCoeff( &idx );
+        win[t] = idx;
+        max_dist[t] = dist.row(t).maxCoeff();
+      }
+    });
+    for( auto& d: max_dist ) {
+      _max_dist_input = std::max( _max_dist_input, d );
+    }
+    _winner_neur = win.back();
+    _winner_dist = win_dist.back();
+
+    // NON-Regular GRID : distance of all neurons to each winner (<0 if none)
+    // and that of each input, ready before threads only read it
+    std::map<unsigned int, std::vector<double>> pos_dist;
+    std::vector<const std::vector<double>*> pos_dist_of( nb_in, nullptr );
+    if( _nb_link > 0 ) {
+      for( unsigned int t = 0; t < nb_in; ++t) {
+        auto it = pos_dist.find( win[t] );
+        if( it == pos_dist.end() ) {
+          std::vector<double> d( v_neur.size(), -1.0 );
+          for( auto& neigh: v_neur[win[t]]->l_neighbors ) {
+            d[neigh.index] = neigh.dist;
+          }
+          it = pos_dist.insert( std::make_pair( win[t], d )).first;
+        }
+        pos_dist_of[t] = &(it->second);
+      }
+    }
+
+    // Sum of deltaW
+    utils::parallel::for_range( 0, v_neur.size(), nb_thread,
+                                [&] (unsigned int begin, unsigned int end) {
+      for( unsigned int i = begin; i < end; ++i) {
+        Eigen::VectorXd delta_weight = Eigen::VectorXd::Zero( v_neur[i]->weights.size() );
+        double gain = 0.0;
+        for( unsigned int t = 0; t < nb_in; ++t) {
+          double d_pos;
+          if( _nb_link > 0 ) {
+            d_pos = (*pos_dist_of[t])[i];
+            if( d_pos < 0.0 ) continue;
+          }
+          else {
+            d_pos = v_neur[i]->computeDistancePos( *(v_neur[win[t]]) );
+          }
+          auto delta = eps * dist(t,i) / _max_dist_input * this->hnDistance( d_pos/_max_dist_neurone, win_dist[t]/_max_dist_input, ela);
+          delta_weight += delta * (inputs[t] - v_neur[i]->weights);
+          gain += delta;
+        }
+        if( gain > 1.0 ) delta_weight /= gain;
+        v_neur[i]->add_to_weights( delta_weight );
+      }
+    });
+    if( _search ) _search->invalidate();
+  }
   // ********************************************************** Network::is_in
   bool is_in( unsigned int elem,  std::list<unsigned int> ll )
   {
@@ -435,12 +538,80 @@ public:
 
 	  _max_dist_neurone = v_neur[0]->computeDistancePos( *(v_neur[nb_neur-1]) );
 	}
+	if( _search ) _search->invalidate();
+  }
+  // ******************************************************** Network::compact
+  /**
+   * Binary save with weights stored with precision p:
+   * nb_link, size_grid, max_dist_input then CompactWeights.
+   */
+  void write_compact( std::ostream& os, Precision p )
+  {
+    int32_t grid[2] = { (int32_t) _nb_link, (int32_t) _size_grid };
+    os.write( (const char*) grid, sizeof(grid) );
+    os.write( (const char*) &_max_dist_input, sizeof(_max_dist_input) );
+    CompactWeights cw( p );
+    cw.build( v_neur );
+    cw.write( os );
+  }
+  /**
+   * Weights from write_compact(), the grid and the dimension of the
+   * weights must be the same. Weights are expanded back to double in
+   * the neurons (same memory as a JSON load, but a faster load).
+   */
+  void read_compact( std::istream& is )
+  {
+    int32_t grid[2];
+    double max_dist_input;
+    CompactWeights cw;
+    if( not read_compact_header( is, grid, max_dist_input ) or not cw.read( is ) or
+        grid[0] != _nb_link or grid[1] != _size_grid or
+        cw.size() != v_neur.size() or
+        (v_neur.size() > 0 and cw.dim() != (unsigned int) v_neur[0]->weights.size()) ) {
+      std::cerr << "Network::read_compact: incompatible or truncated data\n";
+      exit(1);
+    }
+    _max_dist_input = max_dist_input;
+    for( unsigned int i = 0; i < v_neur.size(); ++i) {
+      v_neur[i]->weights = cw.get( i );
+    }
+    if( _search ) _search->invalidate();
+  }
+  /**
+   * Only the CompactWeights of a write_compact(), without any Network
+   * (winner search on the compact form, see CompactWeights::find).
+   */
+  static CompactWeights read_compact_weights( std::istream& is )
+  {
+    int32_t grid[2];
+    double max_dist_input;
+    CompactWeights cw;
+    if( not read_compact_header( is, grid, max_dist_input ) or not cw.read( is ) ) {
+      std::cerr << "Network::read_compact_weights: invalid or truncated data\n";
+      exit(1);
+    }
+    return cw;
+  }
+protected:
+  /** nb_link, size_grid and max_dist_input of write_compact(), false if not valid */
+  static bool read_compact_header( std::istream& is, int32_t grid[2],
+                                   double& max_dist_input )
+  {
+    is.read( (char*) grid, 2 * sizeof(int32_t) );
+    is.read( (char*) &max_dist_input, sizeof(max_dist_input) );
+    return is and grid[1] >= 0 and std::isfinite( max_dist_input );
   }
   // ****************************************************** Network::attributs
 public:
   unsigned int get_winner() const { return _winner_neur; }
   double get_winner_dist() const { return _winner_dist; }
   double get_max_dist_neurone() { return _max_dist_neurone; }
+  /**
+   * Backend used by computeWinner and forward (Network takes ownership).
+   * nullptr means the plain scan over all neurons.
+   */
+  void set_winner_search( WinnerSearch* search ) { _search.reset( search ); }
+  WinnerSearch* get_winner_search() const { return _search.get(); }
 private:
   /** Random engine */
   std::default_random_engine _rnd;
@@ -461,6 +632,8 @@ private:
   double _max_dist_neurone;
   /** The maximum distance between inputs */
   double _max_dist_input;
+  /** Winner search backend */
+  std::unique_ptr<WinnerSearch> _search;
 }; // class Network
 }; // namespace DSOM
 }; // namespace Model
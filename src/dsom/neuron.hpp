@@ -5,6 +5,8 @@
 
 /** 
  * Neuron for DSOM kind of Networks.
+ * Weights are a view (Eigen::Map) on the storage of the Neuron, or on an
+ * external store given by bind_weights() (see Population).
  */
 
 #include <iostream>
@@ -14,6 +16,7 @@
 #include <Eigen/Dense>
 #include <list>
 #include <string>
+#include <new>                      // placement new (rebind Eigen::Map)
 
 #include "rapidjson/prettywriter.h" // rapidjson
 #include "rapidjson/document.h"     // rapidjson's DOM-style API
@@ -47,48 +50,50 @@ public:
   // ************************************************************* Neuron_TYPE
   typedef double          TNumber;
   typedef Eigen::VectorXd TWeight;
+  typedef Eigen::Map<TWeight> TWeightMap;
   typedef Eigen::VectorXi TPos;
 public:
   // ******************************************************** Neuron::creation
   /** Creation with index and random weights in [w_min,w_max]^dim */
   Neuron( int index, int dim_weights, TNumber w_min=0, TNumber w_max=1) :
-    index(index)
+    index(index), weights(nullptr, 0)
   {
     //std::cerr << "Create Neurone " << index << "\n";
     
     // Generate weights between -1 and 1 (Eigen)
-    this->weights = Eigen::VectorXd::Random(dim_weights);
+    this->set_weights( Eigen::VectorXd::Random(dim_weights) );
     // Scale
     this->weights= (this->weights.array() - -1.0) / (1.0 - -1.0) * (w_max - w_min) + w_min;
   }
   /** Creation with index, position and random weights in [w_min,w_max]^dim */
   Neuron( int index, const Eigen::Ref<const TPos>& pos,
 	  int dim_weights, TNumber w_min=0, TNumber w_max=1) : 
-    index(index), _pos(pos)
+    index(index), weights(nullptr, 0), _pos(pos)
   {
     //std::cerr << "Create Neurone " << index << "\n";
 
     // Generate weights between -1 and 1 (Eigen)
-    this->weights = Eigen::VectorXd::Random(dim_weights);
+    this->set_weights( Eigen::VectorXd::Random(dim_weights) );
     // Scale
     this->weights= (this->weights.array() - -1.0) / (1.0 - -1.0) * (w_max - w_min) + w_min;
   };
   /** Creation from JSON doc */
   Neuron( const rj::Value& obj ) :
-    index(0)
+    index(0), weights(nullptr, 0)
   {
     // decode d'après obj
     this->unserialize( obj );
   }
   /** Creation from Persistence (file). */
   //Neuron( Persistence& save ) {};
-  /** Creation with copy */
+  /** Creation with copy (weights in its own storage) */
   Neuron( const Neuron& n ) :
-    index(n.index), weights(n.weights),
+    index(n.index), weights(nullptr, 0),
     l_link(n.l_link), l_neighbors(n.l_neighbors),
     _pos(n._pos)
   {
     //std::cout << "Copy Neuron" << std::endl;
+    set_weights( n.weights );
   }
   /** Creation from assignment */
   Neuron& operator=( const Neuron& n )
@@ -100,12 +105,13 @@ public:
       l_link = n.l_link;
       l_neighbors = n.l_neighbors;
       _pos = n._pos;
-      weights = n.weights;
+      set_weights( n.weights );
     }
     return *this;
   }
   /** Creation from JSON file */
-  Neuron( std::istream& is )
+  Neuron( std::istream& is ) :
+    weights(nullptr, 0)
   {
 	// Wrapper pour lire document
     JSON::IStreamWrapper instream(is);
@@ -215,10 +221,11 @@ public:
 	// Weights
 	const rj::Value& w = obj["weights"];
 	assert( w.IsArray() );
-	this->weights.resize( w.Size() );
+	TWeight values( w.Size() );
 	for( unsigned int i = 0; i < w.Size(); ++i) {
-	  this->weights(i) = w[i].GetDouble();
+	  values(i) = w[i].GetDouble();
 	}
+	set_weights( values );
 
 	// Links
 	l_link.clear();
@@ -332,17 +339,48 @@ public:
   {
     this->weights = this->weights +  delta_weight;
   }
+  // ********************************************************* Neuron::storage
+  /**
+   * Set the weights, in the current storage if of the same size (which
+   * may be an external store), in the own storage of the Neuron otherwise.
+   */
+  void set_weights( const Eigen::Ref<const TWeight>& w )
+  {
+    if( w.size() == weights.size() ) {
+      weights = w;
+    }
+    else {
+      _own_weights = w;
+      new (&weights) TWeightMap( _own_weights.data(), _own_weights.size() );
+    }
+  }
+  /**
+   * Move the weights to 'data' (weights.size() values, that must outlive
+   * the Neuron), which becomes their storage.
+   */
+  void bind_weights( TNumber* data )
+  {
+    TWeightMap ext( data, weights.size() );
+    ext = weights;
+    new (&weights) TWeightMap( data, ext.size() );
+    _own_weights.resize( 0 );
+  }
+  /** true if the weights are stored outside of the Neuron */
+  bool is_bound() const { return weights.data() != _own_weights.data(); }
   // ****************************************************** Neuron::attributes
   /** Index */
   int index;
-  /** Weights */
-  TWeight weights;
+  /** Weights (view on their storage) */
+  TWeightMap weights;
   /** List of Direct Neighbors */
   std::list<unsigned int> l_link;
   /** List of Neighbors */
   std::list<Neur_Dist> l_neighbors;
   /** Position on grid */
   TPos _pos;
+private:
+  /** Own storage of the weights (empty when bound to an external store) */
+  TWeight _own_weights;
 };
 // ******************************************************************** Neuron
 // ***************************************************************************
@@ -0,0 +1,308 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef DSOM_POPULATION_HPP
+#define DSOM_POPULATION_HPP
+
+/**
+ * Population of RNetwork replicas trained in lockstep.
+ * Each replica has its own parameters (beta, sigmas, eps, ...) and seed.
+ * The weights of all the replicas are in one contiguous store, the
+ * neurons of the replicas being views on it (see Neuron::bind_weights).
+ * The same block of inputs is streamed through all the replicas,
+ * replicas being spread among threads.
+ * Tests can also be streamed : start_test(), test_block() on each block
+ * of the test inputs, then get_test_errors().
+ */
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <random>                   // std::mt19937
+#include <stdexcept>                // std::runtime_error
+
+#include <dsom/r_network.hpp>
+#include <parallel.hpp>             // utils::parallel::for_range
+
+#include "rapidjson/document.h"     // rapidjson's DOM-style API
+namespace rj = rapidjson;
+
+// ********************************************************************* Model
+namespace Model
+{
+// ********************************************************************** DSOM
+namespace DSOM
+{
+// ***************************************************************************
+// **************************************************************** Population
+// ***************************************************************************
+class Population
+{
+public:
+  using TNumber = RNetwork::TNumber;
+  /** Parameters of one replica (defaults of xp-004-rdsom) */
+  struct Param {
+    unsigned int seed = 0;
+    bool dsom = true;
+    TNumber beta = 0.5;
+    TNumber sig_input = 0.1;
+    TNumber sig_recur = 0.1;
+    TNumber sig_convo = 0.1;
+    TNumber sig_som = 0.1;
+    TNumber eps = 0.1;
+    TNumber ela = 0.2;
+    TNumber ela_rec = 0.2;
+    TNumber hn_eps = 0.0;
+  };
+  /** Errors summed since last reset_errors() */
+  struct Errors {
+    TNumber input = 0.0;
+    TNumber rec = 0.0;
+    TNumber pred = 0.0;
+    unsigned long nb = 0;
+  };
+public:
+  // **************************************************** Population::creation
+  /**
+   * One replica for each param, its weights drawn by its own RNG
+   * (std::mt19937 seeded with param.seed) : weights in [w_min,w_max],
+   * r_weights in [0,1], whatever the order of the replicas.
+   */
+  Population( const std::vector<Param>& params,
+              int dim_input, int nb_neur, int nb_link=-1,
+              float w_min=0.0, float w_max=1.0 ) :
+    _params(params), _errors(params.size())
+  {
+    _nets.reserve( _params.size() );
+    for( auto& p: _params ) {
+      _nets.emplace_back( dim_input, nb_neur, nb_link, w_min, w_max );
+      _nets.back().set_hn_epsilon( p.hn_eps );
+    }
+    bind_store();
+
+    unsigned int dim = _nets[0].v_neur[0]->weights.size();
+    for( unsigned int k = 0; k < _nets.size(); ++k) {
+      std::mt19937 rnd( _params[k].seed );
+      std::uniform_real_distribution<double> unif_w( w_min, w_max );
+      std::uniform_real_distribution<double> unif_rw( 0.0, 1.0 );
+      for( unsigned int i = 0; i < _nb_neur; ++i) {
+        auto col = _store.col( k * _nb_neur + i );
+        for( unsigned int d = 0; d < col.size(); ++d) {
+          col(d) = (d < dim) ? unif_w( rnd ) : unif_rw( rnd );
+        }
+      }
+    }
+  }
+  /**
+   * One replica for each param, all copied from the same network : replicas
+   * only differ by their parameters. Seeds are meaningless here, so
+   * std::runtime_error if one is set (seed != 0, as with 'repeat').
+   */
+  Population( const std::vector<Param>& params, const RNetwork& model ) :
+    _params(params), _errors(params.size())
+  {
+    for( auto& p: _params ) {
+      if( p.seed != 0 ) {
+        throw std::runtime_error( "Population: seed/repeat need random weights, not a model" );
+      }
+    }
+    _nets.reserve( _params.size() );
+    for( auto& p: _params ) {
+      _nets.emplace_back( model );
+      _nets.back().set_hn_epsilon( p.hn_eps );
+    }
+    bind_store();
+  }
+  /** Neurons are views on _store */
+  Population( const Population& ) = delete;
+  Population& operator=( const Population& ) = delete;
+  // ********************************************************* Population::str
+  std::string str_dump() const
+  {
+    std::stringstream ss;
+    ss << "Population of " << _nets.size() << " replicas" << std::endl;
+    for( unsigned int i = 0; i < _params.size(); ++i) {
+      ss << "  [" << i << "] " << str_param( i ) << std::endl;
+    }
+    return ss.str();
+  }
+  std::string str_param( unsigned int idx ) const
+  {
+    const Param& p = _params[idx];
+    std::stringstream ss;
+    ss << (p.dsom ? "DSOM" : "SOM") << " seed=" << p.seed;
+    ss << " beta=" << p.beta << " sig_i=" << p.sig_input;
+    ss << " sig_r=" << p.sig_recur << " sig_c=" << p.sig_convo;
+    ss << " eps=" << p.eps << " ela=" << p.ela << " ela_rec=" << p.ela_rec;
+    ss << " sig_som=" << p.sig_som << " hn_eps=" << p.hn_eps;
+    return ss.str();
+  }
+  // ******************************************************** Population::run
+  /**
+   * Stream a block of inputs through all replicas (learning or not).
+   * Each thread takes a range of replicas along the whole block.
+   */
+  void run( std::vector<Eigen::VectorXd>& inputs, bool learning,
+            unsigned int nb_thread = 1 )
+  {
+    run_on( _nets, _errors, inputs, learning, nb_thread );
+  }
+  /**
+   * Mean errors of a (reset) copy of every replica on inputs,
+   * without learning.
+   */
+  std::vector<Errors> test( std::vector<Eigen::VectorXd>& inputs,
+                            unsigned int nb_thread = 1 )
+  {
+    start_test();
+    test_block( inputs, nb_thread );
+    std::vector<Errors> res;
+    res.swap( _test_errors );
+    _test_nets.clear();
+    return res;
+  }
+  /** (Reset) copy of every replica, for test_block() */
+  void start_test()
+  {
+    _test_nets.clear();
+    _test_nets.reserve( _nets.size() );
+    for( auto& net: _nets ) {
+      _test_nets.emplace_back( net );
+      _test_nets.back().reset();
+    }
+    _test_errors.assign( _nets.size(), Errors() );
+  }
+  /** Next block of test inputs, through the copies of start_test() */
+  void test_block( std::vector<Eigen::VectorXd>& inputs, unsigned int nb_thread = 1 )
+  {
+    run_on( _test_nets, _test_errors, inputs, false, nb_thread );
+  }
+  /** Errors summed since start_test() */
+  const std::vector<Errors>& get_test_errors() const { return _test_errors; }
+  // ***************************************************** Population::errors
+  /** Mean errors of replica idx since last reset_errors() */
+  Errors get_mean_errors( unsigned int idx ) const
+  {
+    Errors res = _errors[idx];
+    if( res.nb > 0 ) {
+      res.input /= res.nb;
+      res.rec /= res.nb;
+      res.pred /= res.nb;
+    }
+    return res;
+  }
+  void reset_errors()
+  {
+    _errors.assign( _nets.size(), Errors() );
+  }
+  // ************************************************** Population::attributes
+  unsigned int size() const { return _nets.size(); }
+  RNetwork& get_net( unsigned int idx ) { return _nets[idx]; }
+  /**
+   * Weights of all the replicas : column k*nb_neur+i is
+   * [weights; r_weights] of neuron i of replica k.
+   */
+  const Eigen::MatrixXd& get_store() const { return _store; }
+  const Param& get_param( unsigned int idx ) const { return _params[idx]; }
+private:
+  /** Move the weights of all the neurons of the replicas into _store */
+  void bind_store()
+  {
+    if( _nets.empty() or _nets[0].v_neur.empty() ) {
+      throw std::runtime_error( "Population: no replica or no neuron" );
+    }
+    _nb_neur = _nets[0].v_neur.size();
+    unsigned int dim = _nets[0].v_neur[0]->weights.size();
+    unsigned int dim_r = _nets[0].v_neur[0]->r_weights.size();
+    _store.resize( dim + dim_r, _nets.size() * _nb_neur );
+    for( unsigned int k = 0; k < _nets.size(); ++k) {
+      for( unsigned int i = 0; i < _nb_neur; ++i) {
+        RNeuron* neur = _nets[k].v_neur[i];
+        neur->bind_weights( &_store( 0, k * _nb_neur + i ));
+        neur->bind_r_weights( &_store( dim, k * _nb_neur + i ));
+      }
+    }
+  }
+  /** Stream inputs through nets, errors added in errors */
+  void run_on( std::vector<RNetwork>& nets, std::vector<Errors>& errors,
+               std::vector<Eigen::VectorXd>& inputs, bool learning,
+               unsigned int nb_thread )
+  {
+    utils::parallel::for_range( 0, nets.size(), nb_thread,
+                                [&] (unsigned int begin, unsigned int end) {
+      for( unsigned int k = begin; k < end; ++k) {
+        RNetwork& net = nets[k];
+        const Param& p = _params[k];
+        Errors& err = errors[k];
+        for( auto& input: inputs ) {
+          net.forward( input, p.beta, p.sig_input, p.sig_recur, p.sig_convo );
+          if( learning ) {
+            if( p.dsom ) {
+              net.deltaW( input, p.eps, p.ela, p.ela_rec );
+            }
+            else {
+              net.deltaWSOM( input, p.eps, p.sig_som );
+            }
+          }
+          err.input += net.get_winner_dist_input();
+          err.rec += net.get_winner_dist_rec();
+          err.pred += net.get_winner_dist_pred();
+          err.nb += 1;
+        }
+      }
+    });
+  }
+  /** Parameters of the replicas */
+  std::vector<Param> _params;
+  /** Contiguous store of the weights of all the replicas (see get_store) */
+  Eigen::MatrixXd _store;
+  unsigned int _nb_neur;
+  /** Replicas, created once (never reallocated), viewing _store */
+  std::vector<RNetwork> _nets;
+  /** Errors of each replica */
+  std::vector<Errors> _errors;
+  /** Copies of the replicas and their errors, for test_block() */
+  std::vector<RNetwork> _test_nets;
+  std::vector<Errors> _test_errors;
+}; // class Population
+// ***************************************************************************
+// ******************************************************************** params
+// ***************************************************************************
+/**
+ * Read a list of Population::Param from JSON.
+ * {"replicas": [ {"seed": 1, "typenet": "SOM", "beta": 0.5, "repeat": 3}, ...]}
+ * Missing fields keep their default value, 'repeat' creates copies with
+ * seed, seed+1, ...
+ */
+inline std::vector<Population::Param> unserialize_params( const rj::Value& obj )
+{
+  std::vector<Population::Param> params;
+  const rj::Value& replicas = obj["replicas"];
+  for( rj::SizeType i = 0; i < replicas.Size(); ++i) {
+    const rj::Value& r = replicas[i];
+    Population::Param p;
+    if( r.HasMember( "seed" )) p.seed = r["seed"].GetUint();
+    if( r.HasMember( "typenet" ))
+      p.dsom = (std::string( r["typenet"].GetString() ).compare( "DSOM" ) == 0);
+    if( r.HasMember( "beta" )) p.beta = r["beta"].GetDouble();
+    if( r.HasMember( "sig_i" )) p.sig_input = r["sig_i"].GetDouble();
+    if( r.HasMember( "sig_r" )) p.sig_recur = r["sig_r"].GetDouble();
+    if( r.HasMember( "sig_c" )) p.sig_convo = r["sig_c"].GetDouble();
+    if( r.HasMember( "sig_som" )) p.sig_som = r["sig_som"].GetDouble();
+    if( r.HasMember( "eps" )) p.eps = r["eps"].GetDouble();
+    if( r.HasMember( "ela" )) p.ela = r["ela"].GetDouble();
+    if( r.HasMember( "ela_rec" )) p.ela_rec = r["ela_rec"].GetDouble();
+    if( r.HasMember( "hn_eps" )) p.hn_eps = r["hn_eps"].GetDouble();
+
+    unsigned int repeat = 1;
+    if( r.HasMember( "repeat" )) repeat = r["repeat"].GetUint();
+    for( unsigned int n = 0; n < repeat; ++n) {
+      params.push_back( p );
+      p.seed += 1;
+    }
+  }
+  return params;
+}
+
+}; // namespace DSOM
+}; // namespace Model
+
+#endif // DSOM_POPULATION_HPP
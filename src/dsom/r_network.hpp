@@ -11,13 +11,15 @@
 #include <random>                   // std::uniform_int...
 #include <limits>                   // max dbl
 #include <algorithm>    // std::max
+#include <stdexcept>    // std::runtime_error
 
 #include <dsom/r_neuron.hpp>
 #include <dsom/utils.hpp>
+#include <parallel.hpp>             // utils::parallel::for_range
 
 #include "rapidjson/prettywriter.h" // rapidjson
 #include "rapidjson/document.h"     // rapidjson's DOM-style API
-#include <json_wrapper.hpp>         // JSON::OStreamWrapper et IStreamWrapper
+#include <json_wrapper.hpp>         // JSON::SaxHandler, JSON::parse
 namespace rj = rapidjson;
 
 
@@ -54,7 +56,11 @@ public:
     _sim_w(nb_neur,0.0), _sim_rec(nb_neur,0.0), _sim_merged(nb_neur,0.0),
     _sim_convol(nb_neur,0.0),
     _sim_hn_dist(nb_neur,0.0), _sim_hn_rec(nb_neur,0.0),
-    _winner_similarity(0.0)
+    _winner_similarity(0.0), _hn_epsilon(0.0),
+    _local_search(false), _local_radius(0), _local_window(3.0),
+    _nb_local_search(0), _nb_local_hit(0),
+    _symbol_cache(false), _cur_symbol(-1), _weight_epoch(0),
+    _nb_symbol_refresh(0), _nb_step_recall(0)
   {
     // Init Random Engine
     std::random_device rnd_seeder;
@@ -159,7 +165,16 @@ public:
     _sim_w(rn._sim_w), _sim_rec(rn._sim_rec), _sim_merged(rn._sim_merged),
     _sim_convol(rn._sim_convol), _sim_hn_dist(rn._sim_hn_dist),
     _sim_hn_rec(rn._sim_hn_rec),
-    _winner_similarity(rn._winner_similarity)
+    _winner_similarity(rn._winner_similarity),
+    _hn_epsilon(rn._hn_epsilon), _hn_candidates(rn._hn_candidates),
+    _local_search(rn._local_search), _local_radius(rn._local_radius),
+    _local_window(rn._local_window),
+    _nb_local_search(rn._nb_local_search), _nb_local_hit(rn._nb_local_hit),
+    _batch(rn._batch),
+    _symbol_cache(rn._symbol_cache), _symbols(rn._symbols),
+    _cur_symbol(-1), _weight_version(rn._weight_version),
+    _weight_epoch(rn._weight_epoch),
+    _nb_symbol_refresh(rn._nb_symbol_refresh), _nb_step_recall(rn._nb_step_recall)
   {
     for (auto it = rn.v_neur.begin(); it != rn.v_neur.end(); ++it) {
       RNeuron *neur = new RNeuron( **it );
@@ -168,7 +183,10 @@ public:
     
   }
     
-  /** Creation from JSON file */
+  /**
+   * Creation from JSON file, read in streaming (SAX).
+   * Throws std::runtime_error if the JSON is invalid.
+   */
   RNetwork( std::istream& is ) : 
     _winner_neur(0), _old_winner_neur(0), _pred_winner(0),
     _winner_dist(std::numeric_limits<double>::max()),
@@ -178,15 +196,16 @@ public:
     _sim_w(0,0.0), _sim_rec(0,0.0), _sim_merged(0,0.0),
     _sim_convol(0,0.0),
     _sim_hn_dist(0,0.0), _sim_hn_rec(0,0.0),
-    _winner_similarity(0.0)
+    _winner_similarity(0.0), _hn_epsilon(0.0),
+    _local_search(false), _local_radius(0), _local_window(3.0),
+    _nb_local_search(0), _nb_local_hit(0),
+    _symbol_cache(false), _cur_symbol(-1), _weight_epoch(0),
+    _nb_symbol_refresh(0), _nb_step_recall(0)
   {
-    // Wrapper pour lire document
-    JSON::IStreamWrapper instream(is);
-    // Parse into a document
-    rj::Document doc;
-    doc.ParseStream( instream );
-
-    unserialize( doc );
+    // Streaming (SAX), without DOM
+    Reader reader( *this );
+    JSON::parse( is, reader );
+    init_distances( reader.nb_neur() );
   }
   // **************************************************** RNetwork::destructor
   virtual ~RNetwork()
@@ -325,10 +344,11 @@ public:
     _sim_w.clear();
     _sim_rec.clear();
     _sim_merged.clear();
+    const Similarities* sim_in = _symbol_cache ? symbol_similarities( input, sig_input ) : nullptr;
     for( unsigned int i=0; i<v_neur.size(); ++i) {
       // std::cout << "      with i=" << i;
       // std::cout << " in=" << input << " sig_in=" << sig_input << std::endl;
-      auto simw = v_neur[i]->similaritiesInput( input, sig_input );
+      auto simw = sim_in ? (*sim_in)[i] : v_neur[i]->similaritiesInput( input, sig_input );
       _sim_w.push_back( simw );
 
       // std::cout << "      with i=" << i;
@@ -339,44 +359,160 @@ public:
       _sim_merged.push_back( sqrt( _sim_w[i] * (beta+(1-beta) * _sim_rec[i] )) );
       //LINEAR _sim_merged.push_back( _sim_w[i] * beta + (1.0 - beta) * _sim_rec[i] );
     }
+    // prediction would be based on _sim_rec alone
+    auto it_pred = std::max_element( _sim_rec.begin(), _sim_rec.end());
+    _pred_winner = std::distance( _sim_rec.begin(), it_pred );
+
     //std::cout << "     _convolution" << std::endl;
     // // Convolution with gaussian
     // integral of a.exp(-x^2/(2c^2)) = ac.sqrt(2.PI)
-    _sim_convol.clear();
-    for( int i=0; i< (int) v_neur.size(); i++) {
-      TNumber val = 0.0;
-      auto pos_i = v_neur[i]->r_pos(0);
-      for( int j=i-((int)v_neur.size())/2; j<i+(int)v_neur.size()/2; j++) {
-        auto pos_j = 0.0 + (TNumber) j / (TNumber) v_neur.size();
-        // TODO specific to 1D grid network
-        auto k = ((j < 0) ? j+v_neur.size() : j);
-        k = (k >= v_neur.size() ? k-v_neur.size() : k);
-
-        auto dist = (pos_i - pos_j) / 1.0 ;
-        // std::cout << "i,j,k=" << i<<", "<<j<<", "<<k<<" => "<<pos_i << " - " << pos_j;
-        // std::cout << " : " <<  exp( - (dist*dist) / (2.0 * sig_conv * sig_conv)) << " * " << _sim_merged[k];
-        val += _sim_merged[k] * exp( - (dist*dist) / (2.0 * sig_conv * sig_conv));
-        // std::cout << " --> " << val << " (" << (val / (sig_conv * sqrt(2*M_PI))) << ")" << std::endl;
-      }
-      //std::cout << "convol[" << i << "]=" << val << std::endl;
-      _sim_convol.push_back( val / (double) v_neur.size() ); /// (sig_conv * sqrt(2*M_PI)) );
-    }
     // TODO : normalize convolution ??
-	
-    // max and argmax
-    auto it_max = std::max_element( _sim_convol.begin(), _sim_convol.end() );
-    _winner_similarity = *it_max;
-    _winner_neur = std::distance( _sim_convol.begin(), it_max );
+    if( not (_local_search and _nb_link == -1 and computeWinnerLocal( sig_conv )) ) {
+      _sim_convol.clear();
+      for( int i=0; i< (int) v_neur.size(); i++) {
+        _sim_convol.push_back( convolution( i, sig_conv ) );
+      }
+
+      // max and argmax
+      auto it_max = std::max_element( _sim_convol.begin(), _sim_convol.end() );
+      _winner_similarity = *it_max;
+      _winner_neur = std::distance( _sim_convol.begin(), it_max );
+    }
     _winner_dist_input = v_neur[_winner_neur]->computeDistanceInput( input );
     _winner_dist_rec = v_neur[_winner_neur]->computeDistanceRPos( v_neur[_old_winner_neur]->r_pos );
-    // prediction would be based on _sim_rec alone
-    auto it_pred = std::max_element( _sim_rec.begin(), _sim_rec.end());
-    _pred_winner = std::distance( _sim_rec.begin(), it_pred );
     // Compare with the neuron what was predicted
     _winner_dist_pred = v_neur[_pred_winner]->computeDistanceInput( input );
 	
     return _winner_similarity;
   }
+  /**
+   * Convolution of _sim_merged with a gaussian, centered on neuron i.
+   * TODO specific to 1D grid network
+   */
+  TNumber convolution( int i, const TNumber& sig_conv )
+  {
+    TNumber val = 0.0;
+    auto pos_i = v_neur[i]->r_pos(0);
+    for( int j=i-((int)v_neur.size())/2; j<i+(int)v_neur.size()/2; j++) {
+      auto pos_j = 0.0 + (TNumber) j / (TNumber) v_neur.size();
+      auto k = ((j < 0) ? j+v_neur.size() : j);
+      k = (k >= v_neur.size() ? k-v_neur.size() : k);
+
+      auto dist = (pos_i - pos_j) / 1.0 ;
+      // std::cout << "i,j,k=" << i<<", "<<j<<", "<<k<<" => "<<pos_i << " - " << pos_j;
+      // std::cout << " : " <<  exp( - (dist*dist) / (2.0 * sig_conv * sig_conv)) << " * " << _sim_merged[k];
+      val += _sim_merged[k] * exp( - (dist*dist) / (2.0 * sig_conv * sig_conv));
+      // std::cout << " --> " << val << " (" << (val / (sig_conv * sqrt(2*M_PI))) << ")" << std::endl;
+    }
+    //std::cout << "convol[" << i << "]=" << val << std::endl;
+    return val / (double) v_neur.size(); /// (sig_conv * sqrt(2*M_PI)) );
+  }
+  /**
+   * Look for the max of the convolution outward from _pred_winner.
+   *
+   * The convolution of neuron i is bounded by the convolution restricted
+   * to a window of half-width w around i, plus max(_sim_merged) times the
+   * mass of the gaussian outside this window. In the window, the gaussian
+   * is bounded by a staircase of LOCAL_STEPS steps, so that the bound of
+   * every neuron comes from prefix sums of _sim_merged : O(n.LOCAL_STEPS)
+   * per step instead of O(n.w). The search stops when this bound, for all
+   * neurons not yet evaluated, is below the best convolution found (same
+   * winner as the full scan).
+   *
+   * Cost per step is thus O(n) for the bounds plus O(n) per evaluated
+   * neuron, on top of the similarities of all neurons (computeWinner) :
+   * not constant, but far from the O(n^2) of the full convolution.
+   *
+   * Return false (fall back to full scan) when no decision is reached
+   * within _local_radius of _pred_winner.
+   * Only _sim_convol of the evaluated neurons is computed, others are 0.
+   */
+  bool computeWinnerLocal( const TNumber& sig_conv )
+  {
+    int n = v_neur.size();
+    ++_nb_local_search;
+
+    // window, and mass of the gaussian outside the window
+    int w = std::min( (n-1)/2, (int) ceil( _local_window * sig_conv * n ));
+    auto gauss = [&] (int o) {
+      return exp( - ((TNumber) o/n) * ((TNumber) o/n) / (2.0 * sig_conv * sig_conv));
+    };
+    TNumber tail = 0.0;
+    for( int o = w+1; o <= n/2; ++o) {
+      tail += 2.0 * exp( - ((TNumber) o/n) * ((TNumber) o/n) / (2.0 * sig_conv * sig_conv));
+    }
+    tail *= *std::max_element( _sim_merged.begin(), _sim_merged.end() );
+
+    // steps [_local_step[s], _local_step[s+1]) of offsets in ]0,w],
+    // where the gaussian is at most gauss( _local_step[s] )
+    _local_step.clear();
+    _local_gauss.clear();
+    for( int s = 0; s <= LOCAL_STEPS; ++s) {
+      int o = 1 + (s * w) / LOCAL_STEPS;
+      if( _local_step.empty() or o > _local_step.back() ) {
+        _local_step.push_back( o );
+        _local_gauss.push_back( gauss( o ));
+      }
+    }
+    // circular prefix sums : _local_sum[k] = sum of _sim_merged[j mod n], j < k-n
+    _local_sum.assign( 3*n+1, 0.0 );
+    for( int k = 0; k < 3*n; ++k) {
+      _local_sum[k+1] = _local_sum[k] + _sim_merged[k % n];
+    }
+    auto sum = [&] (int from, int to) { // sum of [from, to), from >= -n
+      return _local_sum[to+n] - _local_sum[from+n];
+    };
+
+    // _local_bound[r] : max bound of neurons at ring distance >= r of pred
+    int p = _pred_winner;
+    _local_bound.assign( n/2+2, 0.0 );
+    for( int i = 0; i < n; ++i) {
+      TNumber val = _sim_merged[i];
+      for( unsigned int s = 0; s+1 < _local_step.size(); ++s) {
+        int a = _local_step[s];
+        int b = _local_step[s+1];
+        val += _local_gauss[s] * (sum( i+a, i+b ) + sum( i-b+1, i-a+1 ));
+      }
+      TNumber bound = (val + tail) / n * (1.0 + 1e-9) + 1e-12;
+      int r = std::abs( i - p );
+      r = std::min( r, n - r );
+      _local_bound[r] = std::max( _local_bound[r], bound );
+    }
+    for( int r = n/2; r >= 0; --r) {
+      _local_bound[r] = std::max( _local_bound[r], _local_bound[r+1] );
+    }
+
+    // outward search
+    _sim_convol.assign( n, 0.0 );
+    int best = -1;
+    TNumber best_val = 0.0;
+    for( int r = 0; r <= n/2; ++r) {
+      if( best >= 0 and _local_bound[r] < best_val ) {
+        ++_nb_local_hit;
+        _winner_neur = best;
+        _winner_similarity = best_val;
+        return true;
+      }
+      if( r > _local_radius ) {
+        return false;
+      }
+      int cand[2] = { (p - r + n) % n, (p + r) % n };
+      for( int c = 0; c < ((cand[0] == cand[1]) ? 1 : 2); ++c) {
+        int i = cand[c];
+        _sim_convol[i] = convolution( i, sig_conv );
+        if( best < 0 or _sim_convol[i] > best_val or
+            (_sim_convol[i] == best_val and i < best) ) {
+          best = i;
+          best_val = _sim_convol[i];
+        }
+      }
+    }
+    // all neurons have been evaluated
+    ++_nb_local_hit;
+    _winner_neur = best;
+    _winner_similarity = best_val;
+    return true;
+  }
   void forward( Eigen::VectorXd &input,
                 const RNeuron::TNumber& beta=1.0,
                 const TNumber& sig_input = 1.0,
@@ -390,6 +526,9 @@ public:
     }
 
     _old_winner_neur = _winner_neur;
+    if( _symbol_cache and recall_step( input, beta, sig_input, sig_recur, sig_conv )) {
+      return;
+    }
     computeWinner( input, beta, sig_input, sig_recur, sig_conv );
     if( verb ) {
       std::cout << "  => pred is " << _pred_winner;
@@ -411,6 +550,82 @@ public:
       //std::cout << "  n[" << i << "] din=" << dist_input << "; dr=" << dist_rec << std::endl;
     }
     //std::cout << "  MAX din=" << _max_dist_input << "; dr=" << _max_dist_rec << std::endl;
+    if( _symbol_cache ) memorize_step( beta, sig_recur, sig_conv );
+  }
+  // ************************************************** RNetwork::neighbourhood
+  /**
+   * Store in _hn_candidates the index of the neurons of the regular grid
+   * lying in the box of half-width 'radius' (in grid units) around 'center'.
+   * A negative radius, or a radius larger than the grid, means all neurons.
+   */
+  void computeNeighbourhood( unsigned int center, double radius )
+  {
+    _hn_candidates.clear();
+    if( radius < 0.0 || radius >= _max_dist_neurone ) {
+      for( unsigned int i = 0; i < v_neur.size(); ++i) {
+        _hn_candidates.push_back( i );
+      }
+      return;
+    }
+
+    int r = (int) ceil( radius );
+    if( _nb_link == -1 ) {
+      int c = (int) center;
+      for( int i = std::max( 0, c-r ); i <= std::min( _size_grid-1, c+r ); ++i) {
+        _hn_candidates.push_back( i );
+      }
+    }
+    else if( _nb_link == -2 ) {
+      int ci = (int) center / _size_grid;
+      int cj = (int) center % _size_grid;
+      for( int i = std::max( 0, ci-r ); i <= std::min( _size_grid-1, ci+r ); ++i) {
+        for( int j = std::max( 0, cj-r ); j <= std::min( _size_grid-1, cj+r ); ++j) {
+          _hn_candidates.push_back( i*_size_grid+j );
+        }
+      }
+    }
+  }
+  /**
+   * Radius of the neighbourhood adapted by deltaW : only neurones with
+   * hn > _hn_epsilon are adapted, ie those closer to the winner than
+   * ela * d_win * sqrt(-log(_hn_epsilon)). -1 (all neurons) if no _hn_epsilon.
+   */
+  double radiusW( double dist_input, double dist_rec,
+                  double ela, double ela_rec ) const
+  {
+    if( _hn_epsilon <= 0.0 ) return -1.0;
+    auto d_win_in = std::max( dist_input / _max_dist_input, 0.000001 );
+    auto d_win_rec = std::max( dist_rec / _max_dist_rec, 0.000001 );
+    return std::max( ela * d_win_in, ela_rec * d_win_rec )
+      * sqrt( -log( _hn_epsilon )) * _max_dist_neurone;
+  }
+  /**
+   * Radius of the neighbourhood adapted by deltaWSOM : only neurons with
+   * triangle_dist > _hn_epsilon are adapted, ie closer to the winner than
+   * sig_som * sqrt(1 - _hn_epsilon)
+   */
+  double radiusWSOM( double sig_som ) const
+  {
+    if( _hn_epsilon < 0.0 ) return -1.0;
+    return sig_som * sqrt( std::max( 0.0, 1.0 - _hn_epsilon )) * _max_dist_neurone;
+  }
+  /**
+   * Reset the neighbourhood similarities of the neurons updated at the
+   * previous step (all of them if the size of the network has changed).
+   */
+  void clear_hn_similarities()
+  {
+    if( _sim_hn_dist.size() != v_neur.size() ||
+        _sim_hn_rec.size() != v_neur.size() ) {
+      _sim_hn_dist.assign( v_neur.size(), 0.0 );
+      _sim_hn_rec.assign( v_neur.size(), 0.0 );
+    }
+    else {
+      for( auto& idx: _hn_candidates ) {
+        _sim_hn_dist[idx] = 0.0;
+        _sim_hn_rec[idx] = 0.0;
+      }
+    }
   }
   // ******************************************************* Network::backward
   double hnDistance( double dist_neur_win, double win_dist, double ela)
@@ -424,6 +639,7 @@ public:
   void deltaW( Eigen::VectorXd &input, double eps, double ela,
                double ela_rec = 1.0, bool verb=false)
   {
+    ++_weight_epoch;
     if( verb ) 
       std::cout << "__DeltaW" << std::endl;
     // TODO NON-Regular GRID
@@ -453,6 +669,7 @@ public:
           std::cout << " " << delta << "\tdW=" << utils::eigen::str_vec(delta_weight) << "\n";
         }      
         v_neur[(*i_neigh).index]->add_to_weights( delta_weight );
+        weights_changed( (*i_neigh).index );
       }
       if( verb ) {
         std::cout << "********\n";
@@ -460,8 +677,7 @@ public:
     }
     // REGULAR GRID
     else if (_nb_link < 0 ) {
-      _sim_hn_dist.clear();
-      _sim_hn_rec.clear();
+      clear_hn_similarities();
       if( verb ) {
         std::cout << "  ** max_dist_neur= " << _max_dist_neurone;
         std::cout << " max_dist_input= " << _max_dist_input;
@@ -475,8 +691,11 @@ public:
       auto old_win_rpos = v_neur[_old_winner_neur]->r_pos;
       //std::cout <<  "  old_win is " << _old_winner_neur << " at " << old_win_rpos << std::endl;
       
-      // All neurones will be adapted, difference betwenn weights and r_weights
-      for( unsigned int indn = 0; indn < v_neur.size(); indn++ ) {
+      computeNeighbourhood( _winner_neur,
+                            radiusW( _winner_dist_input, _winner_dist_rec, ela, ela_rec ));
+
+      // difference betwenn weights and r_weights
+      for( auto& indn: _hn_candidates ) {
         // normalized distance to input (ie with weights)
         auto dnorm_in = v_neur[indn]->computeDistanceInput( input ) / _max_dist_input;
         // normalized distance to previous winner (ie with r_weights)
@@ -484,11 +703,13 @@ public:
 
         // hn_distance
         auto hn_input = hnDistance( v_neur[indn]->computeDistancePos( *(v_neur[_winner_neur]) ) /_max_dist_neurone, _winner_dist_input / _max_dist_input, ela );
-        _sim_hn_dist.push_back( hn_input );
-	
+        if( hn_input <= _hn_epsilon ) hn_input = 0.0;
+        _sim_hn_dist[indn] = hn_input;
+
         auto hn_rec = hnDistance( v_neur[indn]->computeDistancePos( *(v_neur[_winner_neur]) ) /_max_dist_neurone, _winner_dist_rec / _max_dist_rec, ela_rec );
-        _sim_hn_rec.push_back( hn_rec );
-	
+        if( hn_rec <= _hn_epsilon ) hn_rec = 0.0;
+        _sim_hn_rec[indn] = hn_rec;
+
         // Delta W / RecWeights
         auto delta_w = eps * dnorm_in * hn_input * (input - v_neur[indn]->weights);
         auto delta_rw = eps * dnorm_rec * hn_rec * (old_win_rpos - v_neur[indn]->r_weights);
@@ -498,9 +719,12 @@ public:
           std::cout << "    dist_pos_win=" <<  v_neur[indn]->computeDistancePos( *(v_neur[_winner_neur])) << std::endl;
           std::cout << "    INPUT: dnorm= " << dnorm_in << "; hn=" << hn_input << " => delta=" << delta_w << std::endl;
           std::cout << "    REC  : dnorm= " << dnorm_rec << "; hn=" << hn_rec << " =>  delta=" << delta_rw << std::endl;
-        }      
-        v_neur[indn]->add_to_weights( delta_w );
-        v_neur[indn]->add_to_r_weights( delta_rw );
+        }
+        if( hn_input > 0.0 ) {
+          v_neur[indn]->add_to_weights( delta_w );
+          weights_changed( indn );
+        }
+        if( hn_rec > 0.0 ) v_neur[indn]->add_to_r_weights( delta_rw );
       }
     }
 
@@ -523,6 +747,7 @@ public:
   void deltaWSOM( Eigen::VectorXd& input, double eps, double sig_som,
                   bool verb = false)
   {
+    ++_weight_epoch;
     if( verb )
       std::cout << "__DeltaWSOM" << std::endl;
 
@@ -533,8 +758,7 @@ public:
     // Regular grid
     else if (_nb_link < 0) {
       // store distances
-      _sim_hn_dist.clear();
-      _sim_hn_rec.clear();
+      clear_hn_similarities();
 
       if (verb) {
         std::cout << "  ** max_dist_neur= " << _max_dist_neurone;
@@ -549,12 +773,13 @@ public:
       // Pos of previous winner
       auto old_win_rpos = v_neur[_old_winner_neur]->r_pos;
       
-      // All neurons are adapted
-      for( unsigned int indn=0; indn < v_neur.size(); ++indn ) {
+      computeNeighbourhood( _winner_neur, radiusWSOM( sig_som ));
+      for( auto& indn: _hn_candidates ) {
         // distance to winner
         auto dist_winner = triangle_dist( v_neur[indn]->computeDistancePos( *(v_neur[_winner_neur]) ) / _max_dist_neurone, sig_som );
-        _sim_hn_dist.push_back( dist_winner );
-        _sim_hn_rec.push_back( dist_winner );
+        if( dist_winner <= _hn_epsilon ) continue;
+        _sim_hn_dist[indn] = dist_winner;
+        _sim_hn_rec[indn] = dist_winner;
 
         // delta
         auto delta_w  = eps * dist_winner * (input - v_neur[indn]->weights);
@@ -570,9 +795,150 @@ public:
         
         v_neur[indn]->add_to_weights( delta_w );
         v_neur[indn]->add_to_r_weights( delta_rw );
+        weights_changed( indn );
       }
     }
   }
+  // ********************************************************* RNetwork::batch
+  /**
+   * Block learning: forward() is called on a block of inputs with the
+   * weights frozen, each step being stored by batch_push(). Then
+   * deltaWBatch() or deltaWSOMBatch() apply the SUM of the deltas of all
+   * the steps of the block, once (in parallel over neurons), as the same
+   * online steps would with frozen weights. A neuron whose total gain
+   * (sum of the coefficients of (input - w)) exceeds 1 moves to the
+   * weighted mean of its inputs instead (as in batch-SOM) : large blocks
+   * do not overshoot.
+   * Only the neurons in the neighbourhood (computeNeighbourhood, cf
+   * _hn_epsilon) of at least one winner of the block are visited.
+   * No backpropagation through time: each step uses its own winner and
+   * previous winner, as given by forward().
+   * Regular grids only : std::runtime_error on a NON-regular grid (which
+   * forward() does not handle either).
+   */
+  void batch_push( Eigen::VectorXd& input )
+  {
+    BatchStep step;
+    step.input = input;
+    step.winner = _winner_neur;
+    step.old_winner = _old_winner_neur;
+    step.dist_input = _winner_dist_input;
+    step.dist_rec = _winner_dist_rec;
+    _batch.push_back( step );
+  }
+  unsigned int batch_size() const { return _batch.size(); }
+  void batch_clear() { _batch.clear(); }
+  /** sum of deltaW over the stored steps */
+  void deltaWBatch( double eps, double ela, double ela_rec = 1.0,
+                    unsigned int nb_thread = 1 )
+  {
+    if( _batch.empty() ) return;
+    ++_weight_epoch;
+    // NON-Regular GRID
+    if( _nb_link > 0 ) {
+      _batch.clear();
+      throw std::runtime_error( "RNetwork::deltaWBatch: regular grid only" );
+    }
+    // REGULAR GRID
+    else if( _nb_link < 0 ) {
+      std::vector<double> radius;
+      for( auto& step: _batch ) {
+        radius.push_back( radiusW( step.dist_input, step.dist_rec, ela, ela_rec ));
+      }
+      batch_neighbourhood( radius );
+      unsigned int last = _batch.size() - 1;
+      utils::parallel::for_range( 0, _hn_candidates.size(), nb_thread,
+                                  [&] (unsigned int begin, unsigned int end) {
+        for( unsigned int k = begin; k < end; ++k) {
+          unsigned int indn = _hn_candidates[k];
+          BatchDelta delta( *v_neur[indn] );
+          for( unsigned int t = 0; t < _batch.size(); ++t) {
+            BatchStep& step = _batch[t];
+            auto& old_win_rpos = v_neur[step.old_winner]->r_pos;
+            auto dist_pos = v_neur[indn]->computeDistancePos( *(v_neur[step.winner]) ) / _max_dist_neurone;
+
+            auto hn_input = hnDistance( dist_pos, step.dist_input / _max_dist_input, ela );
+            if( hn_input <= _hn_epsilon ) hn_input = 0.0;
+            auto hn_rec = hnDistance( dist_pos, step.dist_rec / _max_dist_rec, ela_rec );
+            if( hn_rec <= _hn_epsilon ) hn_rec = 0.0;
+            if( t == last ) {
+              _sim_hn_dist[indn] = hn_input;
+              _sim_hn_rec[indn] = hn_rec;
+            }
+
+            if( hn_input > 0.0 ) {
+              auto dnorm_in = v_neur[indn]->computeDistanceInput( step.input ) / _max_dist_input;
+              delta.add_w( eps * dnorm_in * hn_input, step.input );
+            }
+            if( hn_rec > 0.0 ) {
+              auto dnorm_rec = v_neur[indn]->computeDistanceRPos( old_win_rpos ) / _max_dist_rec;
+              delta.add_rw( eps * dnorm_rec * hn_rec, old_win_rpos );
+            }
+          }
+          delta.apply( *v_neur[indn] );
+          weights_changed( indn );
+        }
+      });
+    }
+    _batch.clear();
+  }
+  /** sum of deltaWSOM over the stored steps */
+  void deltaWSOMBatch( double eps, double sig_som, unsigned int nb_thread = 1 )
+  {
+    if( _batch.empty() ) return;
+    ++_weight_epoch;
+    // Non-regular grid
+    if (_nb_link > 0 ) {
+      _batch.clear();
+      throw std::runtime_error( "RNetwork::deltaWSOMBatch: regular grid only" );
+    }
+    // Regular grid
+    else if (_nb_link < 0) {
+      batch_neighbourhood( std::vector<double>( _batch.size(), radiusWSOM( sig_som )));
+      unsigned int last = _batch.size() - 1;
+      utils::parallel::for_range( 0, _hn_candidates.size(), nb_thread,
+                                  [&] (unsigned int begin, unsigned int end) {
+        for( unsigned int k = begin; k < end; ++k) {
+          unsigned int indn = _hn_candidates[k];
+          BatchDelta delta( *v_neur[indn] );
+          for( unsigned int t = 0; t < _batch.size(); ++t) {
+            BatchStep& step = _batch[t];
+            auto dist_winner = triangle_dist( v_neur[indn]->computeDistancePos( *(v_neur[step.winner]) ) / _max_dist_neurone, sig_som );
+            if( dist_winner <= _hn_epsilon ) continue;
+            if( t == last ) {
+              _sim_hn_dist[indn] = dist_winner;
+              _sim_hn_rec[indn] = dist_winner;
+            }
+            delta.add_w( eps * dist_winner, step.input );
+            delta.add_rw( eps * dist_winner, v_neur[step.old_winner]->r_pos );
+          }
+          delta.apply( *v_neur[indn] );
+          weights_changed( indn );
+        }
+      });
+    }
+    _batch.clear();
+  }
+  /**
+   * _hn_candidates : neurons in the neighbourhood of the winner of at least
+   * one step of the block ('radius' for each step), after the similarities
+   * of the previous candidates have been reset.
+   */
+  void batch_neighbourhood( const std::vector<double>& radius )
+  {
+    clear_hn_similarities();
+    std::vector<char> in_hn( v_neur.size(), 0 );
+    for( unsigned int t = 0; t < _batch.size(); ++t) {
+      computeNeighbourhood( _batch[t].winner, radius[t] );
+      if( _hn_candidates.size() == v_neur.size() ) break;
+      for( auto& idx: _hn_candidates ) in_hn[idx] = 1;
+    }
+    if( _hn_candidates.size() == v_neur.size() ) return;
+    _hn_candidates.clear();
+    for( unsigned int i = 0; i < v_neur.size(); ++i) {
+      if( in_hn[i] ) _hn_candidates.push_back( i );
+    }
+  }
   // ********************************************************** Network::is_in
   bool is_in( unsigned int elem,  std::list<unsigned int> ll )
   {
@@ -622,7 +988,11 @@ public:
       v_neur.push_back(neur);
     }
 
-    // Now, eventually links and distance
+    init_distances( nb_neur );
+  }
+  /** After reading the neurons : eventually links and distance */
+  void init_distances( int nb_neur )
+  {
     // NON-Regular GRID
     if( _nb_link > 0 ) {
       _max_dist_neurone = 1.0;
@@ -650,6 +1020,154 @@ public:
   double get_winner_dist_pred() const { return _winner_dist_pred; }
   double get_max_dist_neurone() { return _max_dist_neurone; }
   int get_size_grid() const { return _size_grid; }
+  /** Neighbourhood coefficient under which neurons are not updated
+   * (negative means that all neurons are updated) */
+  void set_hn_epsilon( double hn_epsilon ) { _hn_epsilon = hn_epsilon; }
+  double get_hn_epsilon() const { return _hn_epsilon; }
+  /** Local search of the winner around the predicted winner (1D grid) */
+  void set_local_search( bool local_search, int radius, double window=3.0 )
+  {
+    _local_search = local_search;
+    _local_radius = radius;
+    _local_window = window;
+  }
+  bool get_local_search() const { return _local_search; }
+  /** Ratio of local searches that did not need a full scan */
+  double get_local_hit_rate() const
+  {
+    if( _nb_local_search == 0 ) return 0.0;
+    return (double) _nb_local_hit / (double) _nb_local_search;
+  }
+  unsigned long get_nb_local_search() const { return _nb_local_search; }
+  void reset_local_stats()
+  {
+    _nb_local_search = 0;
+    _nb_local_hit = 0;
+  }
+  /**
+   * Cache the input similarities of all neurons for each distinct input
+   * (discrete alphabet, at most SYMBOL_CACHE_MAX symbols, other inputs
+   * are not cached). A cached similarity is recomputed only when the
+   * weights of its neuron changed since it was computed : deltaW,
+   * deltaWSOM and the batch updates call weights_changed().
+   * With frozen weights (test), the result of forward() only depends on
+   * the input and the previous winner : it is also memorized for each
+   * (symbol, previous winner), and recalled as long as no update of the
+   * weights happened since. A recalled step does not refresh _sim_*.
+   * Weights written by any other mean (v_neur[i]->weights, Population
+   * store) need invalidate_symbol_cache().
+   */
+  void set_symbol_cache( bool symbol_cache )
+  {
+    _symbol_cache = symbol_cache;
+    invalidate_symbol_cache();
+  }
+  bool get_symbol_cache() const { return _symbol_cache; }
+  void invalidate_symbol_cache()
+  {
+    _symbols.clear();
+    _cur_symbol = -1;
+    _weight_version.clear();
+  }
+  /** Weights of neuron idx have changed : its cached similarities are stale */
+  void weights_changed( unsigned int idx )
+  {
+    if( _symbol_cache and idx < _weight_version.size() ) ++_weight_version[idx];
+  }
+  /** Number of similarities computed by the cache */
+  unsigned long get_nb_symbol_refresh() const { return _nb_symbol_refresh; }
+  /** Number of forward() recalled from the cache */
+  unsigned long get_nb_step_recall() const { return _nb_step_recall; }
+private:
+  /** Entry of 'input' in _symbols, -1 if none */
+  int find_symbol( const RNeuron::TWeight& input, TNumber sig_input ) const
+  {
+    for( unsigned int k = 0; k < _symbols.size(); ++k) {
+      if( _symbols[k].sig_input == sig_input and
+          _symbols[k].input.size() == input.size() and _symbols[k].input == input ) {
+        return k;
+      }
+    }
+    return -1;
+  }
+  /** Recall the winners of a memorized step (false if none) */
+  bool recall_step( const RNeuron::TWeight& input, TNumber beta,
+                    TNumber sig_input, TNumber sig_recur, TNumber sig_conv )
+  {
+    _cur_symbol = find_symbol( input, sig_input );
+    if( _cur_symbol < 0 or _old_winner_neur >= _symbols[_cur_symbol].steps.size() ) {
+      return false;
+    }
+    const StepMemo& m = _symbols[_cur_symbol].steps[_old_winner_neur];
+    if( m.epoch != _weight_epoch or m.beta != beta or m.sig_recur != sig_recur
+        or m.sig_conv != sig_conv ) {
+      return false;
+    }
+    _winner_neur = m.winner;
+    _pred_winner = m.pred_winner;
+    _winner_similarity = m.similarity;
+    _winner_dist_input = m.dist_input;
+    _winner_dist_rec = m.dist_rec;
+    _winner_dist_pred = m.dist_pred;
+    ++_nb_step_recall;
+    return true;
+  }
+  /** Memorize the step just computed by forward() for _cur_symbol */
+  void memorize_step( TNumber beta, TNumber sig_recur, TNumber sig_conv )
+  {
+    if( _cur_symbol < 0 ) return;
+    auto& steps = _symbols[_cur_symbol].steps;
+    if( steps.size() != v_neur.size() ) {
+      StepMemo none;
+      none.epoch = std::numeric_limits<unsigned long>::max();
+      steps.assign( v_neur.size(), none );
+    }
+    StepMemo& m = steps[_old_winner_neur];
+    m.epoch = _weight_epoch;
+    m.beta = beta;
+    m.sig_recur = sig_recur;
+    m.sig_conv = sig_conv;
+    m.winner = _winner_neur;
+    m.pred_winner = _pred_winner;
+    m.similarity = _winner_similarity;
+    m.dist_input = _winner_dist_input;
+    m.dist_rec = _winner_dist_rec;
+    m.dist_pred = _winner_dist_pred;
+  }
+  /**
+   * Up to date input similarities of all neurons for 'input', or nullptr
+   * if the input is not (and can not be) cached.
+   */
+  const Similarities* symbol_similarities( const RNeuron::TWeight& input,
+                                           TNumber sig_input )
+  {
+    if( _weight_version.size() != v_neur.size() ) {
+      invalidate_symbol_cache();
+      _weight_version.assign( v_neur.size(), 0 );
+    }
+    _cur_symbol = find_symbol( input, sig_input );
+    if( _cur_symbol < 0 ) {
+      if( _symbols.size() >= SYMBOL_CACHE_MAX ) return nullptr;
+      _cur_symbol = _symbols.size();
+      _symbols.push_back( SymbolEntry() );
+    }
+    SymbolEntry* entry = &_symbols[_cur_symbol];
+    if( entry->sim.empty() ) {
+      entry->input = input;
+      entry->sig_input = sig_input;
+      entry->sim.assign( v_neur.size(), 0.0 );
+      // versions never reached : all computed below
+      entry->version.assign( v_neur.size(), std::numeric_limits<unsigned long>::max() );
+    }
+    for( unsigned int i = 0; i < v_neur.size(); ++i) {
+      if( entry->version[i] != _weight_version[i] ) {
+        entry->sim[i] = v_neur[i]->similaritiesInput( input, sig_input );
+        entry->version[i] = _weight_version[i];
+        ++_nb_symbol_refresh;
+      }
+    }
+    return &(entry->sim);
+  }
 private:
   /** Random engine */
   std::default_random_engine _rnd;
@@ -684,6 +1202,150 @@ public:
   std::vector<RNeuron::TNumber> _sim_hn_rec;
   /** Similarity with the Winner */
   double _winner_similarity;
+  /** Neurons with a neighbourhood coefficient <= _hn_epsilon are not updated */
+  double _hn_epsilon;
+  /** Neurons around the winner considered by the last update */
+  std::vector<unsigned int> _hn_candidates;
+  /** Winner searched outward from _pred_winner, up to _local_radius,
+   * with bounds computed on windows of _local_window * sig_conv */
+  bool _local_search;
+  int _local_radius;
+  double _local_window;
+  /** Number of local searches and of those that did not fall back */
+  unsigned long _nb_local_search, _nb_local_hit;
+  /** Staircase bounding the gaussian : steps, their value, prefix sums */
+  static const int LOCAL_STEPS = 8;
+  std::vector<int> _local_step;
+  std::vector<RNeuron::TNumber> _local_gauss;
+  std::vector<RNeuron::TNumber> _local_sum;
+  std::vector<RNeuron::TNumber> _local_bound;
+  /** Steps stored for block learning */
+  struct BatchStep {
+    Eigen::VectorXd input;
+    unsigned int winner, old_winner;
+    double dist_input, dist_rec;
+  };
+  std::vector<BatchStep> _batch;
+  /** Winners of forward() for one symbol and one previous winner */
+  struct StepMemo {
+    /** _weight_epoch when computed */
+    unsigned long epoch;
+    TNumber beta, sig_recur, sig_conv;
+    unsigned int winner, pred_winner;
+    TNumber similarity, dist_input, dist_rec, dist_pred;
+  };
+  /** Input similarities of all neurons for one input symbol */
+  struct SymbolEntry {
+    RNeuron::TWeight input;
+    TNumber sig_input;
+    Similarities sim;
+    /** _weight_version of each neuron when sim was computed */
+    std::vector<unsigned long> version;
+    /** Memorized steps, indexed by previous winner */
+    std::vector<StepMemo> steps;
+  };
+  static const unsigned int SYMBOL_CACHE_MAX = 64;
+  bool _symbol_cache;
+  std::vector<SymbolEntry> _symbols;
+  /** Entry of the current input in _symbols (-1 if none) */
+  int _cur_symbol;
+  /** Incremented each time the weights of a neuron change */
+  std::vector<unsigned long> _weight_version;
+  /** Incremented by each update of the weights (deltaW...) */
+  unsigned long _weight_epoch;
+  unsigned long _nb_symbol_refresh, _nb_step_recall;
+  /**
+   * Sum of the deltas of one neuron over a block : sum_t a_t (x_t - w),
+   * divided by sum_t a_t when the latter exceeds 1.
+   */
+  struct BatchDelta {
+    BatchDelta( const RNeuron& n ) :
+      w( n.weights ), rw( n.r_weights ),
+      sum_w( Eigen::VectorXd::Zero( n.weights.size() )),
+      sum_rw( Eigen::VectorXd::Zero( n.r_weights.size() )),
+      gain_w( 0.0 ), gain_rw( 0.0 )
+    {}
+    void add_w( double a, const Eigen::VectorXd& x )
+    {
+      sum_w += a * (x - w);
+      gain_w += a;
+    }
+    void add_rw( double a, const RNeuron::TRPos& x )
+    {
+      sum_rw += a * (x - rw);
+      gain_rw += a;
+    }
+    void apply( RNeuron& n ) const
+    {
+      if( gain_w > 0.0 ) n.add_to_weights( sum_w / std::max( 1.0, gain_w ));
+      if( gain_rw > 0.0 ) n.add_to_r_weights( sum_rw / std::max( 1.0, gain_rw ));
+    }
+    const RNeuron::TWeightMap& w;
+    const RNeuron::TRWeightMap& rw;
+    Eigen::VectorXd sum_w, sum_rw;
+    double gain_w, gain_rw;
+  };
+
+  // ******************************************************** RNetwork::Reader
+  /**
+   * SAX reader of a serialized RNetwork (see serialize()) : neurons are
+   * created and filled while the file is read, without DOM.
+   */
+  class Reader : public JSON::SaxHandler
+  {
+  public:
+    Reader( RNetwork& net ) : _net(net), _nb_neur(0), _neigh_index(0)
+    {
+      for( auto& n: _net.v_neur ) delete n;
+      _net.v_neur.clear();
+    }
+    int nb_neur() const { return _nb_neur; }
+    bool number( double v ) override
+    {
+      if( depth() == 1 ) {
+        if( at( 0, "nb_neur" )) _nb_neur = v;
+        else if( at( 0, "nb_link" )) _net._nb_link = v;
+        else if( at( 0, "size_grid" )) _net._size_grid = v;
+        else if( at( 0, "max_dist_input" )) _net._max_dist_input = v;
+        return true;
+      }
+      if( not at( 0, "r_neurons" ) or _net.v_neur.empty() ) return true;
+      RNeuron* neur = _net.v_neur.back();
+      if( depth() == 3 and at( 2, "id" )) neur->index = v;
+      else if( depth() == 4 and at( 2, "link" )) neur->l_link.push_back( v );
+      else if( depth() == 4 ) _values.push_back( v );
+      else if( depth() == 5 and at( 2, "neighbors" )) {
+        if( index( 4 ) == 0 ) _neigh_index = v;
+        else neur->add_neighbor( _neigh_index, v );
+      }
+      return true;
+    }
+    bool start( bool is_array ) override
+    {
+      if( depth() == 2 and at( 0, "r_neurons" )) {
+        _net.v_neur.push_back( new RNeuron() );
+      }
+      _values.clear();
+      return true;
+    }
+    bool end( bool is_array ) override
+    {
+      if( depth() != 3 or not at( 0, "r_neurons" )) return true;
+      RNeuron* neur = _net.v_neur.back();
+      Eigen::Map<Eigen::VectorXd> values( _values.data(), _values.size() );
+      if( at( 2, "weights" )) neur->set_weights( values );
+      else if( at( 2, "pos" )) neur->_pos = values.cast<int>();
+      else if( at( 2, "r_pos" )) neur->r_pos = values;
+      else if( at( 2, "r_weights" )) neur->set_r_weights( values );
+      return true;
+    }
+  private:
+    RNetwork& _net;
+    int _nb_neur;
+    /** Values of the current array of the current neuron */
+    std::vector<double> _values;
+    unsigned int _neigh_index;
+  };
 }; // class RNetwork
 }; // namespace DSOM
 }; // namespace Model
@@ -30,6 +30,7 @@ public:
   using TNumber  = double;
   using TWeight  = Eigen::VectorXd;
   using TRWeight = Eigen::VectorXd;
+  using TRWeightMap = Eigen::Map<TRWeight>;
   using TPos     = Eigen::VectorXi;
   using TRPos    = Eigen::VectorXd;
 public:
@@ -39,12 +40,12 @@ public:
    * RWeights are in [0,1]^dim
    */
   RNeuron( int index, int dim_weights, TNumber w_min=0, TNumber w_max=1) :
-    Neuron(index,dim_weights,w_min,w_max)
+    Neuron(index,dim_weights,w_min,w_max), r_weights(nullptr, 0)
   {
     //std::cerr << "Create RNeurone " << index << "\n";
     
     // Generate r_weights between 0 and 1 (Eigen) ^ dim (TODO=1)
-    this->r_weights = Eigen::VectorXd::Random(1);
+    this->set_r_weights( Eigen::VectorXd::Random(1) );
     // Scale (TODO dim=1)
     this->r_weights= (this->r_weights.array() - -1.0) / (1.0 - -1.0) * (1.0 - 0.0) + 0.0;
 
@@ -57,13 +58,13 @@ public:
    */
   RNeuron( int index, const Eigen::Ref<const TPos>& pos,
 	  int dim_weights, TNumber w_min=0, TNumber w_max=1) :
-    Neuron( index, pos, dim_weights, w_min, w_max)
+    Neuron( index, pos, dim_weights, w_min, w_max), r_weights(nullptr, 0)
   {
     //std::cerr << "Create RNeurone " << index << "\n";
 
     auto dim = _pos.size();
     // Generate r_weights between 0 and 1 (Eigen) ^ dim_pos
-    this->r_weights = Eigen::VectorXd::Random(dim);
+    this->set_r_weights( Eigen::VectorXd::Random(dim) );
     // Scale
     this->r_weights= (this->r_weights.array() - -1.0) / (1.0 - -1.0) * (1.0 - 0.0) + 0.0;
 
@@ -71,10 +72,11 @@ public:
 	r_pos = TRPos( _pos.size() );
     
   }
-  /** Creation with copy */
+  /** Creation with copy (weights in its own storage) */
   RNeuron( const RNeuron& n ) :
-    Neuron( n ), r_pos(n.r_pos), r_weights( n.r_weights )
+    Neuron( n ), r_pos(n.r_pos), r_weights(nullptr, 0)
   {
+    set_r_weights( n.r_weights );
   }
   /** Creation from assignment */
   RNeuron& operator=( const RNeuron& n )
@@ -84,20 +86,24 @@ public:
       l_link = n.l_link;
       l_neighbors = n.l_neighbors;
       _pos = n._pos;
-      weights = n.weights;
+      set_weights( n.weights );
 	  r_pos = n.r_pos;
-      r_weights = n.r_weights;
+      set_r_weights( n.r_weights );
     }
     return *this;
   }
+  /** Empty Neuron, to be filled (as from JSON, see RNetwork::Reader) */
+  RNeuron() : Neuron(0,1), r_weights(nullptr, 0)
+  {
+  }
   /** Creation from JSON doc */
-  RNeuron( const rj::Value& obj ) : Neuron(0,1)
+  RNeuron( const rj::Value& obj ) : Neuron(0,1), r_weights(nullptr, 0)
   {
     // decode d'après obj
     this->unserialize( obj );
   }
   /** Creation from JSON file */
-  RNeuron( std::istream& is ) : Neuron(0,1)
+  RNeuron( std::istream& is ) : Neuron(0,1), r_weights(nullptr, 0)
   {
     // Wrapper pour lire document
     JSON::IStreamWrapper instream(is);
@@ -197,10 +203,11 @@ public:
     // RWeights
     const rj::Value& rw = obj["r_weights"];
     assert( rw.IsArray() );
-    this->r_weights.resize( rw.Size() );
+    TRWeight values( rw.Size() );
     for( unsigned int i = 0; i < rw.Size(); ++i) {
-      this->r_weights(i) = rw[i].GetDouble();
+      values(i) = rw[i].GetDouble();
     }
+    set_r_weights( values );
   }
   // *************************************************** RNeuron::similarities
   TNumber similaritiesInput( const TWeight& input, const TNumber& sigma )
@@ -226,11 +233,34 @@ public:
   {
     this->r_weights = this->r_weights +  delta_rweight;
   }
+  // ******************************************************** RNeuron::storage
+  /** Set the r_weights (same rules as Neuron::set_weights) */
+  void set_r_weights( const Eigen::Ref<const TRWeight>& rw )
+  {
+    if( rw.size() == r_weights.size() ) {
+      r_weights = rw;
+    }
+    else {
+      _own_r_weights = rw;
+      new (&r_weights) TRWeightMap( _own_r_weights.data(), _own_r_weights.size() );
+    }
+  }
+  /** Move the r_weights to 'data' (same rules as Neuron::bind_weights) */
+  void bind_r_weights( TNumber* data )
+  {
+    TRWeightMap ext( data, r_weights.size() );
+    ext = r_weights;
+    new (&r_weights) TRWeightMap( data, ext.size() );
+    _own_r_weights.resize( 0 );
+  }
   // ***************************************************** RNeuron::attributes
   /** RPos */
   TRPos r_pos;
-  /** RWeights */
-  TRWeight r_weights;
+  /** RWeights (view on their storage) */
+  TRWeightMap r_weights;
+private:
+  /** Own storage of the r_weights (empty when bound to an external store) */
+  TRWeight _own_r_weights;
 };
 // ******************************************************************* RNeuron
 // ***************************************************************************
@@ -9,6 +9,7 @@
  * for neuron weigts and r_weigts, according to a queue.
  *
  * Warning : only on 1D-grid RNetwork.
+ * render_soft draws the same in a SoftCanvas.
  */
 #include <curve.hpp>
 
@@ -47,7 +48,8 @@ public:
 	      -1.5 * _radius, 1.5 * _radius };
   }
   // ************************************************ RDSomviewer::plot_neuron
-  void plot_neuron( RNeuron& neur )
+  /** In 'canvas', or with OpenGL if nullptr */
+  void plot_neuron( RNeuron& neur, SoftCanvas* canvas = nullptr )
   {
     // Position of the neuron
     const Pt2D npos
@@ -59,20 +61,31 @@ public:
 	_radius * sin( neur.r_weights(0) * (_ang_max - _ang_min)+_ang_min) };
 
     // A small disc à neuron position, color according to weights
-    draw_circle( npos,
+    draw_circle( canvas, npos,
 		 Color{neur.weights(0), neur.weights(0), neur.weights(0)},
 		 _radius_inner);
     // and an arrow pointing to neuron
-    draw_vector( fpos, npos );
+    draw_vector( canvas, fpos, npos );
     
   }
   // ***************************************************** RDSomviewer::render
   void render( float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  {
+    draw( nullptr );
+  }
+  void render_soft( SoftCanvas& canvas,
+                    float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  {
+    canvas.line_width( 1.0 );
+    draw( &canvas );
+  }
+  /** In 'canvas', or with OpenGL if nullptr */
+  void draw( SoftCanvas* canvas )
   {
     //std::cout << "  RDSOMViewer::draw_back()" << std::endl;
-    draw_back( _radius );
+    draw_back( canvas, _radius );
     for( auto& idx: _win_buffer) {
-      plot_neuron( *(_rdsom.v_neur[idx]) );
+      plot_neuron( *(_rdsom.v_neur[idx]), canvas );
     }
     //plot_neuron( *(_rdsom.v_neur[0]) );
     //plot_neuron( *(_rdsom.v_neur[5]) );
@@ -92,39 +105,66 @@ public:
   double _radius_inner; // small circles
 private:
   // ******************************************** RDSOMviewer::graphic_utility
-  void draw_circle( const Pt2D& pt, const Color& col,
+  // In 'canvas', or with OpenGL if nullptr
+  static void _color( SoftCanvas* canvas, double r, double g, double b )
+  {
+    if( canvas ) canvas->color( r, g, b );
+    else glColor3d( r, g, b );
+  }
+  static void _begin( SoftCanvas* canvas, GLenum mode )
+  {
+    if( not canvas ) {
+      glBegin( mode );
+      return;
+    }
+    switch( mode ) {
+    case GL_LINES: canvas->begin( SoftCanvas::LINES ); break;
+    case GL_LINE_STRIP: canvas->begin( SoftCanvas::LINE_STRIP ); break;
+    case GL_TRIANGLES: canvas->begin( SoftCanvas::TRIANGLES ); break;
+    default: canvas->begin( SoftCanvas::TRIANGLE_FAN ); break;
+    }
+  }
+  static void _vertex( SoftCanvas* canvas, double x, double y )
+  {
+    if( canvas ) canvas->vertex( x, y );
+    else glVertex3d( x, y, 0.0 );
+  }
+  static void _end( SoftCanvas* canvas )
+  {
+    if( canvas ) canvas->end();
+    else glEnd();
+  }
+  void draw_circle( SoftCanvas* canvas, const Pt2D& pt, const Color& col,
 		    const double radius = 0.05,
 		    unsigned int nb_side=16)
   {
     
     // Inner_cirle
-    glColor3d( col.r, col.g, col.b );
-    glBegin(GL_TRIANGLE_FAN); {
-      glVertex3d( pt.x, pt.y, 0.0);
-      glVertex3d( pt.x + radius, pt.y, 0.0);
+    _color( canvas, col.r, col.g, col.b );
+    _begin( canvas, GL_TRIANGLE_FAN); {
+      _vertex( canvas, pt.x, pt.y );
+      _vertex( canvas, pt.x + radius, pt.y );
       for( unsigned int i = 0; i < nb_side; ++i) {
-	glVertex3d( pt.x + radius * cos( (double) (i+1) * 2.0 * M_PI / (double) nb_side),
-		    pt.y + radius * sin( (double) (i+1) * 2.0 * M_PI / (double) nb_side),
-		    0.0 );
+	_vertex( canvas, pt.x + radius * cos( (double) (i+1) * 2.0 * M_PI / (double) nb_side),
+		    pt.y + radius * sin( (double) (i+1) * 2.0 * M_PI / (double) nb_side) );
       }
     }
-    glEnd();
+    _end( canvas );
 
     // dark outer circle
-    glColor3d( 0.0, 0.0, 0.0 );
-    glBegin(GL_LINE_STRIP); {
-      glVertex3d( pt.x + radius, pt.y, 0.0);
+    _color( canvas, 0.0, 0.0, 0.0 );
+    _begin( canvas, GL_LINE_STRIP); {
+      _vertex( canvas, pt.x + radius, pt.y );
       for( unsigned int i = 0; i < nb_side; ++i) {
-	glVertex3d( pt.x + radius * cos( (double) (i+1) * 2.0 * M_PI / (double) nb_side),
-		    pt.y + radius * sin( (double) (i+1) * 2.0 * M_PI / (double) nb_side),
-		    0.0 );
+	_vertex( canvas, pt.x + radius * cos( (double) (i+1) * 2.0 * M_PI / (double) nb_side),
+		    pt.y + radius * sin( (double) (i+1) * 2.0 * M_PI / (double) nb_side) );
       }
     }
-    glEnd();
+    _end( canvas );
   }
   // -----------------------------------
   /** vector = ligne + triangle */
-  void draw_vector( const Pt2D& from, const Pt2D& to )
+  void draw_vector( SoftCanvas* canvas, const Pt2D& from, const Pt2D& to )
   {
     // colinear vector
     Pt2D cv { (to.x-from.x), (to.y-from.y) };
@@ -147,48 +187,47 @@ private:
 	end.y - tip_length*cv.y - tip_width * ov.y };
 
     // Drawing LINE then TRIANGLE
-    glColor3d( 0.0, 0.0, 0.0);
-    glBegin(GL_LINES); {
-      glVertex3d( start.x, start.y, 0.0 );
-      glVertex3d( end.x, end.y, 0.0 );
+    _color( canvas, 0.0, 0.0, 0.0);
+    _begin( canvas, GL_LINES); {
+      _vertex( canvas, start.x, start.y );
+      _vertex( canvas, end.x, end.y );
     }
-    glEnd();
-    glBegin(GL_TRIANGLES); {
-      glVertex3d( end.x, end.y, 0.0 );
-      glVertex3d( a1.x, a1.y, 0.0 );
-      glVertex3d( a2.x, a2.y, 0.0 );
+    _end( canvas );
+    _begin( canvas, GL_TRIANGLES); {
+      _vertex( canvas, end.x, end.y );
+      _vertex( canvas, a1.x, a1.y );
+      _vertex( canvas, a2.x, a2.y );
     }
-    glEnd();
+    _end( canvas );
   }
   // -----------------------------------
   /** RDSOM1D as an arc of a circle */
-  void draw_back( const double radius )
+  void draw_back( SoftCanvas* canvas, const double radius )
   {
     unsigned int nb_side = 128;
     
-    glColor3d( 0.0, 0.0, 0.0 );
-    glBegin(GL_LINE_STRIP); {
+    _color( canvas, 0.0, 0.0, 0.0 );
+    _begin( canvas, GL_LINE_STRIP); {
       auto angle = _ang_min;
-      glVertex3d( radius* cos(angle), radius* sin(angle), 0.0);
+      _vertex( canvas, radius* cos(angle), radius* sin(angle) );
       for( unsigned int i = 0; i <= nb_side; ++i) {
 	angle = _ang_min + (double) i / (double) nb_side * (_ang_max - _ang_min);
-	glVertex3d( radius * cos( angle ),
-		    radius * sin( angle ),
-		    0.0 );
+	_vertex( canvas, radius * cos( angle ),
+		    radius * sin( angle ) );
       }
     }
-    glEnd();
+    _end( canvas );
     
     // start and end lines
     double rmin = 0.9;
     double rmax = 1.1;
-    glBegin(GL_LINES); {
-      glVertex3d( radius*rmin*cos(_ang_min), radius*rmin*sin(_ang_min), 0.0);
-      glVertex3d( radius*rmax*cos(_ang_min), radius*rmax*sin(_ang_min), 0.0);
-      glVertex3d( radius*rmin*cos(_ang_max), radius*rmin*sin(_ang_max), 0.0);
-      glVertex3d( radius*rmax*cos(_ang_max), radius*rmax*sin(_ang_max), 0.0);
+    _begin( canvas, GL_LINES); {
+      _vertex( canvas, radius*rmin*cos(_ang_min), radius*rmin*sin(_ang_min) );
+      _vertex( canvas, radius*rmax*cos(_ang_min), radius*rmax*sin(_ang_min) );
+      _vertex( canvas, radius*rmin*cos(_ang_max), radius*rmin*sin(_ang_max) );
+      _vertex( canvas, radius*rmax*cos(_ang_max), radius*rmax*sin(_ang_max) );
     }
-    glEnd();
+    _end( canvas );
   }
   
 };
@@ -0,0 +1,374 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef DSOM_WINNER_SEARCH_HPP
+#define DSOM_WINNER_SEARCH_HPP
+
+/**
+ * Winner search for DSOM Networks.
+ *  - BruteForceSearch : all distances at once, vectorized over neurons
+ *  - VPTreeSearch : vantage point tree, lazily rebuilt when weights drift,
+ *    falls back on the vectorized scan when it does not prune (high dim)
+ *
+ * All backends accumulate (w_d - x_d)^2 in the same order (d=0..dim-1) so
+ * that, in exact mode, they return exactly the same winner and distance.
+ * Ties are broken by the lowest index.
+ */
+#include <vector>
+#include <string>
+#include <random>                   // std::default_random_engine
+#include <limits>                   // max dbl
+#include <algorithm>                // std::nth_element
+#include <cmath>                    // sqrt
+
+#include <dsom/neuron.hpp>
+
+// ********************************************************************* Model
+namespace Model
+{
+// ********************************************************************** DSOM
+namespace DSOM
+{
+// ***************************************************************************
+// ************************************************************** WinnerSearch
+// ***************************************************************************
+class WinnerSearch
+{
+public:
+  using TWeight = Neuron::TWeight;
+  using TWeightRef = Eigen::Ref<const TWeight>;
+  using Neurons = std::vector<Neuron *>;
+public:
+  // ************************************************** WinnerSearch::creation
+  WinnerSearch() : _built(false) {}
+  virtual ~WinnerSearch() {}
+  /** Copy of the backend, with its own copy of the weights */
+  virtual WinnerSearch* clone() const = 0;
+  virtual std::string name() const = 0;
+  // ***************************************************** WinnerSearch::build
+  /** Weights will be read again from the neurons before next search */
+  void invalidate() { _built = false; }
+  /** Weights of neuron 'idx' have changed */
+  virtual void update( unsigned int idx, const TWeightRef& w ) = 0;
+  // **************************************************** WinnerSearch::search
+  /**
+   * Index of the neuron closest to 'input',
+   * 'dist' is set to the euclidean distance of this neuron.
+   */
+  unsigned int search( const Neurons& v_neur, const TWeight& input,
+                       double& dist )
+  {
+    if( not _built ) {
+      build( v_neur );
+      _built = true;
+    }
+    return find( input, dist );
+  }
+  /** Euclidean distance from 'input' to all neurons */
+  virtual void distances( const Neurons& v_neur, const TWeight& input,
+                          Eigen::VectorXd& dist )
+  {
+    dist.resize( v_neur.size() );
+    for( unsigned int i = 0; i < v_neur.size(); ++i) {
+      dist(i) = sqrt( sq_dist( v_neur[i]->weights.data(), input.data(),
+                               input.size() ));
+    }
+  }
+  // ****************************************************** WinnerSearch::dist
+  /** Squared distance, sequential accumulation in d */
+  static double sq_dist( const double* w, const double* x, int dim )
+  {
+    double acc = 0.0;
+    for( int d = 0; d < dim; ++d) {
+      double diff = w[d] - x[d];
+      acc += diff * diff;
+    }
+    return acc;
+  }
+protected:
+  /** Copy all the weights from the neurons */
+  virtual void build( const Neurons& v_neur ) = 0;
+  virtual unsigned int find( const TWeight& input, double& dist ) = 0;
+  /** true when internal weights are up to date */
+  bool _built;
+};
+// ***************************************************************************
+// ********************************************************** BruteForceSearch
+// ***************************************************************************
+/**
+ * Weights are stored as rows of dimension (dim x nb_neur) so that the
+ * distance to all neurons is accumulated with vectorized operations.
+ */
+class BruteForceSearch : public WinnerSearch
+{
+public:
+  using TRows = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+public:
+  WinnerSearch* clone() const { return new BruteForceSearch( *this ); }
+  std::string name() const { return "brute"; }
+  void update( unsigned int idx, const TWeightRef& w )
+  {
+    if( _built ) _w.col(idx) = w;
+  }
+  void distances( const Neurons& v_neur, const TWeight& input,
+                  Eigen::VectorXd& dist )
+  {
+    if( not _built ) {
+      build( v_neur );
+      _built = true;
+    }
+    sq_distances( input );
+    dist = _acc.sqrt().matrix();
+  }
+protected:
+  void build( const Neurons& v_neur )
+  {
+    _w.resize( v_neur[0]->weights.size(), v_neur.size() );
+    for( unsigned int i = 0; i < v_neur.size(); ++i) {
+      _w.col(i) = v_neur[i]->weights;
+    }
+  }
+  unsigned int find( const TWeight& input, double& dist )
+  {
+    sq_distances( input );
+    const double* acc = _acc.data();
+    unsigned int best = 0;
+    double best_sq = acc[0];
+    for( unsigned int i = 1; i < (unsigned int) _acc.size(); ++i) {
+      if( acc[i] < best_sq ) {
+        best_sq = acc[i];
+        best = i;
+      }
+    }
+    dist = sqrt( best_sq );
+    return best;
+  }
+  void sq_distances( const TWeight& input )
+  {
+    _acc.setZero( _w.cols() );
+    for( int d = 0; d < _w.rows(); ++d) {
+      _acc += (_w.row(d).array() - input(d)).square();
+    }
+  }
+  /** Weights, one column per neuron */
+  TRows _w;
+  /** Squared distances */
+  Eigen::ArrayXd _acc;
+};
+// ***************************************************************************
+// ************************************************************** VPTreeSearch
+// ***************************************************************************
+/**
+ * Vantage Point Tree built on a copy of the weights.
+ *
+ * When weights are updated, the tree is not rebuilt: pruning bounds are
+ * widened by the maximum drift of a neuron since the build, which keeps
+ * the search exact. A neuron drifting more than 'drift_ratio' times the
+ * radius of the root (typically the winner and its neighbours) is moved
+ * out of the tree and scanned at each search instead. The tree is rebuilt
+ * at the next search when more than 'moved_ratio' of the neurons are out.
+ *
+ * In high dimension the tree prunes little : when searches evaluate more
+ * than 'max_visit' of the neurons, the vectorized scan of BruteForceSearch
+ * is used. The tree is tried again after PROBE_MIN scans, this period is
+ * doubled (up to PROBE_MAX) each time the tree still does not prune.
+ *
+ * With approx > 0, a (1+approx)-approximate winner is returned.
+ */
+class VPTreeSearch : public BruteForceSearch
+{
+public:
+  static const unsigned int PROBE_MIN = 16;
+  static const unsigned int PROBE_MAX = 4096;
+  // ************************************************** VPTreeSearch::creation
+  VPTreeSearch( double drift_ratio = 0.1, double approx = 0.0,
+                unsigned int leaf_size = 8, double moved_ratio = 0.05,
+                double max_visit = 0.25 ) :
+    BruteForceSearch(),
+    _drift_ratio(drift_ratio), _approx(approx),
+    _leaf_size( std::max( leaf_size, 1u )), _moved_ratio(moved_ratio),
+    _max_visit(max_visit),
+    _drift(0.0), _max_drift(0.0), _nb_build(0),
+    _visit(0.0), _nb_scan(0), _probe_period(PROBE_MIN)
+  {}
+  WinnerSearch* clone() const { return new VPTreeSearch( *this ); }
+  std::string name() const { return "vptree"; }
+  // **************************************************** VPTreeSearch::build
+  void update( unsigned int idx, const TWeightRef& w )
+  {
+    if( not _built ) return;
+    BruteForceSearch::update( idx, w );
+    _wc.col(idx) = w;
+    if( _moved[idx] ) return;
+    double d = sqrt( sq_dist( w.data(), _w_build.col(idx).data(), w.size() ));
+    if( d > _max_drift ) {
+      _moved[idx] = true;
+      _l_moved.push_back( idx );
+      if( _l_moved.size() > _moved_ratio * _moved.size() ) _built = false;
+    }
+    else {
+      _drift = std::max( _drift, d );
+    }
+  }
+  /** Number of times the tree was (re)built */
+  unsigned int get_nb_build() const { return _nb_build; }
+  /** Mean fraction of neurons evaluated by a tree search */
+  double get_visit() const { return _visit; }
+  /** true if the vectorized scan is used instead of the tree */
+  bool is_scanning() const { return _visit > _max_visit; }
+protected:
+  /** Node of the tree : leaf if in < 0 */
+  struct Node {
+    unsigned int vp;
+    double mu;
+    int in, out;
+    unsigned int begin, end;
+  };
+  void build( const Neurons& v_neur )
+  {
+    BruteForceSearch::build( v_neur );
+    _wc.resize( v_neur[0]->weights.size(), v_neur.size() );
+    for( unsigned int i = 0; i < v_neur.size(); ++i) {
+      _wc.col(i) = v_neur[i]->weights;
+    }
+    _w_build = _wc;
+    _order.resize( v_neur.size() );
+    for( unsigned int i = 0; i < _order.size(); ++i) _order[i] = i;
+    _moved.assign( v_neur.size(), false );
+    _l_moved.clear();
+
+    _nodes.clear();
+    _rnd.seed( 0 );
+    build_node( 0, _order.size() );
+    _drift = 0.0;
+    _max_drift = _drift_ratio * _nodes[0].mu;
+    ++_nb_build;
+  }
+  int build_node( unsigned int begin, unsigned int end )
+  {
+    int idx = _nodes.size();
+    _nodes.push_back( Node{0, 0.0, -1, -1, begin, end} );
+    if( end - begin <= _leaf_size ) return idx;
+
+    // random vantage point at 'begin'
+    std::uniform_int_distribution<unsigned int> unif( begin, end-1 );
+    std::swap( _order[begin], _order[unif(_rnd)] );
+    unsigned int vp = _order[begin];
+
+    // others are split around the median distance to vp
+    std::vector<std::pair<double, unsigned int>> dist;
+    for( unsigned int i = begin+1; i < end; ++i) {
+      dist.push_back( {sqrt( sq_dist( _w_build.col(_order[i]).data(),
+                                      _w_build.col(vp).data(), _wc.rows() )),
+            _order[i]} );
+    }
+    unsigned int mid = dist.size() / 2;
+    std::nth_element( dist.begin(), dist.begin()+mid, dist.end() );
+    for( unsigned int i = 0; i < dist.size(); ++i) {
+      _order[begin+1+i] = dist[i].second;
+    }
+    // in : [begin+1, begin+mid+2) with d <= mu, out : [begin+mid+2, end) with d >= mu
+    double mu = dist[mid].first;
+    int in = build_node( begin+1, begin+mid+2 );
+    int out = build_node( begin+mid+2, end );
+    _nodes[idx] = Node{vp, mu, in, out, begin, end};
+    return idx;
+  }
+  // *************************************************** VPTreeSearch::search
+  unsigned int find( const TWeight& input, double& dist )
+  {
+    // when scanning, the tree is probed from time to time
+    bool probe = is_scanning();
+    if( probe and ++_nb_scan < _probe_period ) {
+      return BruteForceSearch::find( input, dist );
+    }
+    _best = 0;
+    _best_sq = std::numeric_limits<double>::max();
+    _nb_eval = 0;
+    for( auto& idx: _l_moved ) eval( idx, input );
+    if( _nodes.size() > 0 ) search_node( 0, input );
+
+    double visit = (double) _nb_eval / (double) _moved.size();
+    if( probe ) {
+      _visit = visit;
+      _nb_scan = 0;
+      if( not is_scanning() ) _probe_period = PROBE_MIN;
+      else if( _probe_period < PROBE_MAX ) _probe_period *= 2;
+    }
+    else {
+      _visit = 0.9 * _visit + 0.1 * visit;
+    }
+    dist = sqrt( _best_sq );
+    return _best;
+  }
+  void eval( unsigned int idx, const TWeight& input )
+  {
+    ++_nb_eval;
+    double sq = sq_dist( _wc.col(idx).data(), input.data(), input.size() );
+    if( sq < _best_sq || (sq == _best_sq && idx < _best) ) {
+      _best_sq = sq;
+      _best = idx;
+    }
+  }
+  void search_node( int n, const TWeight& input )
+  {
+    const Node& node = _nodes[n];
+    if( node.in < 0 ) {
+      for( unsigned int i = node.begin; i < node.end; ++i) {
+        if( not _moved[_order[i]] ) eval( _order[i], input );
+      }
+      return;
+    }
+    if( not _moved[node.vp] ) eval( node.vp, input );
+    // pruning uses the positions at build, neurons still in the tree
+    // have moved by at most _drift
+    double d_vp = sqrt( sq_dist( _w_build.col(node.vp).data(), input.data(),
+                                 input.size() ));
+    double slack = _drift + 1e-9 * (d_vp + node.mu);
+    if( d_vp <= node.mu ) {
+      if( (d_vp - node.mu - slack) * (1.0 + _approx) <= sqrt( _best_sq ))
+        search_node( node.in, input );
+      if( (node.mu - d_vp - slack) * (1.0 + _approx) <= sqrt( _best_sq ))
+        search_node( node.out, input );
+    }
+    else {
+      if( (node.mu - d_vp - slack) * (1.0 + _approx) <= sqrt( _best_sq ))
+        search_node( node.out, input );
+      if( (d_vp - node.mu - slack) * (1.0 + _approx) <= sqrt( _best_sq ))
+        search_node( node.in, input );
+    }
+  }
+  // *********************************************** VPTreeSearch::attributes
+  /** Out of the tree when drift > drift_ratio * radius of root */
+  double _drift_ratio;
+  /** Approximation factor (0 means exact) */
+  double _approx;
+  /** At least 1 neuron per leaf */
+  unsigned int _leaf_size;
+  /** Rebuild when more than moved_ratio of the neurons are out */
+  double _moved_ratio;
+  /** Scan when a search evaluates more than max_visit of the neurons */
+  double _max_visit;
+  /** Current weights and weights when the tree was built (per column) */
+  Eigen::MatrixXd _wc, _w_build;
+  /** Max distance between current and build weights (in the tree), and its limit */
+  double _drift, _max_drift;
+  /** Neurons out of the tree */
+  std::vector<bool> _moved;
+  std::vector<unsigned int> _l_moved;
+  /** Neurons index, ordered by tree nodes */
+  std::vector<unsigned int> _order;
+  std::vector<Node> _nodes;
+  std::default_random_engine _rnd;
+  unsigned int _nb_build;
+  /** Mean fraction of neurons evaluated by the tree */
+  double _visit;
+  /** Scans since last probe of the tree, and between probes */
+  unsigned int _nb_scan, _probe_period;
+  /** Search state */
+  unsigned int _best, _nb_eval;
+  double _best_sq;
+};
+}; // namespace DSOM
+}; // namespace Model
+
+#endif // DSOM_WINNER_SEARCH_HPP
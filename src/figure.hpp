@@ -6,15 +6,20 @@
 /** 
  * A Figure has Axes and is a Plotter (which can containes Plotter).
  * Can have a title.
+ * Created without a Window, it has no font (set_font) : it can only be
+ * rendered in a SoftCanvas (render_soft), e.g. by a SoftWindow.
+ * Does not include window.hpp (GLFW) : the program that creates a Window
+ * includes it.
  */
 
 #include <iostream>                  // std::cout
 #include <string>                    // std::string
+#include <utility>                   // std::declval
 
+#include <gl_headers.hpp>            // OpenGL, FTFont
 #include <plotter.hpp>
-#include <window.hpp>
 #include <axis.hpp>
-#include <gl_utils.hpp>              // utils::gl::to_png
+#include <soft_canvas.hpp>           // SoftCanvas
 #include <visugl.hpp>
 
 
@@ -25,7 +30,10 @@ class Figure : public Plotter
 {
 public:
   // ******************************************************** Figure::creation
-  Figure( const Window& window,
+  /** With the font of a Window (anything with a '_font') */
+  template<typename TWindow,
+           typename = decltype( std::declval<const TWindow&>()._font )>
+  Figure( const TWindow& window,
           std::string title = "",
 	  const Range& x_range = {-1.0, 1.0, 10, 2},
 	  const Range& y_range = {-1.0, 1.0, 10, 2} ) :
@@ -39,6 +47,25 @@ public:
     _font( window._font ), _title_offset( 0.0 )
   {
   }
+  /** Without Window (and font) */
+  Figure( std::string title = "",
+	  const Range& x_range = {-1.0, 1.0, 10, 2},
+	  const Range& y_range = {-1.0, 1.0, 10, 2} ) :
+    Plotter(),
+    _title( title ), 
+    _update_axes_x( false ), _update_axes_y( false ),
+    _draw_axes( true ),
+    _axis_x( "X", x_range),
+    _axis_y( "Y", y_range),
+    _text_list(),
+    _font( nullptr ), _title_offset( 0.0 )
+  {
+  }
+  /** Font of a Window, needed by render */
+  void set_font( FTFont* font )
+  {
+    _font = font;
+  }
   // ***************************************************** Figure::destruction
   ~Figure()
   {
@@ -87,8 +114,7 @@ public:
     // Some room for title
     if (_title != "" ) {
       innerbox.y_max += 0.1* (innerbox.y_max - innerbox.y_min);
-      auto titlebox = _font->BBox( _title.c_str() );
-      _title_offset = (titlebox.Upper().X() - titlebox.Lower().X()) / 2.0;
+      _title_offset = title_width() / 2.0;
     }
     
     set_bbox( innerbox );
@@ -96,10 +122,10 @@ public:
     // std::cout << "  offset = " << _title_offset << std::endl;
   }
   
-  // ********************************************************** Figure::render
-  virtual void render( float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  // ***************************************************** Figure::update_axes
+  /** Axes follow the plotters if _update_axes_x/y */
+  void update_axes()
   {
-
     if( _update_axes_x || _update_axes_y ) {
       auto innerbox = get_innerbbox();
 
@@ -110,12 +136,24 @@ public:
       // Some room for title
       if (_title != "" ) {
         innerbox.y_max += 0.1* (innerbox.y_max - innerbox.y_min);
-        auto titlebox = _font->BBox( _title.c_str() );
-        _title_offset = (titlebox.Upper().X() - titlebox.Lower().X()) / 2.0;
+        _title_offset = title_width() / 2.0;
       }
 
       set_bbox( innerbox );
     }
+  }
+  /** Width of the title, in pixels */
+  double title_width() const
+  {
+    if( not _font ) return SoftCanvas::text_width( _title );
+    auto titlebox = _font->BBox( _title.c_str() );
+    return titlebox.Upper().X() - titlebox.Lower().X();
+  }
+  
+  // ********************************************************** Figure::render
+  virtual void render( float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  {
+    update_axes();
     
     // All other objects
     GLenum err;
@@ -163,6 +201,45 @@ public:
       } glPopMatrix();
     }
   }
+  // ***************************************************** Figure::render_soft
+  virtual void render_soft( SoftCanvas& canvas,
+                            float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  {
+    update_axes();
+
+    for( const auto& plotter: _plotters) {
+      plotter->render_soft( canvas, screen_ratio_x, screen_ratio_y );
+    }
+
+    // Basic axes
+    if( _draw_axes ) {
+      _axis_x.render_soft( canvas, screen_ratio_x, screen_ratio_y );
+      canvas.push_matrix(); // AXE_Y
+      canvas.rotate( 90.0 );
+      _axis_y.render_soft( canvas, screen_ratio_y, screen_ratio_x);
+      canvas.pop_matrix(); // AXE_Y
+    }
+
+    // GraphicText
+    for( auto& txt: _text_list) {
+      canvas.color( txt.col.r, txt.col.g, txt.col.b );
+      canvas.push_matrix();
+      canvas.translate( txt.x, txt.y );
+      canvas.scale( screen_ratio_x, screen_ratio_y );
+      canvas.text( txt.msg );
+      canvas.pop_matrix();
+    }
+    // Title
+    if (_title != "") {
+      canvas.color( 0.0, 0.0, 0.0 );
+      canvas.push_matrix();
+      canvas.translate( get_bbox().x_min + (get_bbox().x_max - get_bbox().x_min) / 2.0 - (_title_offset*screen_ratio_x),
+                        (get_bbox().y_max - 0.05 * (get_bbox().y_max - get_bbox().y_min)) );
+      canvas.scale( screen_ratio_x, screen_ratio_y );
+      canvas.text( _title );
+      canvas.pop_matrix();
+    }
+  }
 
 public:
   // ******************************************************* Figure::attributs
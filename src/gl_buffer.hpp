@@ -0,0 +1,152 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef GL_BUFFER_HPP
+#define GL_BUFFER_HPP
+
+/**
+ * Vertex Buffer Object (OpenGL 1.5) mirroring a growing array of vertices
+ * (3 GLdouble each) kept in CPU memory.
+ * - sync( data, n ) only uploads the vertices added since the last sync
+ *   (glBufferSubData), the GPU buffer doubles its capacity when full.
+ *   sync( data, n, from ) also uploads again the vertices modified from
+ *   'from'.
+ * - reset() when the data have been cleared or changed in place.
+ * - draw( mode ) : one glDrawArrays.
+ *
+ * All Window share their OpenGL objects (cf Window), a buffer can thus be
+ * drawn in any Window. When every Window has been destroyed, the buffers
+ * are lost with them : ContextGroup::id() changes and the next sync
+ * creates a new buffer.
+ *
+ * sync, draw and the destructor use the current OpenGL context : it must
+ * be one of the group (ContextGroup::current()), with glewInit() done
+ * (both by Window).
+ */
+
+#include <GL/glew.h>                 // OpenGL 1.5, before any gl.h
+#include <GLFW/glfw3.h>              // GLFWwindow, glfwGetCurrentContext
+#include <cstddef>                   // size_t
+#include <algorithm>                 // std::max, std::find
+#include <limits>                    // std::numeric_limits
+#include <list>                      // std::list
+
+namespace utils {
+namespace gl {
+// ************************************************************** ContextGroup
+/**
+ * Group of shared OpenGL contexts (GLFW windows not yet destroyed),
+ * maintained by Window.
+ */
+class ContextGroup
+{
+public:
+  /** Context to share objects with when creating a new one (or NULL) */
+  static GLFWwindow* share()
+  {
+    return _state().contexts.empty() ? NULL : _state().contexts.front();
+  }
+  /** A new context, created sharing with share() */
+  static void add_context( GLFWwindow* context )
+  {
+    if( _state().contexts.empty() ) ++_state().id;
+    _state().contexts.push_back( context );
+  }
+  static void remove_context( GLFWwindow* context )
+  {
+    _state().contexts.remove( context );
+  }
+  static unsigned int id() { return _state().id; }
+  static bool alive() { return not _state().contexts.empty(); }
+  /** Is the current OpenGL context one of the group ? */
+  static bool current()
+  {
+    GLFWwindow* context = glfwGetCurrentContext();
+    auto& contexts = _state().contexts;
+    return context != NULL and
+      std::find( contexts.begin(), contexts.end(), context ) != contexts.end();
+  }
+  /** Construct the group now : it will outlive statics constructed after */
+  static void touch() { _state(); }
+private:
+  struct State {
+    unsigned int id = 0;
+    std::list<GLFWwindow*> contexts;
+  };
+  static State& _state() { static State state; return state; }
+};
+// ************************************************************** VertexBuffer
+class VertexBuffer
+{
+public:
+  static const size_t VERTEX_SIZE = 3 * sizeof(GLdouble);
+  static const size_t MIN_CAPACITY = 1024;
+  // ************************************************** VertexBuffer::creation
+  VertexBuffer() : _id(0), _group(0), _capacity(0), _uploaded(0) {}
+  /** A copy has its own (empty) buffer */
+  VertexBuffer( const VertexBuffer& ) : VertexBuffer() {}
+  VertexBuffer& operator=( const VertexBuffer& ) { reset(); return *this; }
+  ~VertexBuffer()
+  {
+    if( _id and _group == ContextGroup::id() and ContextGroup::current() ) {
+      glDeleteBuffers( 1, &_id );
+    }
+  }
+  // ***************************************************** VertexBuffer::reset
+  /** Everything will be uploaded again at next sync */
+  void reset() { _uploaded = 0; }
+  // ****************************************************** VertexBuffer::sync
+  /**
+   * Upload vertices [min(uploaded,from), n[ of 'data' (n vertices of
+   * 3 GLdouble)
+   */
+  void sync( const GLdouble* data, size_t n,
+             size_t from = std::numeric_limits<size_t>::max() )
+  {
+    if( _id == 0 or _group != ContextGroup::id() ) {
+      glGenBuffers( 1, &_id );
+      _group = ContextGroup::id();
+      _capacity = 0;
+      _uploaded = 0;
+    }
+    glBindBuffer( GL_ARRAY_BUFFER, _id );
+    if( n > _capacity ) {
+      _capacity = std::max( std::max( n, 2 * _capacity ), (size_t) MIN_CAPACITY );
+      glBufferData( GL_ARRAY_BUFFER, _capacity * VERTEX_SIZE, NULL, GL_DYNAMIC_DRAW );
+      _uploaded = 0;
+    }
+    if( n < _uploaded ) _uploaded = 0;
+    if( from < _uploaded ) _uploaded = from;
+    if( n > _uploaded ) {
+      glBufferSubData( GL_ARRAY_BUFFER, _uploaded * VERTEX_SIZE,
+                       (n - _uploaded) * VERTEX_SIZE, data + 3 * _uploaded );
+      _uploaded = n;
+    }
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  }
+  // ****************************************************** VertexBuffer::draw
+  /** Draw vertices [first, first+count[ (must have been synced) */
+  void draw( GLenum mode, size_t first, size_t count ) const
+  {
+    if( _id == 0 or count == 0 ) return;
+    glBindBuffer( GL_ARRAY_BUFFER, _id );
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glVertexPointer( 3, GL_DOUBLE, 0, 0 );
+    glDrawArrays( mode, first, count );
+    glDisableClientState( GL_VERTEX_ARRAY );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+  }
+  void draw( GLenum mode ) const { draw( mode, 0, _uploaded ); }
+  // ************************************************* VertexBuffer::attributs
+  size_t size() const { return _uploaded; }
+private:
+  GLuint _id;
+  /** ContextGroup of _id */
+  unsigned int _group;
+  /** In vertices */
+  size_t _capacity, _uploaded;
+};
+
+}; // namespace gl
+}; // namespace utils
+
+#endif // GL_BUFFER_HPP
@@ -0,0 +1,18 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef GL_HEADERS_HPP
+#define GL_HEADERS_HPP
+
+/**
+ * OpenGL and FTGL headers of the Plotters (Figure, Axis...), without any
+ * window : GLEW first (Curve uses OpenGL 1.5, glew.h must come before any
+ * gl.h), then FTGL for the fonts.
+ *
+ * Only Window (window.hpp) needs GLFW and a context. A program that only
+ * renders in a SoftCanvas (SoftWindow) does not include window.hpp.
+ */
+
+#include <GL/glew.h>                 // OpenGL 1.5, before any gl.h
+#include <FTGL/ftgl.h>               // FTFont, FTGLTextureFont
+
+#endif // GL_HEADERS_HPP
@@ -9,6 +9,7 @@
  * - TODO show()
  */
 
+#include <GL/glew.h>                 // before gl.h (Curve uses OpenGL 1.5)
 #include <GLFW/glfw3.h>
 #include <iostream>                  // std::cout
 #include <string>                    // std::string
@@ -5,67 +5,139 @@
 
 /** 
  * Utilities for OpenGL
- * - save screen as PNG
+ * - read the viewport as RGB bytes (read_pixels)
+ * - PixelReader : read through 2 Pixel Buffer Objects, the copy to CPU
+ *   memory of a read is only waited for at the next-but-one read (or
+ *   flush), then the Image is written by a PngQueue
+ * - save screen as PNG (to_png, in the background)
  * - check for opengl errors
  */
 #include <iostream>              // std::cout
-#define PNG_SKIP_SETJMP_CHECK    // see /usr/include/libpng12/pngconf.h:383
-#include <pngwriter.h>
-#include <GL/gl.h>               // OpenGL
+#include <GL/glew.h>             // OpenGL 2.1 (PBO), before any gl.h
+#include <png_queue.hpp>         // utils::Image, utils::PngQueue
 
-#include <memory>                // std::unique_ptr, std::shared_ptr
+#include <string>                // std::string
 #include <limits>                // std::numeric_limits
 
 namespace utils {
 namespace gl {
+// *************************************************************** read_pixels
+/** Current viewport of the bound framebuffer in 'img' */
+inline void read_pixels( Image& img )
+{
+  GLint dim[4];
+  glGetIntegerv( GL_VIEWPORT, dim );
+  img.width = dim[2];
+  img.height = dim[3];
+  img.rgb.resize( 3 * img.width * img.height );
+  glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+  glReadPixels( dim[0], dim[1], dim[2], dim[3],
+                GL_RGB, GL_UNSIGNED_BYTE, img.rgb.data() );
+}
 // ******************************************************************** to_png
-void to_png( const std::string& filename )
+/** Write the current viewport in 'filename' (PngQueue::global()) */
+inline void to_png( const std::string& filename )
 {
-  std::cout << "__ SAVE to_png in " << filename << std::endl;
-  GLenum err;
-  while ((err = glGetError()) != GL_NO_ERROR) {
-    std::cerr << "OpenGL error: " << err << std::endl;
-  }
-  // Window dimension, through VIEWPORT
-  GLint screen_dim[4];
-  glGetIntegerv( GL_VIEWPORT, screen_dim);
-
-  std::cout << "  dim = " << "+" << screen_dim[0] << ", " << screen_dim[1];
-  std::cout << " " << screen_dim[2] << " x " << screen_dim[3] << std::endl;
-
-  pngwriter image( screen_dim[2], screen_dim[3],
-		   0, // background color
-		   filename.c_str() );
-  // get image pixels
-  // new buffer, access raw with .get()
-  std::unique_ptr<GLfloat[]> pixels( new GLfloat [3 * screen_dim[2] * screen_dim[3]]);
+  Image img;
+  read_pixels( img );
+  PngQueue::global().push( filename, std::move( img ) );
+}
+// ************************************************************** PixelReader
+/**
+ * Must be used (and release()d) with the same OpenGL context current.
+ * Without PBO (OpenGL < 2.1), reads are done at once.
+ */
+class PixelReader
+{
+public:
+  // *************************************************** PixelReader::creation
+  PixelReader() : _pbo{0, 0}, _size{0, 0}, _pending(), _next(0) {}
+  /** A copy has its own (empty) buffers */
+  PixelReader( const PixelReader& ) : PixelReader() {}
+  PixelReader& operator=( const PixelReader& ) { return *this; }
+  // ******************************************************* PixelReader::read
+  /** Read the current viewport, to be written in 'filename' by 'queue' */
+  void read( const std::string& filename, PngQueue& queue )
+  {
+    if( not GLEW_VERSION_2_1 ) {
+      to_png( filename );
+      return;
+    }
+    unsigned int slot = _next;
+    _next = 1 - _next;
+    if( _pending[slot].active ) _finish( slot, queue );
 
-  // check OpenGL error
-  std::cout << "__ READ buffer start" << std::endl;
-  while ((err = glGetError()) != GL_NO_ERROR) {
-    std::cerr << "OpenGL error: " << err << std::endl;
+    GLint dim[4];
+    glGetIntegerv( GL_VIEWPORT, dim );
+    size_t size = 3 * dim[2] * dim[3];
+    if( _pbo[slot] == 0 ) glGenBuffers( 1, &_pbo[slot] );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, _pbo[slot] );
+    if( size != _size[slot] ) {
+      glBufferData( GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ );
+      _size[slot] = size;
+    }
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+    // returns at once, the copy is done by the GPU
+    glReadPixels( dim[0], dim[1], dim[2], dim[3], GL_RGB, GL_UNSIGNED_BYTE, 0 );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+    _pending[slot] = Pending{ true, filename, (unsigned int) dim[2], (unsigned int) dim[3] };
   }
-  glReadPixels( screen_dim[0], screen_dim[1], screen_dim[2], screen_dim[3],
-		GL_RGB, GL_FLOAT, pixels.get() );
-  std::cout << "__ READ buffer end" << std::endl;
-  while ((err = glGetError()) != GL_NO_ERROR) {
-    std::cerr << "OpenGL error: " << err << std::endl;
+  // ****************************************************** PixelReader::flush
+  /** Give all pending reads to 'queue' */
+  void flush( PngQueue& queue )
+  {
+    // oldest first
+    for( unsigned int i = 0; i < 2; ++i) {
+      unsigned int slot = (_next + i) % 2;
+      if( _pending[slot].active ) _finish( slot, queue );
+    }
   }
-  // copy image
-  std::cout << "__ SET image start" << std::endl;
-  for( auto y = screen_dim[1]; y <screen_dim[3]; ++y ) {
-    for( auto x = screen_dim[0]; x < screen_dim[2]; ++x ) {
-      image.plot( x, y,
-		  pixels[3*x + y*3*screen_dim[2] + 0],
-		  pixels[3*x + y*3*screen_dim[2] + 1],
-		  pixels[3*x + y*3*screen_dim[2] + 2] );
+  // **************************************************** PixelReader::release
+  /** Delete the PBO (pending reads are lost) */
+  void release()
+  {
+    for( unsigned int slot = 0; slot < 2; ++slot) {
+      if( _pbo[slot] ) glDeleteBuffers( 1, &_pbo[slot] );
+      _pbo[slot] = 0;
+      _size[slot] = 0;
+      _pending[slot].active = false;
     }
   }
-  std::cout << "__ SET image end" << std::endl;
-  // save image
-  std::cout << "__ SAVE to "<< filename << std::endl;
-  image.close();
-}
+private:
+  // ************************************************** PixelReader::internals
+  struct Pending {
+    bool active;
+    std::string filename;
+    unsigned int width, height;
+  };
+  void _finish( unsigned int slot, PngQueue& queue )
+  {
+    Pending& pending = _pending[slot];
+    pending.active = false;
+    Image img;
+    img.width = pending.width;
+    img.height = pending.height;
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, _pbo[slot] );
+    auto ptr = (const unsigned char*) glMapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY );
+    if( ptr ) {
+      img.rgb.assign( ptr, ptr + _size[slot] );
+      glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+    }
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+    if( ptr ) {
+      queue.push( pending.filename, std::move( img ) );
+    }
+    else {
+      std::cerr << "PixelReader: cannot map buffer for " << pending.filename << std::endl;
+    }
+  }
+
+  GLuint _pbo[2];
+  size_t _size[2];
+  Pending _pending[2];
+  /** Slot of the next read */
+  unsigned int _next;
+};
 
 // *************************************************************** check_error
 void _check_error(const char *file, int line);
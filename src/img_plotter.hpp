@@ -6,6 +6,7 @@
 #include <vector>
 #include <colormap.hpp>
 #include <plotter.hpp> 
+#include <soft_canvas.hpp>          // SoftCanvas
 
 /** 
  * ¨Plotter : display an 2D image using the "veridis" Colormap. 
@@ -49,6 +50,16 @@ public:
                   _img.data() );
                   
   }
+  virtual void render_soft( SoftCanvas& canvas,
+                            float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  {
+    double zoomx = (_bbox.x_max - _bbox.x_min) /
+      screen_ratio_x / double(_img_width);
+    double zoomy = (_bbox.y_max - _bbox.y_min) /
+      screen_ratio_y / double(_img_height);
+    canvas.draw_pixels( _bbox.x_min, _bbox.y_min, _img_width, _img_height,
+                        _img.data(), zoomx, zoomy );
+  }
   // *************************************************** ImgPlotter::attributs
   TData& _data;
   unsigned int _img_width, _img_height;
@@ -7,9 +7,20 @@
  * Some Wrapper used by rapidjson over std::ostream and std::istream.
  * 
  * see : http://miloyip.github.io/rapidjson/md_doc_stream.html#FileStreams 
+ *
+ * For large files (POMDP, networks), JSON::parse() streams the file
+ * through a SaxHandler (rapidjson::Reader) : no DOM is built, the
+ * handler writes the numbers straight into the model.
  */
 
 #include <iostream>
+#include <cassert>                   // assert
+#include <string>                    // std::string
+#include <vector>                    // std::vector
+#include <stdexcept>                 // std::runtime_error
+
+#include "rapidjson/reader.h"        // rapidjson's SAX-style API
+#include "rapidjson/error/en.h"      // rapidjson::GetParseError_En
 
 namespace JSON
 {
@@ -55,6 +66,148 @@ namespace JSON
     IStreamWrapper& operator=(const IStreamWrapper&);
     std::istream& is_;
   };
+  // **************************************************** BufferedIStreamWrapper
+  /** Same as IStreamWrapper, but reads the stream by blocks */
+  class BufferedIStreamWrapper {
+  public:
+    typedef char Ch;
+    static constexpr size_t BUFFER_SIZE = 1 << 16;
+    BufferedIStreamWrapper(std::istream& is) :
+      is_(is), buffer_(BUFFER_SIZE), pos_(0), end_(0), count_(0) {
+      read();
+    }
+    Ch Peek() const { return pos_ < end_ ? buffer_[pos_] : '\0'; }
+    Ch Take() {
+      if( pos_ >= end_ ) return '\0';
+      Ch c = buffer_[pos_++];
+      if( pos_ == end_ ) read();
+      return c;
+    }
+    size_t Tell() const { return count_ + pos_; }
+    Ch* PutBegin() { assert(false); return 0; }
+    void Put(Ch) { assert(false); }
+    void Flush() { assert(false); }
+    size_t PutEnd(Ch*) { assert(false); return 0; }
+  private:
+    BufferedIStreamWrapper(const BufferedIStreamWrapper&);
+    BufferedIStreamWrapper& operator=(const BufferedIStreamWrapper&);
+    void read() {
+      count_ += end_;
+      is_.read( buffer_.data(), buffer_.size() );
+      pos_ = 0;
+      end_ = (size_t) is_.gcount();
+    }
+    std::istream& is_;
+    std::vector<Ch> buffer_;
+    size_t pos_, end_, count_;
+  };
+  // **************************************************************** SaxHandler
+  /**
+   * rapidjson SAX Handler that keeps the path to the current value
+   * (key in each object, index in each array) and forwards the events
+   * found below 'root' (a key of the top-level object, "" for the whole
+   * document) to the virtual methods number(), string(), start(), end().
+   * Inside these, depth(), key(l) and index(l) give the path relative to
+   * 'root' : key(0) is the member of the root object, index(1) the
+   * position in that member if it is an array, etc. For start() and end(),
+   * the path is the one of the object/array itself, as for a value.
+   */
+  class SaxHandler :
+    public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, SaxHandler> {
+  public:
+    SaxHandler( const std::string& root = "" ) :
+      _root(root), _base(root.empty() ? 0 : 1)
+    {}
+    virtual ~SaxHandler() {}
+    /** Values (numbers and booleans are given as double) */
+    virtual bool number( double v ) { return true; }
+    virtual bool string( const std::string& str ) { return true; }
+    /** Start/End of an object or array (is_array) */
+    virtual bool start( bool is_array ) { return true; }
+    virtual bool end( bool is_array ) { return true; }
+
+    // Path relative to root, for level l < depth()
+    unsigned int depth() const { return _path.size() - _base; }
+    const std::string& key( unsigned int l ) const { return _path[_base+l].key; }
+    unsigned int index( unsigned int l ) const { return _path[_base+l].index; }
+    /** Is key(l) == k (and l an object) ? */
+    bool at( unsigned int l, const char* k ) const {
+      return l < depth() and not _path[_base+l].is_array and key(l) == k;
+    }
+
+    // rapidjson Handler
+    bool Null() { return next(); }
+    bool Bool( bool b ) { return value( b ? 1.0 : 0.0 ); }
+    bool Int( int i ) { return value( i ); }
+    bool Uint( unsigned u ) { return value( u ); }
+    bool Int64( int64_t i ) { return value( (double) i ); }
+    bool Uint64( uint64_t u ) { return value( (double) u ); }
+    bool Double( double d ) { return value( d ); }
+    bool String( const Ch* str, rapidjson::SizeType len, bool ) {
+      if( in_root() and not string( std::string( str, len ))) return false;
+      return next();
+    }
+    bool Key( const Ch* str, rapidjson::SizeType len, bool ) {
+      _path.back().key.assign( str, len );
+      return true;
+    }
+    bool StartObject() { return push( false ); }
+    bool EndObject( rapidjson::SizeType ) { return pop( false ); }
+    bool StartArray() { return push( true ); }
+    bool EndArray( rapidjson::SizeType ) { return pop( true ); }
+  private:
+    struct Level {
+      bool is_array;
+      std::string key;
+      unsigned int index;
+    };
+    /** Below root (including its direct members) ? */
+    bool in_root() const {
+      return _path.size() > _base and (_base == 0 or _path[0].key == _root);
+    }
+    bool value( double v ) {
+      if( in_root() and not number( v )) return false;
+      return next();
+    }
+    bool push( bool is_array ) {
+      if( in_root() and not start( is_array )) return false;
+      _path.push_back( Level{ is_array, "", 0 } );
+      return true;
+    }
+    bool pop( bool is_array ) {
+      _path.pop_back();
+      if( in_root() and not end( is_array )) return false;
+      return next();
+    }
+    /** Next element of the current array */
+    bool next() {
+      if( not _path.empty() and _path.back().is_array ) ++_path.back().index;
+      return true;
+    }
+    std::string _root;
+    unsigned int _base;
+    std::vector<Level> _path;
+  };
+  // ********************************************************************* parse
+  /**
+   * Parse 'is' with 'handler' (a SaxHandler). Numbers are read in full
+   * precision : a serialized model is reloaded exactly.
+   * Throws std::runtime_error if the JSON is malformed or if the handler
+   * stopped the parsing (returned false).
+   */
+  template<typename Handler>
+  void parse( std::istream& is, Handler& handler )
+  {
+    BufferedIStreamWrapper instream( is );
+    rapidjson::Reader reader;
+    rapidjson::ParseResult res =
+      reader.Parse<rapidjson::kParseFullPrecisionFlag>( instream, handler );
+    if( not res ) {
+      throw std::runtime_error( std::string("JSON parse error: ")
+                                + rapidjson::GetParseError_En( res.Code() )
+                                + " at " + std::to_string( res.Offset() ));
+    }
+  }
 }
 
 
@@ -0,0 +1,260 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef MINMAX_PYRAMID_HPP
+#define MINMAX_PYRAMID_HPP
+
+/**
+ * Multi-resolution min/max of a time serie, to draw a Curve with about as
+ * many segments as there are pixels, whatever its number of Samples.
+ *
+ * Level k (k>=1) cuts the serie in buckets of BRANCH^(k+1) Samples and
+ * keeps 2 Samples per bucket : the one with min y and the one with max y,
+ * in x order (memory : about 1/6 of the Samples). As a GL_LINE_STRIP, a level is the envelope of the serie :
+ * a spike stays visible at every level.
+ *
+ * add( sample ) updates the last (open) bucket of the levels, from the
+ * finest, and stops at the first one it does not change (the coarser
+ * buckets contain this one) : O(1) amortized. Level k+1 is created when
+ * level k gets its second bucket.
+ * level_for( nb_sample_per_pixel ) gives the coarsest level whose buckets
+ * are not wider than a pixel (0 : draw the Samples themselves).
+ *
+ * Sliding window (the Samples are a SampleStore with a capacity) :
+ * - set_capacity( n ) : no level with buckets wider than n/BRANCH Samples
+ *   (at least BRANCH buckets in the window), about log_BRANCH(n) levels.
+ * - evict( samples ) forgets the buckets that end before the first Sample
+ *   of the window, levels are SampleStore : a comparison per level.
+ * - trim( samples ) : the first bucket of each level, partially evicted,
+ *   is recomputed from the finer level (or the Samples) when one of its
+ *   extrema is gone : O(BRANCH) per level. Needed only before the levels
+ *   are read (drawing), not after every evict. Samples are compared by
+ *   x, which must increase (time serie).
+ * - rebuild( samples ) : levels of the window only, after set_capacity.
+ */
+
+#include <vector>                    // std::vector
+#include <algorithm>                 // std::swap, std::min
+
+#include <sample_store.hpp>          // SampleStore
+#include <gl_buffer.hpp>             // utils::gl::VertexBuffer
+
+// ***************************************************************************
+// ************************************************************* MinMaxPyramid
+// ***************************************************************************
+template<typename Sample>
+class MinMaxPyramid
+{
+public:
+  static const unsigned int BRANCH = 4;
+  // ************************************************** MinMaxPyramid::Level
+  struct Level {
+    /** Samples per bucket */
+    size_t bucket_size;
+    /** Absolute index of the bucket of data[0] */
+    size_t first_bucket;
+    /** 2 Samples per bucket, the last bucket is open */
+    SampleStore<Sample> data;
+    utils::gl::VertexBuffer vbo;
+  };
+  // *********************************************** MinMaxPyramid::creation
+  MinMaxPyramid() : _levels(), _size(0), _capacity(0) {}
+  // ************************************************** MinMaxPyramid::clear
+  /** Remove all levels, keep the capacity */
+  void clear()
+  {
+    _levels.clear();
+    _size = 0;
+  }
+  // ******************************************* MinMaxPyramid::set_capacity
+  /**
+   * Window of 'capacity' Samples (0 : unbounded), levels with wider
+   * buckets are removed and not created any more.
+   */
+  void set_capacity( size_t capacity )
+  {
+    _capacity = capacity;
+    while( not _levels.empty() and not _fits( _levels.back().bucket_size )) {
+      _levels.pop_back();
+    }
+  }
+  size_t get_capacity() const { return _capacity; }
+  // ************************************************ MinMaxPyramid::rebuild
+  /** Levels of 'samples' only, the window of a serie */
+  void rebuild( const SampleStore<Sample>& samples )
+  {
+    clear();
+    _size = samples.first_index();
+    for( auto& s: samples ) add( s );
+  }
+  // **************************************************** MinMaxPyramid::add
+  /** Add 'sample' at the end of the time serie */
+  void add( const Sample& sample )
+  {
+    if( _levels.empty() and _fits( BRANCH * BRANCH )) _new_level( BRANCH * BRANCH );
+    ++_size;
+    // a level created here already contains 'sample'
+    size_t nb_level = _levels.size();
+    for( size_t k = 0; k < nb_level; ++k) {
+      Level& lvl = _levels[k];
+      size_t bucket = (_size - 1) / lvl.bucket_size;
+      if( lvl.data.empty() or bucket != _last_bucket( lvl ) ) {
+        // first Sample of a bucket
+        if( lvl.data.empty() ) lvl.first_bucket = bucket;
+        lvl.data.push_back( sample );
+        lvl.data.push_back( sample );
+        // second bucket => coarser level, from this one
+        if( lvl.data.size() >= 4 and k+1 == nb_level and
+            _fits( lvl.bucket_size * BRANCH ) ) {
+          _new_level( lvl.bucket_size * BRANCH );
+        }
+      }
+      else if( not _merge( lvl, sample )) {
+        break;
+      }
+    }
+  }
+  // ************************************************** MinMaxPyramid::evict
+  /**
+   * 'samples' is the window of the serie : forget the buckets before the
+   * one of its first Sample (which may still hold evicted extrema, see
+   * trim).
+   */
+  void evict( const SampleStore<Sample>& samples )
+  {
+    if( samples.empty() ) return;
+    size_t first = samples.first_index();
+    for( size_t k = 0; k < _levels.size(); ++k) {
+      Level& lvl = _levels[k];
+      // no division while the first bucket is still in the window
+      if( first >= (lvl.first_bucket + 1) * lvl.bucket_size ) {
+        size_t first_bucket = first / lvl.bucket_size;
+        lvl.data.pop_front( 2 * (first_bucket - lvl.first_bucket) );
+        lvl.first_bucket = first_bucket;
+      }
+    }
+  }
+  // *************************************************** MinMaxPyramid::trim
+  /**
+   * After evict( samples ) : recompute the first bucket of the levels
+   * whose extremum has been evicted, finest level first.
+   */
+  void trim( const SampleStore<Sample>& samples )
+  {
+    if( samples.empty() ) return;
+    for( size_t k = 0; k < _levels.size(); ++k) {
+      Level& lvl = _levels[k];
+      if( lvl.data[0].x < samples.front().x or lvl.data[1].x < samples.front().x ) {
+        _trim( k, samples );
+      }
+    }
+  }
+  // *********************************************** MinMaxPyramid::level_for
+  /**
+   * Coarsest level whose buckets have at most 'nb_sample_per_pixel'
+   * Samples, 0 if none.
+   */
+  size_t level_for( double nb_sample_per_pixel ) const
+  {
+    size_t k = 0;
+    while( k < _levels.size() and _levels[k].bucket_size <= nb_sample_per_pixel ) {
+      ++k;
+    }
+    return k;
+  }
+  /** Level k (k >= 1) */
+  Level& level( size_t k ) { return _levels[k-1]; }
+  const Level& level( size_t k ) const { return _levels[k-1]; }
+  /** Nb of levels (level 0, the Samples, excluded) */
+  size_t nb_level() const { return _levels.size(); }
+  size_t size() const { return _size; }
+
+private:
+  // *********************************************** MinMaxPyramid::internals
+  /** Can a level have buckets of 'bucket_size' Samples ? */
+  bool _fits( size_t bucket_size ) const
+  {
+    return _capacity == 0 or bucket_size * BRANCH <= _capacity;
+  }
+  static size_t _last_bucket( const Level& lvl )
+  {
+    return lvl.first_bucket + lvl.data.size() / 2 - 1;
+  }
+  void _new_level( size_t bucket_size )
+  {
+    Level lvl;
+    lvl.bucket_size = bucket_size;
+    lvl.first_bucket = 0;
+    // already seen Samples : extrema of the buckets of the finer level
+    if( not _levels.empty() ) {
+      const Level& finer = _levels.back();
+      for( size_t i = 0; i < finer.data.size(); i += 2) {
+        size_t bucket = (finer.first_bucket + i / 2) / BRANCH;
+        if( lvl.data.empty() ) lvl.first_bucket = bucket;
+        if( lvl.data.empty() or bucket != _last_bucket( lvl ) ) {
+          lvl.data.push_back( finer.data[i] );
+          lvl.data.push_back( finer.data[i+1] );
+        }
+        else {
+          _merge( lvl, finer.data[i] );
+          _merge( lvl, finer.data[i+1] );
+        }
+      }
+    }
+    _levels.push_back( lvl );
+  }
+  /**
+   * First bucket of level k (index) from the Samples of the window it
+   * still contains : Samples for the finest level, else buckets of the
+   * finer level (already evicted).
+   */
+  void _trim( size_t k, const SampleStore<Sample>& samples )
+  {
+    Level& lvl = _levels[k];
+    size_t end = (lvl.first_bucket + 1) * lvl.bucket_size;
+    const SampleStore<Sample>& src = k == 0 ? samples : _levels[k-1].data;
+    size_t n = k == 0 ? end - samples.first_index()
+      : 2 * (end / _levels[k-1].bucket_size - _levels[k-1].first_bucket);
+    n = std::min( n, src.size() );
+    lvl.data[0] = src[0];
+    lvl.data[1] = src[0];
+    for( size_t i = 1; i < n; ++i) _merge( lvl, src[i], 0 );
+    lvl.data.touch( 0 );
+  }
+  /** Merge 'sample' into the last bucket of 'lvl', false if unchanged */
+  static bool _merge( Level& lvl, const Sample& sample )
+  {
+    return _merge( lvl, sample, lvl.data.size() - 2 );
+  }
+  /** Merge 'sample' into the bucket at 'idx' in lvl.data */
+  static bool _merge( Level& lvl, const Sample& sample, size_t idx )
+  {
+    Sample* a = &lvl.data[idx];
+    Sample* b = a + 1;
+    // (a,b) as (lower, upper)
+    if( a->y > b->y ) std::swap( a, b );
+    if( sample.y < a->y ) {
+      // new min, after the max : (max, min) in x order
+      if( b == a + 1 ) { *a = *b; ++a; }
+      *a = sample;
+    }
+    else if( sample.y > b->y ) {
+      // new max, after the min
+      if( a == b + 1 ) { *b = *a; ++b; }
+      *b = sample;
+    }
+    else {
+      return false;
+    }
+    lvl.data.touch( idx );
+    return true;
+  }
+
+  /** Levels 1..n */
+  std::vector<Level> _levels;
+  /** Nb of Samples added (absolute index of the next one) */
+  size_t _size;
+  /** Samples in the window, 0 : unbounded */
+  size_t _capacity;
+};
+
+#endif // MINMAX_PYRAMID_HPP
@@ -0,0 +1,148 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+/**
+ * Split a range of indices between threads.
+ *
+ * utils::parallel::for_range( 0, n, nb_thread,
+ *                             [&] (unsigned int begin, unsigned int end) {
+ *   for( unsigned int i = begin; i < end; ++i) ...
+ * });
+ *
+ * Chunks run on the threads of a persistent Pool (created at first use,
+ * grown on demand), the calling thread taking part : no thread is created
+ * per call. A call made while the Pool is busy (from one of its tasks, or
+ * from another thread) uses its own threads instead.
+ */
+#include <thread>                     // std::thread
+#include <mutex>                      // std::mutex, std::unique_lock
+#include <condition_variable>         // std::condition_variable
+#include <functional>                 // std::function
+#include <vector>                     // std::vector
+#include <algorithm>                  // std::min
+
+namespace utils
+{
+namespace parallel
+{
+  /** Number of threads of the machine (at least 1) */
+  inline unsigned int nb_hardware_thread()
+  {
+    unsigned int nb = std::thread::hardware_concurrency();
+    return (nb == 0) ? 1 : nb;
+  }
+  // ********************************************************************* Pool
+  /** Persistent worker threads running the tasks of one call at a time */
+  class Pool
+  {
+  public:
+    using Task = std::function<void(unsigned int)>;
+    Pool() : _task(nullptr), _next(0), _nb_task(0), _nb_done(0), _stop(false) {}
+    ~Pool()
+    {
+      {
+        std::unique_lock<std::mutex> lock( _mutex );
+        _stop = true;
+      }
+      _cv_work.notify_all();
+      for( auto& t: _threads ) t.join();
+    }
+    Pool( const Pool& ) = delete;
+    Pool& operator=( const Pool& ) = delete;
+    /** Shared by all for_range */
+    static Pool& global() { static Pool pool; return pool; }
+    /**
+     * task(k) for k in [0, nb_task), on at most nb_thread threads (the
+     * caller included). False, and nothing done, if the Pool is busy.
+     */
+    bool run( unsigned int nb_task, unsigned int nb_thread, const Task& task )
+    {
+      std::unique_lock<std::mutex> run_lock( _run_mutex, std::try_to_lock );
+      if( not run_lock.owns_lock() ) return false;
+      while( _threads.size() + 1 < nb_thread ) {
+        _threads.push_back( std::thread( &Pool::_work, this ));
+      }
+      std::unique_lock<std::mutex> lock( _mutex );
+      _task = &task;
+      _next = 0;
+      _nb_done = 0;
+      _nb_task = nb_task;
+      _cv_work.notify_all();
+      _take( lock );
+      _cv_done.wait( lock, [this] { return _nb_done == _nb_task; } );
+      _nb_task = 0;
+      _next = 0;
+      _task = nullptr;
+      return true;
+    }
+  private:
+    /** Run the remaining tasks ('lock' held, except while running) */
+    void _take( std::unique_lock<std::mutex>& lock )
+    {
+      while( _next < _nb_task ) {
+        unsigned int k = _next++;
+        lock.unlock();
+        (*_task)( k );
+        lock.lock();
+        if( ++_nb_done == _nb_task ) _cv_done.notify_all();
+      }
+    }
+    void _work()
+    {
+      std::unique_lock<std::mutex> lock( _mutex );
+      while( true ) {
+        _cv_work.wait( lock, [this] { return _stop or _next < _nb_task; } );
+        if( _stop ) return;
+        _take( lock );
+      }
+    }
+
+    /** Held during a run */
+    std::mutex _run_mutex;
+    std::mutex _mutex;
+    std::condition_variable _cv_work, _cv_done;
+    std::vector<std::thread> _threads;
+    const Task* _task;
+    unsigned int _next, _nb_task, _nb_done;
+    bool _stop;
+  };
+  // **************************************************************** for_range
+  /**
+   * Call f(begin, end) on contiguous chunks of [begin, end), one chunk per
+   * thread. With nb_thread <= 1 (or a small range), f is called directly.
+   * Chunks only depend on the range and nb_thread.
+   */
+  template<class Function>
+  void for_range( unsigned int begin, unsigned int end,
+                  unsigned int nb_thread, Function f )
+  {
+    if( end <= begin ) return;
+    unsigned int size = end - begin;
+    nb_thread = std::min( nb_thread, size );
+    if( nb_thread <= 1 ) {
+      f( begin, end );
+      return;
+    }
+
+    unsigned int chunk = (size + nb_thread - 1) / nb_thread;
+    unsigned int nb_chunk = (size + chunk - 1) / chunk;
+    auto task = [&] (unsigned int k) {
+      f( begin + k * chunk, std::min( begin + (k+1) * chunk, end ));
+    };
+    if( Pool::global().run( nb_chunk, nb_thread, task )) return;
+
+    // Pool busy : threads of our own
+    std::vector<std::thread> threads;
+    for( unsigned int k = 0; k < nb_chunk; ++k) {
+      threads.push_back( std::thread( task, k ));
+    }
+    for( auto& t: threads ) {
+      t.join();
+    }
+  }
+}; // namespace parallel
+}; // namespace utils
+
+#endif // PARALLEL_HPP
@@ -10,11 +10,16 @@
  *
  * update_bbox()
  * render( ratio_x, ratio_y )
+ * render_soft( canvas, ratio_x, ratio_y ) : same, in a SoftCanvas (no OpenGL)
  */
 
 #include <iostream>
+#include <limits>                    // std::numeric_limits
+#include <algorithm>                 // std::max
 #include <visugl.hpp>
 
+class SoftCanvas;
+
 // ***************************************************************************
 // ******************************************************************* Plotter
 // ***************************************************************************
@@ -59,10 +64,39 @@ public:
   {
     std::cout << "__Plotter::render: TO IMPLEMENT" << std::endl;
   }
+  /** Plotters without software rendering draw nothing */
+  virtual void render_soft( SoftCanvas& canvas,
+                            float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  {
+  }
   // ****************************************************** Plotter::attributs
   /** get BoundingBox */
   const BoundingBox& get_bbox() const {return _bbox;}
   void set_bbox( const BoundingBox& bbox ) { _bbox = bbox; }
+  /** BoundingBox around the (updated) _plotters, with 5% margins */
+  BoundingBox outer_bbox()
+  {
+    BoundingBox bbox{ std::numeric_limits<double>::max(),
+        (-std::numeric_limits<double>::max()),
+        std::numeric_limits<double>::max(),
+        -std::numeric_limits<double>::max() };
+    
+    for( const auto& plotter: _plotters ) {
+      plotter->update_bbox();
+      auto b = plotter->get_bbox();
+      if( b.x_min < bbox.x_min ) bbox.x_min = b.x_min;
+      if( b.x_max > bbox.x_max ) bbox.x_max = std::max( b.x_max, b.x_min+0.1 );
+      if( b.y_min < bbox.y_min ) bbox.y_min = b.y_min;
+      if( b.y_max > bbox.y_max ) bbox.y_max = std::max( b.y_max, b.y_min+0.1 );
+    }
+    auto range_x = bbox.x_max - bbox.x_min;
+    bbox.x_min = bbox.x_min - 0.05 * range_x;
+    bbox.x_max = bbox.x_max + 0.05 * range_x;
+    auto range_y = bbox.y_max - bbox.y_min;
+    bbox.y_min = bbox.y_min - 0.05 * range_y;
+    bbox.y_max = bbox.y_max + 0.05 * range_y;
+    return bbox;
+  }
 
   /** Other things to plot */
   PlotterList _plotters;
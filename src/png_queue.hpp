@@ -0,0 +1,172 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef PNG_QUEUE_HPP
+#define PNG_QUEUE_HPP
+
+/**
+ * Write RGB images as PNG without blocking the caller.
+ *
+ * - Image : width x height RGB bytes, rows from bottom to top (as read
+ *   by glReadPixels).
+ * - write_png( filename, image ) : encode with libpng, whole rows at once.
+ * - PngQueue : one worker thread encodes and writes the pushed Images.
+ *   push() only blocks when 'max_pending' Images are already waiting
+ *   (memory stays bounded if the disk is slow). flush() waits until
+ *   everything is written, the destructor flushes.
+ *   PngQueue::global() is shared by the whole program.
+ */
+
+#include <string>                    // std::string
+#include <vector>                    // std::vector
+#include <deque>                     // std::deque
+#include <utility>                   // std::move
+#include <cstdio>                    // std::fopen
+#include <iostream>                  // std::cerr
+#include <thread>                    // std::thread
+#include <mutex>                     // std::mutex
+#include <condition_variable>        // std::condition_variable
+#include <atomic>                    // std::atomic
+
+#define PNG_SKIP_SETJMP_CHECK        // see /usr/include/libpng12/pngconf.h:383
+#include <png.h>
+
+namespace utils {
+// ********************************************************************* Image
+struct Image {
+  unsigned int width = 0, height = 0;
+  /** 3 bytes per pixel, bottom row first */
+  std::vector<unsigned char> rgb;
+};
+// ***************************************************************** write_png
+/** false (and message on std::cerr) if 'filename' could not be written */
+inline bool write_png( const std::string& filename, const Image& img )
+{
+  if( img.width == 0 or img.height == 0 or
+      img.rgb.size() < 3 * img.width * img.height ) {
+    std::cerr << "write_png: bad image for " << filename << std::endl;
+    return false;
+  }
+  FILE* file = std::fopen( filename.c_str(), "wb" );
+  if( not file ) {
+    std::cerr << "write_png: cannot open " << filename << std::endl;
+    return false;
+  }
+  // PNG rows go from top to bottom (built before setjmp)
+  std::vector<png_bytep> rows( img.height );
+  for( unsigned int y = 0; y < img.height; ++y) {
+    rows[y] = (png_bytep) &img.rgb[3 * img.width * (img.height - 1 - y)];
+  }
+  png_structp png = png_create_write_struct( PNG_LIBPNG_VER_STRING,
+                                             NULL, NULL, NULL );
+  png_infop info = png ? png_create_info_struct( png ) : NULL;
+  if( not info or setjmp( png_jmpbuf( png ))) {
+    std::cerr << "write_png: libpng error for " << filename << std::endl;
+    png_destroy_write_struct( &png, &info );
+    std::fclose( file );
+    return false;
+  }
+  png_init_io( png, file );
+  // plots are mostly uniform : fast compression is nearly as small
+  png_set_compression_level( png, 1 );
+  png_set_IHDR( png, info, img.width, img.height, 8, PNG_COLOR_TYPE_RGB,
+                PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                PNG_FILTER_TYPE_DEFAULT );
+  png_set_rows( png, info, rows.data() );
+  png_write_png( png, info, PNG_TRANSFORM_IDENTITY, NULL );
+  png_destroy_write_struct( &png, &info );
+  return std::fclose( file ) == 0;
+}
+
+// ***************************************************************************
+// ****************************************************************** PngQueue
+// ***************************************************************************
+class PngQueue
+{
+public:
+  // ***************************************************** PngQueue::creation
+  PngQueue( unsigned int max_pending = 4 ) :
+    _max_pending( max_pending > 0 ? max_pending : 1 ),
+    _busy( false ), _stop( false ), _nb_written( 0 ), _nb_error( 0 )
+  {
+    _worker = std::thread( &PngQueue::_run, this );
+  }
+  PngQueue( const PngQueue& ) = delete;
+  PngQueue& operator=( const PngQueue& ) = delete;
+  ~PngQueue()
+  {
+    {
+      std::unique_lock<std::mutex> lock( _mutex );
+      _stop = true;
+    }
+    _cond.notify_all();
+    _worker.join();
+  }
+  /** Shared by the whole program, flushed at exit */
+  static PngQueue& global()
+  {
+    static PngQueue queue;
+    return queue;
+  }
+  // ********************************************************* PngQueue::push
+  /** Write 'img' in 'filename' later ('img' is moved) */
+  void push( const std::string& filename, Image&& img )
+  {
+    std::unique_lock<std::mutex> lock( _mutex );
+    _cond.wait( lock, [this] { return _jobs.size() < _max_pending; } );
+    _jobs.push_back( Job{ filename, std::move( img ) } );
+    _cond.notify_all();
+  }
+  // ******************************************************** PngQueue::flush
+  /** Wait until all pushed Images are written */
+  void flush()
+  {
+    std::unique_lock<std::mutex> lock( _mutex );
+    _cond.wait( lock, [this] { return _jobs.empty() and not _busy; } );
+  }
+  // **************************************************** PngQueue::attributs
+  /** Images written (or failed) so far, read while the worker runs */
+  unsigned int nb_written() const { return _nb_written.load(); }
+  unsigned int nb_error() const { return _nb_error.load(); }
+
+private:
+  // **************************************************** PngQueue::internals
+  struct Job {
+    std::string filename;
+    Image img;
+  };
+  void _run()
+  {
+    std::unique_lock<std::mutex> lock( _mutex );
+    while( true ) {
+      _cond.wait( lock, [this] { return _stop or not _jobs.empty(); } );
+      // remaining jobs are written before stopping
+      if( _jobs.empty() ) return;
+      Job job = std::move( _jobs.front() );
+      _jobs.pop_front();
+      _busy = true;
+      _cond.notify_all();
+
+      lock.unlock();
+      bool ok = write_png( job.filename, job.img );
+      lock.lock();
+
+      if( ok ) ++_nb_written; else ++_nb_error;
+      _busy = false;
+      _cond.notify_all();
+    }
+  }
+
+  unsigned int _max_pending;
+  std::deque<Job> _jobs;
+  /** Worker is writing a Job */
+  bool _busy;
+  bool _stop;
+  std::atomic<unsigned int> _nb_written, _nb_error;
+  std::mutex _mutex;
+  std::condition_variable _cond;
+  std::thread _worker;
+};
+
+}; // namespace utils
+
+#endif // PNG_QUEUE_HPP
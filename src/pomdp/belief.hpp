@@ -0,0 +1,209 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef POMDP_BELIEF_HPP
+#define POMDP_BELIEF_HPP
+
+/**
+ * Filtre bayésien exact des états de croyance d'un POMDP :
+ *   b'(s') ∝ O(o|s') * sum_s T(s,a,s') b(s)
+ * La constante de normalisation est P(o | passé, a), la prédiction
+ * optimale de l'observation ; -log de celle-ci donne l'entropie croisée.
+ *
+ * - BeliefModel : T creux par action (CSR), O rangé par observation
+ * - BeliefFilter : boucle sans allocation, une trajectoire
+ * - filter_batch : épisodes consécutifs d'un Trajectory::POMDP::Data
+ *   (comme écrits par Model::BatchSimulator), en parallèle
+ */
+
+#include <vector>                    // std::vector
+#include <algorithm>                 // std::fill, std::copy
+#include <cmath>                     // log
+#include <limits>                    // infinity
+
+#include <pomdp/pomdp.hpp>
+#include <pomdp/trajectory.hpp>
+#include <parallel.hpp>              // utils::parallel::for_range
+
+namespace Algorithms
+{
+// ***************************************************************************
+// *************************************************************** BeliefModel
+// ***************************************************************************
+class BeliefModel
+{
+public:
+  // *************************************************** BeliefModel::creation
+  BeliefModel( const Model::POMDP& pomdp ) :
+    _nb_states(pomdp._states.size()), _nb_actions(pomdp._actions.size()),
+    _nb_obs(pomdp._obs.size()),
+    _row(_nb_actions * (_nb_states+1), 0),
+    _obs_lik(_nb_obs * _nb_states, 0.0)
+  {
+    // T : une matrice CSR (lignes s) par action
+    for( unsigned int a = 0; a < _nb_actions; ++a) {
+      unsigned int* row = &_row[a * (_nb_states+1)];
+      row[0] = _col.size();
+      for( unsigned int s = 0; s < _nb_states; ++s) {
+        pomdp._trans[s][a].for_each( [this] (unsigned int sp, double p) {
+          _col.push_back( sp );
+          _val.push_back( p );
+        });
+        row[s+1] = _col.size();
+      }
+    }
+    // O(o|s), une ligne par observation
+    for( unsigned int s = 0; s < _nb_states; ++s) {
+      pomdp._percep[s].for_each( [this,s] (unsigned int o, double p) {
+        _obs_lik[o * _nb_states + s] = p;
+      });
+    }
+  }
+  // ************************************************** BeliefModel::attributs
+  unsigned int nb_states() const { return _nb_states; }
+  unsigned int nb_actions() const { return _nb_actions; }
+  unsigned int nb_obs() const { return _nb_obs; }
+  /** CSR de T(.,a,.) : lignes [row[s], row[s+1]) */
+  const unsigned int* row( unsigned int a ) const { return &_row[a * (_nb_states+1)]; }
+  const unsigned int* col() const { return _col.data(); }
+  const double* val() const { return _val.data(); }
+  /** O(o|s) pour tous les s */
+  const double* obs_lik( unsigned int o ) const { return &_obs_lik[o * _nb_states]; }
+private:
+  unsigned int _nb_states, _nb_actions, _nb_obs;
+  std::vector<unsigned int> _row;
+  std::vector<unsigned int> _col;
+  std::vector<double> _val;
+  std::vector<double> _obs_lik;
+};
+// ***************************************************************************
+// ************************************************************** BeliefFilter
+// ***************************************************************************
+class BeliefFilter
+{
+public:
+  using Belief = std::vector<double>;
+  // ************************************************** BeliefFilter::creation
+  BeliefFilter( const BeliefModel& model ) :
+    _model(model), _b(model.nb_states(), 0.0), _next(model.nb_states(), 0.0)
+  {}
+  // ***************************************************** BeliefFilter::update
+  /**
+   * b = prior conditionné par la première observation o.
+   * Retourne P(o | prior).
+   */
+  double reset( const Belief& prior, unsigned int o )
+  {
+    _b = prior;
+    return condition( _b, o );
+  }
+  /**
+   * Action a puis observation o : b <- O(o|.) T(.|.,a)^T b, normalisé.
+   * Retourne P(o | passé, a). Si o est impossible (P = 0), b devient
+   * uniforme sur les états compatibles avec o.
+   */
+  double update( unsigned int a, unsigned int o )
+  {
+    unsigned int nb_s = _model.nb_states();
+    std::fill( _next.begin(), _next.end(), 0.0 );
+    const unsigned int* row = _model.row( a );
+    const unsigned int* col = _model.col();
+    const double* val = _model.val();
+    for( unsigned int s = 0; s < nb_s; ++s) {
+      double bs = _b[s];
+      if( bs == 0.0 ) continue;
+      for( unsigned int k = row[s]; k < row[s+1]; ++k) {
+        _next[col[k]] += val[k] * bs;
+      }
+    }
+    _b.swap( _next );
+    return condition( _b, o );
+  }
+  const Belief& belief() const { return _b; }
+  // ***************************************************** BeliefFilter::filter
+  /**
+   * Filtre les Items [begin, end) d'une trajectoire depuis 'prior'
+   * (conditionné par begin->id_o). Si 'out' n'est pas nullptr, la croyance
+   * après chaque Item y est écrite (nb_states valeurs par Item).
+   * Retourne la somme des -log P(o' | passé, a) (en nats).
+   */
+  template<class Iterator>
+  double filter( Iterator begin, Iterator end, const Belief& prior,
+                 double* out = nullptr )
+  {
+    if( begin == end ) return 0.0;
+    reset( prior, begin->id_o );
+    double nll = 0.0;
+    unsigned int nb_s = _model.nb_states();
+    for( Iterator it = begin; it != end; ++it) {
+      double p = update( it->id_a, it->id_next_o );
+      nll += (p > 0.0) ? -log( p ) : std::numeric_limits<double>::infinity();
+      if( out ) {
+        std::copy( _b.begin(), _b.end(), out );
+        out += nb_s;
+      }
+    }
+    return nll;
+  }
+private:
+  /** b <- O(o|.) b normalisé, retourne la somme avant normalisation */
+  double condition( Belief& b, unsigned int o ) const
+  {
+    const double* lik = _model.obs_lik( o );
+    double norm = 0.0;
+    for( unsigned int s = 0; s < b.size(); ++s) {
+      b[s] *= lik[s];
+      norm += b[s];
+    }
+    if( norm > 0.0 ) {
+      for( auto& bs: b ) bs /= norm;
+      return norm;
+    }
+    // observation impossible : uniforme sur les états compatibles
+    double sum_lik = 0.0;
+    for( unsigned int s = 0; s < b.size(); ++s) sum_lik += lik[s];
+    for( unsigned int s = 0; s < b.size(); ++s) {
+      b[s] = (sum_lik > 0.0) ? lik[s] / sum_lik : 1.0 / b.size();
+    }
+    return 0.0;
+  }
+  const BeliefModel& _model;
+  Belief _b;
+  Belief _next;
+};
+// ***************************************************************************
+// ************************************************************** filter_batch
+// ***************************************************************************
+/**
+ * Filtre les épisodes de 'length' Items consécutifs de 'data', chacun
+ * depuis 'prior', avec nb_thread threads.
+ * Retourne -log P(o') de chaque épisode (somme, en nats).
+ * Si 'beliefs' n'est pas nullptr, il reçoit data.size() * nb_states
+ * valeurs (croyance après chaque Item).
+ */
+inline std::vector<double>
+filter_batch( const BeliefModel& model,
+              const Trajectory::POMDP::Data& data, unsigned int length,
+              const BeliefFilter::Belief& prior,
+              unsigned int nb_thread = 1,
+              std::vector<double>* beliefs = nullptr )
+{
+  unsigned int nb_episode = (length > 0) ? data.size() / length : 0;
+  std::vector<double> nll( nb_episode, 0.0 );
+  if( beliefs ) beliefs->resize( (size_t) nb_episode * length * model.nb_states() );
+  utils::parallel::for_range( 0, nb_episode, nb_thread,
+                              [&] (unsigned int begin, unsigned int end) {
+    BeliefFilter filter( model );
+    for( unsigned int k = begin; k < end; ++k) {
+      double* out = nullptr;
+      if( beliefs ) out = &(*beliefs)[(size_t) k * length * model.nb_states()];
+      nll[k] = filter.filter( data.begin() + (size_t) k * length,
+                              data.begin() + (size_t) (k+1) * length,
+                              prior, out );
+    }
+  });
+  return nll;
+}
+
+}; // namespace Algorithms
+
+#endif // POMDP_BELIEF_HPP
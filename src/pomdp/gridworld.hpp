@@ -0,0 +1,189 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef POMDP_GRIDWORLD_HPP
+#define POMDP_GRIDWORLD_HPP
+
+/**
+ * Gridworlds POMDP de grande taille (10^4 à 10^6 états).
+ * - carte : lignes de caractères, '#' = mur, 'G' = but, le reste est libre
+ *   (hors des lignes = mur). Un état par case libre, label "x,y".
+ * - make_maze : labyrinthe parfait aléatoire (DFS) de w x h cellules.
+ * - make_gridworld : actions Up, Ri, Do, Le. L'action voulue réussit avec
+ *   prob_success, chaque autre direction a (1-prob_success)/3. Vers un mur
+ *   on reste sur place. Observation : les murs autour (4 bits, 16 obs) ou
+ *   "G" sur le but. Récompense 10 sur le but, -1 ailleurs (comme le
+ *   cheese maze de xp-002).
+ * Toutes les Transition sont creuses (Transition::set_sparse), la taille
+ * du modèle est en O(nb_states).
+ */
+
+#include <vector>                    // std::vector
+#include <string>                    // std::string
+#include <istream>                   // std::istream
+#include <algorithm>                 // std::sort
+#include <utility>                   // std::pair
+#include <stdexcept>                 // std::runtime_error
+
+#include <pomdp/pomdp.hpp>
+#include <pomdp/simulator.hpp>       // Model::RandomStream
+
+// ********************************************************************* Model
+namespace Model
+{
+using GridMap = std::vector<std::string>;
+
+/** Lit une carte, une ligne par rangée */
+inline GridMap read_map( std::istream& is )
+{
+  GridMap map;
+  std::string line;
+  while( std::getline( is, line )) {
+    if( not line.empty() and line.back() == '\r' ) line.pop_back();
+    map.push_back( line );
+  }
+  return map;
+}
+/** Case libre ? (hors de la carte = mur) */
+inline bool is_free( const GridMap& map, int x, int y )
+{
+  if( y < 0 or y >= (int) map.size() ) return false;
+  if( x < 0 or x >= (int) map[y].size() ) return false;
+  return map[y][x] != '#';
+}
+// ***************************************************************************
+// ***************************************************************** make_maze
+// ***************************************************************************
+/**
+ * Labyrinthe parfait de w x h cellules, carte de (2h+1) x (2w+1)
+ * caractères. DFS itératif depuis (0,0), but dans la cellule (w-1,h-1).
+ * Environ 2*w*h cases libres.
+ */
+inline GridMap make_maze( unsigned int w, unsigned int h, uint64_t seed )
+{
+  GridMap map( 2*h+1, std::string( 2*w+1, '#' ));
+  if( w == 0 or h == 0 ) return map;
+  RandomStream rnd( seed, 0 );
+  const int dx[4] = {0, 1, 0, -1};
+  const int dy[4] = {-1, 0, 1, 0};
+  std::vector<bool> visited( w*h, false );
+  std::vector<unsigned int> stack = {0};
+  visited[0] = true;
+  map[1][1] = ' ';
+  while( not stack.empty() ) {
+    unsigned int cell = stack.back();
+    int cx = cell % w, cy = cell / w;
+    // voisins non visités
+    unsigned int next[4], nb_next = 0;
+    for( unsigned int d = 0; d < 4; ++d) {
+      int nx = cx + dx[d], ny = cy + dy[d];
+      if( nx < 0 or ny < 0 or nx >= (int) w or ny >= (int) h ) continue;
+      if( not visited[ny*w+nx] ) next[nb_next++] = d;
+    }
+    if( nb_next == 0 ) {
+      stack.pop_back();
+      continue;
+    }
+    unsigned int d = next[rnd.uniform_int( nb_next )];
+    int nx = cx + dx[d], ny = cy + dy[d];
+    map[2*cy+1+dy[d]][2*cx+1+dx[d]] = ' ';
+    map[2*ny+1][2*nx+1] = ' ';
+    visited[ny*w+nx] = true;
+    stack.push_back( ny*w+nx );
+  }
+  map[2*h-1][2*w-1] = 'G';
+  return map;
+}
+// ***************************************************************************
+// ************************************************************ make_gridworld
+// ***************************************************************************
+/** std::runtime_error si la carte n'a aucune case libre */
+inline POMDP make_gridworld( const GridMap& map, double prob_success = 1.0 )
+{
+  // Actions : UP, RIGHT, DOWN, LEFT
+  const int dx[4] = {0, 1, 0, -1};
+  const int dy[4] = {-1, 0, 1, 0};
+
+  // un état par case libre, ligne par ligne
+  std::vector<Node> states;
+  std::vector<std::vector<int>> id( map.size() );
+  for( unsigned int y = 0; y < map.size(); ++y) {
+    id[y].assign( map[y].size(), -1 );
+    for( unsigned int x = 0; x < map[y].size(); ++x) {
+      if( is_free( map, x, y )) {
+        id[y][x] = states.size();
+        states.push_back( {(unsigned int) states.size(),
+                           std::to_string(x) + "," + std::to_string(y)} );
+      }
+    }
+  }
+  if( states.empty() )
+    throw std::runtime_error( "make_gridworld: the map has no free cell" );
+  // observations : murs U,R,D,L (bit d) puis le but
+  std::vector<Node> obs;
+  for( unsigned int m = 0; m < 16; ++m) {
+    std::string label = "....";
+    for( unsigned int d = 0; d < 4; ++d) {
+      if( m & (1 << d) ) label[d] = "URDL"[d];
+    }
+    obs.push_back( {m, label} );
+  }
+  obs.push_back( {16, "G"} );
+
+  std::vector<std::vector<Transition>> trans( states.size() );
+  std::vector<Transition> percep( states.size() );
+  std::vector<double> reward( states.size(), -1.0 );
+  std::vector<std::pair<unsigned int,double>> next;
+  std::vector<unsigned int> idx;
+  std::vector<double> val;
+  for( unsigned int y = 0; y < map.size(); ++y) {
+    for( unsigned int x = 0; x < map[y].size(); ++x) {
+      if( id[y][x] < 0 ) continue;
+      unsigned int s = id[y][x];
+      unsigned int dest[4];
+      unsigned int walls = 0;
+      for( unsigned int d = 0; d < 4; ++d) {
+        if( is_free( map, x+dx[d], y+dy[d] )) {
+          dest[d] = id[y+dy[d]][x+dx[d]];
+        }
+        else {
+          dest[d] = s;
+          walls |= 1 << d;
+        }
+      }
+      trans[s].resize( 4 );
+      for( unsigned int a = 0; a < 4; ++a) {
+        next.clear();
+        for( unsigned int d = 0; d < 4; ++d) {
+          next.push_back( {dest[d], (d == a) ? prob_success : (1.0 - prob_success) / 3.0} );
+        }
+        // regroupe les destinations identiques
+        std::sort( next.begin(), next.end() );
+        idx.clear();
+        val.clear();
+        for( auto& n: next ) {
+          if( not idx.empty() and idx.back() == n.first ) val.back() += n.second;
+          else {
+            idx.push_back( n.first );
+            val.push_back( n.second );
+          }
+        }
+        trans[s][a].set_sparse( idx, val );
+      }
+      if( map[y][x] == 'G' ) {
+        reward[s] = 10.0;
+        percep[s].set_sparse( {16}, {1.0} );
+      }
+      else {
+        percep[s].set_sparse( {walls}, {1.0} );
+      }
+    }
+  }
+
+  return POMDP( states, obs,
+                {{0,"Up"},{1,"Ri"},{2,"Do"},{3,"Le"}},
+                std::move( trans ), std::move( percep ), reward );
+}
+
+}; // namespace Model
+
+#endif // POMDP_GRIDWORLD_HPP
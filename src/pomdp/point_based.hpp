@@ -0,0 +1,406 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef POMDP_POINT_BASED_HPP
+#define POMDP_POINT_BASED_HPP
+
+/**
+ * Résolution approchée d'un POMDP par points de croyance (PBVI, Perseus).
+ * V(b) = max_alpha b.alpha, chaque alpha-vecteur porte une action.
+ *
+ * Backup en b (R ne dépend que de l'état, comme dans compute_Q) :
+ *   g_ao^alpha(s) = sum_s' T(s,a,s') O(o|s') alpha(s')
+ *   alpha_b = R + gamma sum_o argmax_{g_ao^alpha} b.g_ao^alpha, meilleur a
+ * Les g_ao^alpha sont calculés une fois par itération (en parallèle sur
+ * les alpha), avec les matrices creuses de BeliefModel, et rangés dans
+ * une matrice : les b.g_ao^alpha de plusieurs points sont un seul produit.
+ *  - PBVI : backup de tous les points (en parallèle), en gardant l'ancien
+ *           vecteur là où le backup est moins bon, puis élagage
+ *  - PERSEUS : backups de points tirés au hasard parmi ceux dont la
+ *              valeur n'a pas encore augmenté (V ne décroît jamais)
+ * Arrêt quand le résidu de Bellman sur les points est sous epsilon
+ * (backups de tous les points, en parallèle).
+ */
+
+#include <vector>                    // std::vector
+#include <algorithm>                 // std::max
+#include <cmath>                     // fabs, pow
+#include <limits>                    // lowest dbl
+#include <cstdint>                   // uint64_t
+#include <Eigen/Dense>
+
+#include <pomdp/pomdp.hpp>
+#include <pomdp/belief.hpp>          // BeliefModel, BeliefFilter
+#include <pomdp/simulator.hpp>       // Model::RandomStream
+#include <parallel.hpp>              // utils::parallel::for_range
+
+namespace Algorithms
+{
+// ***************************************************************************
+// ********************************************************** PointBasedSolver
+// ***************************************************************************
+class PointBasedSolver
+{
+public:
+  enum class Method { PBVI, PERSEUS };
+  using Belief = BeliefFilter::Belief;
+  struct Alpha {
+    std::vector<double> v;
+    unsigned int action;
+  };
+public:
+  // ********************************************** PointBasedSolver::creation
+  PointBasedSolver( const Model::POMDP& pomdp, double gamma = 0.95,
+                    Method method = Method::PERSEUS,
+                    unsigned int nb_thread = 1 ) :
+    _pomdp(pomdp), _model(pomdp), _gamma(gamma), _method(method),
+    _nb_thread(nb_thread), _nb_ite(0), _nb_backup(0), _residual(0.0)
+  {
+    // V0 : un seul vecteur, min R / (1-gamma) partout
+    double r_min = *std::min_element( pomdp._reward.begin(), pomdp._reward.end() );
+    _alphas.push_back( Alpha{ std::vector<double>( _model.nb_states(),
+                                                   r_min / (1.0 - gamma) ), 0 } );
+  }
+  // *********************************************** PointBasedSolver::beliefs
+  void add_belief( const Belief& b ) { _beliefs.push_back( b ); }
+  /**
+   * Ajoute jusqu'à nb_belief croyances distinctes (distance L1 > 1e-6),
+   * rencontrées lors de marches aléatoires de 'length' pas depuis 'prior'.
+   */
+  void collect_beliefs( const Belief& prior, unsigned int nb_belief,
+                        uint64_t seed, unsigned int length = 50 )
+  {
+    BeliefFilter filter( _model );
+    unsigned int nb_s = _model.nb_states();
+    unsigned int target = _beliefs.size() + nb_belief;
+    unsigned int nb_try = 0;
+    for( uint64_t episode = 0; _beliefs.size() < target and nb_try < 100 * nb_belief; ++episode) {
+      Model::RandomStream rnd( seed, episode );
+      unsigned int s = draw( prior, rnd.uniform_pos() );
+      unsigned int o = _pomdp._percep[s].sample( rnd.uniform_pos() );
+      filter.reset( prior, o );
+      for( unsigned int t = 0; t < length and _beliefs.size() < target; ++t) {
+        ++nb_try;
+        add_if_new( filter.belief(), nb_s );
+        unsigned int a = rnd.uniform_int( _model.nb_actions() );
+        s = _pomdp._trans[s][a].sample( rnd.uniform_pos() );
+        o = _pomdp._percep[s].sample( rnd.uniform_pos() );
+        filter.update( a, o );
+      }
+    }
+  }
+  // ************************************************* PointBasedSolver::solve
+  /**
+   * Itère jusqu'à max_ite, ou quand un backup n'augmente la valeur
+   * d'aucun point de plus de epsilon (résidu de Bellman sur les points).
+   * Retourne le nombre d'itérations.
+   */
+  unsigned int solve( unsigned int max_ite = 100, double epsilon = 1e-4,
+                      uint64_t seed = 0 )
+  {
+    _nb_ite = 0;
+    _nb_backup = 0;
+    std::vector<Alpha> next;
+    compute_g();
+    _residual = backup_all( next );
+    while( _residual > epsilon and _nb_ite < max_ite ) {
+      if( _method == Method::PBVI ) {
+        _alphas.swap( next );
+        prune();
+      }
+      else {
+        iterate_perseus( seed );
+      }
+      ++_nb_ite;
+      compute_g();
+      _residual = backup_all( next );
+    }
+    return _nb_ite;
+  }
+  // ************************************************ PointBasedSolver::policy
+  /** max_alpha b.alpha (et indice de alpha) */
+  double value( const Belief& b, unsigned int* idx = nullptr ) const
+  {
+    double best = std::numeric_limits<double>::lowest();
+    for( unsigned int i = 0; i < _alphas.size(); ++i) {
+      double v = dot( b, _alphas[i].v );
+      if( v > best ) {
+        best = v;
+        if( idx ) *idx = i;
+      }
+    }
+    return best;
+  }
+  unsigned int action( const Belief& b ) const
+  {
+    unsigned int idx = 0;
+    value( b, &idx );
+    return _alphas[idx].action;
+  }
+  /**
+   * Moyenne sur nb_episode épisodes de sum_t gamma^t R(s_t), sur 'length'
+   * pas depuis s_0 tiré dans 'prior', actions de la politique.
+   * 'policy(b)' peut remplacer la politique du solveur (ex. QMDP).
+   */
+  template<class Policy>
+  double evaluate( const Belief& prior, unsigned int nb_episode,
+                   unsigned int length, uint64_t seed, Policy policy ) const
+  {
+    std::vector<double> ret( nb_episode, 0.0 );
+    utils::parallel::for_range( 0, nb_episode, _nb_thread,
+                                [&] (unsigned int begin, unsigned int end) {
+      BeliefFilter filter( _model );
+      for( unsigned int k = begin; k < end; ++k) {
+        Model::RandomStream rnd( seed, k );
+        unsigned int s = draw( prior, rnd.uniform_pos() );
+        filter.reset( prior, _pomdp._percep[s].sample( rnd.uniform_pos() ));
+        double disc = 1.0;
+        for( unsigned int t = 0; t < length; ++t) {
+          ret[k] += disc * _pomdp._reward[s];
+          disc *= _gamma;
+          unsigned int a = policy( filter.belief() );
+          s = _pomdp._trans[s][a].sample( rnd.uniform_pos() );
+          filter.update( a, _pomdp._percep[s].sample( rnd.uniform_pos() ));
+        }
+      }
+    });
+    double sum = 0.0;
+    for( auto& r: ret ) sum += r;
+    return sum / nb_episode;
+  }
+  double evaluate( const Belief& prior, unsigned int nb_episode,
+                   unsigned int length, uint64_t seed ) const
+  {
+    return evaluate( prior, nb_episode, length, seed,
+                     [this] (const Belief& b) { return action( b ); } );
+  }
+  // ********************************************* PointBasedSolver::attributs
+  const std::vector<Alpha>& get_alphas() const { return _alphas; }
+  const std::vector<Belief>& get_beliefs() const { return _beliefs; }
+  const BeliefModel& get_model() const { return _model; }
+  unsigned int get_nb_ite() const { return _nb_ite; }
+  /** Backups de points faits par le dernier solve */
+  unsigned long get_nb_backup() const { return _nb_backup; }
+  /** Résidu de Bellman sur les points à la fin du dernier solve */
+  double get_residual() const { return _residual; }
+private:
+  // ************************************************* PointBasedSolver::tools
+  static double dot( const Belief& b, const std::vector<double>& v )
+  {
+    double acc = 0.0;
+    for( unsigned int s = 0; s < b.size(); ++s) acc += b[s] * v[s];
+    return acc;
+  }
+  /** s tiré selon b, avec u dans ]0,1] */
+  static unsigned int draw( const Belief& b, double u )
+  {
+    double sum = 0.0;
+    for( unsigned int s = 0; s < b.size(); ++s) {
+      sum += b[s];
+      if( u <= sum ) return s;
+    }
+    return b.size()-1;
+  }
+  void add_if_new( const Belief& b, unsigned int nb_s )
+  {
+    for( auto& other: _beliefs ) {
+      double dist = 0.0;
+      for( unsigned int s = 0; s < nb_s; ++s) dist += fabs( b[s] - other[s] );
+      if( dist <= 1e-6 ) return;
+    }
+    _beliefs.push_back( b );
+  }
+  /** Valeur de chaque point */
+  std::vector<double> values() const
+  {
+    std::vector<double> v( _beliefs.size() );
+    for( unsigned int i = 0; i < _beliefs.size(); ++i) v[i] = value( _beliefs[i] );
+    return v;
+  }
+  // ************************************************ PointBasedSolver::backup
+  /** ligne (i*A + a)*O + o de _g = g_ao^alpha_i */
+  void compute_g()
+  {
+    unsigned int nb_s = _model.nb_states();
+    unsigned int nb_a = _model.nb_actions();
+    unsigned int nb_o = _model.nb_obs();
+    _g.resize( _alphas.size() * nb_a * nb_o, nb_s );
+    utils::parallel::for_range( 0, _alphas.size(), _nb_thread,
+                                [&] (unsigned int begin, unsigned int end) {
+      std::vector<double> lik_alpha( nb_s );
+      for( unsigned int i = begin; i < end; ++i) {
+        for( unsigned int o = 0; o < nb_o; ++o) {
+          const double* lik = _model.obs_lik( o );
+          for( unsigned int sp = 0; sp < nb_s; ++sp) {
+            lik_alpha[sp] = lik[sp] * _alphas[i].v[sp];
+          }
+          for( unsigned int a = 0; a < nb_a; ++a) {
+            unsigned int r = (i*nb_a + a)*nb_o + o;
+            const unsigned int* row = _model.row( a );
+            for( unsigned int s = 0; s < nb_s; ++s) {
+              double acc = 0.0;
+              for( unsigned int k = row[s]; k < row[s+1]; ++k) {
+                acc += _model.val()[k] * lik_alpha[_model.col()[k]];
+              }
+              _g( r, s ) = acc;
+            }
+          }
+        }
+      }
+    });
+  }
+  /** Nouvel alpha-vecteur optimal en b, d = _g * b */
+  Alpha backup( const Belief& b, const double* d ) const
+  {
+    unsigned int nb_s = _model.nb_states();
+    unsigned int nb_a = _model.nb_actions();
+    unsigned int nb_o = _model.nb_obs();
+    unsigned int nb_alpha = _g.rows() / (nb_a * nb_o);
+    Alpha best{ std::vector<double>( nb_s ), 0 };
+    double best_val = std::numeric_limits<double>::lowest();
+    std::vector<double> v( nb_s );
+    for( unsigned int a = 0; a < nb_a; ++a) {
+      for( unsigned int s = 0; s < nb_s; ++s) v[s] = _pomdp._reward[s];
+      for( unsigned int o = 0; o < nb_o; ++o) {
+        unsigned int i_best = 0;
+        double g_best = std::numeric_limits<double>::lowest();
+        for( unsigned int i = 0; i < nb_alpha; ++i) {
+          double gv = d[(i*nb_a + a)*nb_o + o];
+          if( gv > g_best ) {
+            g_best = gv;
+            i_best = i;
+          }
+        }
+        unsigned int r = (i_best*nb_a + a)*nb_o + o;
+        for( unsigned int s = 0; s < nb_s; ++s) v[s] += _gamma * _g( r, s );
+      }
+      double val = dot( b, v );
+      if( val > best_val ) {
+        best_val = val;
+        best.v = v;
+        best.action = a;
+      }
+    }
+    return best;
+  }
+  Alpha backup( const Belief& b ) const
+  {
+    Eigen::VectorXd d = _g * Eigen::Map<const Eigen::VectorXd>( b.data(), b.size() );
+    return backup( b, d.data() );
+  }
+  /**
+   * Backup de tous les points (en parallèle, un produit _g * [b...] par
+   * bloc de points). next[i] garde le meilleur vecteur actuel en b_i si le
+   * backup est moins bon (V ne décroît pas).
+   * Retourne max_b b.backup(b) - V(b).
+   */
+  double backup_all( std::vector<Alpha>& next )
+  {
+    unsigned int nb_s = _model.nb_states();
+    next.resize( _beliefs.size() );
+    std::vector<double> gain( _beliefs.size(), 0.0 );
+    utils::parallel::for_range( 0, _beliefs.size(), _nb_thread,
+                                [&] (unsigned int begin, unsigned int end) {
+      Eigen::MatrixXd bm( nb_s, end - begin );
+      for( unsigned int i = begin; i < end; ++i) {
+        bm.col( i - begin ) = Eigen::Map<const Eigen::VectorXd>( _beliefs[i].data(), nb_s );
+      }
+      Eigen::MatrixXd d = _g * bm;
+      for( unsigned int i = begin; i < end; ++i) {
+        next[i] = backup( _beliefs[i], d.col( i - begin ).data() );
+        unsigned int idx = 0;
+        gain[i] = dot( _beliefs[i], next[i].v ) - value( _beliefs[i], &idx );
+        if( gain[i] < 0.0 ) next[i] = _alphas[idx];
+      }
+    });
+    _nb_backup += _beliefs.size();
+    if( gain.empty() ) return 0.0;
+    return *std::max_element( gain.begin(), gain.end() );
+  }
+  void iterate_perseus( uint64_t seed )
+  {
+    std::vector<double> v_old = values();
+    std::vector<Alpha> next;
+    // points dont la valeur n'a pas encore augmenté
+    std::vector<unsigned int> todo( _beliefs.size() );
+    for( unsigned int i = 0; i < todo.size(); ++i) todo[i] = i;
+    Model::RandomStream rnd( seed, _nb_ite );
+    while( not todo.empty() ) {
+      unsigned int i = todo[rnd.uniform_int( todo.size() )];
+      Alpha alpha = backup( _beliefs[i] );
+      ++_nb_backup;
+      if( dot( _beliefs[i], alpha.v ) >= v_old[i] ) {
+        next.push_back( alpha );
+      }
+      else {
+        unsigned int idx = 0;
+        value( _beliefs[i], &idx );
+        next.push_back( _alphas[idx] );
+      }
+      // retire les points améliorés par le dernier vecteur
+      const std::vector<double>& v = next.back().v;
+      std::vector<unsigned int> remain;
+      for( auto j: todo ) {
+        if( dot( _beliefs[j], v ) < v_old[j] ) remain.push_back( j );
+      }
+      todo.swap( remain );
+    }
+    _alphas.swap( next );
+    prune();
+  }
+  /**
+   * Supprime les vecteurs dominés point par point (et les doublons), puis
+   * ceux qui ne sont le meilleur en aucun point de croyance (la valeur
+   * des points ne change pas).
+   */
+  void prune()
+  {
+    std::vector<Alpha> kept;
+    for( unsigned int i = 0; i < _alphas.size(); ++i) {
+      bool dominated = false;
+      for( unsigned int j = 0; j < _alphas.size() and not dominated; ++j) {
+        if( i == j ) continue;
+        bool all_le = true, all_eq = true;
+        for( unsigned int s = 0; s < _alphas[i].v.size() and all_le; ++s) {
+          if( _alphas[i].v[s] > _alphas[j].v[s] ) all_le = false;
+          if( _alphas[i].v[s] != _alphas[j].v[s] ) all_eq = false;
+        }
+        // égaux : on garde le premier
+        if( all_le and (not all_eq or j < i) ) dominated = true;
+      }
+      if( not dominated ) kept.push_back( _alphas[i] );
+    }
+    _alphas.swap( kept );
+    if( _beliefs.empty() ) return;
+
+    std::vector<bool> used( _alphas.size(), false );
+    for( auto& b: _beliefs ) {
+      unsigned int idx = 0;
+      value( b, &idx );
+      used[idx] = true;
+    }
+    kept.clear();
+    for( unsigned int i = 0; i < _alphas.size(); ++i) {
+      if( used[i] ) kept.push_back( _alphas[i] );
+    }
+    _alphas.swap( kept );
+  }
+  /** Le modèle */
+  const Model::POMDP& _pomdp;
+  BeliefModel _model;
+  double _gamma;
+  Method _method;
+  unsigned int _nb_thread;
+  /** Points de croyance et fonction valeur */
+  std::vector<Belief> _beliefs;
+  std::vector<Alpha> _alphas;
+  /** g_ao^alpha de l'itération, un par ligne */
+  Eigen::MatrixXd _g;
+  /** Stats du dernier solve */
+  unsigned int _nb_ite;
+  unsigned long _nb_backup;
+  double _residual;
+};
+
+}; // namespace Algorithms
+
+#endif // POMDP_POINT_BASED_HPP
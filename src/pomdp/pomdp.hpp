@@ -12,13 +12,18 @@
 #include <string>                     // std::string
 #include <sstream>                   // std::stringstream
 #include <vector>                     // std::vector
+#include <algorithm>                  // std::lower_bound
+#include <cassert>                    // assert
+#include <utility>                    // std::move
+#include <iterator>                   // std::make_move_iterator
+#include <stdexcept>                  // std::runtime_error
 
 #include <gsl/gsl_rng.h>             // gsl random generator
 #include <ctime>                     // std::time
 
 #include "rapidjson/prettywriter.h" // rapidjson
 #include "rapidjson/document.h"     // rapidjson's DOM-style API
-// #include <json_wrapper.hpp>         // JSON::OStreamWrapper et IStreamWrapper
+#include <json_wrapper.hpp>         // JSON::SaxHandler, JSON::parse
 namespace rj = rapidjson;
 
 // ********************************************************************* Model
@@ -56,14 +61,31 @@ struct Node
 /**
  * Transition est un tableau des probas de transiter
  * vers un autre noeud.
+ *
+ * Deux formes :
+ *  - dense : _proba (une proba par noeud)
+ *  - creuse : _proba vide, seulement les (noeud, p > 0), cf set_sparse(),
+ *    pour les grands modèles (JSON {"idx": [...], "val": [...]})
+ * for_each() parcourt les p > 0 quelle que soit la forme.
+ *
+ * Pour simuler, build_sampler() construit une table creuse : CDF pour
+ * les petites lignes, méthode des alias (Walker/Vose) sinon. sample() ne
+ * dépend alors plus du nombre de noeuds. La table doit être reconstruite
+ * si _proba change.
  */ 
 class Transition
 {
 public:
+  /** Lignes avec plus de non-nuls utilisent les alias */
+  static constexpr unsigned int MAX_CDF = 8;
+  Transition( const std::vector<double>& proba = std::vector<double>() ) :
+    _proba(proba)
+  {}
   std::vector<double> _proba;
   // **************************************************** Transition::get_next
-  unsigned int get_next( double random )
+  unsigned int get_next( double random ) const
   {
+    if( _proba.empty() and not _idx.empty() ) return sample( random );
     double sum_proba = 0;
     for( unsigned int i = 0; i < _proba.size(); ++i) {
       sum_proba += _proba[i];
@@ -73,13 +95,97 @@ public:
     }
     return _proba.size()-1;
   };
+  // ****************************************************** Transition::sparse
+  /** Forme creuse, idx croissants (vide _proba) */
+  void set_sparse( const std::vector<unsigned int>& idx,
+                   const std::vector<double>& val )
+  {
+    _proba.clear();
+    _idx.clear();
+    _val.clear();
+    for( unsigned int k = 0; k < idx.size(); ++k) {
+      if( val[k] > 0.0 ) {
+        _idx.push_back( idx[k] );
+        _val.push_back( val[k] );
+      }
+    }
+    build_alias();
+  }
+  bool is_sparse() const { return _proba.empty() and not _idx.empty(); }
+  /** f(i, p) pour tous les p > 0, i croissants */
+  template<class Function>
+  void for_each( Function f ) const
+  {
+    if( not _proba.empty() ) {
+      for( unsigned int i = 0; i < _proba.size(); ++i) {
+        if( _proba[i] > 0.0 ) f( i, _proba[i] );
+      }
+    }
+    else {
+      for( unsigned int k = 0; k < _idx.size(); ++k) f( _idx[k], _val[k] );
+    }
+  }
+  /** Proba de aller en i */
+  double proba( unsigned int i ) const
+  {
+    if( not _proba.empty() ) return (i < _proba.size()) ? _proba[i] : 0.0;
+    auto it = std::lower_bound( _idx.begin(), _idx.end(), i );
+    if( it == _idx.end() or *it != i ) return 0.0;
+    return _val[it - _idx.begin()];
+  }
+  // ***************************************************** Transition::sampler
+  /** Table de tirage d'après _proba (ou la forme creuse) */
+  void build_sampler()
+  {
+    if( not _proba.empty() ) {
+      _idx.clear();
+      _val.clear();
+      for( unsigned int i = 0; i < _proba.size(); ++i) {
+        if( _proba[i] > 0.0 ) {
+          _idx.push_back( i );
+          _val.push_back( _proba[i] );
+        }
+      }
+    }
+    build_alias();
+  }
+  /**
+   * Tirage avec random dans ]0,1], même loi que get_next mais en O(1)
+   * (alias) ou en parcourant au plus MAX_CDF non-nuls.
+   * Utilise get_next si pas de table.
+   */
+  unsigned int sample( double random ) const
+  {
+    if( _idx.empty() ) return get_next( random );
+    if( _alias.empty() ) {
+      double sum = 0.0;
+      for( unsigned int k = 0; k < _idx.size(); ++k) {
+        sum += _val[k];
+        if( random <= sum ) return _idx[k];
+      }
+      return _idx.back();
+    }
+    double x = random * _idx.size();
+    unsigned int k = std::min( (unsigned int) x, (unsigned int) _idx.size()-1 );
+    if( x - k < _cut[k] ) return _idx[k];
+    return _alias[k];
+  }
+  /** Nb de non-nuls dans la table */
+  unsigned int nb_nonzero() const { return _idx.size(); }
   // ********************************************************* Transition::str
   std::string str_dump() const
   {
     std::stringstream dump;
     dump << "[";
-    for( auto& prob: _proba) {
-      dump << prob << "; ";
+    if( is_sparse() ) {
+      for_each( [&dump] (unsigned int i, double p) {
+        dump << i << ":" << p << "; ";
+      });
+    }
+    else {
+      for( auto& prob: _proba) {
+        dump << prob << "; ";
+      }
     }
     dump << "]";
     return dump.str();
@@ -87,6 +193,21 @@ public:
   // *************************************************** Transition::serialize
   rj::Value serialize( rj::Document& doc )
   {
+    if( is_sparse() ) {
+      // rj::Object {"idx": [...], "val": [...]}
+      rj::Value rj_idx, rj_val;
+      rj_idx.SetArray();
+      rj_val.SetArray();
+      for( unsigned int k = 0; k < _idx.size(); ++k) {
+        rj_idx.PushBack( _idx[k], doc.GetAllocator() );
+        rj_val.PushBack( _val[k], doc.GetAllocator() );
+      }
+      rj::Value rj_trans;
+      rj_trans.SetObject();
+      rj_trans.AddMember( "idx", rj_idx, doc.GetAllocator() );
+      rj_trans.AddMember( "val", rj_val, doc.GetAllocator() );
+      return rj_trans;
+    }
     // rj::Array qui contient les données
     rj::Value rj_trans;
     rj_trans.SetArray();
@@ -100,6 +221,19 @@ public:
   void unserialize( const rapidjson::Value& obj )
   {
     _proba.clear();
+    if( obj.IsObject() ) {
+      const rj::Value& ar_idx = obj["idx"];
+      const rj::Value& ar_val = obj["val"];
+      assert( ar_idx.IsArray() and ar_val.IsArray() );
+      std::vector<unsigned int> idx;
+      std::vector<double> val;
+      for( rj::SizeType k = 0; k < ar_idx.Size(); ++k ) {
+        idx.push_back( ar_idx[k].GetUint() );
+        val.push_back( ar_val[k].GetDouble() );
+      }
+      set_sparse( idx, val );
+      return;
+    }
     const rj::Value& ar = obj;
     assert( ar.IsArray() );
     rapidjson::SizeType idx = 0;
@@ -107,7 +241,124 @@ public:
       assert( ar[idx].IsNumber() );
       _proba.push_back( ar[idx].GetDouble() );
     }
+    build_sampler();
+  }
+private:
+  /** Alias de Vose si plus de MAX_CDF non-nuls */
+  void build_alias()
+  {
+    _cut.clear();
+    _alias.clear();
+    if( _idx.size() <= MAX_CDF ) return;
+
+    // _cut[k] = proba de garder _idx[k], sinon _alias[k]
+    unsigned int n = _idx.size();
+    double sum = 0.0;
+    for( auto& p: _val ) sum += p;
+    std::vector<double> scaled( n );
+    std::vector<unsigned int> small, large;
+    for( unsigned int k = 0; k < n; ++k) {
+      scaled[k] = _val[k] * n / sum;
+      if( scaled[k] < 1.0 ) small.push_back( k );
+      else large.push_back( k );
+    }
+    _cut.assign( n, 1.0 );
+    _alias.assign( n, 0 );
+    while( not small.empty() and not large.empty() ) {
+      unsigned int l = small.back(); small.pop_back();
+      unsigned int g = large.back(); large.pop_back();
+      _cut[l] = scaled[l];
+      _alias[l] = _idx[g];
+      scaled[g] = (scaled[g] + scaled[l]) - 1.0;
+      if( scaled[g] < 1.0 ) small.push_back( g );
+      else large.push_back( g );
+    }
+    // restes (arrondis) : toujours gardés
+    for( auto k: large ) { _cut[k] = 1.0; _alias[k] = _idx[k]; }
+    for( auto k: small ) { _cut[k] = 1.0; _alias[k] = _idx[k]; }
   }
+  /** Non-nuls (forme creuse, ou tirés de _proba) */
+  std::vector<unsigned int> _idx;
+  std::vector<double> _val;
+  /** Alias : seuils et noeuds */
+  std::vector<double> _cut;
+  std::vector<unsigned int> _alias;
+};
+// ***************************************************************************
+// *************************************************************** POMDPReader
+// ***************************************************************************
+/**
+ * Lecture SAX d'un POMDP sérialisé (cf POMDP::serialize), sans DOM :
+ * les probas vont directement dans les Transition.
+ * Les transitions sont rangées à plat, (s,a) -> s * nb_actions + a.
+ */
+class POMDPReader : public JSON::SaxHandler
+{
+public:
+  POMDPReader( const std::string& root = "" ) : SaxHandler(root) {}
+  std::vector<Node> _states, _obs, _actions;
+  std::vector<Transition> _trans, _percep;
+  std::vector<double> _reward;
+
+  bool number( double v ) override
+  {
+    if( depth() == 2 and at( 0, "reward" )) {
+      _reward.push_back( v );
+    }
+    else if( depth() == 3 and at( 2, "id" ) and nodes() ) {
+      nodes()->back()._id = (unsigned int) v;
+    }
+    else if( transitions() ) {
+      if( depth() == 3 ) transitions()->back()._proba.push_back( v );
+      else if( depth() == 4 and at( 2, "idx" )) _idx.push_back( (unsigned int) v );
+      else if( depth() == 4 and at( 2, "val" )) _val.push_back( v );
+    }
+    return true;
+  }
+  bool string( const std::string& str ) override
+  {
+    if( depth() == 3 and at( 2, "label" ) and nodes() ) {
+      nodes()->back()._label = str;
+    }
+    return true;
+  }
+  bool start( bool is_array ) override
+  {
+    if( depth() != 2 ) return true;
+    if( nodes() ) nodes()->emplace_back();
+    else if( transitions() ) {
+      transitions()->emplace_back();
+      _idx.clear();
+      _val.clear();
+    }
+    return true;
+  }
+  bool end( bool is_array ) override
+  {
+    if( depth() == 2 and transitions() ) {
+      if( is_array ) transitions()->back().build_sampler();
+      else transitions()->back().set_sparse( _idx, _val );
+    }
+    return true;
+  }
+private:
+  /** Liste de Node ou de Transition selon key(0), sinon nullptr */
+  std::vector<Node>* nodes()
+  {
+    if( at( 0, "states" )) return &_states;
+    if( at( 0, "obs" )) return &_obs;
+    if( at( 0, "actions" )) return &_actions;
+    return nullptr;
+  }
+  std::vector<Transition>* transitions()
+  {
+    if( at( 0, "trans" )) return &_trans;
+    if( at( 0, "perc" )) return &_percep;
+    return nullptr;
+  }
+  /** Transition creuse en cours */
+  std::vector<unsigned int> _idx;
+  std::vector<double> _val;
 };
 // ***************************************************************************
 // ********************************************************************* POMDP
@@ -119,18 +370,19 @@ public:
   POMDP( const std::vector<Node>& states,
 	 const std::vector<Node>& obs,
 	 const std::vector<Node>& actions,
-	 const std::vector<std::vector<Transition>>& trans,
-	 const std::vector<Transition>& percep,
+	 std::vector<std::vector<Transition>> trans,
+	 std::vector<Transition> percep,
 	 const std::vector<double>& reward
 	 ) :
     _states(states), _obs(obs), _actions(actions),
-    _trans(trans), _percep(percep), _reward(reward),
+    _trans(std::move(trans)), _percep(std::move(percep)), _reward(reward),
     _rnd(nullptr),
     _cur_state(states[0]), _cur_obs()
   {
     // Générateur Aléatoire
     _rnd = gsl_rng_alloc( gsl_rng_taus );
     gsl_rng_set( _rnd, std::time( NULL ) );
+    build_samplers();
     // obs
     simul_obs();
 
@@ -152,13 +404,48 @@ public:
     // obs
     // simul_obs();
   };
+  /**
+   * Lecture en flux (SAX) d'un fichier JSON, sans DOM. 'root' est la clé
+   * du POMDP dans l'objet principal ("" si le fichier est le POMDP).
+   * Lance std::runtime_error si le JSON est invalide.
+   */
+  POMDP( std::istream& is, const std::string& root = "" ) :
+    _states(), _obs(), _actions(),
+    _trans(), _percep(), _reward(),
+    _rnd(nullptr),
+    _cur_state(), _cur_obs()
+  {
+    POMDPReader reader( root );
+    JSON::parse( is, reader );
+    _states = std::move( reader._states );
+    _obs = std::move( reader._obs );
+    _actions = std::move( reader._actions );
+    _percep = std::move( reader._percep );
+    _reward = std::move( reader._reward );
+    unsigned int nb_a = _actions.size();
+    if( reader._trans.size() != _states.size() * nb_a or
+        _percep.size() != _states.size() or _reward.size() != _states.size() ) {
+      throw std::runtime_error( "POMDP: sizes of trans/perc/reward do not match states" );
+    }
+    _trans.resize( _states.size() );
+    for( unsigned int s = 0; s < _states.size(); ++s) {
+      _trans[s].assign( std::make_move_iterator( reader._trans.begin() + s * nb_a ),
+                        std::make_move_iterator( reader._trans.begin() + (s+1) * nb_a ));
+    }
+
+    // Générateur Aléatoire
+    _rnd = gsl_rng_alloc( gsl_rng_taus );
+    gsl_rng_set( _rnd, std::time( NULL ) );
+  };
   // ************************************************************* POMDP::copy
   POMDP( const POMDP& other ) :
     _states(other._states), _obs(other._obs), _actions(other._actions),
     _trans(other._trans), _percep(other._percep), _reward(other._reward),
-    _rnd(other._rnd),
+    _rnd(nullptr),
     _cur_state(other.cur_state()), _cur_obs(other.cur_obs())
   {
+    // son propre générateur, dans le même état
+    if( other._rnd ) _rnd = gsl_rng_clone( other._rnd );
   };
   POMDP& operator=(const POMDP& other)
   {
@@ -169,7 +456,8 @@ public:
       _trans = other._trans;
       _percep = other._percep;
       _reward = other._reward;
-      _rnd = other._rnd;
+      if( _rnd ) gsl_rng_free( _rnd );
+      _rnd = other._rnd ? gsl_rng_clone( other._rnd ) : nullptr;
       _cur_state = other.cur_state();
       _cur_obs = other.cur_obs();
     }
@@ -345,20 +633,35 @@ public:
       idx++;
     }
   };
+  // ********************************************************* POMDP::sampler
+  /** (Re)construit les tables de tirage, après avoir modifié _trans/_percep */
+  void build_samplers()
+  {
+    for( auto& tr_s: _trans) {
+      for( auto& tr: tr_s) {
+        tr.build_sampler();
+      }
+    }
+    for( auto& per: _percep) {
+      per.build_sampler();
+    }
+  }
+  /** Ré-initialise le générateur aléatoire */
+  void set_seed( unsigned long seed )
+  {
+    gsl_rng_set( _rnd, seed );
+  }
   // ************************************************************ POMDP::simul
   const Node& simul_trans(const Node& act)
   {
-    // std::cout << "simul_trans from " << _cur_state.str_dump();
-    // std::cout << " + " << act.str_dump();
-    // std::cout << std::endl;
     double p = gsl_rng_uniform_pos(_rnd);
-    _cur_state = _states[_trans[_cur_state._id][act._id].get_next(p)];
+    _cur_state = _states[_trans[_cur_state._id][act._id].sample(p)];
     return _cur_state;
   };
   const Node& simul_obs()
   {
     double p = gsl_rng_uniform_pos(_rnd);
-    _cur_obs = _obs[_percep[_cur_state._id].get_next(p)];
+    _cur_obs = _obs[_percep[_cur_state._id].sample(p)];
     return _cur_obs;
   };
   // ************************************************ POMDP::set_current_state
@@ -10,16 +10,407 @@
 #include <iostream>                  // std::cout
 #include <algorithm>                 // std::max_element
 #include <limits>                    // max dbl
+#include <vector>                    // std::vector
+#include <numeric>                   // std::accumulate
+#include <cmath>                     // fabs
+
+#include <pomdp/pomdp.hpp>
+#include <parallel.hpp>              // utils::parallel::for_range
 
 namespace Algorithms
 {
 
 typedef std::vector<std::vector<double>> TVal;
 
+// ***************************************************************************
+// ***************************************************************** SparseMDP
+// ***************************************************************************
+/**
+ * Transitions of a MDP stored as CSR: one row per (s,a), row = s*A+a,
+ * holding only the (s', p) with p > 0.
+ * Reward depends on the state only, as in Model::POMDP.
+ */
+class SparseMDP
+{
+public:
+  // ***************************************************** SparseMDP::creation
+  SparseMDP( unsigned int nb_states, unsigned int nb_actions ) :
+    _nb_states(nb_states), _nb_actions(nb_actions),
+    _reward(nb_states, 0.0), _row(nb_states*nb_actions+1, 0)
+  {}
+  /** Transitions and rewards of a POMDP (only p > 0 are kept) */
+  SparseMDP( const Model::POMDP& pomdp ) :
+    SparseMDP( pomdp._states.size(), pomdp._actions.size() )
+  {
+    _reward = pomdp._reward;
+    for( unsigned int s = 0; s < _nb_states; ++s) {
+      for( unsigned int a = 0; a < _nb_actions; ++a) {
+        pomdp._trans[s][a].for_each( [this] (unsigned int sp, double p) {
+          _col.push_back( sp );
+          _val.push_back( p );
+        });
+        _row[s*_nb_actions+a+1] = _col.size();
+      }
+    }
+  }
+  /**
+   * Add transitions of (s,a). Rows must be given in order
+   * (s=0,a=0), (s=0,a=1), ... (all rows must be given).
+   */
+  void push_row( unsigned int s, unsigned int a,
+                 const std::vector<std::pair<unsigned int, double>>& next )
+  {
+    for( auto& sp: next ) {
+      if( sp.second > 0.0 ) {
+        _col.push_back( sp.first );
+        _val.push_back( sp.second );
+      }
+    }
+    _row[s*_nb_actions+a+1] = _col.size();
+  }
+  void set_reward( unsigned int s, double r ) { _reward[s] = r; }
+  // ******************************************************* SparseMDP::backup
+  /** Q(s,a) = R(s) + gamma * sum_s' T(s,a,s') V(s') */
+  double backup( unsigned int s, unsigned int a,
+                 const std::vector<double>& v, double gamma ) const
+  {
+    unsigned int row = s*_nb_actions + a;
+    double acc = 0.0;
+    for( unsigned int k = _row[row]; k < _row[row+1]; ++k) {
+      acc += _val[k] * v[_col[k]];
+    }
+    return _reward[s] + gamma * acc;
+  }
+  /** max_a Q(s,a) (and best action, lowest index if ties) */
+  double backup_max( unsigned int s, const std::vector<double>& v,
+                     double gamma, unsigned int& best ) const
+  {
+    best = 0;
+    double best_q = backup( s, 0, v, gamma );
+    for( unsigned int a = 1; a < _nb_actions; ++a) {
+      double q = backup( s, a, v, gamma );
+      if( q > best_q ) {
+        best_q = q;
+        best = a;
+      }
+    }
+    return best_q;
+  }
+  /**
+   * Predecessors of every state (CSR, one row per state s', holding the
+   * states s such that T(s,a,s') > 0 for some a, with max_a T(s,a,s')).
+   */
+  void predecessors( std::vector<unsigned int>& row,
+                     std::vector<unsigned int>& col,
+                     std::vector<double>& val ) const
+  {
+    // last[s'] : last s counted as predecessor of s' (no duplicates)
+    std::vector<int> last( _nb_states, -1 );
+    row.assign( _nb_states+1, 0 );
+    for( unsigned int s = 0; s < _nb_states; ++s) {
+      for( unsigned int k = _row[s*_nb_actions]; k < _row[(s+1)*_nb_actions]; ++k) {
+        if( last[_col[k]] == (int) s ) continue;
+        last[_col[k]] = s;
+        row[_col[k]+1] += 1;
+      }
+    }
+    for( unsigned int s = 0; s < _nb_states; ++s) {
+      row[s+1] += row[s];
+    }
+    col.resize( row[_nb_states] );
+    val.assign( row[_nb_states], 0.0 );
+    last.assign( _nb_states, -1 );
+    // pos[s'] : next free place, the place of s is pos[s']-1 once set
+    std::vector<unsigned int> pos( row.begin(), row.end()-1 );
+    for( unsigned int s = 0; s < _nb_states; ++s) {
+      for( unsigned int k = _row[s*_nb_actions]; k < _row[(s+1)*_nb_actions]; ++k) {
+        unsigned int sp = _col[k];
+        if( last[sp] != (int) s ) {
+          last[sp] = s;
+          col[pos[sp]++] = s;
+        }
+        val[pos[sp]-1] = std::max( val[pos[sp]-1], _val[k] );
+      }
+    }
+  }
+  // *************************************************** SparseMDP::attributs
+  unsigned int nb_states() const { return _nb_states; }
+  unsigned int nb_actions() const { return _nb_actions; }
+  unsigned int nb_transitions() const { return _col.size(); }
+private:
+  unsigned int _nb_states, _nb_actions;
+  std::vector<double> _reward;
+  /** CSR : transitions of row r are in [_row[r], _row[r+1]) */
+  std::vector<unsigned int> _row;
+  std::vector<unsigned int> _col;
+  std::vector<double> _val;
+};
+// ***************************************************************************
+// ************************************************************ ValueIteration
+// ***************************************************************************
+/**
+ * Value iteration on a SparseMDP, V(s) = max_a R(s) + gamma E[V(s')].
+ *  - JACOBI : all states backed up from the previous V, in parallel
+ *  - GAUSS_SEIDEL : in place, states in order
+ *  - PRIORITIZED : in place, only the states whose bound of the Bellman
+ *                  error is above a decreasing threshold (bounds of
+ *                  predecessors are raised after each backup)
+ * PRIORITIZED pays when the error is localized (e.g. a reward only in a
+ * goal : few states change at each sweep). When every state keeps
+ * changing (e.g. a step reward everywhere) it does as many backups as
+ * JACOBI, each one about twice as costly (raising the bounds).
+ *
+ * Stopping criterion (JACOBI, GAUSS_SEIDEL), see set_criterion :
+ *  - MAX_NORM : max-norm of the change of V over a sweep <= epsilon
+ *  - SQUARED_Q : sum over (s,a) of the squared change of Q(s,a) over a
+ *                sweep <= epsilon (as the former compute_Q)
+ * PRIORITIZED always stops when the largest bound is <= epsilon.
+ */
+class ValueIteration
+{
+public:
+  enum class Method { JACOBI, GAUSS_SEIDEL, PRIORITIZED };
+  enum class Criterion { MAX_NORM, SQUARED_Q };
+public:
+  // ************************************************ ValueIteration::creation
+  ValueIteration( const SparseMDP& mdp, double gamma = 0.9,
+                  Method method = Method::JACOBI,
+                  unsigned int nb_thread = 1 ) :
+    _mdp(mdp), _gamma(gamma), _method(method), _nb_thread(nb_thread),
+    _criterion(Criterion::MAX_NORM),
+    _v(mdp.nb_states(), 0.0), _nb_ite(0), _nb_backup(0), _residual(0.0)
+  {}
+  /** Stopping criterion of JACOBI and GAUSS_SEIDEL (default MAX_NORM) */
+  void set_criterion( Criterion criterion ) { _criterion = criterion; }
+  Criterion get_criterion() const { return _criterion; }
+  // *************************************************** ValueIteration::solve
+  /**
+   * Iterate until the criterion is <= epsilon, or max_ite sweeps
+   * (for PRIORITIZED, max_ite * nb_states backups).
+   * Return true if converged.
+   */
+  bool solve( double epsilon = 1e-6, unsigned int max_ite = 10000 )
+  {
+    switch( _method ) {
+    case Method::JACOBI: return solve_jacobi( epsilon, max_ite );
+    case Method::GAUSS_SEIDEL: return solve_gauss_seidel( epsilon, max_ite );
+    case Method::PRIORITIZED: return solve_prioritized( epsilon, max_ite );
+    }
+    return false;
+  }
+  // ******************************************************** ValueIteration::Q
+  /** Q(s,a) from the current V */
+  TVal get_Q() const
+  {
+    TVal vQ( _mdp.nb_states(), std::vector<double>( _mdp.nb_actions() ));
+    utils::parallel::for_range( 0, _mdp.nb_states(), _nb_thread,
+                                [&] (unsigned int begin, unsigned int end) {
+      for( unsigned int s = begin; s < end; ++s) {
+        for( unsigned int a = 0; a < _mdp.nb_actions(); ++a) {
+          vQ[s][a] = _mdp.backup( s, a, _v, _gamma );
+        }
+      }
+    });
+    return vQ;
+  }
+  /**
+   * Q(s,a) computed by the last sweep of a solve with SQUARED_Q (the
+   * V of that sweep is max_a of it), empty otherwise.
+   */
+  TVal get_sweep_Q() const
+  {
+    if( _q_prev.empty() ) return TVal();
+    unsigned int nb_a = _mdp.nb_actions();
+    TVal vQ( _mdp.nb_states(), std::vector<double>( nb_a ));
+    for( unsigned int s = 0; s < _mdp.nb_states(); ++s) {
+      for( unsigned int a = 0; a < nb_a; ++a) {
+        vQ[s][a] = _q_prev[s*nb_a+a];
+      }
+    }
+    return vQ;
+  }
+  /** Greedy action of every state */
+  std::vector<unsigned int> get_policy() const
+  {
+    std::vector<unsigned int> pi( _mdp.nb_states() );
+    for( unsigned int s = 0; s < _mdp.nb_states(); ++s) {
+      _mdp.backup_max( s, _v, _gamma, pi[s] );
+    }
+    return pi;
+  }
+  // *********************************************** ValueIteration::attributs
+  const std::vector<double>& get_V() const { return _v; }
+  /** Sweeps done by the last solve (JACOBI, GAUSS_SEIDEL) */
+  unsigned int get_nb_ite() const { return _nb_ite; }
+  /** Backups max_a done by the last solve */
+  unsigned long get_nb_backup() const { return _nb_backup; }
+  /** Value of the criterion reached by the last solve */
+  double get_residual() const { return _residual; }
+private:
+  /**
+   * max_a Q(s,a), with 'change' the sum over a of (Q(s,a) - _q_prev)^2
+   * (_q_prev then set to Q(s,a)).
+   */
+  double backup_squared( unsigned int s, const std::vector<double>& v,
+                         double& change )
+  {
+    unsigned int nb_a = _mdp.nb_actions();
+    double best_q = -std::numeric_limits<double>::max();
+    change = 0.0;
+    for( unsigned int a = 0; a < nb_a; ++a) {
+      double q = _mdp.backup( s, a, v, _gamma );
+      double& q_prev = _q_prev[s*nb_a+a];
+      change += (q - q_prev) * (q - q_prev);
+      q_prev = q;
+      best_q = std::max( best_q, q );
+    }
+    return best_q;
+  }
+  /** Q of the previous sweep, from Q = 0 (SQUARED_Q) */
+  void init_criterion()
+  {
+    if( _criterion == Criterion::SQUARED_Q ) {
+      _q_prev.assign( _mdp.nb_states() * _mdp.nb_actions(), 0.0 );
+    }
+    else {
+      _q_prev.clear();
+    }
+  }
+  bool solve_jacobi( double epsilon, unsigned int max_ite )
+  {
+    unsigned int nb_s = _mdp.nb_states();
+    bool squared = (_criterion == Criterion::SQUARED_Q);
+    std::vector<double> v_new( nb_s );
+    std::vector<double> delta( nb_s );
+    init_criterion();
+    _nb_ite = 0;
+    _nb_backup = 0;
+    do {
+      utils::parallel::for_range( 0, nb_s, _nb_thread,
+                                  [&] (unsigned int begin, unsigned int end) {
+        unsigned int best;
+        for( unsigned int s = begin; s < end; ++s) {
+          if( squared ) {
+            v_new[s] = backup_squared( s, _v, delta[s] );
+          }
+          else {
+            v_new[s] = _mdp.backup_max( s, _v, _gamma, best );
+            delta[s] = fabs( v_new[s] - _v[s] );
+          }
+        }
+      });
+      _v.swap( v_new );
+      // sum in order : same residual whatever the number of threads
+      if( squared ) _residual = std::accumulate( delta.begin(), delta.end(), 0.0 );
+      else _residual = *std::max_element( delta.begin(), delta.end() );
+      _nb_backup += nb_s;
+      ++_nb_ite;
+    } while( _residual > epsilon and _nb_ite < max_ite );
+    return _residual <= epsilon;
+  }
+  bool solve_gauss_seidel( double epsilon, unsigned int max_ite )
+  {
+    unsigned int nb_s = _mdp.nb_states();
+    bool squared = (_criterion == Criterion::SQUARED_Q);
+    init_criterion();
+    _nb_ite = 0;
+    _nb_backup = 0;
+    do {
+      _residual = 0.0;
+      unsigned int best;
+      double change;
+      for( unsigned int s = 0; s < nb_s; ++s) {
+        if( squared ) {
+          _v[s] = backup_squared( s, _v, change );
+          _residual += change;
+        }
+        else {
+          double v = _mdp.backup_max( s, _v, _gamma, best );
+          _residual = std::max( _residual, fabs( v - _v[s] ));
+          _v[s] = v;
+        }
+      }
+      _nb_backup += nb_s;
+      ++_nb_ite;
+    } while( _residual > epsilon and _nb_ite < max_ite );
+    return _residual <= epsilon;
+  }
+  bool solve_prioritized( double epsilon, unsigned int max_ite )
+  {
+    unsigned int nb_s = _mdp.nb_states();
+    std::vector<unsigned int> pred_row, pred_col;
+    std::vector<double> pred_val;
+    _mdp.predecessors( pred_row, pred_col, pred_val );
+    _q_prev.clear();
+
+    // Upper bound of the Bellman error of every state, starting exact.
+    // When V(s) changes by d, the error of a predecessor p changes by
+    // at most gamma * max_a T(p,a,s) * d (no backup needed).
+    // Sweeps in state order (as GAUSS_SEIDEL, alternating direction) only
+    // back up the states with bound > threshold ; the threshold is divided
+    // by 4 when a sweep backs up nothing, down to epsilon. No priority
+    // queue : a skipped state costs one comparison.
+    std::vector<double> bound( nb_s );
+    unsigned int best;
+    double threshold = 0.0;
+    for( unsigned int s = 0; s < nb_s; ++s) {
+      bound[s] = fabs( _mdp.backup_max( s, _v, _gamma, best ) - _v[s] );
+      threshold = std::max( threshold, bound[s] );
+    }
+    threshold = std::max( threshold / 2.0, epsilon );
+    _nb_ite = 0;
+    _nb_backup = nb_s;
+    unsigned long max_backup = (unsigned long) max_ite * nb_s;
+    auto update = [&] (unsigned int s) {
+      if( bound[s] <= threshold ) return false;
+      double v = _mdp.backup_max( s, _v, _gamma, best );
+      double d = fabs( v - _v[s] );
+      _v[s] = v;
+      bound[s] = 0.0;
+      for( unsigned int k = pred_row[s]; k < pred_row[s+1]; ++k) {
+        bound[pred_col[k]] += _gamma * pred_val[k] * d;
+      }
+      return true;
+    };
+    while( _nb_backup < max_backup ) {
+      unsigned long nb = 0;
+      if( _nb_ite % 2 == 0 ) {
+        for( unsigned int s = 0; s < nb_s; ++s) nb += update( s );
+      }
+      else {
+        for( unsigned int s = nb_s; s-- > 0; ) nb += update( s );
+      }
+      _nb_backup += nb;
+      ++_nb_ite;
+      if( nb == 0 ) {
+        if( threshold <= epsilon ) break;
+        threshold = std::max( threshold / 4.0, epsilon );
+      }
+    }
+    _residual = *std::max_element( bound.begin(), bound.end() );
+    return _residual <= epsilon;
+  }
+  /** The MDP */
+  const SparseMDP& _mdp;
+  double _gamma;
+  Method _method;
+  unsigned int _nb_thread;
+  Criterion _criterion;
+  /** Value function */
+  std::vector<double> _v;
+  /** Q of the previous sweep (SQUARED_Q) */
+  std::vector<double> _q_prev;
+  /** Stats of last solve */
+  unsigned int _nb_ite;
+  unsigned long _nb_backup;
+  double _residual;
+};
 // ****************************************************************** comput_Q
 /** 
  * Compute the Q value for the states of a given POMDP.
- * Iterates until the square of the Bellman Error is below `epsilon`
+ * Value iteration (JACOBI) on the sparse transitions of the POMDP,
+ * iterates until the square of the Bellman Error is below `epsilon`
+ * (sum over (s,a) of the squared change of Q, Criterion::SQUARED_Q).
  * 
  * @param pomdp : a POMDP
  * @param gamma : discount factor for V
@@ -27,68 +418,16 @@ typedef std::vector<std::vector<double>> TVal;
  * 
  * @return vQ : a TVal representation of the value-function
  */
-TVal compute_Q( const Model::POMDP& pomdp,
-		const double gamma = 0.9,
-		const double epsilon = 0.1
-		)
+inline TVal compute_Q( const Model::POMDP& pomdp,
+                       const double gamma = 0.9,
+                       const double epsilon = 0.1
+                       )
 {
-  TVal vQ;
-
-  // Initialisation à 0.0
-  for( unsigned int ids = 0; ids < pomdp._states.size(); ++ids) {
-    std::vector<double> vQ_s;
-    for( unsigned int ida = 0; ida < pomdp._actions.size(); ++ida) {
-      vQ_s.push_back( 0.0 );
-    }
-    vQ.push_back( vQ_s );
-  }
-  // DEBUG
-  // std::cout << "___ INIT " << std::endl;
-  // for( auto& s: pomdp._states) {
-  //   for( auto& a: pomdp._actions ) {
-  //     std::cout << "Q["<< s._id << ", " << a._id << "]=" << vQ[s._id][a._id] << std::endl;
-  //   }
-  // }
-  
-  // Iterate until convergence (< epsilon)
-  double bellman_residual = std::numeric_limits<double>::max();
-  TVal new_vQ = vQ;
-
-  unsigned int num_ite = 0;
-  while(  bellman_residual > epsilon ) {
-    bellman_residual = 0.0;
-    new_vQ = vQ;
-    
-    for( auto& s: pomdp._states) {
-      for( auto& a: pomdp._actions) {
-	double newQ = 0.0;
-	Model::Transition pr_sa = pomdp._trans[s._id][a._id];
-	for( auto& sprim: pomdp._states) {
-	  // Trouver le max de vQ(sprim,.)
-	  double maxQ = *std::max_element( vQ[sprim._id].begin(),
-					   vQ[sprim._id].end() );
-	  newQ += pr_sa._proba[sprim._id] * maxQ;
-	}
-	// std::cout << "("<<s._id<<","<<a._id<<")" << " newQ="<< newQ << std::endl;
-	// r(s,a) + \gamma * E[maxQ]
-	double newValQ = pomdp._reward[s._id] + gamma * newQ; 
-	bellman_residual += (vQ[s._id][a._id] - newValQ)
-	  * (vQ[s._id][a._id] - newValQ);
-	new_vQ[s._id][a._id] = newValQ;
-      }
-    }
-    vQ = new_vQ;
-    // DEBUG
-    // std::cout << "___ STEP " << num_ite++ << std::endl;
-    // for( auto& s: pomdp._states) {
-    //   for( auto& a: pomdp._actions ) {
-    // 	std::cout << "Q["<< s._id << ", " << a._id << "]=" << vQ[s._id][a._id] << std::endl;
-    //   }
-    // }
-    // std::cout << "BE= " << bellman_residual << std::endl;
-  }
-
-  return vQ;
+  SparseMDP mdp( pomdp );
+  ValueIteration vi( mdp, gamma );
+  vi.set_criterion( ValueIteration::Criterion::SQUARED_Q );
+  vi.solve( epsilon );
+  return vi.get_sweep_Q();
 };
 
 }; // namespace Algorithms
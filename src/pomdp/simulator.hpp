@@ -0,0 +1,140 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef POMDP_SIMULATOR_HPP
+#define POMDP_SIMULATOR_HPP
+
+/**
+ * Simulation par lots d'épisodes d'un POMDP, en parallèle.
+ * - le POMDP n'est que lu (tables de tirage construites à sa création)
+ * - chaque épisode a son propre flux aléatoire RandomStream(seed, k),
+ *   les trajectoires ne dépendent donc pas du nombre de threads
+ * - les épisodes sont écrits directement dans un Trajectory::POMDP::Data,
+ *   l'épisode k occupe [k*length, (k+1)*length)
+ * - ou tirés au fil de l'eau par SimulatorSource (un épisode en mémoire)
+ */
+
+#include <vector>                    // std::vector
+#include <cstdint>                   // uint64_t
+#include <iostream>                  // std::ostream
+
+#include <pomdp/pomdp.hpp>
+#include <pomdp/trajectory.hpp>
+#include <parallel.hpp>              // utils::parallel::for_range
+#include <random_stream.hpp>         // utils::random::Stream
+#include <traj_source.hpp>           // Trajectory::Source
+
+// ********************************************************************* Model
+namespace Model
+{
+// ************************************************************** RandomStream
+/** Flux aléatoire par épisode (SplitMix64, cf random_stream.hpp) */
+using RandomStream = utils::random::Stream;
+// ***************************************************************************
+// ************************************************************ BatchSimulator
+// ***************************************************************************
+/**
+ * Épisodes de 'length' pas depuis 'start_state', actions uniformes
+ * (comme gene_traj de xp-001). Item = (s, o, a, s', o', R(s')).
+ */
+class BatchSimulator
+{
+public:
+  using Traj = Trajectory::POMDP;
+  // ************************************************ BatchSimulator::creation
+  BatchSimulator( const POMDP& pomdp, uint64_t seed ) :
+    _pomdp(pomdp), _seed(seed)
+  {}
+  // ***************************************************** BatchSimulator::run
+  /** 'nb_episode' épisodes dans 'data' (redimensionné) */
+  void run( unsigned int nb_episode, unsigned int length,
+            unsigned int start_state, Traj::Data& data,
+            unsigned int nb_thread = 1 ) const
+  {
+    data.resize( (size_t) nb_episode * length );
+    utils::parallel::for_range( 0, nb_episode, nb_thread,
+                                [&] (unsigned int begin, unsigned int end) {
+      for( unsigned int k = begin; k < end; ++k) {
+        episode( k, length, start_state, &data[(size_t) k * length] );
+      }
+    });
+  }
+  /** Épisode k, 'length' Items écrits à partir de 'out' */
+  void episode( unsigned int k, unsigned int length,
+                unsigned int start_state, Traj::Item* out ) const
+  {
+    RandomStream rnd( _seed, k );
+    unsigned int nb_act = _pomdp._actions.size();
+    unsigned int s = start_state;
+    unsigned int o = _pomdp._percep[s].sample( rnd.uniform_pos() );
+    for( unsigned int t = 0; t < length; ++t) {
+      unsigned int a = rnd.uniform_int( nb_act );
+      unsigned int next_s = _pomdp._trans[s][a].sample( rnd.uniform_pos() );
+      unsigned int next_o = _pomdp._percep[next_s].sample( rnd.uniform_pos() );
+      out[t] = { s, o, a, next_s, next_o, _pomdp._reward[next_s] };
+      s = next_s;
+      o = next_o;
+    }
+  }
+  // *************************************************** BatchSimulator::write
+  /** Format de Trajectory::POMDP::read, "## episode k" avant chaque épisode */
+  static void write( std::ostream& os, const Traj::Data& data,
+                     unsigned int length )
+  {
+    for( size_t i = 0; i < data.size(); ++i) {
+      if( length > 0 and i % length == 0 ) {
+        os << "## episode " << i / length << std::endl;
+      }
+      const Traj::Item& item = data[i];
+      os << item.id_s << "\t" << item.id_o << "\t" << item.id_a << "\t";
+      os << item.id_next_s << "\t" << item.id_next_o << "\t" << item.r << std::endl;
+    }
+  }
+  uint64_t seed() const { return _seed; }
+private:
+  /** Le modèle, partagé entre threads */
+  const POMDP& _pomdp;
+  uint64_t _seed;
+};
+
+// ***************************************************************************
+// *********************************************************** SimulatorSource
+// ***************************************************************************
+/**
+ * Les Items de BatchSimulator::run, dans le même ordre, mais un seul
+ * épisode à la fois en mémoire. 'nb_episode' à 0 : sans fin.
+ */
+class SimulatorSource : public Trajectory::POMDPSource
+{
+public:
+  SimulatorSource( const BatchSimulator& simul, unsigned int nb_episode,
+                   unsigned int length, unsigned int start_state = 0 ) :
+    _simul(simul), _nb_episode(nb_episode), _start(start_state),
+    _episode(length), _k(0), _t(length)
+  {}
+  virtual bool next( Item& item ) override
+  {
+    if( _episode.empty() ) return false;
+    if( _t == _episode.size() ) {
+      if( _nb_episode > 0 and _k >= _nb_episode ) return false;
+      _simul.episode( _k++, _episode.size(), _start, _episode.data() );
+      _t = 0;
+    }
+    item = _episode[_t++];
+    return true;
+  }
+  virtual void rewind() override
+  {
+    _k = 0;
+    _t = _episode.size();
+  }
+private:
+  const BatchSimulator& _simul;
+  unsigned int _nb_episode, _start;
+  BatchSimulator::Traj::Data _episode;
+  unsigned int _k;
+  size_t _t;
+};
+
+}; // namespace Model
+
+#endif // POMDP_SIMULATOR_HPP
@@ -0,0 +1,102 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef RANDOM_STREAM_HPP
+#define RANDOM_STREAM_HPP
+
+/**
+ * Counter based random streams, to draw in parallel reproducibly.
+ *
+ * utils::random::Stream rnd( seed, k );  // k-th stream of 'seed'
+ * double u = rnd.uniform();              // [0,1[
+ * rnd.fill_normal( buffer, n );          // n N(0,1) at once
+ *
+ * A Stream has no shared state : one Stream per thread/episode/trajectory
+ * gives the same draws whatever the number of threads.
+ */
+#include <cstdint>                    // uint64_t
+#include <cstddef>                    // size_t
+#include <cmath>                      // std::sqrt, std::log, std::cos
+
+namespace utils
+{
+namespace random
+{
+  // ********************************************************************* Stream
+  /**
+   * SplitMix64 generator : the n-th draw of stream (seed, stream) is
+   * mix( key + n * GAMMA ). Two streams with different keys are
+   * independent in practice, and jump(n) is O(1).
+   */
+  class Stream
+  {
+  public:
+    static constexpr uint64_t GAMMA = 0x9E3779B97F4A7C15ULL;
+    Stream( uint64_t seed = 0, uint64_t stream = 0 ) :
+      _key( mix( mix( seed ) + stream * GAMMA )), _counter(0)
+    {}
+    /** Next 64 bits integer */
+    uint64_t next()
+    {
+      ++_counter;
+      return mix( _key + _counter * GAMMA );
+    }
+    /** Skip the next n draws */
+    void jump( uint64_t n ) { _counter += n; }
+    /** Real in [0,1[ */
+    double uniform()
+    {
+      return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+    /** Real in ]0,1] (as gsl_rng_uniform_pos, for Transition::sample) */
+    double uniform_pos()
+    {
+      return ((next() >> 11) + 1) * (1.0 / 9007199254740992.0);
+    }
+    /** Integer in [0, n[ */
+    unsigned int uniform_int( unsigned int n )
+    {
+      return (unsigned int) ((next() >> 32) * n >> 32);
+    }
+    /** N(0,1), Box-Muller (2 draws) */
+    double normal()
+    {
+      double r = std::sqrt( -2.0 * std::log( uniform_pos() ));
+      return r * std::cos( TWO_PI * uniform() );
+    }
+    /** n reals in [0,1[ */
+    void fill_uniform( double* out, size_t n )
+    {
+      uint64_t c = _counter;
+      for( size_t i = 0; i < n; ++i) {
+        out[i] = (mix( _key + (c + i + 1) * GAMMA ) >> 11) * (1.0 / 9007199254740992.0);
+      }
+      _counter += n;
+    }
+    /** n N(0,1), both Box-Muller values of each pair of draws are used */
+    void fill_normal( double* out, size_t n )
+    {
+      for( size_t i = 0; i + 1 < n; i += 2) {
+        double r = std::sqrt( -2.0 * std::log( uniform_pos() ));
+        double theta = TWO_PI * uniform();
+        out[i] = r * std::cos( theta );
+        out[i+1] = r * std::sin( theta );
+      }
+      if( n % 2 == 1 ) out[n-1] = normal();
+    }
+    /** Number of draws done */
+    uint64_t counter() const { return _counter; }
+    static uint64_t mix( uint64_t z )
+    {
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+  private:
+    static constexpr double TWO_PI = 6.283185307179586476925286766559;
+    uint64_t _key;
+    uint64_t _counter;
+  };
+}; // namespace random
+}; // namespace utils
+
+#endif // RANDOM_STREAM_HPP
@@ -24,7 +24,7 @@
 
 #include "rapidjson/prettywriter.h"  // rapidjson
 #include "rapidjson/document.h"      // rapidjson's DOM-style API
-#include <json_wrapper.hpp>          // JSON::OStreamWrapper et IStreamWrapper
+#include <json_wrapper.hpp>          // JSON::SaxHandler, JSON::parse
 namespace rj = rapidjson;
 
 #include <utils.hpp>                 // utils::str_vec, utils::str_mat ...
@@ -81,24 +81,25 @@ public:
   };
   /** 
    * Creation à partir d'un fichier contenant uniquement JSON format
-   * of ONE Reservoir.
+   * of ONE Reservoir (or under key 'root' of the main object).
+   * Read in streaming (SAX), without DOM.
+   * Throws std::runtime_error if the JSON is invalid.
    */
-  Reservoir( std::istream& is ) :
+  Reservoir( std::istream& is, const std::string& root = "" ) :
     _w_in(nullptr), _w_res(nullptr), _x_res(nullptr), _rnd(nullptr)
   {
-    // Wrapper pour lire document
-    JSON::IStreamWrapper instream(is);
-    // Parse into a document
-    rj::Document doc;
-    doc.ParseStream( instream );
-
-    std::cout << "Document read" << std::endl;
-    for (rj::Value::ConstMemberIterator itr = doc.MemberBegin();
-	 itr != doc.MemberEnd(); ++itr) {
-      std::cout << "Doc has " << itr->name.GetString() << std::endl;
+    Reader reader( *this, root );
+    try {
+      JSON::parse( is, reader );
+      reader.finish();
+    }
+    catch( std::runtime_error& ) {
+      // no destructor call when the constructor throws
+      if( _w_in ) gsl_matrix_free( _w_in );
+      if( _w_res ) gsl_matrix_free( _w_res );
+      if( _x_res ) gsl_vector_free( _x_res );
+      throw;
     }
-
-    unserialize( doc );
   };
   /** Creation from a JSON Object in a Document */
   Reservoir( const rj::Value& obj ) :
@@ -386,4 +387,95 @@ private:
 
   /** Random generator */
   gsl_rng* _rnd;
+
+  // ******************************************************* Reservoir::Reader
+  /**
+   * SAX reader of a serialized Reservoir. Once nb_input and nb_output
+   * are read, the matrices are allocated and filled directly; values
+   * found before (other key order) are kept in _pending until finish().
+   * finish() checks that every array has exactly the size of its matrix.
+   */
+  class Reader : public JSON::SaxHandler
+  {
+  public:
+    Reader( Reservoir& res, const std::string& root ) :
+      SaxHandler(root), _res(res), _nb_in(0), _nb_out(0), _count{0, 0, 0}
+    {}
+    bool number( double v ) override
+    {
+      if( depth() == 1 ) {
+        if( at( 0, "nb_input" )) _nb_in = v;
+        else if( at( 0, "nb_output" )) _nb_out = v;
+        else if( at( 0, "input_scaling" )) _res._input_scaling = v;
+        else if( at( 0, "spectral_radius" )) _res._spectral_radius = v;
+        else if( at( 0, "leaking_rate" )) _res._leaking_rate = v;
+        if( _nb_in > 0 and _nb_out > 0 and not _res._w_in ) alloc();
+      }
+      else if( depth() == 2 ) {
+        unsigned int idx = index( 1 );
+        if( at( 0, "w_in" )) {
+          ++_count[0];
+          return set( _res._w_in, 0, idx, v );
+        }
+        if( at( 0, "w_res" )) {
+          ++_count[1];
+          return set( _res._w_res, 1, idx, v );
+        }
+        if( at( 0, "x_res" )) {
+          ++_count[2];
+          if( not _res._x_res ) _pending[2].push_back( v );
+          else if( idx < _res._x_res->size ) gsl_vector_set( _res._x_res, idx, v );
+          else return false;
+        }
+      }
+      return true;
+    }
+    /** After parsing : check sizes, allocate if needed and copy _pending */
+    void finish()
+    {
+      if( _nb_in == 0 or _nb_out == 0 ) {
+        throw std::runtime_error( "Reservoir: nb_input/nb_output missing" );
+      }
+      check( "w_in", _count[0], _nb_out * _nb_in );
+      check( "w_res", _count[1], _nb_out * _nb_out );
+      check( "x_res", _count[2], _nb_out );
+      if( not _res._w_in ) alloc();
+      for( unsigned int k = 0; k < _pending[0].size(); ++k) set( _res._w_in, 0, k, _pending[0][k] );
+      for( unsigned int k = 0; k < _pending[1].size(); ++k) set( _res._w_res, 1, k, _pending[1][k] );
+      for( unsigned int k = 0; k < _pending[2].size(); ++k) {
+        gsl_vector_set( _res._x_res, k, _pending[2][k] );
+      }
+    }
+  private:
+    void check( const std::string& name, unsigned int count, unsigned int size )
+    {
+      if( count != size ) {
+        throw std::runtime_error( "Reservoir: " + name + " has "
+                                  + std::to_string( count ) + " values instead of "
+                                  + std::to_string( size ));
+      }
+    }
+    void alloc()
+    {
+      _res._w_in = gsl_matrix_alloc( _nb_out, _nb_in );
+      _res._w_res = gsl_matrix_alloc( _nb_out, _nb_out );
+      _res._x_res = gsl_vector_calloc( _nb_out );
+    }
+    /** idx-th value (row major) of m, or of _pending[k] if not allocated */
+    bool set( gsl_matrix* m, unsigned int k, unsigned int idx, double v )
+    {
+      if( not m ) {
+        _pending[k].push_back( v );
+        return true;
+      }
+      if( idx >= m->size1 * m->size2 ) return false;
+      gsl_matrix_set( m, idx / m->size2, idx % m->size2, v );
+      return true;
+    }
+    Reservoir& _res;
+    unsigned int _nb_in, _nb_out;
+    std::vector<double> _pending[3];
+    /** Values read in w_in, w_res, x_res */
+    unsigned int _count[3];
+  };
 };
@@ -0,0 +1,164 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef SAMPLE_STORE_HPP
+#define SAMPLE_STORE_HPP
+
+/**
+ * SampleStore : FIFO of values in ONE contiguous array, with an optional
+ * capacity (0 : unbounded). When full, push_back() evicts the oldest value
+ * (sliding window over a long run).
+ * - push_back, pop_front : O(1) amortized. Popped values are only skipped
+ *   (_head), the live values are moved back to the start of the array
+ *   when there are fewer of them than skipped ones (memory <= 2*capacity).
+ * - [data(), data()+size()[ are the live values, oldest first : no copy
+ *   to iterate, to draw or to upload.
+ * - first_index() : number of values popped since clear(), the absolute
+ *   index of front().
+ * - A GPU mirror of storage() is valid up to dirty() (position in
+ *   storage) : moving the live values makes it 0, touch( i ) when a value
+ *   is modified in place, clean() once mirrored.
+ *
+ * SlidingMinMax : min and max of a sliding window of values (monotonic
+ * deques), O(1) amortized per push/evict.
+ */
+
+#include <vector>                    // std::vector
+#include <deque>                     // std::deque
+#include <utility>                   // std::pair
+#include <algorithm>                 // std::min, std::copy
+#include <limits>                    // std::numeric_limits
+
+// ***************************************************************************
+// *************************************************************** SampleStore
+// ***************************************************************************
+template<typename T>
+class SampleStore
+{
+public:
+  using iterator = T*;
+  using const_iterator = const T*;
+  // ***************************************************** SampleStore::creation
+  SampleStore( size_t capacity = 0 ) :
+    _buf(), _head(0), _first(0), _capacity(0), _dirty(0)
+  {
+    set_capacity( capacity );
+  }
+  // ********************************************************* SampleStore::clear
+  /** Remove all values, keep the capacity */
+  void clear()
+  {
+    _buf.clear();
+    _head = 0;
+    _first = 0;
+    _dirty = 0;
+  }
+  // ************************************************** SampleStore::set_capacity
+  /** 0 : unbounded. Oldest values are evicted if needed */
+  void set_capacity( size_t capacity )
+  {
+    _capacity = capacity;
+    if( _capacity > 0 ) {
+      if( size() > _capacity ) pop_front( size() - _capacity );
+      _buf.reserve( 2 * _capacity );
+    }
+  }
+  size_t capacity() const { return _capacity; }
+  // ***************************************************** SampleStore::push_pop
+  void push_back( const T& val )
+  {
+    if( _capacity > 0 and size() == _capacity ) pop_front();
+    if( _head > 0 and _head >= size() ) _compact();
+    _buf.push_back( val );
+  }
+  /** Remove the 'n' oldest values */
+  void pop_front( size_t n = 1 )
+  {
+    n = std::min( n, size() );
+    _head += n;
+    _first += n;
+  }
+  // ****************************************************** SampleStore::access
+  size_t size() const { return _buf.size() - _head; }
+  bool empty() const { return size() == 0; }
+  /** Absolute index of front() */
+  size_t first_index() const { return _first; }
+
+  T& operator[]( size_t i ) { return _buf[_head + i]; }
+  const T& operator[]( size_t i ) const { return _buf[_head + i]; }
+  T& front() { return _buf[_head]; }
+  const T& front() const { return _buf[_head]; }
+  T& back() { return _buf.back(); }
+  const T& back() const { return _buf.back(); }
+
+  T* data() { return _buf.data() + _head; }
+  const T* data() const { return _buf.data() + _head; }
+  iterator begin() { return data(); }
+  iterator end() { return data() + size(); }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size(); }
+  // ****************************************************** SampleStore::mirror
+  /** Whole array, live values are [offset(), storage_size()[ */
+  const T* storage() const { return _buf.data(); }
+  size_t storage_size() const { return _buf.size(); }
+  size_t offset() const { return _head; }
+  /** First position of storage() modified since clean() */
+  size_t dirty() const { return _dirty; }
+  void touch( size_t i ) { _dirty = std::min( _dirty, _head + i ); }
+  void clean() { _dirty = std::numeric_limits<size_t>::max(); }
+
+private:
+  // *************************************************** SampleStore::internals
+  void _compact()
+  {
+    std::copy( _buf.begin() + _head, _buf.end(), _buf.begin() );
+    _buf.resize( _buf.size() - _head );
+    _head = 0;
+    _dirty = 0;
+  }
+
+  std::vector<T> _buf;
+  /** Position of front() in _buf */
+  size_t _head;
+  /** Nb of values popped since clear() */
+  size_t _first;
+  size_t _capacity;
+  size_t _dirty;
+};
+
+// ***************************************************************************
+// ************************************************************* SlidingMinMax
+// ***************************************************************************
+class SlidingMinMax
+{
+public:
+  // *************************************************** SlidingMinMax::update
+  void clear()
+  {
+    _min.clear();
+    _max.clear();
+  }
+  /** Value of absolute index 'idx' (increasing) */
+  void push( size_t idx, double val )
+  {
+    while( not _min.empty() and _min.back().second >= val ) _min.pop_back();
+    _min.push_back( {idx, val} );
+    while( not _max.empty() and _max.back().second <= val ) _max.pop_back();
+    _max.push_back( {idx, val} );
+  }
+  /** Forget values with index < 'first' */
+  void evict( size_t first )
+  {
+    while( not _min.empty() and _min.front().first < first ) _min.pop_front();
+    while( not _max.empty() and _max.front().first < first ) _max.pop_front();
+  }
+  // ************************************************* SlidingMinMax::attributs
+  bool empty() const { return _min.empty(); }
+  double min() const { return _min.front().second; }
+  double max() const { return _max.front().second; }
+
+private:
+  /** (index, value), values increasing for _min, decreasing for _max */
+  std::deque<std::pair<size_t,double>> _min, _max;
+};
+
+#endif // SAMPLE_STORE_HPP
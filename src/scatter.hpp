@@ -49,6 +49,7 @@ public:
     glLineWidth( _line_width );
 
     glBegin(GL_LINES);
+    // Samples of _curve, not copied
     for( auto& pt: _curve.get_samples() ) {
       glVertex3d( pt.x + _size, pt.y, pt.z );
       glVertex3d( pt.x, pt.y + _size, pt.z );
@@ -64,6 +65,29 @@ public:
     }
     glEnd();
   }
+  virtual void render_soft( SoftCanvas& canvas,
+                            float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  {
+    if (not _active ) return;
+
+    canvas.color( _fg_col.r, _fg_col.g, _fg_col.b );
+    canvas.line_width( _line_width );
+    canvas.begin( SoftCanvas::LINES );
+    for( auto& pt: _curve.get_samples() ) {
+      canvas.vertex( pt.x + _size, pt.y );
+      canvas.vertex( pt.x, pt.y + _size );
+
+      canvas.vertex( pt.x, pt.y + _size );
+      canvas.vertex( pt.x - _size, pt.y );
+
+      canvas.vertex( pt.x - _size, pt.y );
+      canvas.vertex( pt.x, pt.y - _size );
+
+      canvas.vertex( pt.x, pt.y - _size );
+      canvas.vertex( pt.x + _size, pt.y );
+    }
+    canvas.end();
+  }
 protected:
   // *********************************************** ScatterPlotter::attributs
   Curve& _curve;
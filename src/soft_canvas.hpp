@@ -0,0 +1,354 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef SOFT_CANVAS_HPP
+#define SOFT_CANVAS_HPP
+
+/**
+ * SoftCanvas : rasterize in CPU memory what Plotters draw with Classical
+ * OpenGL, to save figures without any display, GPU or OpenGL context.
+ * The API follows the OpenGL calls it replaces :
+ * - ortho( bbox ) : projection (resets the matrix stack)
+ * - push_matrix, pop_matrix, translate, scale, rotate (degrees)
+ * - color, line_width, begin( LINES | LINE_STRIP | TRIANGLES |
+ *   TRIANGLE_FAN ), vertex, end
+ * - text( msg ) : built-in 5x7 font, at the origin of the current matrix,
+ *   1 unit = 1 pixel (as a FTGL font scaled by the screen ratio)
+ * - draw_pixels( x, y, width, height, rgb, zoom_x, zoom_y ) : as
+ *   glRasterPos + glPixelZoom + glDrawPixels( GL_RGB, GL_FLOAT )
+ * Pixels are opaque (no blending, no antialiasing). get_image() has the
+ * bottom row first, as glReadPixels.
+ * An empty or non finite range in ortho() becomes a unit range, lines and
+ * triangles with a non finite vertex are not drawn.
+ */
+
+#include <string>                    // std::string
+#include <vector>                    // std::vector
+#include <algorithm>                 // std::min, std::max, std::swap
+#include <cmath>                     // cos, sin, floor, sqrt, std::isfinite
+
+#include <png_queue.hpp>             // utils::Image
+
+// ***************************************************************************
+// **************************************************************** SoftCanvas
+// ***************************************************************************
+class SoftCanvas
+{
+public:
+  enum Mode { LINES, LINE_STRIP, TRIANGLES, TRIANGLE_FAN };
+  /** Glyphs are 5x7 in a 6x8 cell */
+  static const unsigned int GLYPH_ADVANCE = 6;
+  static const unsigned int GLYPH_HEIGHT = 8;
+  // *************************************************** SoftCanvas::creation
+  SoftCanvas( unsigned int width, unsigned int height ) :
+    _proj(), _stack( 1 ), _mode( LINES ), _nb_vertex( 0 ),
+    _col{0, 0, 0}, _width( 1.0 )
+  {
+    _img.width = width;
+    _img.height = height;
+    _img.rgb.assign( 3 * width * height, 255 );
+  }
+  unsigned int width() const { return _img.width; }
+  unsigned int height() const { return _img.height; }
+  const utils::Image& get_image() const { return _img; }
+  // ****************************************************** SoftCanvas::clear
+  void clear( double r, double g, double b )
+  {
+    unsigned char col[3] = {_byte( r ), _byte( g ), _byte( b )};
+    for( size_t i = 0; i < _img.rgb.size(); ++i) _img.rgb[i] = col[i % 3];
+  }
+  // **************************************************** SoftCanvas::matrices
+  /** [x_min,x_max]x[y_min,y_max] on the whole canvas */
+  void ortho( double x_min, double x_max, double y_min, double y_max )
+  {
+    _valid_range( x_min, x_max );
+    _valid_range( y_min, y_max );
+    double sx = _img.width / (x_max - x_min);
+    double sy = _img.height / (y_max - y_min);
+    _proj = Affine{ sx, 0.0, 0.0, sy, -x_min * sx, -y_min * sy };
+    _stack.assign( 1, Affine() );
+  }
+  void push_matrix() { _stack.push_back( _stack.back() ); }
+  void pop_matrix() { if( _stack.size() > 1 ) _stack.pop_back(); }
+  void translate( double x, double y )
+  {
+    _stack.back() = _stack.back() * Affine{ 1.0, 0.0, 0.0, 1.0, x, y };
+  }
+  void scale( double sx, double sy )
+  {
+    _stack.back() = _stack.back() * Affine{ sx, 0.0, 0.0, sy, 0.0, 0.0 };
+  }
+  void rotate( double angle_deg )
+  {
+    double a = angle_deg * M_PI / 180.0;
+    _stack.back() = _stack.back() * Affine{ cos(a), sin(a), -sin(a), cos(a), 0.0, 0.0 };
+  }
+  // *************************************************** SoftCanvas::drawing
+  void color( double r, double g, double b )
+  {
+    _col[0] = _byte( r );
+    _col[1] = _byte( g );
+    _col[2] = _byte( b );
+  }
+  void line_width( double width ) { _width = width; }
+  void begin( Mode mode )
+  {
+    _mode = mode;
+    _nb_vertex = 0;
+  }
+  void vertex( double x, double y )
+  {
+    Pt pt = (_proj * _stack.back()).apply( x, y );
+    switch( _mode ) {
+    case LINES:
+      if( _nb_vertex % 2 == 1 ) _line( _pts[0], pt );
+      _pts[0] = pt;
+      break;
+    case LINE_STRIP:
+      if( _nb_vertex > 0 ) _line( _pts[0], pt );
+      _pts[0] = pt;
+      break;
+    case TRIANGLES:
+      _pts[_nb_vertex % 3] = pt;
+      if( _nb_vertex % 3 == 2 ) _triangle( _pts[0], _pts[1], _pts[2] );
+      break;
+    case TRIANGLE_FAN:
+      // _pts[0] : center, _pts[1] : previous
+      if( _nb_vertex >= 2 ) _triangle( _pts[0], _pts[1], pt );
+      _pts[_nb_vertex == 0 ? 0 : 1] = pt;
+      break;
+    }
+    ++_nb_vertex;
+  }
+  void end() { _nb_vertex = 0; }
+  // ****************************************************** SoftCanvas::text
+  /** Width of 'msg', in pixels */
+  static double text_width( const std::string& msg )
+  {
+    return GLYPH_ADVANCE * msg.size();
+  }
+  /** 'msg' from the origin, baseline along x */
+  void text( const std::string& msg )
+  {
+    Affine mat = _proj * _stack.back();
+    double x0 = 0.0;
+    for( unsigned char c: msg ) {
+      if( c < 32 or c > 126 ) c = '?';
+      const unsigned char* glyph = _font()[c - 32];
+      for( unsigned int col = 0; col < 5; ++col) {
+        for( unsigned int row = 0; row < 7; ++row) {
+          if( not (glyph[col] & (1 << row)) ) continue;
+          // bit 0 is the top row
+          double x = x0 + col, y = 6 - row;
+          Pt a = mat.apply( x, y ), b = mat.apply( x+1, y );
+          Pt c = mat.apply( x+1, y+1 ), d = mat.apply( x, y+1 );
+          _triangle( a, b, c );
+          _triangle( a, c, d );
+        }
+      }
+      x0 += GLYPH_ADVANCE;
+    }
+  }
+  // ************************************************ SoftCanvas::draw_pixels
+  /** Image of width x height RGB floats (bottom row first) from (x,y) */
+  void draw_pixels( double x, double y, unsigned int width, unsigned int height,
+                    const float* rgb, double zoom_x, double zoom_y )
+  {
+    if( width == 0 or height == 0 or zoom_x <= 0.0 or zoom_y <= 0.0 ) return;
+    Pt pos = (_proj * _stack.back()).apply( x, y );
+    if( not _finite( pos ) ) return;
+    int i_min = _pixel( pos.x, _img.width );
+    int i_max = _pixel( ceil( pos.x + width * zoom_x ), _img.width );
+    int j_min = _pixel( pos.y, _img.height );
+    int j_max = _pixel( ceil( pos.y + height * zoom_y ), _img.height );
+    for( int j = j_min; j < j_max; ++j) {
+      int src_j = (int) floor( (j + 0.5 - pos.y) / zoom_y );
+      if( src_j < 0 or src_j >= (int) height ) continue;
+      for( int i = i_min; i < i_max; ++i) {
+        int src_i = (int) floor( (i + 0.5 - pos.x) / zoom_x );
+        if( src_i < 0 or src_i >= (int) width ) continue;
+        const float* src = &rgb[3 * (src_j * width + src_i)];
+        unsigned char* dst = &_img.rgb[3 * (j * _img.width + i)];
+        dst[0] = _byte( src[0] );
+        dst[1] = _byte( src[1] );
+        dst[2] = _byte( src[2] );
+      }
+    }
+  }
+
+private:
+  // ************************************************** SoftCanvas::internals
+  struct Pt {
+    double x, y;
+  };
+  /** x' = a.x + c.y + e, y' = b.x + d.y + f */
+  struct Affine {
+    double a = 1.0, b = 0.0, c = 0.0, d = 1.0, e = 0.0, f = 0.0;
+    Affine() {}
+    Affine( double a, double b, double c, double d, double e, double f ) :
+      a(a), b(b), c(c), d(d), e(e), f(f) {}
+    Affine operator*( const Affine& m ) const
+    {
+      return Affine( a*m.a + c*m.b, b*m.a + d*m.b,
+                     a*m.c + c*m.d, b*m.c + d*m.d,
+                     a*m.e + c*m.f + e, b*m.e + d*m.f + f );
+    }
+    Pt apply( double x, double y ) const
+    {
+      return Pt{ a*x + c*y + e, b*x + d*y + f };
+    }
+  };
+  /** Empty or non finite range : unit range around it */
+  static void _valid_range( double& min, double& max )
+  {
+    if( not std::isfinite( min ) or not std::isfinite( max )) {
+      min = 0.0;
+      max = 1.0;
+    }
+    else if( not (max > min) ) {
+      min -= 0.5;
+      max += 0.5;
+    }
+  }
+  static bool _finite( const Pt& pt )
+  {
+    return std::isfinite( pt.x ) and std::isfinite( pt.y );
+  }
+  /** Pixel of coordinate 'val' clamped to [0, size], cast safely */
+  static int _pixel( double val, unsigned int size )
+  {
+    return (int) floor( std::min( (double) size, std::max( 0.0, val )));
+  }
+  static unsigned char _byte( double val )
+  {
+    return (unsigned char) (std::min( 1.0, std::max( 0.0, val )) * 255.0 + 0.5);
+  }
+  void _plot( int i, int j )
+  {
+    if( i < 0 or j < 0 or i >= (int) _img.width or j >= (int) _img.height ) return;
+    unsigned char* dst = &_img.rgb[3 * (j * _img.width + i)];
+    dst[0] = _col[0];
+    dst[1] = _col[1];
+    dst[2] = _col[2];
+  }
+  /** Thin lines : one pixel per step, thick lines : a quad */
+  void _line( const Pt& from, const Pt& to )
+  {
+    if( not _finite( from ) or not _finite( to ) ) return;
+    double dx = to.x - from.x, dy = to.y - from.y;
+    double len = sqrt( dx*dx + dy*dy );
+    if( _width > 1.5 and len > 0.0 ) {
+      double nx = -dy / len * _width / 2.0, ny = dx / len * _width / 2.0;
+      Pt a{from.x + nx, from.y + ny}, b{to.x + nx, to.y + ny};
+      Pt c{to.x - nx, to.y - ny}, d{from.x - nx, from.y - ny};
+      _triangle( a, b, c );
+      _triangle( a, c, d );
+      return;
+    }
+    // skip what is far outside the canvas
+    if( std::max( from.x, to.x ) < -1.0 or std::min( from.x, to.x ) > _img.width + 1.0 or
+        std::max( from.y, to.y ) < -1.0 or std::min( from.y, to.y ) > _img.height + 1.0 ) {
+      return;
+    }
+    unsigned int nb_step = (unsigned int) ceil(
+      std::min( std::max( fabs( dx ), fabs( dy )),
+                4.0 * (_img.width + _img.height) ));
+    for( unsigned int s = 0; s <= nb_step; ++s) {
+      double t = nb_step > 0 ? (double) s / nb_step : 0.0;
+      double x = from.x + t * dx, y = from.y + t * dy;
+      // far outside : int cast would overflow
+      if( x < -1.0 or y < -1.0 or x >= _img.width or y >= _img.height ) continue;
+      _plot( (int) floor( x ), (int) floor( y ));
+    }
+  }
+  /** Pixels whose center is inside (or on the border of) the triangle */
+  void _triangle( Pt a, Pt b, Pt c )
+  {
+    if( not _finite( a ) or not _finite( b ) or not _finite( c ) ) return;
+    double area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if( not (area != 0.0) or not std::isfinite( area ) ) return;
+    if( area < 0.0 ) std::swap( b, c );
+    int i_min = _pixel( std::min( {a.x, b.x, c.x} ), _img.width - 1 );
+    int i_max = _pixel( ceil( std::max( {a.x, b.x, c.x} )), _img.width - 1 );
+    int j_min = _pixel( std::min( {a.y, b.y, c.y} ), _img.height - 1 );
+    int j_max = _pixel( ceil( std::max( {a.y, b.y, c.y} )), _img.height - 1 );
+    for( int j = j_min; j <= j_max; ++j) {
+      double y = j + 0.5;
+      for( int i = i_min; i <= i_max; ++i) {
+        double x = i + 0.5;
+        if( (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x) >= 0.0 and
+            (c.x - b.x) * (y - b.y) - (c.y - b.y) * (x - b.x) >= 0.0 and
+            (a.x - c.x) * (y - c.y) - (a.y - c.y) * (x - c.x) >= 0.0 ) {
+          _plot( i, j );
+        }
+      }
+    }
+  }
+  /** ASCII 32..126, 5 columns, bit 0 at the top */
+  static const unsigned char (*_font())[5]
+  {
+    static const unsigned char font[95][5] = {
+      {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, // ' ' !
+      {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14}, // " #
+      {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, // $ %
+      {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00}, // & '
+      {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, // ( )
+      {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08}, // * +
+      {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, // , -
+      {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02}, // . /
+      {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, // 0 1
+      {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31}, // 2 3
+      {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, // 4 5
+      {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03}, // 6 7
+      {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, // 8 9
+      {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00}, // : ;
+      {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, // < =
+      {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06}, // > ?
+      {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, // @ A
+      {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22}, // B C
+      {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, // D E
+      {0x7F,0x09,0x09,0x01,0x01}, {0x3E,0x41,0x41,0x51,0x32}, // F G
+      {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, // H I
+      {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41}, // J K
+      {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x04,0x02,0x7F}, // L M
+      {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E}, // N O
+      {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, // P Q
+      {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31}, // R S
+      {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, // T U
+      {0x1F,0x20,0x40,0x20,0x1F}, {0x7F,0x20,0x18,0x20,0x7F}, // V W
+      {0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03}, // X Y
+      {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00}, // Z [
+      {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, // \ ]
+      {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40}, // ^ _
+      {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, // ` a
+      {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20}, // b c
+      {0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, // d e
+      {0x08,0x7E,0x09,0x01,0x02}, {0x08,0x14,0x54,0x54,0x3C}, // f g
+      {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, // h i
+      {0x20,0x40,0x44,0x3D,0x00}, {0x00,0x7F,0x10,0x28,0x44}, // j k
+      {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, // l m
+      {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38}, // n o
+      {0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, // p q
+      {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20}, // r s
+      {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, // t u
+      {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C}, // v w
+      {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, // x y
+      {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00}, // z {
+      {0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, // | }
+      {0x08,0x04,0x08,0x10,0x08}                              // ~
+    };
+    return font;
+  }
+
+  /** Projection, and matrix stack (as GL_MODELVIEW) */
+  Affine _proj;
+  std::vector<Affine> _stack;
+  Mode _mode;
+  /** Vertices since begin(), and the ones kept */
+  unsigned int _nb_vertex;
+  Pt _pts[3];
+  unsigned char _col[3];
+  double _width;
+  utils::Image _img;
+};
+
+#endif // SOFT_CANVAS_HPP
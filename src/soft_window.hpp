@@ -0,0 +1,95 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef SOFT_WINDOW_HPP
+#define SOFT_WINDOW_HPP
+
+/**
+ * A SoftWindow is a Plotter, like an offscreen Window, but rendered by the
+ * CPU in a SoftCanvas (render_soft of its Plotters) : no display, GLFW or
+ * OpenGL context needed. Figures have to be created without Window.
+ *
+ * save( filename ) : PNG written in the background (PngQueue::global()).
+ * render_all( jobs, nb_thread ) : render and write several SoftWindow in
+ * parallel (their Plotters must not change meanwhile).
+ *
+ * Window::has_display() tells which one to use.
+ */
+
+#include <string>                    // std::string
+#include <vector>                    // std::vector
+#include <utility>                   // std::pair
+
+#include <plotter.hpp>
+#include <soft_canvas.hpp>           // SoftCanvas
+#include <png_queue.hpp>             // utils::PngQueue, utils::write_png
+#include <parallel.hpp>              // utils::parallel::for_range
+
+// ***************************************************************************
+// **************************************************************** SoftWindow
+// ***************************************************************************
+class SoftWindow : public Plotter
+{
+public:
+  using Job = std::pair<SoftWindow*, std::string>;
+  // **************************************************** SoftWindow::creation
+  SoftWindow( const int width=640, const int height=400 ) :
+    Plotter( -1.0, 2.0, -1.0, 2.0 ), // default _bbox
+    _width(width), _height(height), _canvas( width, height )
+  {
+  }
+  // ****************************************************** SoftWindow::update
+  virtual void update_bbox()
+  {
+    // update BBox to be slightly larger than inner_bboxes
+    set_bbox( outer_bbox() );
+  }
+  // ****************************************************** SoftWindow::render
+  virtual void render( float screen_ratio_x = 1.0, float screen_ratio_y = 1.0 )
+  {
+    // screen ratio
+    auto ratio_x = (_bbox.x_max-_bbox.x_min) / (double) _width;
+    auto ratio_y = (_bbox.y_max-_bbox.y_min) / (double) _height;
+
+    _canvas.clear( 1.0, 1.0, 1.0 );
+    _canvas.ortho( _bbox.x_min, _bbox.x_max, _bbox.y_min, _bbox.y_max );
+    // Render Plots
+    for( const auto& plotter: _plotters) {
+      plotter->render_soft( _canvas, ratio_x, ratio_y );
+    }
+  }
+  // ******************************************************** SoftWindow::save
+  void save( const std::string& filename )
+  {
+    utils::Image img = _canvas.get_image();
+    utils::PngQueue::global().push( filename, std::move( img ) );
+  }
+  // ************************************************** SoftWindow::render_all
+  /**
+   * update_bbox, render and write each SoftWindow in its file, 'nb_thread'
+   * at a time. False if a file could not be written.
+   */
+  static bool render_all( const std::vector<Job>& jobs,
+                          unsigned int nb_thread = utils::parallel::nb_hardware_thread() )
+  {
+    std::vector<char> ok( jobs.size(), true );
+    utils::parallel::for_range( 0, jobs.size(), nb_thread,
+      [&] (unsigned int begin, unsigned int end) {
+        for( unsigned int i = begin; i < end; ++i) {
+          SoftWindow& win = *jobs[i].first;
+          win.update_bbox();
+          win.render();
+          ok[i] = utils::write_png( jobs[i].second, win._canvas.get_image() );
+        }
+      });
+    for( auto res: ok ) if( not res ) return false;
+    return true;
+  }
+  // *************************************************** SoftWindow::attributs
+  const SoftCanvas& get_canvas() const { return _canvas; }
+
+  int _width, _height;
+private:
+  SoftCanvas _canvas;
+}; // SoftWindow
+
+#endif // SOFT_WINDOW_HPP
@@ -12,11 +12,47 @@
 #include <vector>
 #include <numeric> // std::accumulate
 
+#include <random_stream.hpp>   // utils::random::Stream
+
 namespace bica {
   namespace random {
 
+    using Stream = utils::random::Stream;
+
+    /**
+     * Flux utilise par uniform/proba/normal dans ce thread.
+     * nullptr : std::rand (global, pas thread-safe).
+     */
+    inline Stream*& current() {
+      static thread_local Stream* stream = nullptr;
+      return stream;
+    }
+
+    /**
+     * Tant qu'il existe, les tirages de ce thread (et donc des T et O
+     * de hmm::) utilisent 'stream'.
+     */
+    class ScopedStream {
+    public:
+      ScopedStream(Stream& stream) : previous(current()) {
+        current() = &stream;
+      }
+      ~ScopedStream() { current() = previous; }
+      ScopedStream(const ScopedStream&) = delete;
+      ScopedStream& operator=(const ScopedStream&) = delete;
+    private:
+      Stream* previous;
+    };
+
+    // (private) reel dans [0,1[
+    inline double _draw() {
+      Stream* stream = current();
+      if(stream) return stream->uniform();
+      return std::rand()/(RAND_MAX+1.0);
+    }
+
     inline double uniform(double min,double max) {
-      return min + (max-min)*(std::rand()/(RAND_MAX+1.0));
+      return min + (max-min)*_draw();
     }
 
     /**
@@ -24,7 +60,7 @@ namespace bica {
      */
     template<typename VALUE>
     inline VALUE uniform(VALUE max) {
-      return (VALUE)(max*(std::rand()/(RAND_MAX+1.0)));
+      return (VALUE)(max*_draw());
     }
 
 
@@ -37,6 +73,8 @@ namespace bica {
     }
 
     inline double normal(double std) {
+      Stream* stream = current();
+      if(stream) return stream->normal() * std;
       double u1 = uniform(0.0, 1.0);
       double u2 = uniform(0.0, 1.0);
       double z1 = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
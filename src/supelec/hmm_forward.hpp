@@ -0,0 +1,296 @@
+#pragma once
+
+/**
+ * Filtrage exact d'un HMM compilé (cf hmm_table.hpp), pour donner la
+ * meilleure prédiction possible (Bayes) de o_{t+1} sachant o_0..o_t,
+ * à comparer aux ESN de xp-003.
+ *  - Forward : algorithme forward normalisé, en flux, mémoire O(S)
+ *  - viterbi : suite d'états la plus probable (en log), mémoire
+ *    O(sqrt(n)*S)
+ *  - evaluate : MSE de la prédiction, log-vraisemblance, taux d'états
+ *    bien retrouvés, sur une ou plusieurs trajectoires (en parallèle).
+ *    Une trajectoire est un HMM::Data ou tout ce qui a size() et
+ *    operator[] (ex. Trajectory::HMMStore, sans copie)
+ *
+ * Comme pour les samplers, l'état initial est 0.
+ * Les observations sont soit des masses (valeurs ABCDEF sans bruit),
+ * soit des densités (bruit gaussien, '*'). Si o correspond à une masse
+ * dans au moins un état, seules les masses sont comptées (une densité a
+ * une probabilité nulle de tomber sur cette valeur).
+ */
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <cstddef>                   // size_t
+#include <algorithm>                 // std::max_element
+
+#include "hmm_table.hpp"
+#include "hmm_trajectory.hpp"
+#include <parallel.hpp>               // utils::parallel::for_range
+
+namespace bica {
+  namespace hmm {
+
+    // écart max entre o et une masse (trajectoires relues d'un fichier)
+    constexpr double MASS_EPS = 1e-6;
+
+    /**
+     * Vraisemblance P(o|s) de chaque état dans 'lik'.
+     * @return true si ce sont des masses, false des densités
+     */
+    inline bool likelihood( const Table& table, double o, std::vector<double>& lik ) {
+      unsigned int n = table.nb_states();
+      lik.assign( n, 0.0 );
+      bool mass = false;
+      for( unsigned int s = 0; s < n; ++s) {
+	if( table.o[s].sigma > 0.0 ) continue;
+	for( auto& a: table.o[s].atoms ) {
+	  if( not a.uniform and std::fabs( o - a.value ) < MASS_EPS ) {
+	    lik[s] += a.proba;
+	    mass = true;
+	  }
+	}
+      }
+      if( mass ) return true;
+
+      for( unsigned int s = 0; s < n; ++s) {
+	double sigma = table.o[s].sigma;
+	for( auto& a: table.o[s].atoms ) {
+	  if( sigma > 0.0 ) {
+	    if( a.uniform ) {
+	      // U[0,1[ + N(0,sigma)
+	      lik[s] += a.proba * 0.5 * (std::erf( (1.0 - o) / (sigma * M_SQRT2) )
+					 - std::erf( (0.0 - o) / (sigma * M_SQRT2) ));
+	    }
+	    else {
+	      double z = (o - a.value) / sigma;
+	      lik[s] += a.proba * std::exp( -0.5 * z * z ) / (sigma * std::sqrt( 2.0 * M_PI ));
+	    }
+	  }
+	  else if( a.uniform and o >= 0.0 and o < 1.0 ) {
+	    lik[s] += a.proba;
+	  }
+	}
+      }
+      return false;
+    }
+    /** E[o|s] */
+    inline double mean_observation( const ODist& od ) {
+      double mean = 0.0;
+      for( auto& a: od.atoms ) mean += a.proba * (a.uniform ? 0.5 : a.value);
+      return mean;
+    }
+
+    // ******************************************************************* Forward
+    /**
+     * alpha_t(s) = P(s_t=s | o_0..o_t), normalisé à chaque pas.
+     * update(o_t) puis predict() donne E[o_{t+1} | o_0..o_t].
+     */
+    class Forward {
+    public:
+      Forward( const Table& table ) : _table(table) {
+	for( auto& od: table.o ) _mean.push_back( mean_observation( od ));
+	reset();
+      }
+      void reset() {
+	_prior.assign( _table.nb_states(), 0.0 );
+	_prior[0] = 1.0;
+	_alpha = _prior;
+      }
+      /**
+       * Ajoute o_t.
+       * @return log P(o_t | o_0..o_{t-1}) (masse ou densité),
+       *         -inf si o_t est impossible (alors ignorée)
+       */
+      double update( double o ) {
+	likelihood( _table, o, _lik );
+	double c = 0.0;
+	for( unsigned int s = 0; s < _alpha.size(); ++s) {
+	  _alpha[s] = _prior[s] * _lik[s];
+	  c += _alpha[s];
+	}
+	double log_c = -std::numeric_limits<double>::infinity();
+	if( c > 0.0 ) {
+	  for( auto& a: _alpha ) a /= c;
+	  log_c = std::log( c );
+	}
+	else {
+	  _alpha = _prior;
+	}
+	// P(s_{t+1} | o_0..o_t)
+	std::fill( _prior.begin(), _prior.end(), 0.0 );
+	for( unsigned int s = 0; s < _alpha.size(); ++s) {
+	  if( _alpha[s] == 0.0 ) continue;
+	  for( auto& next: _table.t[s] ) _prior[next.first] += _alpha[s] * next.second;
+	}
+	return log_c;
+      }
+      /** E[o_{t+1} | o_0..o_t] */
+      double predict() const {
+	double o = 0.0;
+	for( unsigned int s = 0; s < _prior.size(); ++s) o += _prior[s] * _mean[s];
+	return o;
+      }
+      /** argmax_s alpha_t(s) */
+      unsigned int map_state() const {
+	return std::max_element( _alpha.begin(), _alpha.end() ) - _alpha.begin();
+      }
+      const std::vector<double>& belief() const { return _alpha; }
+    private:
+      const Table& _table;
+      std::vector<double> _mean;
+      std::vector<double> _prior, _alpha, _lik;
+    };
+
+    // ******************************************************************* viterbi
+    /**
+     * Un pas de viterbi : delta_{t-1} -> delta_t (en log, renormalisé).
+     * 'bp' reçoit les meilleurs prédécesseurs de chaque état (t > 0).
+     */
+    template<typename Traj>
+    void viterbi_step( const Table& table, const Traj& data, size_t t,
+		       std::vector<double>& delta, std::vector<double>& next,
+		       std::vector<double>& lik, unsigned int* bp ) {
+      const double NEG_INF = -std::numeric_limits<double>::infinity();
+      unsigned int nb_s = table.nb_states();
+      if( t == 0 ) {
+	delta.assign( nb_s, NEG_INF );
+	delta[0] = 0.0;
+      }
+      else {
+	// meilleur prédécesseur
+	std::fill( next.begin(), next.end(), NEG_INF );
+	std::fill( bp, bp + nb_s, 0 );
+	for( unsigned int s = 0; s < nb_s; ++s) {
+	  if( delta[s] == NEG_INF ) continue;
+	  for( auto& tr: table.t[s] ) {
+	    double v = delta[s] + std::log( tr.second );
+	    if( v > next[tr.first] ) {
+	      next[tr.first] = v;
+	      bp[tr.first] = s;
+	    }
+	  }
+	}
+	delta.swap( next );
+      }
+      likelihood( table, data[t].id_o, lik );
+      bool possible = false;
+      for( unsigned int s = 0; s < nb_s; ++s) {
+	if( lik[s] > 0.0 and delta[s] > NEG_INF ) possible = true;
+      }
+      // observation impossible : ignorée, comme pour Forward
+      if( possible ) {
+	for( unsigned int s = 0; s < nb_s; ++s) delta[s] += std::log( lik[s] );
+      }
+      // renormalise (évite une dérive vers -inf en double)
+      double best = *std::max_element( delta.begin(), delta.end() );
+      for( auto& d: delta ) d -= best;
+    }
+    /**
+     * Suite d'états la plus probable pour data[0..n[ : f(t, s_t) pour
+     * t de n-1 à 0.
+     * Mémoire O(sqrt(n)*S) : delta est gardé tous les sqrt(n) pas, et les
+     * pointeurs arrière d'un segment sont recalculés depuis son début
+     * (deux passes sur les données).
+     */
+    template<typename Traj, typename Function>
+    void viterbi_for_each( const Table& table, const Traj& data, size_t n,
+			   Function f ) {
+      if( n == 0 ) return;
+      unsigned int nb_s = table.nb_states();
+      size_t seg = std::max( (size_t) 1, (size_t) std::ceil( std::sqrt( (double) n )));
+      std::vector<double> delta( nb_s ), next( nb_s ), lik;
+      std::vector<unsigned int> back( seg * nb_s );
+      // check[k] : delta_{k*seg-1}
+      std::vector<std::vector<double>> check;
+      for( size_t t = 0; t < n; ++t) {
+	if( t % seg == 0 ) check.push_back( delta );
+	viterbi_step( table, data, t, delta, next, lik, back.data() );
+      }
+      unsigned int s = std::max_element( delta.begin(), delta.end() ) - delta.begin();
+      for( size_t k = check.size(); k-- > 0; ) {
+	size_t begin = k * seg, end = std::min( n, begin + seg );
+	delta = check[k];
+	for( size_t t = begin; t < end; ++t) {
+	  viterbi_step( table, data, t, delta, next, lik, &back[(t - begin) * nb_s] );
+	}
+	for( size_t t = end; t-- > begin; ) {
+	  f( t, s );
+	  s = back[(t - begin) * nb_s + s];
+	}
+      }
+    }
+    /** Suite d'états la plus probable pour data[0..n[ (cf viterbi_for_each) */
+    template<typename Traj>
+    std::vector<int> viterbi( const Table& table, const Traj& data, size_t n ) {
+      std::vector<int> path( n );
+      viterbi_for_each( table, data, n,
+			[&path] (size_t t, unsigned int s) { path[t] = s; } );
+      return path;
+    }
+
+    // ****************************************************************** evaluate
+    /** Résultats de l'observateur bayésien sur une trajectoire */
+    struct Baseline {
+      size_t length = 0;
+      double mse = 0.0;              // (o_{t+1} - E[o_{t+1}|o_0..o_t])^2
+      double mse_test = 0.0;         // idem sur les test_length dernières cibles
+      double loglik = 0.0;           // somme des log P(o_t|o_0..o_{t-1})
+      double acc_filter = 0.0;       // argmax alpha_t == s_t
+      double acc_viterbi = 0.0;      // viterbi[t] == s_t
+      std::vector<double> predict;   // predict[t] = E[o_{t+1}|o_0..o_t] (keep_predict)
+    };
+    /**
+     * Mémoire O(sqrt(n)*S) (viterbi), plus O(n) si keep_predict (les
+     * prédictions sont gardées dans Baseline::predict).
+     */
+    template<typename Traj>
+    Baseline evaluate( const Table& table, const Traj& data,
+		       unsigned int test_length = 0, bool keep_predict = false ) {
+      Baseline res;
+      res.length = data.size();
+      if( data.size() == 0 ) return res;
+      // cibles o_1..o_{n-1}
+      size_t nb_target = data.size() - 1;
+      size_t start_test = nb_target > test_length ? nb_target - test_length : 0;
+      Forward fwd( table );
+      double prediction = 0.0;
+      for( size_t t = 0; t < data.size(); ++t) {
+	if( t > 0 ) {
+	  double err = data[t].id_o - prediction;
+	  res.mse += err * err;
+	  if( t-1 >= start_test ) res.mse_test += err * err;
+	}
+	double l = fwd.update( data[t].id_o );
+	if( std::isfinite( l )) res.loglik += l;
+	if( (int) fwd.map_state() == data[t].id_s ) res.acc_filter += 1.0;
+	prediction = fwd.predict();
+	if( keep_predict ) res.predict.push_back( prediction );
+      }
+      res.acc_filter /= data.size();
+      if( nb_target > 0 ) res.mse /= nb_target;
+      if( nb_target > start_test ) res.mse_test /= (nb_target - start_test);
+
+      viterbi_for_each( table, data, data.size(), [&] (size_t t, unsigned int s) {
+	if( (int) s == data[t].id_s ) res.acc_viterbi += 1.0;
+      });
+      res.acc_viterbi /= data.size();
+      return res;
+    }
+    /** Une trajectoire par thread (au plus nb_thread) */
+    inline std::vector<Baseline> evaluate( const Table& table,
+					   const std::vector<Trajectory::HMM::Data>& l_data,
+					   unsigned int test_length,
+					   unsigned int nb_thread ) {
+      std::vector<Baseline> l_res( l_data.size() );
+      utils::parallel::for_range( 0, l_data.size(), nb_thread,
+				  [&] (unsigned int begin, unsigned int end) {
+	for( unsigned int i = begin; i < end; ++i) {
+	  l_res[i] = evaluate( table, l_data[i], test_length );
+	}
+      });
+      return l_res;
+    }
+  }
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+/**
+ * Statistiques d'un HMM compilé (cf hmm_table.hpp), sans simulation.
+ *  - stationary : distribution stationnaire pi (itération de puissance
+ *    creuse sur la chaîne paresseuse (I+T)/2 depuis l'état 0, qui
+ *    converge même si T est périodique, comme "ABCD")
+ *  - cesaro_time : nb de pas pour que la moyenne des P(s_t) depuis l'état
+ *    0 soit à moins de eps de pi (variation totale), i.e. l'ordre de
+ *    grandeur d'une trajectoire dont les fréquences d'états sont justes
+ *  - stats : taux d'entropie des états h_S, H(pi) et, si les observations
+ *    sont discrètes (pas de bruit ni de '*'), les bornes de Cover &
+ *    Thomas sur le taux d'entropie des observations
+ *        H(O_n|O_1..O_{n-1},S_1) <= h_O <= H(O_n|O_1..O_{n-1})
+ *    et l'information prédictive (excess entropy) E :
+ *        H(O_1..O_n) - n H(O_n|O_1..O_{n-1}) <= E <= H(pi)
+ * Entropies en bits.
+ */
+
+#include <vector>
+#include <map>
+#include <cmath>
+#include <algorithm>                 // std::sort, std::unique
+
+#include "hmm_table.hpp"
+
+namespace bica {
+  namespace hmm {
+
+    // (private) -p log2 p
+    inline double _plogp( double p ) {
+      return p > 0.0 ? -p * std::log2( p ) : 0.0;
+    }
+
+    /** x <- x T (creux) */
+    inline void step( const Table& table, const std::vector<double>& x,
+		      std::vector<double>& y ) {
+      y.assign( x.size(), 0.0 );
+      for( unsigned int s = 0; s < x.size(); ++s) {
+	if( x[s] == 0.0 ) continue;
+	for( auto& next: table.t[s] ) y[next.first] += x[s] * next.second;
+      }
+    }
+
+    // **************************************************************** stationary
+    /**
+     * pi = pi T, par itération sur (I+T)/2 depuis l'état 0 (comme les
+     * samplers et Forward), jusqu'à |pi_{k+1} - pi_k|_1 < eps.
+     * Si la chaîne n'est pas irréductible, c'est la distribution atteinte
+     * par les trajectoires (les états inaccessibles depuis 0 ont pi = 0).
+     * @param nb_ite (out) nombre d'itérations faites
+     */
+    inline std::vector<double> stationary( const Table& table, double eps = 1e-12,
+					   unsigned int max_ite = 1000000,
+					   unsigned int* nb_ite = nullptr ) {
+      unsigned int n = table.nb_states();
+      std::vector<double> pi( n, 0.0 ), next;
+      pi[0] = 1.0;
+      unsigned int ite = 0;
+      for( ; ite < max_ite; ++ite) {
+	step( table, pi, next );
+	double diff = 0.0;
+	for( unsigned int s = 0; s < n; ++s) {
+	  next[s] = 0.5 * (pi[s] + next[s]);
+	  diff += std::fabs( next[s] - pi[s] );
+	}
+	pi.swap( next );
+	if( diff < eps ) break;
+      }
+      if( nb_ite ) *nb_ite = ite;
+      return pi;
+    }
+
+    // *************************************************************** cesaro_time
+    /**
+     * Plus petit t tel que |(1/t) sum_{k<t} P(s_k) - pi|_TV < eps,
+     * depuis s_0 = 0 (max_t si jamais atteint).
+     */
+    inline unsigned int cesaro_time( const Table& table, const std::vector<double>& pi,
+				     double eps = 0.01, unsigned int max_t = 10000000 ) {
+      unsigned int n = table.nb_states();
+      std::vector<double> p( n, 0.0 ), next, sum( n, 0.0 );
+      p[0] = 1.0;
+      for( unsigned int t = 1; t <= max_t; ++t) {
+	double tv = 0.0;
+	for( unsigned int s = 0; s < n; ++s) {
+	  sum[s] += p[s];
+	  tv += std::fabs( sum[s] / t - pi[s] );
+	}
+	if( 0.5 * tv < eps ) return t;
+	step( table, p, next );
+	p.swap( next );
+      }
+      return max_t;
+    }
+
+    // ********************************************************************* Stats
+    struct Stats {
+      std::vector<double> pi;
+      unsigned int nb_ite = 0;       // itérations pour pi
+      unsigned int cesaro = 0;       // cf cesaro_time
+      double h_states = 0.0;         // taux d'entropie de la chaîne d'états
+      double h_pi = 0.0;             // H(pi), borne sup de E
+      bool discrete = false;         // observations discrètes ?
+      std::vector<double> symbols;   // alphabet des observations
+      double h_obs = 0.0;            // H(O_t) stationnaire
+      // pour n=1..depth (tant que le nb de croyances reste < max_nodes)
+      std::vector<double> h_upper;   // H(O_n|O_1..O_{n-1})
+      std::vector<double> h_lower;   // H(O_n|O_1..O_{n-1},S_1)
+      std::vector<double> e_lower;   // H(O_1..O_n) - n h_upper[n]
+    };
+
+    /**
+     * (private) H(O_n|passé) pour n=1..depth, en partant des croyances
+     * 'init' (poids, P(S_1)). Les préfixes qui mènent à la même
+     * croyance sur l'état sont fusionnés.
+     * 'obs[s][k]' = P(O=symbole k | s).
+     */
+    inline std::vector<double> _conditional_entropies(
+		 const Table& table, const std::vector<std::vector<double>>& obs,
+		 std::vector<std::pair<double,std::vector<double>>> nodes,
+		 unsigned int depth, unsigned int max_nodes ) {
+      unsigned int nb_s = table.nb_states();
+      unsigned int nb_k = obs.empty() ? 0 : obs[0].size();
+      std::vector<double> h;
+      std::vector<double> emit, next;
+      for( unsigned int n = 1; n <= depth; ++n) {
+	double h_n = 0.0;
+	std::map<std::vector<long long>, std::pair<double,std::vector<double>>> children;
+	for( auto& node: nodes ) {
+	  const std::vector<double>& b = node.second;
+	  for( unsigned int k = 0; k < nb_k; ++k) {
+	    double pk = 0.0;
+	    emit.assign( nb_s, 0.0 );
+	    for( unsigned int s = 0; s < nb_s; ++s) {
+	      emit[s] = b[s] * obs[s][k];
+	      pk += emit[s];
+	    }
+	    if( pk <= 0.0 ) continue;
+	    h_n += node.first * _plogp( pk );
+	    // croyance sur S_{n+1} après O_n = k
+	    for( auto& e: emit ) e /= pk;
+	    step( table, emit, next );
+	    std::vector<long long> key( nb_s );
+	    for( unsigned int s = 0; s < nb_s; ++s) key[s] = std::llround( next[s] * 1e9 );
+	    auto& child = children[key];
+	    if( child.second.empty() ) child.second = next;
+	    child.first += node.first * pk;
+	  }
+	}
+	h.push_back( h_n );
+	if( children.size() > max_nodes ) break;
+	nodes.clear();
+	for( auto& c: children ) nodes.push_back( c.second );
+      }
+      return h;
+    }
+
+    /**
+     * Toutes les statistiques ci-dessus. Les bornes sur h_O sont
+     * calculées jusqu'à 'depth' symboles.
+     */
+    inline Stats stats( const Table& table, unsigned int depth = 10,
+			unsigned int max_nodes = 100000 ) {
+      Stats st;
+      unsigned int nb_s = table.nb_states();
+      st.pi = stationary( table, 1e-12, 1000000, &st.nb_ite );
+      st.cesaro = cesaro_time( table, st.pi );
+      for( unsigned int s = 0; s < nb_s; ++s) {
+	double h = 0.0;
+	for( auto& next: table.t[s] ) h += _plogp( next.second );
+	st.h_states += st.pi[s] * h;
+	st.h_pi += _plogp( st.pi[s] );
+      }
+
+      // Observations discrètes ?
+      st.discrete = true;
+      for( auto& od: table.o ) {
+	if( od.sigma > 0.0 ) st.discrete = false;
+	for( auto& a: od.atoms ) {
+	  if( a.uniform ) st.discrete = false;
+	  st.symbols.push_back( a.value );
+	}
+      }
+      if( not st.discrete ) {
+	st.symbols.clear();
+	return st;
+      }
+      std::sort( st.symbols.begin(), st.symbols.end() );
+      st.symbols.erase( std::unique( st.symbols.begin(), st.symbols.end() ),
+			st.symbols.end() );
+      std::vector<std::vector<double>> obs( nb_s, std::vector<double>( st.symbols.size(), 0.0 ));
+      for( unsigned int s = 0; s < nb_s; ++s) {
+	for( auto& a: table.o[s].atoms ) {
+	  unsigned int k = std::lower_bound( st.symbols.begin(), st.symbols.end(), a.value )
+	    - st.symbols.begin();
+	  obs[s][k] += a.proba;
+	}
+      }
+
+      // sans S_1 : partir de pi
+      st.h_upper = _conditional_entropies( table, obs, {{1.0, st.pi}},
+					   depth, max_nodes );
+      st.h_obs = st.h_upper.empty() ? 0.0 : st.h_upper[0];
+      // avec S_1 : une croyance par état, de poids pi
+      std::vector<std::pair<double,std::vector<double>>> init;
+      for( unsigned int s = 0; s < nb_s; ++s) {
+	if( st.pi[s] <= 0.0 ) continue;
+	std::vector<double> b( nb_s, 0.0 );
+	b[s] = 1.0;
+	init.push_back( {st.pi[s], b} );
+      }
+      st.h_lower = _conditional_entropies( table, obs, init, depth, max_nodes );
+      double h_block = 0.0;
+      for( unsigned int n = 0; n < st.h_upper.size(); ++n) {
+	h_block += st.h_upper[n];
+	st.e_lower.push_back( h_block - (n+1) * st.h_upper[n] );
+      }
+      return st;
+    }
+  }
+}
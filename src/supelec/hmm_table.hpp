@@ -0,0 +1,432 @@
+#pragma once
+
+/**
+ * HMM "compilés" : une expression de la grammaire de bica::hmm::make
+ * (SEQ, FORK, ALT, CONCAT, NOISE, densité <...>) devient un espace
+ * d'états explicite :
+ *  - T : une ligne creuse (etat suivant, proba) par état
+ *  - O : par état, une loi discrète sur des valeurs (ou uniforme dans
+ *        [0,1[ pour '*') plus un bruit gaussien (sigma)
+ * La loi est la même que celle des closures de hmm.hpp, qui restent
+ * la référence. sampler::TableHMM tire N pas d'un coup dans un buffer,
+ * sampler::TableSource les donne un par un (Trajectory::Source).
+ */
+
+#include <vector>
+#include <string>
+#include <map>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>                 // std::upper_bound
+#include <utility>                   // std::pair
+#include <cstdint>                   // uint64_t
+
+#include "hmm.hpp"
+#include "input.hpp"
+#include "hmm_trajectory.hpp"
+#include <traj_source.hpp>            // Trajectory::Source
+#include <parallel.hpp>               // utils::parallel::for_range
+
+namespace bica {
+  namespace hmm {
+
+    /** Loi d'observation d'un état */
+    struct ODist {
+      struct Atom {
+	double value;
+	double proba;
+	bool   uniform;              // '*' : uniforme dans [0,1[
+      };
+      std::vector<Atom> atoms;
+      double sigma = 0.0;            // bruit gaussien ajouté
+    };
+
+    /**
+     * Espace d'états explicite d'un HMM.
+     * t[s] : (s', P(s'|s)), o[s] : loi de l'observation en s.
+     */
+    struct Table {
+      using Row = std::vector<std::pair<unsigned int,double>>;
+      std::vector<Row>   t;
+      std::vector<ODist> o;
+
+      unsigned int nb_states() const { return t.size(); }
+
+      std::string str_dump() const {
+	std::stringstream dump;
+	for( unsigned int s = 0; s < t.size(); ++s) {
+	  dump << s << " -> ";
+	  for( auto& next: t[s] ) dump << next.first << ":" << next.second << " ";
+	  dump << "| O=";
+	  for( auto& a: o[s].atoms ) {
+	    if( a.uniform ) dump << "U";
+	    else dump << a.value;
+	    dump << ":" << a.proba << " ";
+	  }
+	  if( o[s].sigma > 0.0 ) dump << "+N(" << o[s].sigma << ")";
+	  dump << std::endl;
+	}
+	return dump.str();
+      }
+    };
+
+    // (private) observation d'un symbole ABCDEF, *=uniform, 0
+    inline ODist::Atom _atom_from_char( char c, double proba ) {
+      if( c == '*' ) return {0.0, proba, true};
+      return {_from_string( c ), proba, false};
+    }
+    // (private) ajoute p a la transition vers s' (ou la crée)
+    inline void _add( Table::Row& row, unsigned int next, double p ) {
+      if( p <= 0.0 ) return;
+      for( auto& n: row ) {
+	if( n.first == next ) {
+	  n.second += p;
+	  return;
+	}
+      }
+      row.push_back( {next, p} );
+    }
+    // (private) copie de la ligne 'row' décalée de 'offset', pondérée par w
+    inline void _add( Table::Row& row, const Table::Row& from,
+		      unsigned int offset, double w = 1.0 ) {
+      for( auto& n: from ) _add( row, n.first + offset, n.second * w );
+    }
+    /**
+     * (private) probas effectives d'un tirage "proba <= somme cumulée"
+     * avec proba uniforme dans [0,1[ : les probas sont tronquées à 1,
+     * le reste (si la somme < 1) est retourné.
+     */
+    inline double _clip( std::vector<double>& probas ) {
+      double sum = 0.0;
+      for( auto& p: probas ) {
+	double next = std::min( sum + p, 1.0 );
+	p = next - sum;
+	sum = next;
+      }
+      return 1.0 - sum;
+    }
+
+    // ************************************************************ tables
+    /** periodic(seq) */
+    inline Table table_periodic( const std::string& seq ) {
+      Table tab;
+      unsigned int n = seq.size();
+      for( unsigned int s = 0; s < n; ++s) {
+	tab.t.push_back( {{(s+1) % n, 1.0}} );
+	ODist od;
+	od.atoms.push_back( _atom_from_char( seq[s], 1.0 ));
+	tab.o.push_back( od );
+      }
+      return tab;
+    }
+    /** {uniform(1), from_map(density)} */
+    inline Table table_density( const PO& density ) {
+      Table tab;
+      tab.t.push_back( {{0, 1.0}} );
+      std::vector<double> probas;
+      for( auto& po: density ) probas.push_back( po.second );
+      double rest = _clip( probas );
+      ODist od;
+      unsigned int i = 0;
+      for( auto& po: density ) {
+	if( probas[i] > 0.0 ) od.atoms.push_back( _atom_from_char( po.first[0], probas[i] ));
+	++i;
+      }
+      if( rest > 0.0 ) od.atoms.push_back( {_from_string( '0' ), rest, false} );
+      tab.o.push_back( od );
+      return tab;
+    }
+    /** add_gaussian_noise */
+    inline Table table_noise( Table tab, double sigma ) {
+      for( auto& od: tab.o ) od.sigma = std::sqrt( od.sigma * od.sigma + sigma * sigma );
+      return tab;
+    }
+    /** concat : fin de tab1 -> debut de tab2 -> debut de tab1 */
+    inline Table table_concat( const Table& tab1, const Table& tab2 ) {
+      unsigned int n1 = tab1.nb_states(), n2 = tab2.nb_states();
+      Table tab;
+      tab.t.resize( n1 + n2 );
+      for( unsigned int s = 0; s < n1 + n2; ++s) {
+	if( s < n1-1 ) _add( tab.t[s], tab1.t[s], 0 );
+	else if( s == n1-1 ) _add( tab.t[s], n1, 1.0 );
+	else if( s == n1+n2-1 ) _add( tab.t[s], 0, 1.0 );
+	else _add( tab.t[s], tab2.t[s-n1], n1 );
+      }
+      tab.o = tab1.o;
+      tab.o.insert( tab.o.end(), tab2.o.begin(), tab2.o.end() );
+      return tab;
+    }
+    /** join : alterne entre tab1 et tab2 (n'importe où dans l'autre) */
+    inline Table table_join( const Table& tab1, const Table& tab2,
+			     double p12, double p21 ) {
+      unsigned int n1 = tab1.nb_states(), n2 = tab2.nb_states();
+      p12 = std::min( std::max( p12, 0.0 ), 1.0 );
+      p21 = std::min( std::max( p21, 0.0 ), 1.0 );
+      Table tab;
+      tab.t.resize( n1 + n2 );
+      for( unsigned int s = 0; s < n1; ++s) {
+	for( unsigned int s2 = 0; s2 < n2; ++s2) _add( tab.t[s], n1+s2, p12 / n2 );
+	_add( tab.t[s], tab1.t[s], 0, 1.0 - p12 );
+      }
+      for( unsigned int s = n1; s < n1 + n2; ++s) {
+	for( unsigned int s1 = 0; s1 < n1; ++s1) _add( tab.t[s], s1, p21 / n1 );
+	_add( tab.t[s], tab2.t[s-n1], n1, 1.0 - p21 );
+      }
+      tab.o = tab1.o;
+      tab.o.insert( tab.o.end(), tab2.o.begin(), tab2.o.end() );
+      return tab;
+    }
+    /** fork : fin de start -> un des sous-HMM, fin d'un sous-HMM -> 0 */
+    inline Table table_fork( const Table& start, const std::vector<Table>& l_tab,
+			     std::vector<double> l_proba ) {
+      unsigned int ns = start.nb_states();
+      double rest = _clip( l_proba );
+      Table tab = start;
+      // fin de start
+      Table::Row& fork = tab.t[ns-1];
+      fork.clear();
+      unsigned int offset = ns;
+      for( unsigned int i = 0; i < l_tab.size(); ++i) {
+	_add( fork, offset, l_proba[i] );
+	offset += l_tab[i].nb_states();
+      }
+      _add( fork, ns, rest );
+      // sous-HMM
+      offset = ns;
+      for( auto& sub: l_tab ) {
+	unsigned int n = sub.nb_states();
+	for( unsigned int s = 0; s < n; ++s) {
+	  Table::Row row;
+	  if( s < n-1 ) _add( row, sub.t[s], offset );
+	  else _add( row, 0, 1.0 );
+	  tab.t.push_back( row );
+	}
+	tab.o.insert( tab.o.end(), sub.o.begin(), sub.o.end() );
+	offset += n;
+      }
+      return tab;
+    }
+
+    // *********************************************************** compile
+    /**
+     * Compile un HMM décrit avec la grammaire de make(std::istream&)
+     * (même lecture, mêmes erreurs).
+     */
+    inline Table compile(std::istream& is) {
+      char c;
+      is >> c;
+
+      // fork
+      if (c == '[') {
+	Table start = compile(is);
+	std::vector<Table>  l_tab;
+	std::vector<double> l_proba;
+	double proba;
+	is >> c;
+	do {
+	  is >> proba;
+	  l_tab.push_back( compile(is) );
+	  l_proba.push_back( proba );
+	  is >> c;
+	} while ( c != ']' );
+	return table_fork( start, l_tab, l_proba );
+      }
+      // density of proba for O
+      else if (c == '<') {
+	PO densityO;
+	double proba;
+	std::string s;
+	do {
+	  is >> proba;
+	  is >> s;
+	  densityO[s] = proba;
+	  is >> c;
+	} while ( c != '>' );
+	return table_density( densityO );
+      }
+
+      std::string s;
+      bool stop;
+      double sigma, p12, p21;
+      switch(c) {
+      case 'A':
+      case 'B':
+      case 'C':
+      case 'c':
+      case 'D':
+      case 'E':
+      case 'F':
+      case '*':
+	s = c;
+	stop = false;
+	do {
+	  is.get(c);
+	  if(is.eof())
+	    stop = true;
+	  else if((c > 'F' || c < 'A') && (c != '*')) {
+	    stop = true;
+	    is.putback(c);
+	  }
+	  else
+	    s += c;
+	} while(!stop);
+	return table_periodic( s );
+      case '!': {
+	is >> sigma;
+	return table_noise( compile(is), sigma );
+      }
+      case '|': {
+	is >> p12;
+	Table tab1 = compile(is);
+	is >> p21;
+	Table tab2 = compile(is);
+	return table_join( tab1, tab2, p12, p21 );
+      }
+      case '+': {
+	Table tab1 = compile(is);
+	is >> c;
+	if(c != '&')
+	  throw std::runtime_error("HMM parse error");
+	Table tab2 = compile(is);
+	return table_concat( tab1, tab2 );
+      }
+      default:
+	throw std::runtime_error("HMM parse error");
+      }
+    }
+    inline Table compile(const std::string& s) {
+      std::istringstream is(s);
+      return compile(is);
+    }
+  }
+
+  namespace sampler {
+
+    /**
+     * Sample une Table (cf hmm::compile), à partir de l'état 0.
+     * T et O en CSR avec probas cumulées ; les lignes à une seule
+     * entrée ne tirent pas de nombre aléatoire. L'observation est tirée
+     * à chaque shift() (input() la relit). Tirages avec le flux
+     * random::Stream(seed, stream).
+     */
+    class TableHMM : public Base {
+    public:
+      TableHMM( const hmm::Table& table, uint64_t seed = 0, uint64_t stream = 0 )
+	: _state(0), _obs(0.0), _rnd(seed, stream)
+      {
+	_t_row.push_back( 0 );
+	_o_row.push_back( 0 );
+	for( unsigned int s = 0; s < table.nb_states(); ++s) {
+	  double sum = 0.0;
+	  for( auto& next: table.t[s] ) {
+	    sum += next.second;
+	    _t_next.push_back( next.first );
+	    _t_cdf.push_back( sum );
+	  }
+	  _t_row.push_back( _t_next.size() );
+	  sum = 0.0;
+	  for( auto& a: table.o[s].atoms ) {
+	    sum += a.proba;
+	    _o_value.push_back( a.value );
+	    _o_uniform.push_back( a.uniform );
+	    _o_cdf.push_back( sum );
+	  }
+	  _o_row.push_back( _o_value.size() );
+	  _sigma.push_back( table.o[s].sigma );
+	}
+	_obs = observe( _state );
+      }
+
+      virtual double input() const override { return _obs; }
+      virtual int input_id() const override { return _state; }
+      virtual void shift() override {
+	_state = next( _state );
+	_obs = observe( _state );
+      }
+      /** n pas (l'état courant d'abord) dans out[0..n[ */
+      void generate( unsigned int n, Trajectory::HMM::Item* out ) {
+	for( unsigned int i = 0; i < n; ++i) {
+	  out[i] = Trajectory::HMM::Item{ _state, _obs };
+	  shift();
+	}
+      }
+    private:
+      /** Indice dans [begin,end[ tiré d'après les probas cumulées */
+      unsigned int pick( const std::vector<double>& cdf,
+			 unsigned int begin, unsigned int end ) {
+	if( end - begin == 1 ) return begin;
+	double p = _rnd.uniform() * cdf[end-1];
+	auto it = std::upper_bound( cdf.begin() + begin, cdf.begin() + end, p );
+	return std::min( (unsigned int) (it - cdf.begin()), end-1 );
+      }
+      int next( int s ) {
+	return _t_next[pick( _t_cdf, _t_row[s], _t_row[s+1] )];
+      }
+      double observe( int s ) {
+	if( _o_row[s] == _o_row[s+1] ) return 0.0;
+	unsigned int k = pick( _o_cdf, _o_row[s], _o_row[s+1] );
+	double o = _o_uniform[k] ? _rnd.uniform() : _o_value[k];
+	if( _sigma[s] > 0.0 ) o += _sigma[s] * _rnd.normal();
+	return o;
+      }
+      int    _state;
+      double _obs;
+      /** T : lignes [_t_row[s], _t_row[s+1]) */
+      std::vector<unsigned int> _t_row, _t_next;
+      std::vector<double>       _t_cdf;
+      /** O : atomes [_o_row[s], _o_row[s+1]) */
+      std::vector<unsigned int> _o_row;
+      std::vector<double>       _o_value, _o_cdf;
+      std::vector<bool>         _o_uniform;
+      std::vector<double>       _sigma;
+      random::Stream _rnd;
+    };
+
+    /**
+     * Trajectoire tirée au fil de next(), sans buffer : 'length' pas
+     * (0 : sans fin) avec le flux (seed, stream), rewind() rejoue la
+     * même suite.
+     */
+    class TableSource : public Trajectory::HMMSource {
+    public:
+      TableSource( const hmm::Table& table, uint64_t seed = 0,
+		   uint64_t stream = 0, size_t length = 0 )
+	: _init(table, seed, stream), _hmm(_init), _length(length), _t(0)
+      {}
+      virtual bool next( Item& item ) override {
+	if( _length > 0 and _t >= _length ) return false;
+	_hmm.generate( 1, &item );
+	++_t;
+	return true;
+      }
+      virtual void rewind() override {
+	_hmm = _init;
+	_t = 0;
+      }
+    private:
+      const TableHMM _init;
+      TableHMM _hmm;
+      size_t _length, _t;
+    };
+
+    /**
+     * 'nb_traj' trajectoires de 'length' pas dans 'data' (redimensionné),
+     * la k-ième dans [k*length, (k+1)*length) avec le flux (seed, k) :
+     * même résultat quel que soit nb_thread.
+     */
+    inline void generate( const hmm::Table& table,
+			  unsigned int nb_traj, unsigned int length,
+			  uint64_t seed, Trajectory::HMM::Data& data,
+			  unsigned int nb_thread = 1 ) {
+      data.resize( (size_t) nb_traj * length );
+      utils::parallel::for_range( 0, nb_traj, nb_thread,
+				  [&] (unsigned int begin, unsigned int end) {
+	for( unsigned int k = begin; k < end; ++k) {
+	  TableHMM hmm( table, seed, k );
+	  hmm.generate( length, &data[(size_t) k * length] );
+	}
+      });
+    }
+  }
+}
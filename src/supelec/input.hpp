@@ -4,6 +4,7 @@
 #include <functional>
 #include <algorithm>
 #include <utility>
+#include <cstdint>
 
 #include "hmm.hpp"
 
@@ -22,21 +23,37 @@ namespace bica {
 
     /**
      * Sample un HMM en gardant en memoire le state courant.
+     * Version de référence (closures) : pour générer de longues
+     * trajectoires, voir TableHMM dans hmm_table.hpp.
      */
     class HMM : public Base {
     private:
       int state;
       hmm::T toss_next_state;
       hmm::O toss_observation;
+      bool use_stream;
+      mutable random::Stream rnd;
     public:
 
+      /** Tirages avec std::rand */
       template<typename TOSS_S,typename TOSS_O>
       HMM(const TOSS_S& ts, const TOSS_O& to)
-	: state(0), toss_next_state(ts), toss_observation(to) {}
+	: state(0), toss_next_state(ts), toss_observation(to),
+	  use_stream(false) {}
+      /** Tirages avec son propre flux (seed, stream) : thread-safe */
+      template<typename TOSS_S,typename TOSS_O>
+      HMM(const TOSS_S& ts, const TOSS_O& to,
+	  uint64_t seed, uint64_t stream = 0)
+	: state(0), toss_next_state(ts), toss_observation(to),
+	  use_stream(true), rnd(seed, stream) {}
       HMM(const HMM& cp) = default;
       HMM& operator=(const HMM& cp) = default;
 
       virtual double input() const override {
+	if(use_stream) {
+	  random::ScopedStream scope(rnd);
+	  return toss_observation(state);
+	}
 	return toss_observation(state);
       }
 
@@ -45,7 +62,12 @@ namespace bica {
       }
 
       virtual void shift() override {
-	state = toss_next_state(state);
+	if(use_stream) {
+	  random::ScopedStream scope(rnd);
+	  state = toss_next_state(state);
+	}
+	else
+	  state = toss_next_state(state);
       }
     };
 
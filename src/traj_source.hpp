@@ -0,0 +1,211 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef TRAJ_SOURCE_HPP
+#define TRAJ_SOURCE_HPP
+
+/**
+ * Trajectory::Source<Item> : suite d'Item tirés un par un (next) et
+ * rejouable depuis le début (rewind), sans Data en mémoire.
+ * - DataSource : un Data existant, par référence
+ * - StoreSource : un fichier binaire (traj_store.hpp), par mmap
+ *   (DataSource et StoreSource peuvent se limiter aux Item [first, last))
+ * - TextSource : un fichier texte, lu ligne à ligne
+ * - open_hmm / open_pomdp : StoreSource ou TextSource selon le fichier
+ * Les générateurs sont à côté de leur modèle : bica::sampler::TableSource
+ * (hmm_table.hpp), Model::SimulatorSource (pomdp/simulator.hpp).
+ *
+ * for( auto& item: source ) {...} part du début (rewind).
+ */
+
+#include <memory>                    // std::unique_ptr
+#include <iterator>                  // std::input_iterator_tag
+#include <string>                    // std::string
+#include <sstream>                   // std::istringstream
+#include <fstream>                   // std::ifstream
+#include <stdexcept>                 // std::runtime_error
+#include <algorithm>                 // std::min
+
+#include "traj_store.hpp"
+
+// **************************************************************** Trajectory
+namespace Trajectory
+{
+// ***************************************************************************
+// ******************************************************************** Source
+// ***************************************************************************
+template<typename T>
+class Source
+{
+public:
+  using Item = T;
+  virtual ~Source() {}
+  /** Item suivant dans 'item', false à la fin */
+  virtual bool next( Item& item ) = 0;
+  /** Repart du premier Item (la même suite) */
+  virtual void rewind() = 0;
+  /** Comme next, mais repart du début à la fin (false si vide) */
+  bool next_loop( Item& item )
+  {
+    if( next( item )) return true;
+    rewind();
+    return next( item );
+  }
+  // ********************************************************* Source::iterator
+  class iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Item;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Item*;
+    using reference = const Item&;
+
+    iterator() : _src(nullptr) {}
+    iterator( Source* src ) : _src(src) { ++(*this); }
+    reference operator*() const { return _item; }
+    pointer operator->() const { return &_item; }
+    iterator& operator++()
+    {
+      if( not _src->next( _item )) _src = nullptr;
+      return *this;
+    }
+    bool operator==( const iterator& it ) const { return _src == it._src; }
+    bool operator!=( const iterator& it ) const { return _src != it._src; }
+  private:
+    Source* _src;
+    Item _item;
+  };
+  iterator begin() { rewind(); return iterator( this ); }
+  iterator end() { return iterator(); }
+};
+using HMMSource = Source<HMM::Item>;
+using POMDPSource = Source<POMDP::Item>;
+
+// ***************************************************************************
+// **************************************************************** DataSource
+// ***************************************************************************
+/** Un Data (HMM::Data, POMDP::Data), non copié, ou ses Item [first, last) */
+template<typename Container>
+class DataSource : public Source<typename Container::value_type>
+{
+public:
+  using Item = typename Container::value_type;
+  DataSource( const Container& data, size_t first = 0, size_t last = -1 ) :
+    _data(data), _first(first), _last(std::min( last, data.size() )), _idx(first)
+  {}
+  virtual bool next( Item& item ) override
+  {
+    if( _idx >= _last ) return false;
+    item = _data[_idx++];
+    return true;
+  }
+  virtual void rewind() override { _idx = _first; }
+  size_t size() const { return _last > _first ? _last - _first : 0; }
+private:
+  const Container& _data;
+  size_t _first, _last;
+  size_t _idx;
+};
+// ***************************************************************************
+// *************************************************************** StoreSource
+// ***************************************************************************
+/**
+ * Fichier binaire ouvert par mmap (HMMStore ou POMDPStore), ou ses Item
+ * [first, last) : plusieurs StoreSource sur le même fichier partagent
+ * les pages.
+ */
+template<typename Store>
+class StoreSource : public Source<typename Store::Item>
+{
+public:
+  using Item = typename Store::Item;
+  StoreSource( const std::string& filename, size_t first = 0, size_t last = -1 ) :
+    _store(filename), _first(first), _last(std::min( last, _store.size() )),
+    _idx(first)
+  {}
+  virtual bool next( Item& item ) override
+  {
+    if( _idx >= _last ) return false;
+    item = _store[_idx++];
+    return true;
+  }
+  virtual void rewind() override { _idx = _first; }
+  size_t size() const { return _last > _first ? _last - _first : 0; }
+  const Store& store() const { return _store; }
+private:
+  Store _store;
+  size_t _first, _last;
+  size_t _idx;
+};
+// ***************************************************************************
+// **************************************************************** TextSource
+// ***************************************************************************
+/** (private) une ligne de HMM::save / POMDP::read */
+inline bool _parse( const std::string& line, HMM::Item& item )
+{
+  std::istringstream iss( line );
+  return static_cast<bool>( iss >> item.id_s >> item.id_o );
+}
+inline bool _parse( const std::string& line, POMDP::Item& item )
+{
+  std::istringstream iss( line );
+  return static_cast<bool>( iss >> item.id_s >> item.id_o >> item.id_a
+                            >> item.id_next_s >> item.id_next_o >> item.r );
+}
+/**
+ * Fichier texte (format de Traj::read), lu au fil de next : les lignes
+ * vides ou commençant par '#' sont sautées, les autres doivent être
+ * complètes (sinon std::runtime_error).
+ */
+template<typename Traj>
+class TextSource : public Source<typename Traj::Item>
+{
+public:
+  using Item = typename Traj::Item;
+  TextSource( const std::string& filename ) : _filename(filename), _ifile(filename)
+  {
+    if( _ifile.fail() ) {
+      throw std::runtime_error( "TextSource: cannot open " + filename );
+    }
+  }
+  virtual bool next( Item& item ) override
+  {
+    while( std::getline( _ifile, _line )) {
+      if( _line.empty() or _line.front() == '#' ) continue;
+      if( not _parse( _line, item )) {
+        throw std::runtime_error( "TextSource: bad line '" + _line + "' in " + _filename );
+      }
+      return true;
+    }
+    return false;
+  }
+  virtual void rewind() override
+  {
+    _ifile.clear();
+    _ifile.seekg( 0 );
+  }
+private:
+  std::string _filename;
+  std::ifstream _ifile;
+  std::string _line;
+};
+// ***************************************************************************
+// ********************************************************** open_hmm / pomdp
+// ***************************************************************************
+/** StoreSource si le fichier est binaire, sinon TextSource */
+inline std::unique_ptr<HMMSource> open_hmm( const std::string& filename )
+{
+  if( Binary::is_binary( filename ))
+    return std::unique_ptr<HMMSource>( new StoreSource<HMMStore>( filename ));
+  return std::unique_ptr<HMMSource>( new TextSource<HMM>( filename ));
+}
+inline std::unique_ptr<POMDPSource> open_pomdp( const std::string& filename )
+{
+  if( Binary::is_binary( filename ))
+    return std::unique_ptr<POMDPSource>( new StoreSource<POMDPStore>( filename ));
+  return std::unique_ptr<POMDPSource>( new TextSource<POMDP>( filename ));
+}
+
+}; // namespace Trajectory
+
+#endif // TRAJ_SOURCE_HPP
@@ -0,0 +1,496 @@
+/* -*- coding: utf-8 -*- */
+
+#ifndef TRAJ_STORE_HPP
+#define TRAJ_STORE_HPP
+
+/**
+ * Format binaire en colonnes pour Trajectory::HMM et Trajectory::POMDP,
+ * lu par mmap : plusieurs processus qui lisent le même fichier partagent
+ * les pages, et l'ouverture ne lit que l'en-tête.
+ *
+ * Fichier (endianness de la machine) :
+ *   Header | ColDesc[nb_col] | meta | colonne 0 | colonne 1 | ...
+ * - meta : texte libre (les lignes "## ..." des fichiers texte,
+ *   ex. "hmm_exp")
+ * - colonne PACKED : entiers sur 'bits' bits (juste ce qu'il faut pour
+ *   le max), dans des mots de 64 bits
+ * - colonne DOUBLE : les double tels quels
+ * - colonne DICT : double avec peu de valeurs différentes (observations
+ *   sans bruit) : nb de valeurs (uint64), les valeurs, puis leurs
+ *   indices en PACKED
+ * Chaque bloc commence sur 8 octets.
+ *
+ * Trajectory::HMMStore / POMDPStore donnent des Item (par valeur) par
+ * index ou itérateur (it->id_o par un proxy), sans copie ; to_data() fait
+ * une copie en Data (traj-convert seulement).
+ */
+
+#include <vector>                    // std::vector
+#include <algorithm>                 // std::max
+#include <map>                       // std::map
+#include <string>                    // std::string
+#include <cstring>                   // std::memcmp, std::memcpy
+#include <cstdint>                   // uint64_t
+#include <cstddef>                   // ptrdiff_t
+#include <iterator>                  // std::random_access_iterator_tag
+#include <fstream>                   // std::ifstream
+#include <stdexcept>                 // std::runtime_error
+
+#include <sys/mman.h>                // mmap
+#include <sys/stat.h>                // fstat
+#include <fcntl.h>                   // open
+#include <unistd.h>                  // close
+
+#include "pomdp/trajectory.hpp"
+#include "supelec/hmm_trajectory.hpp"
+
+// **************************************************************** Trajectory
+namespace Trajectory
+{
+namespace Binary
+{
+  static const char MAGIC[8] = { 'X', 'P', 'T', 'R', 'A', 'J', '0', '1' };
+  enum Kind : uint32_t { KIND_HMM = 1, KIND_POMDP = 2 };
+  enum ColType : uint32_t { COL_PACKED = 0, COL_DOUBLE = 1, COL_DICT = 2 };
+  /** Nb max de valeurs d'une colonne DICT */
+  static const uint64_t MAX_DICT = 1 << 16;
+  /** Nb max d'Item d'un fichier */
+  static const uint64_t MAX_LENGTH = (uint64_t) 1 << 56;
+  struct Header {
+    char     magic[8];
+    uint32_t kind;
+    uint32_t nb_col;
+    uint64_t length;
+    uint64_t meta_size;
+  };
+  struct ColDesc {
+    uint32_t type;
+    uint32_t bits;                   // PACKED et DICT (indices)
+    uint64_t offset;                 // depuis le début du fichier
+    uint64_t size;                   // en octets
+  };
+  inline uint64_t align8( uint64_t n ) { return (n + 7) & ~(uint64_t) 7; }
+  /** Nb de bits pour les entiers de [0, max] */
+  inline uint32_t nb_bits( uint64_t max )
+  {
+    uint32_t bits = 0;
+    while( bits < 32 and (max >> bits) != 0 ) ++bits;
+    return bits;
+  }
+  /** Taille en octets de 'length' entiers de 'bits' bits (+1 mot) */
+  inline uint64_t packed_size( uint64_t length, uint32_t bits )
+  {
+    return ((length * bits + 63) / 64 + 1) * sizeof(uint64_t);
+  }
+
+  // ************************************************************ Binary::Writer
+  class Writer
+  {
+  public:
+    Writer( Kind kind, uint64_t length, const std::string& meta ) :
+      _kind(kind), _length(length), _meta(meta)
+    {}
+    /** Colonne d'entiers, bit-packée */
+    void add_packed( const std::vector<uint32_t>& values )
+    {
+      uint32_t max = 0;
+      for( auto& v: values ) max = std::max( max, v );
+      Column col;
+      col.desc = ColDesc{ COL_PACKED, nb_bits( max ), 0, 0 };
+      pack( values, col.desc.bits, col.words );
+      col.desc.size = col.words.size() * sizeof(uint64_t);
+      _cols.push_back( col );
+    }
+    /** Colonne de double, en DICT si c'est plus petit */
+    void add_double( const std::vector<double>& values )
+    {
+      Column col;
+      // valeurs différentes (clé = bits du double)
+      std::map<uint64_t,uint32_t> dict;
+      for( auto& v: values ) {
+        uint64_t key;
+        std::memcpy( &key, &v, sizeof(v) );
+        if( dict.size() <= MAX_DICT ) dict.emplace( key, 0 );
+      }
+      uint32_t bits = nb_bits( dict.empty() ? 0 : dict.size() - 1 );
+      uint64_t dict_size = sizeof(uint64_t) + dict.size() * sizeof(double)
+        + packed_size( _length, bits );
+      if( dict.size() > MAX_DICT or dict_size >= _length * sizeof(double) ) {
+        col.desc = ColDesc{ COL_DOUBLE, 64, 0, _length * sizeof(double) };
+        col.values = values;
+        _cols.push_back( col );
+        return;
+      }
+      col.desc = ColDesc{ COL_DICT, bits, 0, dict_size };
+      col.values.push_back( 0.0 );            // place du nb de valeurs
+      uint64_t nb = dict.size();
+      std::memcpy( &col.values[0], &nb, sizeof(nb) );
+      for( auto& d: dict ) {
+        d.second = col.values.size() - 1;
+        double v;
+        std::memcpy( &v, &d.first, sizeof(v) );
+        col.values.push_back( v );
+      }
+      std::vector<uint32_t> index;
+      for( auto& v: values ) {
+        uint64_t key;
+        std::memcpy( &key, &v, sizeof(v) );
+        index.push_back( dict[key] );
+      }
+      pack( index, bits, col.words );
+      _cols.push_back( col );
+    }
+    void write( std::ostream& os )
+    {
+      Header head;
+      std::memcpy( head.magic, MAGIC, sizeof(MAGIC) );
+      head.kind = _kind;
+      head.nb_col = _cols.size();
+      head.length = _length;
+      head.meta_size = _meta.size();
+      // offsets
+      uint64_t offset = align8( sizeof(Header) + _cols.size() * sizeof(ColDesc) + _meta.size() );
+      for( auto& col: _cols ) {
+        col.desc.offset = offset;
+        offset = align8( offset + col.desc.size );
+      }
+      uint64_t pos = 0;
+      put( os, pos, (const char*) &head, sizeof(head) );
+      for( auto& col: _cols ) put( os, pos, (const char*) &col.desc, sizeof(ColDesc) );
+      put( os, pos, _meta.data(), _meta.size() );
+      for( auto& col: _cols ) {
+        pad( os, pos, col.desc.offset );
+        // DICT : values puis words
+        put( os, pos, (const char*) col.values.data(), col.values.size() * sizeof(double) );
+        put( os, pos, (const char*) col.words.data(), col.words.size() * sizeof(uint64_t) );
+      }
+      pad( os, pos, align8( pos ));
+    }
+  private:
+    struct Column {
+      ColDesc desc;
+      std::vector<uint64_t> words;
+      std::vector<double> values;
+    };
+    /** 'values' sur 'bits' bits dans 'words' (+1 mot : lecture à cheval sans test) */
+    void pack( const std::vector<uint32_t>& values, uint32_t bits,
+               std::vector<uint64_t>& words ) const
+    {
+      words.assign( packed_size( _length, bits ) / sizeof(uint64_t), 0 );
+      for( uint64_t i = 0; i < _length; ++i) {
+        uint64_t bit = i * bits;
+        uint64_t v = values[i];
+        words[bit >> 6] |= v << (bit & 63);
+        if( (bit & 63) + bits > 64 ) words[(bit >> 6) + 1] |= v >> (64 - (bit & 63));
+      }
+    }
+    static void put( std::ostream& os, uint64_t& pos, const char* data, uint64_t size )
+    {
+      os.write( data, size );
+      pos += size;
+    }
+    static void pad( std::ostream& os, uint64_t& pos, uint64_t to )
+    {
+      while( pos < to ) {
+        os.put( '\0' );
+        ++pos;
+      }
+    }
+    Kind _kind;
+    uint64_t _length;
+    std::string _meta;
+    std::vector<Column> _cols;
+  };
+
+  // ******************************************************** Binary::MappedFile
+  /** Fichier entier en lecture seule, par mmap */
+  class MappedFile
+  {
+  public:
+    MappedFile( const std::string& filename ) : _data(nullptr), _size(0)
+    {
+      int fd = open( filename.c_str(), O_RDONLY );
+      if( fd < 0 ) throw std::runtime_error( "MappedFile: cannot open " + filename );
+      struct stat st;
+      if( fstat( fd, &st ) != 0 ) {
+        close( fd );
+        throw std::runtime_error( "MappedFile: cannot stat " + filename );
+      }
+      _size = st.st_size;
+      if( _size > 0 ) {
+        void* data = mmap( nullptr, _size, PROT_READ, MAP_SHARED, fd, 0 );
+        if( data == MAP_FAILED ) {
+          close( fd );
+          throw std::runtime_error( "MappedFile: cannot mmap " + filename );
+        }
+        _data = (const char*) data;
+      }
+      close( fd );
+    }
+    ~MappedFile()
+    {
+      if( _data ) munmap( (void*) _data, _size );
+    }
+    MappedFile( const MappedFile& ) = delete;
+    MappedFile& operator=( const MappedFile& ) = delete;
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+  private:
+    const char* _data;
+    size_t _size;
+  };
+
+  // ****************************************************** Binary::PackedColumn
+  struct PackedColumn
+  {
+    const uint64_t* words;
+    uint32_t bits;
+    uint32_t operator[]( uint64_t i ) const
+    {
+      if( bits == 0 ) return 0;
+      uint64_t bit = i * bits;
+      uint64_t w = bit >> 6, sh = bit & 63;
+      uint64_t v = words[w] >> sh;
+      if( sh + bits > 64 ) v |= words[w+1] << (64 - sh);
+      return (uint32_t) (v & ((((uint64_t) 1) << bits) - 1));
+    }
+  };
+
+  // ****************************************************** Binary::DoubleColumn
+  /**
+   * Colonne DOUBLE ou DICT. Un indice DICT hors du dictionnaire (fichier
+   * corrompu) donne std::runtime_error.
+   */
+  struct DoubleColumn
+  {
+    const double* values;            // tous (DOUBLE) ou le dictionnaire (DICT)
+    PackedColumn index;              // DICT seulement
+    uint64_t nb;                     // DICT : nb de valeurs
+    bool dict;
+    double operator[]( uint64_t i ) const
+    {
+      if( not dict ) return values[i];
+      uint32_t k = index[i];
+      if( k >= nb ) throw std::runtime_error( "Trajectory::Binary: DICT index out of range" );
+      return values[k];
+    }
+  };
+
+  // ************************************************************ Binary::Reader
+  class Reader
+  {
+  public:
+    Reader( const std::string& filename, Kind kind, uint32_t nb_col ) :
+      _file(filename)
+    {
+      const char* data = _file.data();
+      if( _file.size() < sizeof(Header)
+          or std::memcmp( data, MAGIC, sizeof(MAGIC) ) != 0 ) {
+        throw std::runtime_error( "Trajectory::Binary: not a binary trajectory " + filename );
+      }
+      _head = (const Header*) data;
+      _desc = (const ColDesc*) (data + sizeof(Header));
+      // length borné : pas de débordement de length * bits ou * 8
+      if( _head->kind != kind or _head->nb_col != nb_col
+          or _head->length > MAX_LENGTH or _head->meta_size > _file.size()
+          or sizeof(Header) + nb_col * sizeof(ColDesc) + _head->meta_size > _file.size() ) {
+        throw std::runtime_error( "Trajectory::Binary: bad header in " + filename );
+      }
+      for( uint32_t c = 0; c < nb_col; ++c) {
+        const ColDesc& desc = _desc[c];
+        bool ok = desc.offset % 8 == 0 and desc.size <= _file.size()
+          and desc.offset <= _file.size() - desc.size;
+        if( ok and desc.type == COL_PACKED ) {
+          ok = desc.bits <= 32 and desc.size >= packed_size( _head->length, desc.bits );
+        }
+        else if( ok and desc.type == COL_DOUBLE ) {
+          ok = desc.size >= _head->length * sizeof(double);
+        }
+        else if( ok and desc.type == COL_DICT ) {
+          // le nb de valeurs n'est lu que s'il est dans la colonne
+          uint64_t nb = 0;
+          if( desc.size >= sizeof(uint64_t) ) nb = *(const uint64_t*) (data + desc.offset);
+          ok = desc.size >= sizeof(uint64_t)
+            and desc.bits <= 32 and nb <= MAX_DICT and (nb > 0 or _head->length == 0)
+            and desc.size >= sizeof(uint64_t) + nb * sizeof(double)
+                             + packed_size( _head->length, desc.bits );
+        }
+        else {
+          ok = false;
+        }
+        if( not ok ) {
+          throw std::runtime_error( "Trajectory::Binary: bad column in " + filename );
+        }
+      }
+      _meta.assign( data + sizeof(Header) + nb_col * sizeof(ColDesc), _head->meta_size );
+    }
+    uint64_t length() const { return _head->length; }
+    const std::string& meta() const { return _meta; }
+    PackedColumn packed( uint32_t c ) const
+    {
+      check( c, COL_PACKED );
+      return PackedColumn{ (const uint64_t*) (_file.data() + _desc[c].offset), _desc[c].bits };
+    }
+    DoubleColumn doubles( uint32_t c ) const
+    {
+      const char* data = _file.data() + _desc[c].offset;
+      if( _desc[c].type == COL_DICT ) {
+        uint64_t nb = *(const uint64_t*) data;
+        const double* values = (const double*) (data + sizeof(uint64_t));
+        return DoubleColumn{ values, PackedColumn{ (const uint64_t*) (values + nb), _desc[c].bits }, nb, true };
+      }
+      check( c, COL_DOUBLE );
+      return DoubleColumn{ (const double*) data, PackedColumn{ nullptr, 0 }, 0, false };
+    }
+  private:
+    void check( uint32_t c, ColType type ) const
+    {
+      if( _desc[c].type != type ) {
+        throw std::runtime_error( "Trajectory::Binary: bad column type" );
+      }
+    }
+    MappedFile _file;
+    const Header* _head;
+    const ColDesc* _desc;
+    std::string _meta;
+  };
+
+  /** Le fichier commence-t-il par MAGIC ? */
+  inline bool is_binary( const std::string& filename )
+  {
+    std::ifstream ifile( filename, std::ios::binary );
+    char magic[sizeof(MAGIC)];
+    if( not ifile.read( magic, sizeof(magic) )) return false;
+    return std::memcmp( magic, MAGIC, sizeof(MAGIC) ) == 0;
+  }
+
+  // ********************************************************** Binary::Iterator
+  /** Itérateur (accès direct) sur un Store, Item par valeur */
+  template<typename Store>
+  class Iterator
+  {
+  public:
+    /** it->id_o : l'Item est gardé dans le proxy le temps de l'expression */
+    struct Arrow {
+      typename Store::Item item;
+      const typename Store::Item* operator->() const { return &item; }
+    };
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename Store::Item;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Arrow;
+    using reference = value_type;
+
+    Iterator( const Store* store, size_t idx ) : _store(store), _idx(idx) {}
+    value_type operator*() const { return (*_store)[_idx]; }
+    Arrow operator->() const { return Arrow{ (*_store)[_idx] }; }
+    value_type operator[]( difference_type n ) const { return (*_store)[_idx + n]; }
+    Iterator& operator++() { ++_idx; return *this; }
+    Iterator operator++(int) { Iterator it = *this; ++_idx; return it; }
+    Iterator& operator--() { --_idx; return *this; }
+    Iterator operator--(int) { Iterator it = *this; --_idx; return it; }
+    Iterator& operator+=( difference_type n ) { _idx += n; return *this; }
+    Iterator& operator-=( difference_type n ) { _idx -= n; return *this; }
+    Iterator operator+( difference_type n ) const { return Iterator( _store, _idx + n ); }
+    Iterator operator-( difference_type n ) const { return Iterator( _store, _idx - n ); }
+    difference_type operator-( const Iterator& it ) const { return (difference_type) _idx - (difference_type) it._idx; }
+    bool operator==( const Iterator& it ) const { return _idx == it._idx; }
+    bool operator!=( const Iterator& it ) const { return _idx != it._idx; }
+    bool operator<( const Iterator& it ) const { return _idx < it._idx; }
+  private:
+    const Store* _store;
+    size_t _idx;
+  };
+}; // namespace Binary
+
+// ***************************************************************************
+// ****************************************************************** HMMStore
+// ***************************************************************************
+/** Trajectory::HMM en binaire : colonnes id_s (PACKED), id_o (DOUBLE) */
+class HMMStore
+{
+public:
+  using Item = HMM::Item;
+  using const_iterator = Binary::Iterator<HMMStore>;
+  HMMStore( const std::string& filename ) :
+    _reader( filename, Binary::KIND_HMM, 2 ),
+    _s( _reader.packed(0) ), _o( _reader.doubles(1) )
+  {}
+  size_t size() const { return _reader.length(); }
+  const std::string& meta() const { return _reader.meta(); }
+  Item operator[]( size_t i ) const { return Item{ (int) _s[i], _o[i] }; }
+  const_iterator begin() const { return const_iterator( this, 0 ); }
+  const_iterator end() const { return const_iterator( this, size() ); }
+  HMM::Data to_data() const { return HMM::Data( begin(), end() ); }
+
+  static void write( std::ostream& os, const HMM::Data& data,
+                     const std::string& meta = "" )
+  {
+    std::vector<uint32_t> s;
+    std::vector<double> o;
+    for( auto& item: data ) {
+      if( item.id_s < 0 ) throw std::runtime_error( "HMMStore: negative state id" );
+      s.push_back( item.id_s );
+      o.push_back( item.id_o );
+    }
+    Binary::Writer writer( Binary::KIND_HMM, data.size(), meta );
+    writer.add_packed( s );
+    writer.add_double( o );
+    writer.write( os );
+  }
+private:
+  Binary::Reader _reader;
+  Binary::PackedColumn _s;
+  Binary::DoubleColumn _o;
+};
+// ***************************************************************************
+// **************************************************************** POMDPStore
+// ***************************************************************************
+/** Trajectory::POMDP en binaire : s, o, a, s', o' (PACKED), r (DOUBLE) */
+class POMDPStore
+{
+public:
+  using Item = POMDP::Item;
+  using const_iterator = Binary::Iterator<POMDPStore>;
+  POMDPStore( const std::string& filename ) :
+    _reader( filename, Binary::KIND_POMDP, 6 ),
+    _s( _reader.packed(0) ), _o( _reader.packed(1) ), _a( _reader.packed(2) ),
+    _next_s( _reader.packed(3) ), _next_o( _reader.packed(4) ), _r( _reader.doubles(5) )
+  {}
+  size_t size() const { return _reader.length(); }
+  const std::string& meta() const { return _reader.meta(); }
+  Item operator[]( size_t i ) const
+  {
+    return Item{ _s[i], _o[i], _a[i], _next_s[i], _next_o[i], _r[i] };
+  }
+  const_iterator begin() const { return const_iterator( this, 0 ); }
+  const_iterator end() const { return const_iterator( this, size() ); }
+  POMDP::Data to_data() const { return POMDP::Data( begin(), end() ); }
+
+  static void write( std::ostream& os, const POMDP::Data& data,
+                     const std::string& meta = "" )
+  {
+    std::vector<std::vector<uint32_t>> cols( 5 );
+    std::vector<double> r;
+    for( auto& item: data ) {
+      cols[0].push_back( item.id_s );
+      cols[1].push_back( item.id_o );
+      cols[2].push_back( item.id_a );
+      cols[3].push_back( item.id_next_s );
+      cols[4].push_back( item.id_next_o );
+      r.push_back( item.r );
+    }
+    Binary::Writer writer( Binary::KIND_POMDP, data.size(), meta );
+    for( auto& col: cols ) writer.add_packed( col );
+    writer.add_double( r );
+    writer.write( os );
+  }
+private:
+  Binary::Reader _reader;
+  Binary::PackedColumn _s, _o, _a, _next_s, _next_o;
+  Binary::DoubleColumn _r;
+};
+
+}; // namespace Trajectory
+
+#endif // TRAJ_STORE_HPP
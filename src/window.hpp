@@ -7,6 +7,13 @@
  * A Window is Plotter.
  * Has its own font.
  * Can be rendered and saved OFFSCREEN.
+ * All Window share their OpenGL objects (Vertex Buffers of Curve).
+ * save( filename ) reads the pixels as bytes through PBO, the PNG is
+ * written in the background (PngQueue::global()). With 'deferred', the
+ * read is only finished at the next-but-one save (or flush_save).
+ * Window::offscreen( width, height ) gives an offscreen Window kept for
+ * the next saves, release_offscreen() before glfwTerminate().
+ * Without display (has_display()), use a SoftWindow (soft_window.hpp).
  *
  * MUST have error_callback and key_callback defined as static somewhere !!
  */
@@ -23,8 +30,13 @@
 // Default scale for fonts : screen width=800, axe from -1 to 1.
 #define FONT_SCALE ((1.0 - -1.0) / 800.0)
 
-#include <gl_utils.hpp>              // utils::gl::to_png, error
+#include <gl_utils.hpp>              // utils::gl::PixelReader, error
+#include <png_queue.hpp>             // utils::PngQueue
+#include <gl_buffer.hpp>             // utils::gl::ContextGroup
 #include <algorithm>
+#include <map>                       // std::map
+#include <memory>                    // std::unique_ptr
+#include <cstdlib>                   // getenv
 
 #include <visugl.hpp>
 #include <plotter.hpp>
@@ -49,7 +61,7 @@ public:
     Plotter( -1.0, 2.0, -1.0, 2.0 ), // default _bbox
     _title( title ), _width(width), _height(height),
     _offscreen(offscreen),
-    _window(nullptr), _font(nullptr)
+    _window(nullptr), _font(nullptr), _reader()
   {
     // Create window _________________________________________________
     glfwSetErrorCallback(error_callback);
@@ -60,11 +72,14 @@ public:
     if( _offscreen) {
       glfwWindowHint(GLFW_VISIBLE, false );
     }
-    _window = glfwCreateWindow(_width, _height, _title.c_str(), NULL, NULL);
+    // share OpenGL objects with living Windows
+    _window = glfwCreateWindow(_width, _height, _title.c_str(), NULL,
+                               utils::gl::ContextGroup::share() );
     if (! _window ) {
       glfwTerminate();
       exit(EXIT_FAILURE);
     }
+    utils::gl::ContextGroup::add_context( _window );
     glfwSetWindowPos( _window, posx, posy );
     glfwMakeContextCurrent( _window );
     // TODO can also be set to another DataStructure
@@ -86,20 +101,20 @@ public:
       }
     }
 
+    /** Vertex Buffers, and FrameBufferObject if offscreen */
+    GLenum error = glewInit();
+    if (error != GLEW_OK) {
+      std::cout << "error with glew init() : " << glewGetErrorString(error) << std::endl;
+    }
     /** offscreen => need RenderBuffer in FrameBufferObject */
     if( _offscreen ) {
-      GLenum error = glewInit();
-      if (error != GLEW_OK) {
-	std::cout << "error with glew init() : " << glewGetErrorString(error) << std::endl;
-      } else {
-        std::cout << "glew is ok\n\n";
-      }
       // std::cout << "__CREATE RenderBuffer" << std::endl;
       glGenRenderbuffers( 1 /* nb buffer */, &_render_buf);
       utils::gl::check_error();
       glBindRenderbuffer( GL_RENDERBUFFER, _render_buf );
       utils::gl::check_error();
-      glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB32F, width, height);
+      // bytes, as read by save
+      glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
       utils::gl::check_error();
       glBindRenderbuffer( GL_RENDERBUFFER, 0 );
       utils::gl::check_error();
@@ -122,43 +137,32 @@ public:
   // ****************************************************** Window::destructor
   virtual ~Window()
   {
-    if (_window) {
-      glfwSetWindowShouldClose(_window, GL_TRUE);
-      glfwDestroyWindow( _window);
-      _window = nullptr;
-    }
+    glfwMakeContextCurrent( _window );
+    flush_save();
+    _reader.release();
     if( _offscreen ) {
       glDeleteRenderbuffers( 1, &_render_buf );
       utils::gl::check_error();
       glDeleteFramebuffers( 1, &_fbo );
       utils::gl::check_error();
     }
+    if (_window) {
+      glfwSetWindowShouldClose(_window, GL_TRUE);
+      glfwDestroyWindow( _window);
+      utils::gl::ContextGroup::remove_context( _window );
+      // shared objects stay usable through another Window
+      if( utils::gl::ContextGroup::alive() ) {
+        glfwMakeContextCurrent( utils::gl::ContextGroup::share() );
+      }
+      _window = nullptr;
+    }
   }
 
   // ********************************************************** Window::update
   virtual void update_bbox()
   {
     // update BBox to be slightly larger than inner_bboxes
-    BoundingBox bbox{ std::numeric_limits<double>::max(),
-        (-std::numeric_limits<double>::max()),
-        std::numeric_limits<double>::max(),
-        -std::numeric_limits<double>::max() };
-    
-    for( const auto& plotter: _plotters ) {
-      plotter->update_bbox();
-      auto b = plotter->get_bbox();
-      if( b.x_min < bbox.x_min ) bbox.x_min = b.x_min;
-      if( b.x_max > bbox.x_max ) bbox.x_max = std::max( b.x_max, b.x_min+0.1 );
-      if( b.y_min < bbox.y_min ) bbox.y_min = b.y_min;
-      if( b.y_max > bbox.y_max ) bbox.y_max = std::max( b.y_max, b.y_min+0.1 );
-    }
-    auto range_x = bbox.x_max - bbox.x_min;
-    bbox.x_min = bbox.x_min - 0.05 * range_x;
-    bbox.x_max = bbox.x_max + 0.05 * range_x;
-    auto range_y = bbox.y_max - bbox.y_min;
-    bbox.y_min = bbox.y_min - 0.05 * range_y;
-    bbox.y_max = bbox.y_max + 0.05 * range_y;
-    set_bbox( bbox );
+    set_bbox( outer_bbox() );
     
     // std::cout << "__UPD BBOX WIN window  = " << get_bbox() << std::endl;
   }
@@ -240,9 +244,9 @@ public:
     }
   }
   // ************************************************************ Window::save
-  void save( const std::string& filename )
+  /** 'deferred' : do not wait for the pixels now (cf flush_save) */
+  void save( const std::string& filename, bool deferred = false )
   {
-    std::cout << "__SAVE" << std::endl;
     // Make sure using current window
     glfwMakeContextCurrent( _window );
     // TODO can also be set to another DataStructure
@@ -253,11 +257,49 @@ public:
       glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
       utils::gl::check_error();
     }
-    // debug
-    std::cout << "  before" << std::endl;
-    utils::gl::to_png( filename );
-    std::cout << "  after" << std::endl;
+    _reader.read( filename, utils::PngQueue::global() );
+    if( not deferred ) flush_save();
+  }
+  /** Pending saves are given to PngQueue::global() */
+  void flush_save()
+  {
+    glfwMakeContextCurrent( _window );
+    _reader.flush( utils::PngQueue::global() );
+  }
+  // ***************************************************** Window::has_display
+  /** Can GLFW open a Window here ? Otherwise, use SoftWindow */
+  static bool has_display()
+  {
+    const char* x11 = getenv( "DISPLAY" );
+    const char* wayland = getenv( "WAYLAND_DISPLAY" );
+    if( not (x11 and *x11) and not (wayland and *wayland) ) return false;
+    return glfwInit() == GL_TRUE;
+  }
+  // ******************************************************* Window::offscreen
+  /**
+   * Offscreen Window of that size, created at first call and kept (with
+   * its context and FBO) for the next calls. Its plotters are removed :
+   * call clear_plotters() once rendered, so that the pool never keeps
+   * pointers to destroyed Plotters.
+   */
+  static Window& offscreen( const int width, const int height )
+  {
+    auto& win = _pool()[std::make_pair( width, height )];
+    if( not win ) {
+      win.reset( new Window( "Offscreen", width, height, true /*offscreen*/ ) );
+    }
+    win->clear_plotters();
+    return *win;
   }
+  /** Destroy offscreen Windows, pending saves are written */
+  static void release_offscreen()
+  {
+    for( auto& item: _pool() ) item.second->clear_plotters();
+    _pool().clear();
+    utils::PngQueue::global().flush();
+  }
+  /** Forget the plotters (not destroyed) */
+  void clear_plotters() { _plotters.clear(); }
 
   // ******************************************************* Window::attributs
   std::string _title;
@@ -270,6 +312,19 @@ public:
   GLuint _fbo, _render_buf;
 
 private:
+  /** Reads pixels for save */
+  utils::gl::PixelReader _reader;
+  /** Offscreen Windows by (width, height) */
+  using Pool = std::map<std::pair<int,int>, std::unique_ptr<Window>>;
+  static Pool& _pool()
+  {
+    // the queue and the contexts must outlive the pool (pending saves
+    // and Window destructors at exit)
+    utils::PngQueue::global();
+    utils::gl::ContextGroup::touch();
+    static Pool pool;
+    return pool;
+  }
   // *************************************************** Window::GLFW callback
   static void resize_callback( GLFWwindow* window, int width, int height )
   {
@@ -4,6 +4,7 @@
  * Test RDSOM Viewer.
  */
 
+#include <GL/glew.h>                 // before gl.h (Curve uses OpenGL 1.5)
 #include <GLFW/glfw3.h>
 
 #include <dsom/r_network.hpp>
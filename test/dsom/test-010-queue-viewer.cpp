@@ -6,6 +6,7 @@
  * - ideal idx according to input ([0,1] scaled according to idx_max
  */
 
+#include <window.hpp>
 #include <figure.hpp>
 #include <curve.hpp>
 #include <axis.hpp>
@@ -0,0 +1,88 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Neighbourhood-truncated update of REC_DSOM.
+ *   o same learning with full and truncated (hn_epsilon) update
+ *   o compare weights and learning time
+ */
+#include <iostream>                     // std::cout
+#include <chrono>                       // std::chrono
+#include <dsom/r_network.hpp>
+
+using RNetwork = Model::DSOM::RNetwork;
+// ******************************************************************** Global
+#define NB_NEUR 1000
+#define NB_STEP 500
+
+/** Max difference between weights and r_weights of two networks */
+double max_diff( const RNetwork& n1, const RNetwork& n2 )
+{
+  double diff = 0.0;
+  for( unsigned int i = 0; i < n1.v_neur.size(); ++i) {
+    diff = std::max( diff, (n1.v_neur[i]->weights - n2.v_neur[i]->weights).cwiseAbs().maxCoeff() );
+    diff = std::max( diff, (n1.v_neur[i]->r_weights - n2.v_neur[i]->r_weights).cwiseAbs().maxCoeff() );
+  }
+  return diff;
+}
+/** Learn NB_STEP random inputs, return duration of deltaW in ms */
+double learn( RNetwork& net, bool som, unsigned int seed )
+{
+  std::default_random_engine rnd( seed );
+  std::uniform_real_distribution<double> unif( 0.0, 1.0 );
+
+  double duration = 0.0;
+  for( unsigned int t = 0; t < NB_STEP; ++t) {
+    Eigen::VectorXd input(1);
+    input << unif( rnd );
+    net.forward( input, 0.5, 0.1, 0.1, 0.01 );
+
+    auto start = std::chrono::steady_clock::now();
+    if( som ) {
+      net.deltaWSOM( input, 0.1, 0.05 );
+    }
+    else {
+      net.deltaW( input, 0.1, 0.2, 0.2 );
+    }
+    auto end = std::chrono::steady_clock::now();
+    duration += std::chrono::duration<double, std::milli>(end - start).count();
+  }
+  return duration;
+}
+/** SOM: triangle_dist is 0 outside sig_som => exact with hn_eps=0 */
+void tt_sparse_som()
+{
+  RNetwork full( 1, NB_NEUR, -1 );
+  RNetwork sparse( full );
+  full.set_hn_epsilon( -1.0 );  // full scan
+  sparse.set_hn_epsilon( 0.0 );
+
+  auto t_full = learn( full, true, 42 );
+  auto t_sparse = learn( sparse, true, 42 );
+  std::cout << "SOM  full=" << t_full << "ms sparse=" << t_sparse << "ms";
+  std::cout << " max_diff=" << max_diff( full, sparse ) << std::endl;
+}
+/** DSOM: gaussian neighbourhood truncated at hn_eps */
+void tt_sparse_dsom( double hn_eps )
+{
+  RNetwork full( 1, NB_NEUR, -1 );
+  RNetwork sparse( full );
+  sparse.set_hn_epsilon( hn_eps );
+
+  auto t_full = learn( full, false, 42 );
+  auto t_sparse = learn( sparse, false, 42 );
+  std::cout << "DSOM hn_eps=" << hn_eps;
+  std::cout << " full=" << t_full << "ms sparse=" << t_sparse << "ms";
+  std::cout << " max_diff=" << max_diff( full, sparse ) << std::endl;
+}
+// ***************************************************************************
+int main(int argc, char *argv[])
+{
+  std::cout << "__SPARSE SOM" << std::endl;
+  tt_sparse_som();
+  std::cout << "__SPARSE DSOM" << std::endl;
+  tt_sparse_dsom( 1e-12 );
+  tt_sparse_dsom( 1e-6 );
+  tt_sparse_dsom( 1e-3 );
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Winner search backends for DSOM.
+ *   o same winners with plain scan, brute force and VP-tree
+ *   o same winners after some learning (VP-tree is not rebuilt each step)
+ *   o VP-tree falls back on the brute force scan in high dimension
+ *   o benchmark of the backends on a 100x100 map with 2D and 16D inputs
+ */
+#include <iostream>                     // std::cout
+#include <chrono>                       // std::chrono
+#include <dsom/network.hpp>
+
+using Network = Model::DSOM::Network;
+// ******************************************************************** Global
+#define NB_NEUR   10000
+#define NB_QUERY  1000
+#define NB_LEARN  20
+
+std::vector<Eigen::VectorXd> make_inputs( unsigned int dim, unsigned int nb,
+                                          unsigned int seed )
+{
+  std::default_random_engine rnd( seed );
+  std::uniform_real_distribution<double> unif( 0.0, 1.0 );
+  std::vector<Eigen::VectorXd> inputs;
+  for( unsigned int i = 0; i < nb; ++i) {
+    Eigen::VectorXd v(dim);
+    for( unsigned int d = 0; d < dim; ++d) v(d) = unif( rnd );
+    inputs.push_back( v );
+  }
+  return inputs;
+}
+/** Winners (and time in ms) of net on all inputs */
+std::vector<unsigned int> winners( Network& net,
+                                   std::vector<Eigen::VectorXd>& inputs,
+                                   std::vector<double>& dist,
+                                   double& duration )
+{
+  std::vector<unsigned int> win;
+  dist.clear();
+  auto start = std::chrono::steady_clock::now();
+  for( auto& in: inputs ) {
+    dist.push_back( net.computeWinner( in ));
+    win.push_back( net.get_winner() );
+  }
+  auto end = std::chrono::steady_clock::now();
+  duration = std::chrono::duration<double, std::milli>(end - start).count();
+  return win;
+}
+/** Compare backends on a map with inputs of dimension 'dim' */
+void tt_compare( unsigned int dim )
+{
+  Network net( dim, NB_NEUR, -2 );
+  std::vector<Network*> v_net;
+  Network* brute = new Network( net );
+  brute->set_winner_search( new Model::DSOM::BruteForceSearch() );
+  v_net.push_back( brute );
+  Network* vptree = new Network( net );
+  vptree->set_winner_search( new Model::DSOM::VPTreeSearch() );
+  v_net.push_back( vptree );
+
+  auto queries = make_inputs( dim, NB_QUERY, 1 );
+  auto samples = make_inputs( dim, NB_LEARN, 2 );
+  for( unsigned int epoch = 0; epoch < 3; ++epoch) {
+    std::cout << "__EPOCH " << epoch << std::endl;
+    double t_ref;
+    std::vector<double> d_ref;
+    auto w_ref = winners( net, queries, d_ref, t_ref );
+    std::cout << "  scan   : " << t_ref << " ms" << std::endl;
+
+    std::vector<unsigned int> w_brute;
+    std::vector<double> d_brute;
+    for( auto& n: v_net ) {
+      double t;
+      std::vector<double> d;
+      auto w = winners( *n, queries, d, t );
+      if( w_brute.empty() ) {
+        w_brute = w;
+        d_brute = d;
+      }
+      unsigned int diff_ref = 0, diff_brute = 0;
+      for( unsigned int i = 0; i < w.size(); ++i) {
+        if( w[i] != w_ref[i] ) ++diff_ref;
+        if( w[i] != w_brute[i] or d[i] != d_brute[i] ) ++diff_brute;
+      }
+      std::cout << "  " << n->get_winner_search()->name() << " : " << t << " ms";
+      std::cout << " (x" << t_ref / t << ")";
+      std::cout << " diff_scan=" << diff_ref << " diff_brute=" << diff_brute;
+      std::cout << std::endl;
+    }
+    auto vp = dynamic_cast<Model::DSOM::VPTreeSearch*>( vptree->get_winner_search() );
+    std::cout << "  vptree built " << vp->get_nb_build() << " times, visit=";
+    std::cout << vp->get_visit() << " scanning=" << vp->is_scanning() << std::endl;
+
+    // some learning, identical for all networks
+    for( auto& s: samples ) {
+      net.forward( s );
+      net.deltaW( s, 0.05, 0.5 );
+      for( auto& n: v_net ) {
+        n->forward( s );
+        n->deltaW( s, 0.05, 0.5 );
+      }
+    }
+  }
+
+  for( auto& n: v_net ) delete n;
+}
+// ***************************************************************************
+int main(int argc, char *argv[])
+{
+  std::cout << "__DIM 2" << std::endl;
+  tt_compare( 2 );
+  std::cout << "__DIM 16" << std::endl;
+  tt_compare( 16 );
+
+  return 0;
+}
@@ -0,0 +1,81 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Local search of the winner of REC_DSOM around the predicted winner.
+ *   o learn a periodic sequence with the full search
+ *   o same winners with full and local search on the learned network
+ *   o hit rate (no fall back to full scan) and time
+ */
+#include <iostream>                     // std::cout
+#include <chrono>                       // std::chrono
+#include <dsom/r_network.hpp>
+
+using RNetwork = Model::DSOM::RNetwork;
+// ******************************************************************** Global
+#define NB_NEUR  200
+#define NB_LEARN 2000
+#define NB_TEST  500
+
+// Parameters as in xp-004-rdsom
+#define BETA      0.5
+#define SIG_INPUT 0.1
+#define SIG_RECUR 0.1
+#define SIG_CONV  0.01
+
+/** Periodic sequence of 7 symbols, coded in [0,1] */
+Eigen::VectorXd symbol( unsigned int t )
+{
+  const double seq[] = {0, 1, 2, 3, 4, 5, 6, 1, 2, 6};
+  Eigen::VectorXd v(1);
+  v << seq[t % 10] / 6.0;
+  return v;
+}
+/** Winners of net along NB_TEST steps (and time in ms) */
+std::vector<unsigned int> run( RNetwork& net, double& duration )
+{
+  std::vector<unsigned int> win;
+  auto start = std::chrono::steady_clock::now();
+  for( unsigned int t = 0; t < NB_TEST; ++t) {
+    auto input = symbol( t );
+    net.forward( input, BETA, SIG_INPUT, SIG_RECUR, SIG_CONV );
+    win.push_back( net.get_winner() );
+  }
+  auto end = std::chrono::steady_clock::now();
+  duration = std::chrono::duration<double, std::milli>(end - start).count();
+  return win;
+}
+// ***************************************************************************
+int main(int argc, char *argv[])
+{
+  std::cout << "__LEARN" << std::endl;
+  RNetwork net( 1, NB_NEUR, -1 );
+  for( unsigned int t = 0; t < NB_LEARN; ++t) {
+    auto input = symbol( t );
+    net.forward( input, BETA, SIG_INPUT, SIG_RECUR, SIG_CONV );
+    net.deltaWSOM( input, 0.1, 0.05 );
+  }
+
+  std::cout << "__TEST" << std::endl;
+  RNetwork full( net );
+  full.reset();
+  double t_full;
+  auto w_full = run( full, t_full );
+  std::cout << "  full   : " << t_full << " ms" << std::endl;
+
+  for( int radius: {2, 10, NB_NEUR/2} ) {
+    RNetwork local( net );
+    local.reset();
+    local.set_local_search( true, radius );
+    double t_local;
+    auto w_local = run( local, t_local );
+    unsigned int diff = 0;
+    for( unsigned int i = 0; i < w_full.size(); ++i) {
+      if( w_full[i] != w_local[i] ) ++diff;
+    }
+    std::cout << "  local radius=" << radius << " : " << t_local << " ms";
+    std::cout << " hit_rate=" << local.get_local_hit_rate();
+    std::cout << " diff=" << diff << std::endl;
+  }
+
+  return 0;
+}
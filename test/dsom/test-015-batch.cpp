@@ -0,0 +1,190 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Block (mini-batch) learning of DSOM and REC_DSOM.
+ * The delta of a block is the sum of the deltas of its inputs (rescaled
+ * when the gain of a neuron exceeds 1) : runs are compared for the same nb
+ * of inputs.
+ *   o DSOM: random weights gathered in [0.45,0.55]^2 spread on [0,1]^2,
+ *     quantization error decreases, online vs blocks of 8/32 inputs agree,
+ *     same result with 1 and 4 threads
+ *   o REC_DSOM: errors on a periodic sequence decrease, online vs blocks
+ * Return 1 if a check fails.
+ */
+#include <iostream>                     // std::cout
+#include <chrono>                       // std::chrono
+#include <cmath>                        // fabs
+#include <algorithm>                    // std::max
+#include <dsom/network.hpp>
+#include <dsom/r_network.hpp>
+
+using Network = Model::DSOM::Network;
+using RNetwork = Model::DSOM::RNetwork;
+// ******************************************************************** Global
+#define NB_NEUR   400
+#define NB_SAMPLE 2000
+#define NB_SEEN   16000
+#define NB_REPORT 5
+// Final errors of blocks are within TOL (relative) of online errors
+#define TOL_DSOM  0.1
+#define TOL_RDSOM 0.05
+
+unsigned int _nb_fail = 0;
+void check( bool ok, const std::string& msg )
+{
+  if( not ok ) ++_nb_fail;
+  std::cout << "  " << (ok ? "OK   " : "FAIL ") << msg << std::endl;
+}
+std::vector<Eigen::VectorXd> make_inputs( unsigned int nb, unsigned int seed )
+{
+  std::default_random_engine rnd( seed );
+  std::uniform_real_distribution<double> unif( 0.0, 1.0 );
+  std::vector<Eigen::VectorXd> inputs;
+  for( unsigned int i = 0; i < nb; ++i) {
+    Eigen::VectorXd v(2);
+    v << unif( rnd ), unif( rnd );
+    inputs.push_back( v );
+  }
+  return inputs;
+}
+/** Mean distance of inputs to their winner */
+double quantization( Network& net, std::vector<Eigen::VectorXd>& inputs )
+{
+  double err = 0.0;
+  for( auto& in: inputs ) {
+    err += net.computeWinner( in );
+  }
+  return err / inputs.size();
+}
+/** 'nb_seen' inputs used in turn, by online steps (batch == 1) or blocks */
+void learn( Network& net, std::vector<Eigen::VectorXd>& inputs,
+            unsigned int& t, unsigned int nb_seen,
+            unsigned int batch, unsigned int nb_thread )
+{
+  std::vector<Eigen::VectorXd> block;
+  for( unsigned int u = 0; u < nb_seen / std::max( 1u, batch ); ++u) {
+    block.clear();
+    for( unsigned int b = 0; b < batch; ++b, ++t) {
+      block.push_back( inputs[t % inputs.size()] );
+    }
+    if( batch <= 1 ) {
+      net.forward( block[0] );
+      net.deltaW( block[0], 0.05, 1.0 );
+    }
+    else {
+      net.learnBatch( block, 0.05, 1.0, nb_thread );
+    }
+  }
+}
+// ***************************************************************************
+void tt_dsom()
+{
+  std::cout << "__DSOM" << std::endl;
+  Network net( 2, NB_NEUR, -2, 0.45, 0.55 );
+  auto samples = make_inputs( NB_SAMPLE, 1 );
+  auto tests = make_inputs( 500, 2 );
+
+  struct Run { unsigned int batch, nb_thread; };
+  std::vector<Run> runs = { {1,1}, {8,1}, {8,4}, {32,4} };
+  std::vector<double> err_end;
+  std::vector<Network*> v_net;
+  double err_init = quantization( net, tests );
+  std::cout << "  init err=" << err_init << std::endl;
+  for( unsigned int i = 0; i < runs.size(); ++i) {
+    v_net.push_back( new Network( net ));
+    std::cout << "  batch=" << runs[i].batch << " threads=" << runs[i].nb_thread;
+    auto start = std::chrono::steady_clock::now();
+    unsigned int t = 0;
+    for( unsigned int r = 0; r < NB_REPORT; ++r) {
+      learn( *v_net[i], samples, t, NB_SEEN / NB_REPORT,
+             runs[i].batch, runs[i].nb_thread );
+      std::cout << " " << quantization( *v_net[i], tests );
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << " (" << std::chrono::duration<double, std::milli>(end - start).count() << " ms)" << std::endl;
+    err_end.push_back( quantization( *v_net[i], tests ));
+  }
+
+  for( unsigned int i = 0; i < runs.size(); ++i) {
+    std::stringstream msg;
+    msg << "batch=" << runs[i].batch << " err " << err_init << " -> " << err_end[i];
+    check( err_end[i] < 0.5 * err_init, msg.str() );
+  }
+  for( unsigned int i = 1; i < runs.size(); ++i) {
+    std::stringstream msg;
+    msg << "batch=" << runs[i].batch << " vs online : " << err_end[i] << " / " << err_end[0];
+    check( fabs( err_end[i] - err_end[0] ) < TOL_DSOM * err_end[0], msg.str() );
+  }
+  // Threads do not change the result
+  double diff = quantization( *v_net[1], samples ) - quantization( *v_net[2], samples );
+  std::stringstream msg;
+  msg << "diff 1 vs 4 threads=" << diff;
+  check( diff == 0.0, msg.str() );
+
+  for( auto& n: v_net ) delete n;
+}
+// ***************************************************************************
+/** Periodic sequence of 7 symbols, coded in [0,1] */
+Eigen::VectorXd symbol( unsigned int t )
+{
+  const double seq[] = {0, 1, 2, 3, 4, 5, 6, 1, 2, 6};
+  Eigen::VectorXd v(1);
+  v << seq[t % 10] / 6.0;
+  return v;
+}
+void tt_rdsom()
+{
+  std::cout << "__REC_DSOM" << std::endl;
+  RNetwork net( 1, 100, -1 );
+  std::vector<unsigned int> batches = {1, 5, 10};
+  std::vector<double> err_end;
+  for( auto& batch: batches ) {
+    RNetwork rnet( net );
+    double err_in = 0.0, err_rec = 0.0;
+    double err_in_start = 0.0;
+    unsigned int nb_step = NB_SEEN;
+    auto start = std::chrono::steady_clock::now();
+    for( unsigned int t = 0; t < nb_step; ++t) {
+      auto input = symbol( t );
+      rnet.forward( input, 0.5, 0.1, 0.1, 0.01 );
+      if( batch <= 1 ) {
+        rnet.deltaWSOM( input, 0.1, 0.05 );
+      }
+      else {
+        rnet.batch_push( input );
+        if( rnet.batch_size() >= batch ) rnet.deltaWSOMBatch( 0.1, 0.05, 4 );
+      }
+      if( t < 200 ) {
+        err_in_start += rnet.get_winner_dist_input();
+      }
+      if( t >= nb_step - 200 ) {
+        err_in += rnet.get_winner_dist_input();
+        err_rec += rnet.get_winner_dist_rec();
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "  batch=" << batch << " err_in=" << err_in_start / 200.0;
+    std::cout << " -> " << err_in / 200.0;
+    std::cout << " err_rec=" << err_rec / 200.0;
+    std::cout << " (" << std::chrono::duration<double, std::milli>(end - start).count() << " ms)" << std::endl;
+    std::stringstream msg;
+    msg << "batch=" << batch << " err_in decreases";
+    check( err_in < err_in_start, msg.str() );
+    err_end.push_back( err_in / 200.0 );
+  }
+  for( unsigned int i = 1; i < err_end.size(); ++i) {
+    std::stringstream msg;
+    msg << "batch=" << batches[i] << " vs online : err_in " << err_end[i] << " / " << err_end[0];
+    // symbols are 1/6 apart : absolute tolerance
+    check( fabs( err_end[i] - err_end[0] ) < TOL_RDSOM, msg.str() );
+  }
+}
+// ***************************************************************************
+int main(int argc, char *argv[])
+{
+  tt_dsom();
+  tt_rdsom();
+
+  std::cout << "__FAIL " << _nb_fail << std::endl;
+  return _nb_fail == 0 ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Population of REC_DSOM trained in lockstep.
+ *   o weights of the replicas are views on one contiguous store, drawn
+ *     from the seed of each replica
+ *   o each replica learns as the same network trained alone
+ *   o same result with 1 and 4 threads
+ *   o time of population vs one after the other
+ *   o no seed with a model network
+ */
+#include <iostream>                     // std::cout
+#include <chrono>                       // std::chrono
+#include <dsom/population.hpp>
+
+using RNetwork = Model::DSOM::RNetwork;
+using Population = Model::DSOM::Population;
+// ******************************************************************** Global
+#define NB_NEUR  100
+#define NB_LEARN 2000
+
+/** Periodic sequence of 7 symbols, coded in [0,1] */
+std::vector<Eigen::VectorXd> make_sequence()
+{
+  const double seq[] = {0, 1, 2, 3, 4, 5, 6, 1, 2, 6};
+  std::vector<Eigen::VectorXd> inputs;
+  for( unsigned int t = 0; t < NB_LEARN; ++t) {
+    Eigen::VectorXd v(1);
+    v << seq[t % 10] / 6.0;
+    inputs.push_back( v );
+  }
+  return inputs;
+}
+// ***************************************************************************
+int main(int argc, char *argv[])
+{
+  std::vector<Population::Param> params;
+  for( unsigned int k = 0; k < 8; ++k) {
+    Population::Param p;
+    p.seed = k;
+    p.dsom = (k % 2 == 0);
+    p.sig_convo = 0.01;
+    p.eps = 0.05 + 0.01 * k;
+    params.push_back( p );
+  }
+  auto inputs = make_sequence();
+
+  std::cout << "__STORE" << std::endl;
+  // untrained population, starting point of the networks trained alone
+  Population pop_init( params, 1, NB_NEUR, -1 );
+  {
+    auto& store = pop_init.get_store();
+    std::cout << "  store " << store.rows() << "x" << store.cols() << std::endl;
+    auto& neur = *pop_init.get_net( 3 ).v_neur[7];
+    std::cout << "  view of store=" << (neur.weights.data() == &store( 0, 3*NB_NEUR+7 ));
+    std::cout << " " << (neur.r_weights.data() == &store( 1, 3*NB_NEUR+7 )) << std::endl;
+    // same seed in another position : same weights
+    std::vector<Population::Param> other = { params[5], params[3] };
+    Population pop_other( other, 1, NB_NEUR, -1 );
+    std::cout << "  same seed, same weights="
+              << (pop_other.get_store().rightCols( NB_NEUR ) == store.middleCols( 3*NB_NEUR, NB_NEUR ));
+    std::cout << " other seed, other weights="
+              << (pop_other.get_store().leftCols( NB_NEUR ) != store.middleCols( 3*NB_NEUR, NB_NEUR ))
+              << std::endl;
+  }
+
+  std::cout << "__POPULATION" << std::endl;
+  double t_pop[2];
+  std::vector<Population*> v_pop;
+  for( unsigned int nb_thread: {1, 4} ) {
+    Population* pop = new Population( params, 1, NB_NEUR, -1 );
+    auto start = std::chrono::steady_clock::now();
+    pop->run( inputs, true, nb_thread );
+    auto end = std::chrono::steady_clock::now();
+    t_pop[v_pop.size()] = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << "  threads=" << nb_thread << " : " << t_pop[v_pop.size()] << " ms" << std::endl;
+    v_pop.push_back( pop );
+  }
+
+  std::cout << "__ALONE" << std::endl;
+  auto start = std::chrono::steady_clock::now();
+  for( unsigned int k = 0; k < params.size(); ++k) {
+    auto& p = params[k];
+    RNetwork net( pop_init.get_net( k ));
+    for( auto& input: inputs ) {
+      net.forward( input, p.beta, p.sig_input, p.sig_recur, p.sig_convo );
+      if( p.dsom ) net.deltaW( input, p.eps, p.ela, p.ela_rec );
+      else net.deltaWSOM( input, p.eps, p.sig_som );
+    }
+    // compare winners on the sequence
+    unsigned int diff_1 = 0, diff_4 = 0;
+    RNetwork& net_1 = v_pop[0]->get_net( k );
+    RNetwork& net_4 = v_pop[1]->get_net( k );
+    net.reset(); net_1.reset(); net_4.reset();
+    for( unsigned int t = 0; t < 100; ++t) {
+      net.forward( inputs[t], p.beta, p.sig_input, p.sig_recur, p.sig_convo );
+      net_1.forward( inputs[t], p.beta, p.sig_input, p.sig_recur, p.sig_convo );
+      net_4.forward( inputs[t], p.beta, p.sig_input, p.sig_recur, p.sig_convo );
+      if( net.get_winner() != net_1.get_winner() ) ++diff_1;
+      if( net.get_winner() != net_4.get_winner() ) ++diff_4;
+    }
+    auto err = v_pop[0]->get_mean_errors( k );
+    std::cout << "  [" << k << "] err_in=" << err.input << " err_rec=" << err.rec;
+    std::cout << " diff_1=" << diff_1 << " diff_4=" << diff_4 << std::endl;
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::cout << "  alone : " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+  std::cout << "__MODEL" << std::endl;
+  try {
+    Population pop_model( params, pop_init.get_net( 0 ));
+    std::cout << "  seeds accepted" << std::endl;
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "  seeds rejected: " << e.what() << std::endl;
+  }
+  for( auto& p: params ) p.seed = 0;
+  Population pop_model( params, pop_init.get_net( 0 ));
+  std::cout << "  no seed, " << pop_model.size() << " replicas" << std::endl;
+
+  for( auto& pop: v_pop ) delete pop;
+  return 0;
+}
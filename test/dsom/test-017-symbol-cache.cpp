@@ -0,0 +1,98 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Cache of input similarities of REC_DSOM for discrete inputs.
+ *   o learning with and without cache gives the same winners and errors
+ *   o test (frozen weights) with and without cache: same winners, time
+ *   o number of similarities recomputed and of steps recalled by the cache
+ *   o with the full convolution and with the local search (user-028)
+ */
+#include <iostream>                     // std::cout
+#include <chrono>                       // std::chrono
+#include <dsom/r_network.hpp>
+
+using RNetwork = Model::DSOM::RNetwork;
+// ******************************************************************** Global
+#define NB_NEUR  400
+#define NB_LEARN 2000
+#define NB_TEST  2000
+
+// Parameters as in xp-004-rdsom
+#define BETA      0.5
+#define SIG_INPUT 0.1
+#define SIG_RECUR 0.1
+#define SIG_CONV  0.01
+
+/** Periodic sequence of 7 symbols, coded in [0,1] */
+Eigen::VectorXd symbol( unsigned int t )
+{
+  const double seq[] = {0, 1, 2, 3, 4, 5, 6, 1, 2, 6};
+  Eigen::VectorXd v(1);
+  v << seq[t % 10] / 6.0;
+  return v;
+}
+/** Winners and sum of errors along nb steps (and time in ms) */
+std::vector<unsigned int> run( RNetwork& net, unsigned int nb, bool learning,
+                               double& err, double& duration )
+{
+  std::vector<unsigned int> win;
+  err = 0.0;
+  auto start = std::chrono::steady_clock::now();
+  for( unsigned int t = 0; t < nb; ++t) {
+    auto input = symbol( t );
+    net.forward( input, BETA, SIG_INPUT, SIG_RECUR, SIG_CONV );
+    if( learning ) net.deltaW( input, 0.1, 0.2, 0.2 );
+    win.push_back( net.get_winner() );
+    err += net.get_winner_dist_input() + net.get_winner_dist_pred();
+  }
+  auto end = std::chrono::steady_clock::now();
+  duration = std::chrono::duration<double, std::milli>(end - start).count();
+  return win;
+}
+unsigned int nb_diff( const std::vector<unsigned int>& a,
+                      const std::vector<unsigned int>& b )
+{
+  unsigned int diff = 0;
+  for( unsigned int i = 0; i < a.size(); ++i) {
+    if( a[i] != b[i] ) ++diff;
+  }
+  return diff;
+}
+// ***************************************************************************
+void tt_cache( bool local_search )
+{
+  RNetwork net( 1, NB_NEUR, -1 );
+  net.set_hn_epsilon( 0.001 );
+  net.set_local_search( local_search, NB_NEUR / 2 );
+  RNetwork cached( net );
+  cached.set_symbol_cache( true );
+
+  std::cout << "__LEARN local_search=" << local_search << std::endl;
+  double err, err_c, t, t_c;
+  auto w = run( net, NB_LEARN, true, err, t );
+  auto w_c = run( cached, NB_LEARN, true, err_c, t_c );
+  std::cout << "  plain  : " << t << " ms" << std::endl;
+  std::cout << "  cached : " << t_c << " ms, refresh=" << cached.get_nb_symbol_refresh();
+  std::cout << " (on " << NB_LEARN * NB_NEUR << ")" << std::endl;
+  std::cout << "  diff=" << nb_diff( w, w_c ) << " err_diff=" << err - err_c << std::endl;
+
+  std::cout << "__TEST local_search=" << local_search << std::endl;
+  net.reset();
+  cached.reset();
+  auto refresh = cached.get_nb_symbol_refresh();
+  auto recall = cached.get_nb_step_recall();
+  w = run( net, NB_TEST, false, err, t );
+  w_c = run( cached, NB_TEST, false, err_c, t_c );
+  std::cout << "  plain  : " << t << " ms" << std::endl;
+  std::cout << "  cached : " << t_c << " ms, refresh=" << cached.get_nb_symbol_refresh() - refresh;
+  std::cout << " recall=" << cached.get_nb_step_recall() - recall << " (on " << NB_TEST << ")" << std::endl;
+  std::cout << "  diff=" << nb_diff( w, w_c ) << " err_diff=" << err - err_c << std::endl;
+}
+// ***************************************************************************
+int main(int argc, char *argv[])
+{
+  tt_cache( false );
+  tt_cache( true );
+
+  return 0;
+}
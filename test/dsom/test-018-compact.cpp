@@ -0,0 +1,142 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Reduced precision (float/int16) weights of DSOM.
+ * Accuracy report against the double precision map:
+ *   o same winner ratio, error on the winner distance
+ *   o quantization error of the map
+ *   o size and load time of binary vs JSON saves
+ *   o CompactWeights::read refuses a bad magic, a wrong precision and
+ *     truncated data
+ */
+#include <iostream>                     // std::cout
+#include <sstream>                      // std::stringstream
+#include <chrono>                       // std::chrono
+#include <dsom/network.hpp>
+
+#include "rapidjson/document.h"         // rapidjson's DOM-style API
+#include <utils.hpp>                    // various str_xxx
+using namespace utils::rj;
+
+using Network = Model::DSOM::Network;
+using Precision = Model::DSOM::Precision;
+// ******************************************************************** Global
+#define NB_NEUR   2500
+#define NB_LEARN  2000
+#define NB_QUERY  2000
+
+std::vector<Eigen::VectorXd> make_inputs( unsigned int dim, unsigned int nb,
+                                          unsigned int seed )
+{
+  std::default_random_engine rnd( seed );
+  std::uniform_real_distribution<double> unif( 0.0, 1.0 );
+  std::vector<Eigen::VectorXd> inputs;
+  for( unsigned int i = 0; i < nb; ++i) {
+    Eigen::VectorXd v(dim);
+    for( unsigned int d = 0; d < dim; ++d) v(d) = unif( rnd );
+    inputs.push_back( v );
+  }
+  return inputs;
+}
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** Accuracy of reduced precision on a map with inputs of dimension 'dim' */
+void tt_report( unsigned int dim )
+{
+  Network net( dim, NB_NEUR, -2 );
+  net.set_winner_search( new Model::DSOM::BruteForceSearch() );
+  for( auto& s: make_inputs( dim, NB_LEARN, 1 ) ) {
+    net.forward( s );
+    net.deltaW( s, 0.05, 1.0 );
+  }
+  auto queries = make_inputs( dim, NB_QUERY, 2 );
+  std::vector<unsigned int> w_ref;
+  std::vector<double> d_ref;
+  double q_ref = 0.0;
+  for( auto& q: queries ) {
+    d_ref.push_back( net.computeWinner( q ));
+    w_ref.push_back( net.get_winner() );
+    q_ref += d_ref.back();
+  }
+
+  // JSON save / load
+  rj::Document doc;
+  std::stringstream json;
+  json << str_obj( net.serialize( doc ));
+  auto start = std::chrono::steady_clock::now();
+  Network net_json( json );
+  double t_json = elapsed( start );
+  std::cout << "  json   : size=" << json.str().size();
+  std::cout << " load=" << t_json << " ms" << std::endl;
+  std::cout << "  double : quantization=" << q_ref / NB_QUERY << std::endl;
+
+  for( Precision p: {Precision::DOUBLE, Precision::FLOAT, Precision::INT16} ) {
+    Network compact( net );
+    compact.set_winner_search( new Model::DSOM::CompactSearch( p ));
+    unsigned int same = 0;
+    double err_dist = 0.0, max_err_dist = 0.0, q = 0.0;
+    for( unsigned int i = 0; i < queries.size(); ++i) {
+      double d = compact.computeWinner( queries[i] );
+      if( compact.get_winner() == w_ref[i] ) ++same;
+      err_dist += fabs( d - d_ref[i] );
+      max_err_dist = std::max( max_err_dist, fabs( d - d_ref[i] ));
+      q += d;
+    }
+    // binary save / load
+    std::stringstream bin;
+    net.write_compact( bin, p );
+    start = std::chrono::steady_clock::now();
+    Network loaded( dim, NB_NEUR, -2 );
+    loaded.read_compact( bin );
+    double t_bin = elapsed( start );
+    bin.seekg( 0 );
+    auto cw = Network::read_compact_weights( bin );
+
+    std::cout << "  " << Model::DSOM::str_precision( p ) << " : same_winner=" << (double) same / NB_QUERY;
+    std::cout << " err_dist=" << err_dist / NB_QUERY << " (max " << max_err_dist << ")";
+    std::cout << " quantization=" << q / NB_QUERY << std::endl;
+    std::cout << "      size=" << bin.str().size() << " (" << cw.size() << " neurons)";
+    std::cout << " load=" << t_bin << " ms" << std::endl;
+  }
+}
+/** CompactWeights::read on corrupted binary data */
+void tt_invalid()
+{
+  Network net( 4, 100, -2 );
+  std::stringstream bin;
+  net.write_compact( bin, Precision::INT16 );
+  // CompactWeights starts after nb_link, size_grid and max_dist_input
+  const size_t start = 2 * sizeof(int32_t) + sizeof(double);
+  std::string data = bin.str().substr( start );
+
+  auto try_read = [] (const std::string& str) {
+    std::stringstream is( str );
+    Model::DSOM::CompactWeights cw;
+    return cw.read( is ) ? "read" : "refused";
+  };
+  std::cout << "  valid     : " << try_read( data ) << std::endl;
+  std::string bad_magic = data;
+  bad_magic[0] = 'X';
+  std::cout << "  bad magic : " << try_read( bad_magic ) << std::endl;
+  std::string bad_precision = data;
+  int32_t p = 7;
+  bad_precision.replace( sizeof(int32_t), sizeof(p), (const char*) &p, sizeof(p) );
+  std::cout << "  bad prec. : " << try_read( bad_precision ) << std::endl;
+  std::cout << "  header    : " << try_read( data.substr( 0, 10 )) << std::endl;
+  std::cout << "  truncated : " << try_read( data.substr( 0, data.size() - 1 )) << std::endl;
+}
+// ***************************************************************************
+int main(int argc, char *argv[])
+{
+  std::cout << "__DIM 2" << std::endl;
+  tt_report( 2 );
+  std::cout << "__DIM 16" << std::endl;
+  tt_report( 16 );
+  std::cout << "__INVALID" << std::endl;
+  tt_invalid();
+
+  return 0;
+}
@@ -6,6 +6,7 @@
  * Fenetre avec Courbe et Axe_X dynamiques.
  */
 
+#include <GL/glew.h>                 // before gl.h (Curve uses OpenGL 1.5)
 #include <GLFW/glfw3.h>
 #include <string>
 #include <stdlib.h>
@@ -0,0 +1,154 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste Algorithms::ValueIteration.
+ *  - small POMDP : compute_Q vs naive dense value iteration
+ *  - maze of 10^5 states : JACOBI (1 and 4 threads, both criteria),
+ *    GAUSS_SEIDEL, PRIORITIZED : iterations, backups, time and
+ *    difference of V
+ */
+
+#include <iostream>                  // std::cout
+#include <chrono>                    // std::chrono
+#include <random>                    // std::default_random_engine
+
+#include <pomdp/pomdp.hpp>
+#include <pomdp/prog_dynamique.hpp>
+
+using VI = Algorithms::ValueIteration;
+// ***************************************************************************
+#define MAZE_SIZE 316
+#define GAMMA     0.95
+#define EPSILON   1e-6
+
+/**
+ * Naive dense value iteration on Q (as the former compute_Q), until the
+ * sum of the squared changes of Q is below epsilon.
+ */
+Algorithms::TVal naive_Q( const Model::POMDP& pomdp, double gamma, double epsilon )
+{
+  unsigned int nb_s = pomdp._states.size();
+  unsigned int nb_a = pomdp._actions.size();
+  Algorithms::TVal vQ( nb_s, std::vector<double>( nb_a, 0.0 ));
+  double residual;
+  do {
+    residual = 0.0;
+    Algorithms::TVal new_vQ = vQ;
+    for( unsigned int s = 0; s < nb_s; ++s) {
+      for( unsigned int a = 0; a < nb_a; ++a) {
+        double newQ = 0.0;
+        for( unsigned int sp = 0; sp < nb_s; ++sp) {
+          newQ += pomdp._trans[s][a]._proba[sp] * *std::max_element( vQ[sp].begin(), vQ[sp].end() );
+        }
+        new_vQ[s][a] = pomdp._reward[s] + gamma * newQ;
+        residual += (new_vQ[s][a] - vQ[s][a]) * (new_vQ[s][a] - vQ[s][a]);
+      }
+    }
+    vQ = new_vQ;
+  } while( residual > epsilon );
+  return vQ;
+}
+/**
+ * Maze of size x size cells, 20% of walls, goal (reward 1) in the last
+ * cell, other cells give 'step_reward'.
+ * 4 actions : intended move with proba 0.8, each side with 0.1,
+ * moves into walls or outside stay in place.
+ */
+Algorithms::SparseMDP make_maze( unsigned int size, double step_reward )
+{
+  std::default_random_engine rnd( 1 );
+  std::bernoulli_distribution wall( 0.2 );
+  std::vector<bool> is_wall( size*size );
+  for( unsigned int c = 0; c < size*size; ++c) is_wall[c] = wall( rnd );
+  is_wall[0] = false;
+  is_wall[size*size-1] = false;
+
+  Algorithms::SparseMDP mdp( size*size, 4 );
+  const int dx[] = {0, 1, 0, -1};
+  const int dy[] = {-1, 0, 1, 0};
+  for( unsigned int c = 0; c < size*size; ++c) {
+    int x = c % size, y = c / size;
+    mdp.set_reward( c, (c == size*size-1) ? 1.0 : step_reward );
+    for( unsigned int a = 0; a < 4; ++a) {
+      std::vector<std::pair<unsigned int, double>> next;
+      const unsigned int dirs[] = { a, (a+1) % 4, (a+3) % 4 };
+      const double proba[] = { 0.8, 0.1, 0.1 };
+      for( unsigned int k = 0; k < 3; ++k) {
+        int nx = x + dx[dirs[k]], ny = y + dy[dirs[k]];
+        unsigned int nc = c;
+        if( nx >= 0 and nx < (int) size and ny >= 0 and ny < (int) size
+            and not is_wall[ny*size+nx] ) {
+          nc = ny*size+nx;
+        }
+        next.push_back( std::make_pair( nc, proba[k] ));
+      }
+      // goal is absorbing
+      if( c == size*size-1 ) next = { std::make_pair( c, 1.0 ) };
+      mdp.push_row( c, a, next );
+    }
+  }
+  return mdp;
+}
+/** Solve the maze with every method, V of JACOBI as reference */
+void tt_maze( double step_reward )
+{
+  std::cout << "__MAZE " << MAZE_SIZE << "x" << MAZE_SIZE;
+  std::cout << " step_reward=" << step_reward << std::endl;
+  auto mdp = make_maze( MAZE_SIZE, step_reward );
+  std::cout << "  " << mdp.nb_states() << " states, " << mdp.nb_transitions() << " transitions" << std::endl;
+
+  struct Run { std::string name; VI::Method method; unsigned int nb_thread;
+               VI::Criterion criterion; };
+  std::vector<Run> runs = { {"jacobi", VI::Method::JACOBI, 1, VI::Criterion::MAX_NORM},
+                            {"jacobi x4", VI::Method::JACOBI, 4, VI::Criterion::MAX_NORM},
+                            {"jacobi squared_Q", VI::Method::JACOBI, 1, VI::Criterion::SQUARED_Q},
+                            {"gauss_seidel", VI::Method::GAUSS_SEIDEL, 1, VI::Criterion::MAX_NORM},
+                            {"prioritized", VI::Method::PRIORITIZED, 1, VI::Criterion::MAX_NORM} };
+  std::vector<double> v_ref;
+  for( auto& run: runs ) {
+    VI vi( mdp, GAMMA, run.method, run.nb_thread );
+    vi.set_criterion( run.criterion );
+    auto start = std::chrono::steady_clock::now();
+    bool ok = vi.solve( EPSILON );
+    auto end = std::chrono::steady_clock::now();
+    if( v_ref.empty() ) v_ref = vi.get_V();
+    double diff_v = 0.0;
+    for( unsigned int s = 0; s < v_ref.size(); ++s) {
+      diff_v = std::max( diff_v, fabs( vi.get_V()[s] - v_ref[s] ));
+    }
+    std::cout << "  " << run.name << " : converged=" << ok;
+    std::cout << " ite=" << vi.get_nb_ite() << " backups=" << vi.get_nb_backup();
+    std::cout << " residual=" << vi.get_residual();
+    std::cout << " diff_V=" << diff_v;
+    std::cout << " (" << std::chrono::duration<double, std::milli>(end - start).count() << " ms)" << std::endl;
+  }
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  std::cout << "__SMALL POMDP" << std::endl;
+  Model::POMDP pomdp = {{{0, "zero"}, {1, "un"}},
+			{{0, "0"}},
+			{{0, "Up"}, {1, "Right"}, {2, "Down"}},
+			{{ {{0.1, 0.9}}, {{0.5, 0.5}}, {{1.0, 0.0}}},
+			 { {{0.9, 0.1}}, {{1.0, 0.0}}, {{0.3, 0.7}} }
+			},
+			{ {{1.0}}, {{1.0}} },
+			{{-1, 10.0}}
+  };
+  auto vQ = Algorithms::compute_Q( pomdp, 0.9, EPSILON );
+  auto vQ_ref = naive_Q( pomdp, 0.9, EPSILON );
+  double diff = 0.0;
+  for( auto& s: pomdp._states) {
+    for( auto& a: pomdp._actions ) {
+      std::cout << "  Q["<< s._id << ", " << a._id << "]=" << vQ[s._id][a._id] << std::endl;
+      diff = std::max( diff, fabs( vQ[s._id][a._id] - vQ_ref[s._id][a._id] ));
+    }
+  }
+  std::cout << "  max diff with naive=" << diff << std::endl;
+
+  tt_maze( -0.01 );
+  tt_maze( 0.0 );
+
+  return 0;
+}
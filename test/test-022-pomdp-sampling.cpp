@@ -0,0 +1,115 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste les tables de tirage de Model::Transition.
+ *  - CDF (petite ligne) et alias (grande ligne) : fréquences vs _proba
+ *  - simulation sur un POMDP de NB_STATES états : get_next vs sample
+ */
+
+#include <iostream>                  // std::cout
+#include <chrono>                    // std::chrono
+#include <cmath>                     // fabs
+
+#include <pomdp/pomdp.hpp>
+
+// ***************************************************************************
+#define NB_DRAW   1000000
+#define NB_STATES 2000
+#define NB_STEP   200000
+
+/** Max écart entre fréquences de sample() et _proba */
+double max_freq_error( Model::Transition& tr, gsl_rng* rnd )
+{
+  std::vector<double> freq( tr._proba.size(), 0.0 );
+  for( unsigned int i = 0; i < NB_DRAW; ++i) {
+    freq[tr.sample( gsl_rng_uniform_pos( rnd ))] += 1.0 / NB_DRAW;
+  }
+  double err = 0.0;
+  for( unsigned int i = 0; i < freq.size(); ++i) {
+    err = std::max( err, fabs( freq[i] - tr._proba[i] ));
+  }
+  return err;
+}
+/** POMDP aléatoire, chaque ligne a 'nb_next' successeurs */
+Model::POMDP make_pomdp( unsigned int nb_next, gsl_rng* rnd )
+{
+  std::vector<Model::Node> states, obs;
+  for( unsigned int s = 0; s < NB_STATES; ++s) {
+    states.push_back( {s, std::to_string(s)} );
+  }
+  obs.push_back( {0, "0"} );
+  std::vector<std::vector<Model::Transition>> trans;
+  std::vector<Model::Transition> percep;
+  for( unsigned int s = 0; s < NB_STATES; ++s) {
+    Model::Transition tr( std::vector<double>( NB_STATES, 0.0 ));
+    for( unsigned int k = 0; k < nb_next; ++k) {
+      tr._proba[gsl_rng_uniform_int( rnd, NB_STATES )] += 1.0 / nb_next;
+    }
+    trans.push_back( {tr} );
+    percep.push_back( Model::Transition( {1.0} ));
+  }
+  return Model::POMDP( states, obs, {{0, "go"}}, trans, percep,
+                       std::vector<double>( NB_STATES, 0.0 ));
+}
+/** Temps (ms) de NB_STEP pas avec get_next (dense) ou sample */
+double time_simul( Model::POMDP& pomdp, bool dense, gsl_rng* rnd )
+{
+  auto start = std::chrono::steady_clock::now();
+  unsigned int s = 0, check = 0;
+  for( unsigned int i = 0; i < NB_STEP; ++i) {
+    double p = gsl_rng_uniform_pos( rnd );
+    if( dense ) s = pomdp._trans[s][0].get_next( p );
+    else s = pomdp._trans[s][0].sample( p );
+    check += s;
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::cout << "    (check=" << check % 1000 << ")";
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  gsl_rng* rnd = gsl_rng_alloc( gsl_rng_taus );
+  gsl_rng_set( rnd, 1 );
+
+  std::cout << "__FREQUENCIES" << std::endl;
+  Model::Transition small = {{0.1, 0.0, 0.3, 0.6}};
+  small.build_sampler();
+  std::cout << "  cdf   nnz=" << small.nb_nonzero();
+  std::cout << " err=" << max_freq_error( small, rnd ) << std::endl;
+
+  Model::Transition large( std::vector<double>( 100, 0.0 ));
+  double sum = 0.0;
+  for( unsigned int i = 0; i < 100; i += 2) {
+    large._proba[i] = (double) (i+1);
+    sum += i+1;
+  }
+  for( auto& p: large._proba ) p /= sum;
+  large.build_sampler();
+  std::cout << "  alias nnz=" << large.nb_nonzero();
+  std::cout << " err=" << max_freq_error( large, rnd ) << std::endl;
+
+  std::cout << "__SIMULATION " << NB_STATES << " states, " << NB_STEP << " steps" << std::endl;
+  for( unsigned int nb_next: {4, 64} ) {
+    Model::POMDP pomdp = make_pomdp( nb_next, rnd );
+    gsl_rng_set( rnd, 2 );
+    double t_dense = time_simul( pomdp, true, rnd );
+    gsl_rng_set( rnd, 2 );
+    double t_sample = time_simul( pomdp, false, rnd );
+    std::cout << std::endl << "  nb_next=" << nb_next;
+    std::cout << " get_next=" << t_dense << " ms sample=" << t_sample << " ms" << std::endl;
+  }
+
+  // Copie : générateur propre, même suite de tirages
+  Model::POMDP pomdp = make_pomdp( 4, rnd );
+  pomdp.set_seed( 3 );
+  Model::POMDP copy( pomdp );
+  unsigned int nb_same = 0;
+  for( unsigned int i = 0; i < 100; ++i) {
+    if( pomdp.simul_trans( {0, "go"} )._id == copy.simul_trans( {0, "go"} )._id ) ++nb_same;
+  }
+  std::cout << "__COPY same trajectory=" << nb_same << "/100" << std::endl;
+
+  gsl_rng_free( rnd );
+  return 0;
+}
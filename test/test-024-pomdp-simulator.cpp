@@ -0,0 +1,121 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste Model::BatchSimulator.
+ *  - même trajectoires avec 1 ou 4 threads, épisodes différents entre eux
+ *  - fréquence des transitions simulées vs _trans
+ *  - write puis Trajectory::POMDP::read
+ *  - temps vs simulation en série avec POMDP::simul_trans
+ */
+
+#include <iostream>                  // std::cout
+#include <sstream>                   // std::stringstream
+#include <chrono>                    // std::chrono
+#include <cmath>                     // fabs
+
+#include <pomdp/pomdp.hpp>
+#include <pomdp/simulator.hpp>
+
+using Traj = Trajectory::POMDP;
+// ***************************************************************************
+#define NB_EPISODE 256
+#define LENGTH     2000
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+bool same( const Traj::Item& i1, const Traj::Item& i2 )
+{
+  return i1.id_s == i2.id_s and i1.id_o == i2.id_o and i1.id_a == i2.id_a
+    and i1.id_next_s == i2.id_next_s and i1.id_next_o == i2.id_next_o
+    and i1.r == i2.r;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  Model::POMDP pomdp = {{{0, "zero"}, {1, "un"}, {2, "deux"}},
+			{{0, "A"}, {1, "B"}},
+			{{0, "Up"}, {1, "Down"}},
+			{{ {{0.1, 0.9, 0.0}}, {{0.5, 0.0, 0.5}} },
+			 { {{0.0, 0.2, 0.8}}, {{1.0, 0.0, 0.0}} },
+			 { {{0.3, 0.3, 0.4}}, {{0.0, 0.6, 0.4}} }
+			},
+			{ {{1.0, 0.0}}, {{0.5, 0.5}}, {{0.0, 1.0}} },
+			{{-1, 0.0, 10.0}}
+  };
+
+  std::cout << "__THREADS" << std::endl;
+  Model::BatchSimulator simul( pomdp, 42 );
+  Traj::Data d1, d4;
+  auto start = std::chrono::steady_clock::now();
+  simul.run( NB_EPISODE, LENGTH, 0, d1, 1 );
+  double t1 = elapsed( start );
+  start = std::chrono::steady_clock::now();
+  simul.run( NB_EPISODE, LENGTH, 0, d4, 4 );
+  double t4 = elapsed( start );
+  unsigned int nb_diff = 0;
+  for( unsigned int i = 0; i < d1.size(); ++i) {
+    if( not same( d1[i], d4[i] )) ++nb_diff;
+  }
+  unsigned int nb_same_ep = 0;
+  for( unsigned int t = 0; t < LENGTH; ++t) {
+    if( same( d1[t], d1[LENGTH+t] )) ++nb_same_ep;
+  }
+  std::cout << "  size=" << d1.size() << " diff 1/4 threads=" << nb_diff << std::endl;
+  std::cout << "  ep0 == ep1 on " << nb_same_ep << "/" << LENGTH << " steps" << std::endl;
+  std::cout << "  1 thread=" << t1 << " ms, 4 threads=" << t4 << " ms" << std::endl;
+
+  std::cout << "__FREQUENCIES" << std::endl;
+  std::vector<std::vector<std::vector<double>>> count( 3, std::vector<std::vector<double>>( 2, std::vector<double>( 3, 0.0 )));
+  for( auto& item: d1 ) {
+    count[item.id_s][item.id_a][item.id_next_s] += 1.0;
+  }
+  double err = 0.0;
+  for( unsigned int s = 0; s < 3; ++s) {
+    for( unsigned int a = 0; a < 2; ++a) {
+      double nb = count[s][a][0] + count[s][a][1] + count[s][a][2];
+      for( unsigned int sp = 0; sp < 3; ++sp) {
+        err = std::max( err, fabs( count[s][a][sp] / nb - pomdp._trans[s][a]._proba[sp] ));
+      }
+    }
+  }
+  std::cout << "  max err T=" << err << std::endl;
+
+  std::cout << "__WRITE/READ" << std::endl;
+  std::stringstream ss;
+  Model::BatchSimulator::write( ss, d1, LENGTH );
+  Traj::Data read;
+  Traj::read( ss, read );
+  nb_diff = 0;
+  for( unsigned int i = 0; i < d1.size(); ++i) {
+    if( not same( d1[i], read[i] )) ++nb_diff;
+  }
+  std::cout << "  read=" << read.size() << " diff=" << nb_diff << std::endl;
+
+  std::cout << "__SERIAL simul_trans" << std::endl;
+  const std::vector<Model::Node>& list_action = pomdp.actions();
+  gsl_rng* rnd = gsl_rng_alloc( gsl_rng_taus );
+  gsl_rng_set( rnd, 1 );
+  pomdp.set_seed( 1 );
+  Traj::Data serial;
+  start = std::chrono::steady_clock::now();
+  for( unsigned int k = 0; k < NB_EPISODE; ++k) {
+    pomdp.set_current_state( 0 );
+    unsigned int idx_state = 0;
+    unsigned int idx_obs = pomdp.simul_obs()._id;
+    for( unsigned int t = 0; t < LENGTH; ++t) {
+      const Model::Node& act = list_action[gsl_rng_uniform_int( rnd, list_action.size() )];
+      unsigned int idx_next_state = pomdp.simul_trans( act )._id;
+      unsigned int idx_next_obs = pomdp.simul_obs()._id;
+      serial.push_back( {idx_state, idx_obs, act._id, idx_next_state, idx_next_obs, pomdp.cur_reward()} );
+      idx_state = idx_next_state;
+      idx_obs = idx_next_obs;
+    }
+  }
+  std::cout << "  " << serial.size() << " items in " << elapsed( start ) << " ms" << std::endl;
+  gsl_rng_free( rnd );
+
+  return 0;
+}
@@ -0,0 +1,134 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste Algorithms::BeliefFilter.
+ *  - POMDP aléatoire, trajectoires de Model::BatchSimulator
+ *  - croyances vs mise à jour dense naïve
+ *  - filter_batch avec 1 ou 4 threads
+ *  - entropie croisée du prédicteur optimal vs fréquences des observations
+ */
+
+#include <iostream>                  // std::cout
+#include <chrono>                    // std::chrono
+#include <cmath>                     // fabs, log
+
+#include <pomdp/pomdp.hpp>
+#include <pomdp/simulator.hpp>
+#include <pomdp/belief.hpp>
+
+// ***************************************************************************
+#define NB_STATES  200
+#define NB_ACTIONS 4
+#define NB_OBS     8
+#define NB_NEXT    3
+#define NB_EPISODE 64
+#define LENGTH     1000
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** NB_NEXT successeurs par (s,a), observation bruitée de s % NB_OBS */
+Model::POMDP make_pomdp()
+{
+  Model::RandomStream rnd( 1, 0 );
+  std::vector<Model::Node> states, obs, actions;
+  for( unsigned int s = 0; s < NB_STATES; ++s) states.push_back( {s, std::to_string(s)} );
+  for( unsigned int o = 0; o < NB_OBS; ++o) obs.push_back( {o, std::to_string(o)} );
+  for( unsigned int a = 0; a < NB_ACTIONS; ++a) actions.push_back( {a, std::to_string(a)} );
+  std::vector<std::vector<Model::Transition>> trans;
+  std::vector<Model::Transition> percep;
+  for( unsigned int s = 0; s < NB_STATES; ++s) {
+    std::vector<Model::Transition> trans_s;
+    for( unsigned int a = 0; a < NB_ACTIONS; ++a) {
+      Model::Transition tr( std::vector<double>( NB_STATES, 0.0 ));
+      for( unsigned int k = 0; k < NB_NEXT; ++k) {
+        tr._proba[rnd.uniform_int( NB_STATES )] += 1.0 / NB_NEXT;
+      }
+      trans_s.push_back( tr );
+    }
+    trans.push_back( trans_s );
+    Model::Transition per( std::vector<double>( NB_OBS, 0.1 / (NB_OBS-1) ));
+    per._proba[s % NB_OBS] = 0.9;
+    percep.push_back( per );
+  }
+  return Model::POMDP( states, obs, actions, trans, percep,
+                       std::vector<double>( NB_STATES, 0.0 ));
+}
+/** Mise à jour dense naïve */
+std::vector<double> naive_update( const Model::POMDP& pomdp,
+                                  const std::vector<double>& b,
+                                  unsigned int a, unsigned int o )
+{
+  std::vector<double> next( NB_STATES, 0.0 );
+  double norm = 0.0;
+  for( unsigned int sp = 0; sp < NB_STATES; ++sp) {
+    for( unsigned int s = 0; s < NB_STATES; ++s) {
+      next[sp] += pomdp._trans[s][a]._proba[sp] * b[s];
+    }
+    next[sp] *= pomdp._percep[sp]._proba[o];
+    norm += next[sp];
+  }
+  for( auto& v: next ) v /= norm;
+  return next;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  Model::POMDP pomdp = make_pomdp();
+  Model::BatchSimulator simul( pomdp, 7 );
+  Trajectory::POMDP::Data data;
+  simul.run( NB_EPISODE, LENGTH, 0, data, 1 );
+
+  Algorithms::BeliefModel model( pomdp );
+  std::vector<double> prior( NB_STATES, 0.0 );
+  prior[0] = 1.0;
+
+  std::cout << "__NAIVE" << std::endl;
+  Algorithms::BeliefFilter filter( model );
+  filter.reset( prior, data[0].id_o );
+  std::vector<double> b_ref = filter.belief();
+  double err = 0.0;
+  for( unsigned int t = 0; t < LENGTH; ++t) {
+    filter.update( data[t].id_a, data[t].id_next_o );
+    b_ref = naive_update( pomdp, b_ref, data[t].id_a, data[t].id_next_o );
+    for( unsigned int s = 0; s < NB_STATES; ++s) {
+      err = std::max( err, fabs( filter.belief()[s] - b_ref[s] ));
+    }
+  }
+  std::cout << "  max err on " << LENGTH << " steps=" << err << std::endl;
+
+  std::cout << "__BATCH " << NB_EPISODE << "x" << LENGTH << std::endl;
+  std::vector<double> beliefs1, beliefs4;
+  auto start = std::chrono::steady_clock::now();
+  auto nll1 = Algorithms::filter_batch( model, data, LENGTH, prior, 1, &beliefs1 );
+  double t1 = elapsed( start );
+  start = std::chrono::steady_clock::now();
+  auto nll4 = Algorithms::filter_batch( model, data, LENGTH, prior, 4, &beliefs4 );
+  double t4 = elapsed( start );
+  unsigned int nb_diff = 0;
+  for( unsigned int i = 0; i < beliefs1.size(); ++i) {
+    if( beliefs1[i] != beliefs4[i] ) ++nb_diff;
+  }
+  for( unsigned int k = 0; k < nll1.size(); ++k) {
+    if( nll1[k] != nll4[k] ) ++nb_diff;
+  }
+  std::cout << "  diff 1/4 threads=" << nb_diff << std::endl;
+  std::cout << "  1 thread=" << t1 << " ms, 4 threads=" << t4 << " ms" << std::endl;
+  start = std::chrono::steady_clock::now();
+  Algorithms::filter_batch( model, data, LENGTH, prior, 1 );
+  std::cout << "  without beliefs=" << elapsed( start ) << " ms" << std::endl;
+
+  std::cout << "__CROSS-ENTROPY (nats/step)" << std::endl;
+  double sum_nll = 0.0;
+  for( auto& v: nll1 ) sum_nll += v;
+  std::vector<double> freq( NB_OBS, 0.0 );
+  for( auto& item: data ) freq[item.id_next_o] += 1.0 / data.size();
+  double h_freq = 0.0;
+  for( auto& f: freq ) if( f > 0.0 ) h_freq -= f * log( f );
+  std::cout << "  optimal=" << sum_nll / data.size();
+  std::cout << " marginal=" << h_freq << std::endl;
+
+  return 0;
+}
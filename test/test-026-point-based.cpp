@@ -0,0 +1,126 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste Algorithms::PointBasedSolver sur un POMDP aléatoire.
+ *  - PBVI et PERSEUS : itérations, backups, alpha-vecteurs, temps
+ *  - valeur du prior (borne inférieure) vs retour simulé de la politique
+ *  - même solution avec 1 ou 4 threads
+ *  - retour de la politique QMDP (compute_Q)
+ */
+
+#include <iostream>                  // std::cout
+#include <chrono>                    // std::chrono
+#include <cmath>                     // log
+
+#include <pomdp/pomdp.hpp>
+#include <pomdp/prog_dynamique.hpp>
+#include <pomdp/point_based.hpp>
+
+using Solver = Algorithms::PointBasedSolver;
+// ***************************************************************************
+#define NB_STATES  50
+#define NB_ACTIONS 4
+#define NB_OBS     6
+#define NB_NEXT    2
+#define NB_BELIEF  200
+#define GAMMA      0.95
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** NB_NEXT successeurs par (s,a), observation bruitée, récompense en 3 états */
+Model::POMDP make_pomdp()
+{
+  Model::RandomStream rnd( 3, 0 );
+  std::vector<Model::Node> states, obs, actions;
+  for( unsigned int s = 0; s < NB_STATES; ++s) states.push_back( {s, std::to_string(s)} );
+  for( unsigned int o = 0; o < NB_OBS; ++o) obs.push_back( {o, std::to_string(o)} );
+  for( unsigned int a = 0; a < NB_ACTIONS; ++a) actions.push_back( {a, std::to_string(a)} );
+  std::vector<std::vector<Model::Transition>> trans;
+  std::vector<Model::Transition> percep;
+  std::vector<double> reward( NB_STATES, -1.0 );
+  for( unsigned int s = 0; s < NB_STATES; ++s) {
+    std::vector<Model::Transition> trans_s;
+    for( unsigned int a = 0; a < NB_ACTIONS; ++a) {
+      Model::Transition tr( std::vector<double>( NB_STATES, 0.0 ));
+      for( unsigned int k = 0; k < NB_NEXT; ++k) {
+        tr._proba[rnd.uniform_int( NB_STATES )] += 1.0 / NB_NEXT;
+      }
+      trans_s.push_back( tr );
+    }
+    trans.push_back( trans_s );
+    Model::Transition per( std::vector<double>( NB_OBS, 0.2 / (NB_OBS-1) ));
+    per._proba[s % NB_OBS] = 0.8;
+    percep.push_back( per );
+  }
+  reward[7] = reward[23] = reward[41] = 10.0;
+  return Model::POMDP( states, obs, actions, trans, percep, reward );
+}
+/** sum_o P(o|prior) V(prior|o) */
+double prior_value( const Solver& solver, const Solver::Belief& prior )
+{
+  Algorithms::BeliefFilter filter( solver.get_model() );
+  double v = 0.0;
+  for( unsigned int o = 0; o < NB_OBS; ++o) {
+    double p = filter.reset( prior, o );
+    if( p > 0.0 ) v += p * solver.value( filter.belief() );
+  }
+  return v;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  Model::POMDP pomdp = make_pomdp();
+  Solver::Belief prior( NB_STATES, 1.0 / NB_STATES );
+  unsigned int length = (unsigned int) (log( 1e-3 ) / log( GAMMA )) + 1;
+
+  std::vector<std::vector<double>> alphas;
+  for( auto method: {Solver::Method::PBVI, Solver::Method::PERSEUS} ) {
+    for( unsigned int nb_thread: {1, 4} ) {
+      Solver solver( pomdp, GAMMA, method, nb_thread );
+      solver.collect_beliefs( prior, NB_BELIEF, 1 );
+      auto start = std::chrono::steady_clock::now();
+      solver.solve( 1000, 1e-4, 2 );
+      double t = elapsed( start );
+      std::cout << (method == Solver::Method::PBVI ? "__PBVI" : "__PERSEUS");
+      std::cout << " x" << nb_thread << std::endl;
+      std::cout << "  beliefs=" << solver.get_beliefs().size();
+      std::cout << " ite=" << solver.get_nb_ite() << " backups=" << solver.get_nb_backup();
+      std::cout << " alpha=" << solver.get_alphas().size();
+      std::cout << " residual=" << solver.get_residual();
+      std::cout << " (" << t << " ms)" << std::endl;
+      std::cout << "  V(prior)=" << prior_value( solver, prior );
+      std::cout << " return=" << solver.evaluate( prior, 2000, length, 5 ) << std::endl;
+
+      // même solution quel que soit le nombre de threads
+      std::vector<double> flat;
+      for( auto& alpha: solver.get_alphas() ) {
+        flat.insert( flat.end(), alpha.v.begin(), alpha.v.end() );
+      }
+      if( nb_thread == 1 ) alphas.push_back( flat );
+      else std::cout << "  same as x1=" << (flat == alphas.back()) << std::endl;
+    }
+  }
+
+  std::cout << "__QMDP" << std::endl;
+  Algorithms::TVal vQ = Algorithms::compute_Q( pomdp, GAMMA, 1e-6 );
+  Solver solver( pomdp, GAMMA );
+  auto qmdp = [&vQ] (const Solver::Belief& b) {
+    unsigned int best = 0;
+    double best_q = std::numeric_limits<double>::lowest();
+    for( unsigned int a = 0; a < NB_ACTIONS; ++a) {
+      double q = 0.0;
+      for( unsigned int s = 0; s < NB_STATES; ++s) q += b[s] * vQ[s][a];
+      if( q > best_q ) {
+        best_q = q;
+        best = a;
+      }
+    }
+    return best;
+  };
+  std::cout << "  return=" << solver.evaluate( prior, 2000, length, 5, qmdp ) << std::endl;
+
+  return 0;
+}
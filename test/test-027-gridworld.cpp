@@ -0,0 +1,132 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste Model::make_gridworld et Model::make_maze.
+ *  - petite carte : transitions, observations, récompenses
+ *  - carte sans case libre : std::runtime_error
+ *  - labyrinthe d'environ 10^5 états : temps de génération, taille du
+ *    JSON creux (vs dense), relecture, ValueIteration et simulation
+ */
+
+#include <iostream>                  // std::cout
+#include <sstream>                   // std::stringstream
+#include <chrono>                    // std::chrono
+#include <cmath>                     // fabs
+
+#include <pomdp/pomdp.hpp>
+#include <pomdp/gridworld.hpp>
+#include <pomdp/prog_dynamique.hpp>
+#include <pomdp/simulator.hpp>
+#include <utils.hpp>                 // utils::rj::str_obj
+
+// ***************************************************************************
+#define MAZE_W 224
+#define MAZE_H 224
+#define PROBA  0.8
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** Sum of probas of all T(s,a,.) and O(.|s) (should all be 1) */
+double max_err_sum( const Model::POMDP& pomdp )
+{
+  double err = 0.0;
+  auto check = [&err] (const Model::Transition& tr) {
+    double sum = 0.0;
+    tr.for_each( [&sum] (unsigned int i, double p) { sum += p; } );
+    err = std::max( err, fabs( sum - 1.0 ));
+  };
+  for( unsigned int s = 0; s < pomdp._states.size(); ++s) {
+    for( auto& tr: pomdp._trans[s] ) check( tr );
+    check( pomdp._percep[s] );
+  }
+  return err;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  std::cout << "__SMALL MAP" << std::endl;
+  std::stringstream map_str;
+  map_str << "#####" << std::endl;
+  map_str << "#  G#" << std::endl;
+  map_str << "# ###" << std::endl;
+  map_str << "#####" << std::endl;
+  Model::GridMap map = Model::read_map( map_str );
+  Model::POMDP small = Model::make_gridworld( map, PROBA );
+  std::cout << small.str_dump() << std::endl;
+  // état 0 = (1,1) : Ri va en (2,1) avec 0.8, Up et Le restent (2 x 0.2/3)
+  std::cout << "  T(1,1; Ri)=" << small._trans[0][1].str_dump() << std::endl;
+  std::cout << "  P(2,1)=" << small._trans[0][1].proba( 1 );
+  std::cout << " P(1,1)=" << small._trans[0][1].proba( 0 );
+  std::cout << " P(3,1)=" << small._trans[0][1].proba( 2 ) << std::endl;
+  std::cout << "  max err sum=" << max_err_sum( small ) << std::endl;
+
+  std::cout << "__NO FREE CELL" << std::endl;
+  try {
+    Model::make_gridworld( {"###", "###"}, PROBA );
+    std::cout << "  no error !!" << std::endl;
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "  error : " << e.what() << std::endl;
+  }
+
+  std::cout << "__MAZE " << MAZE_W << "x" << MAZE_H << std::endl;
+  auto start = std::chrono::steady_clock::now();
+  Model::GridMap maze = Model::make_maze( MAZE_W, MAZE_H, 1 );
+  Model::POMDP pomdp = Model::make_gridworld( maze, PROBA );
+  unsigned int nb_s = pomdp._states.size();
+  unsigned long nnz = 0;
+  for( auto& tr_s: pomdp._trans ) {
+    for( auto& tr: tr_s ) nnz += tr.nb_nonzero();
+  }
+  std::cout << "  states=" << nb_s << " nnz(T)=" << nnz;
+  std::cout << " (" << elapsed( start ) << " ms)" << std::endl;
+  std::cout << "  max err sum=" << max_err_sum( pomdp ) << std::endl;
+
+  std::cout << "__JSON" << std::endl;
+  start = std::chrono::steady_clock::now();
+  rapidjson::Document doc;
+  doc.SetObject();
+  doc.AddMember( "pomdp", pomdp.serialize( doc ), doc.GetAllocator() );
+  std::string json = utils::rj::str_obj( doc );
+  std::cout << "  sparse=" << json.size() / 1000000.0 << " MB";
+  // dense : au moins 2 caractères ("0,") par proba
+  std::cout << " dense>=" << 2.0 * nb_s * nb_s * 5 / 1000000.0 << " MB";
+  std::cout << " (" << elapsed( start ) << " ms)" << std::endl;
+  start = std::chrono::steady_clock::now();
+  rapidjson::Document read_doc;
+  read_doc.Parse( json.c_str() );
+  Model::POMDP read( read_doc["pomdp"] );
+  read.build_samplers();
+  unsigned int nb_diff = 0;
+  for( unsigned int s = 0; s < nb_s; ++s) {
+    for( unsigned int a = 0; a < 4; ++a) {
+      pomdp._trans[s][a].for_each( [&] (unsigned int sp, double p) {
+        if( read._trans[s][a].proba( sp ) != p ) ++nb_diff;
+      });
+      if( read._trans[s][a].nb_nonzero() != pomdp._trans[s][a].nb_nonzero() ) ++nb_diff;
+    }
+  }
+  std::cout << "  read states=" << read._states.size() << " diff=" << nb_diff;
+  std::cout << " (" << elapsed( start ) << " ms)" << std::endl;
+
+  std::cout << "__SOLVE" << std::endl;
+  start = std::chrono::steady_clock::now();
+  Algorithms::SparseMDP mdp( pomdp );
+  Algorithms::ValueIteration vi( mdp, 0.95 );
+  vi.solve( 1e-6 );
+  std::cout << "  backups=" << vi.get_nb_backup() << " V(start)=" << vi.get_V()[0];
+  std::cout << " V(goal)=" << vi.get_V()[nb_s-1];
+  std::cout << " (" << elapsed( start ) << " ms)" << std::endl;
+
+  std::cout << "__SIMULATION" << std::endl;
+  start = std::chrono::steady_clock::now();
+  Model::BatchSimulator simul( pomdp, 3 );
+  Trajectory::POMDP::Data data;
+  simul.run( 16, 10000, 0, data, 1 );
+  std::cout << "  " << data.size() << " items in " << elapsed( start ) << " ms" << std::endl;
+
+  return 0;
+}
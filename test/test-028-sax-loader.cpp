@@ -0,0 +1,149 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste la lecture en flux (JSON::parse + SaxHandler) vs DOM.
+ *  - POMDP (labyrinthe d'environ 10^5 états, sous la clé "pomdp") :
+ *    même modèle, temps, pic mémoire (VmHWM, Linux)
+ *  - Reservoir et RNetwork : mêmes poids qu'avec unserialize
+ *  - JSON invalide, tableau de Reservoir tronqué : std::runtime_error
+ */
+
+#include <iostream>                  // std::cout
+#include <fstream>                   // std::ifstream
+#include <sstream>                   // std::stringstream
+#include <chrono>                    // std::chrono
+#include <stdexcept>                 // std::runtime_error
+
+#include <pomdp/pomdp.hpp>
+#include <pomdp/gridworld.hpp>
+#include <reservoir.hpp>
+#include <dsom/r_network.hpp>
+#include <utils.hpp>                 // utils::rj::str_obj
+
+// ***************************************************************************
+#define MAZE_SIZE 224
+#define FILENAME  "test-028.json"
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** Pic mémoire depuis le dernier reset_peak (kB, -1 si pas /proc) */
+long peak_kb()
+{
+  std::ifstream status( "/proc/self/status" );
+  std::string line;
+  while( std::getline( status, line )) {
+    if( line.compare( 0, 6, "VmHWM:" ) == 0 ) return std::stol( line.substr( 6 ));
+  }
+  return -1;
+}
+void reset_peak()
+{
+  std::ofstream( "/proc/self/clear_refs" ) << "5";
+}
+unsigned int nb_diff( const Model::POMDP& p1, const Model::POMDP& p2 )
+{
+  unsigned int nb = 0;
+  if( p1._states.size() != p2._states.size() ) return 1;
+  for( unsigned int s = 0; s < p1._states.size(); ++s) {
+    if( p1._states[s]._label != p2._states[s]._label ) ++nb;
+    if( p1._reward[s] != p2._reward[s] ) ++nb;
+    if( p1._percep[s].nb_nonzero() != p2._percep[s].nb_nonzero() ) ++nb;
+    for( unsigned int a = 0; a < p1._actions.size(); ++a) {
+      if( p1._trans[s][a].nb_nonzero() != p2._trans[s][a].nb_nonzero() ) ++nb;
+      p1._trans[s][a].for_each( [&] (unsigned int sp, double p) {
+        if( p2._trans[s][a].proba( sp ) != p ) ++nb;
+      });
+    }
+  }
+  return nb;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  std::cout << "__POMDP " << MAZE_SIZE << "x" << MAZE_SIZE << std::endl;
+  {
+    Model::POMDP pomdp = Model::make_gridworld( Model::make_maze( MAZE_SIZE, MAZE_SIZE, 1 ), 0.8 );
+    rapidjson::Document doc;
+    doc.SetObject();
+    doc.AddMember( "pomdp", pomdp.serialize( doc ), doc.GetAllocator() );
+    std::ofstream ofile( FILENAME );
+    ofile << utils::rj::str_obj( doc ) << std::endl;
+  }
+  {
+    reset_peak();
+    long base = peak_kb();
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream ifile( FILENAME );
+    Model::POMDP sax( ifile, "pomdp" );
+    std::cout << "  SAX states=" << sax._states.size();
+    std::cout << " peak=+" << (peak_kb() - base) / 1024 << " MB";
+    std::cout << " (" << elapsed( start ) << " ms)" << std::endl;
+
+    reset_peak();
+    base = peak_kb();
+    start = std::chrono::steady_clock::now();
+    std::ifstream ifile_dom( FILENAME );
+    JSON::IStreamWrapper instream( ifile_dom );
+    rapidjson::Document read_doc;
+    read_doc.ParseStream( instream );
+    Model::POMDP dom( read_doc["pomdp"] );
+    std::cout << "  DOM states=" << dom._states.size();
+    std::cout << " peak=+" << (peak_kb() - base) / 1024 << " MB";
+    std::cout << " (" << elapsed( start ) << " ms)" << std::endl;
+    std::cout << "  diff SAX/DOM=" << nb_diff( sax, dom ) << std::endl;
+  }
+  std::remove( FILENAME );
+
+  std::cout << "__RESERVOIR" << std::endl;
+  {
+    Reservoir res( 3, 50, 0.5, 0.9, 0.2 );
+    rapidjson::Document doc;
+    rapidjson::Value obj = res.serialize( doc );
+    std::stringstream ss;
+    ss << utils::rj::str_obj( obj );
+    Reservoir sax( ss );
+    Reservoir dom( obj );
+    rapidjson::Document doc_sax, doc_dom;
+    std::cout << "  same=" << (utils::rj::str_obj( sax.serialize( doc_sax ))
+                               == utils::rj::str_obj( dom.serialize( doc_dom )));
+    std::cout << " " << sax.str_display() << std::endl;
+  }
+
+  std::cout << "__RNETWORK" << std::endl;
+  {
+    Model::DSOM::RNetwork net( 2, 16, -1 );
+    rapidjson::Document doc;
+    rapidjson::Value obj = net.serialize( doc );
+    std::stringstream ss;
+    ss << utils::rj::str_obj( obj );
+    Model::DSOM::RNetwork sax( ss );
+    rapidjson::Document doc_sax;
+    std::cout << "  neurons=" << sax.v_neur.size();
+    std::cout << " same=" << (utils::rj::str_obj( sax.serialize( doc_sax ))
+                              == utils::rj::str_obj( obj )) << std::endl;
+  }
+
+  std::cout << "__INVALID" << std::endl;
+  try {
+    std::stringstream ss( "{\"pomdp\": {\"states\": [ {\"id\": 0, " );
+    Model::POMDP bad( ss, "pomdp" );
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "  " << e.what() << std::endl;
+  }
+  try {
+    // w_res tronqué (3 valeurs au lieu de 4)
+    std::stringstream ss( "{\"nb_input\": 1, \"nb_output\": 2,"
+                          " \"w_in\": [0.1, 0.2], \"w_res\": [0.1, 0.2, 0.3],"
+                          " \"x_res\": [0.0, 0.0]}" );
+    Reservoir bad( ss );
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "  " << e.what() << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste bica::hmm::compile et bica::sampler::TableHMM.
+ *  - pour plusieurs expressions, fréquences empiriques de (s,s') et des
+ *    observations : closures (référence) vs tables
+ *  - temps pour 10^6 pas : sampler::HMM vs TableHMM::generate
+ */
+
+#include <iostream>                  // std::cout
+#include <chrono>                    // std::chrono
+#include <cmath>                     // fabs
+#include <map>                       // std::map
+#include <stdexcept>                 // std::runtime_error
+
+#include <supelec/hmm_table.hpp>
+
+// ***************************************************************************
+#define NB_STEPS 1000000
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** Fréquences de (s,s') et de (s, o arrondie à 0.1) */
+using Freq = std::map<std::pair<int,int>,double>;
+void count( bica::sampler::Base& h, unsigned int nb, Freq& trans, Freq& obs )
+{
+  for( unsigned int i = 0; i < nb; ++i) {
+    int s = h.input_id();
+    obs[{s, (int) std::round( h.input() * 10.0 )}] += 1.0 / nb;
+    h.shift();
+    trans[{s, h.input_id()}] += 1.0 / nb;
+  }
+}
+double max_diff( const Freq& f1, const Freq& f2 )
+{
+  double diff = 0.0;
+  for( auto& f: f1 ) {
+    auto it = f2.find( f.first );
+    diff = std::max( diff, fabs( f.second - (it == f2.end() ? 0.0 : it->second )));
+  }
+  for( auto& f: f2 ) {
+    if( f1.find( f.first ) == f1.end() ) diff = std::max( diff, f.second );
+  }
+  return diff;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  std::srand( 1 );
+  std::cout << "__TABLE" << std::endl;
+  std::cout << bica::hmm::compile( "[ AB , .3 CD , .5 EFE ]" ).str_dump();
+
+  std::cout << "__FREQUENCIES closure vs table (max diff)" << std::endl;
+  std::vector<std::string> l_expr = {
+    "ABCDEF", "| .1 AB .2 DEF", "+ AB & CcD", "[ AC , .3 BD , .5 EFE ]",
+    "+ c & < .3 A , .5 F >", "! .05 AB*", "+ [ AB , .5 C , .5 DE ] & | .3 *A .4 EF" };
+  for( auto& expr: l_expr ) {
+    auto hmm = bica::hmm::make( expr );
+    bica::hmm::Table table = bica::hmm::compile( expr );
+    bica::sampler::HMM ref( hmm.first.first, hmm.first.second );
+    bica::sampler::TableHMM tab( table, 1 );
+    Freq t_ref, o_ref, t_tab, o_tab;
+    count( ref, NB_STEPS / 10, t_ref, o_ref );
+    count( tab, NB_STEPS / 10, t_tab, o_tab );
+    std::cout << "  " << expr << " : states=" << hmm.second << "/" << table.nb_states();
+    std::cout << " T=" << max_diff( t_ref, t_tab );
+    std::cout << " O=" << max_diff( o_ref, o_tab ) << std::endl;
+  }
+
+  std::cout << "__PARSE ERROR" << std::endl;
+  try {
+    bica::hmm::compile( "+ AB CD" );
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "  " << e.what() << std::endl;
+  }
+
+  std::cout << "__TIMING " << NB_STEPS << " steps" << std::endl;
+  std::string expr = "+ [ AB , .5 C , .5 DE ] & ! .1 | .3 *A .4 EF";
+  auto hmm = bica::hmm::make( expr );
+  Trajectory::HMM::Data ref_data, tab_data( NB_STEPS );
+  auto start = std::chrono::steady_clock::now();
+  bica::sampler::HMM ref( hmm.first.first, hmm.first.second );
+  for( unsigned int i = 0; i < NB_STEPS; ++i) {
+    ref_data.push_back( Trajectory::HMM::Item{ ref.input_id(), ref.input() } );
+    ref.shift();
+  }
+  std::cout << "  closures : " << elapsed( start ) << " ms" << std::endl;
+  start = std::chrono::steady_clock::now();
+  bica::sampler::TableHMM tab( bica::hmm::compile( expr ), 1 );
+  tab.generate( NB_STEPS, tab_data.data() );
+  std::cout << "  tables   : " << elapsed( start ) << " ms" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste utils::random::Stream et son usage par bica::random.
+ *  - jump(n) == n tirages, moyenne/variance de uniform et normal
+ *  - fill_uniform/fill_normal vs std::rand (temps)
+ *  - sampler::HMM avec flux : trajectoires identiques en 1 ou 4 threads
+ *  - sampler::generate (tables) : idem
+ */
+
+#include <iostream>                  // std::cout
+#include <chrono>                    // std::chrono
+#include <vector>                    // std::vector
+#include <cstdlib>                   // std::rand
+
+#include <random_stream.hpp>
+#include <parallel.hpp>
+#include <supelec/hmm_table.hpp>
+
+// ***************************************************************************
+#define NB_DRAW   10000000
+#define NB_TRAJ   8
+#define LENGTH    100000
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+void mean_var( const std::vector<double>& v, double& mean, double& var )
+{
+  mean = 0.0;
+  var = 0.0;
+  for( auto& x: v ) mean += x;
+  mean /= v.size();
+  for( auto& x: v ) var += (x - mean) * (x - mean);
+  var /= v.size();
+}
+/** NB_TRAJ trajectoires avec sampler::HMM(seed, k) */
+Trajectory::HMM::Data closure_trajs( const std::string& expr, unsigned int nb_thread )
+{
+  auto hmm = bica::hmm::make( expr );
+  Trajectory::HMM::Data data( NB_TRAJ * LENGTH );
+  utils::parallel::for_range( 0, NB_TRAJ, nb_thread,
+                              [&] (unsigned int begin, unsigned int end) {
+    for( unsigned int k = begin; k < end; ++k) {
+      bica::sampler::HMM h( hmm.first.first, hmm.first.second, 1, k );
+      for( unsigned int t = 0; t < LENGTH; ++t) {
+        data[k * LENGTH + t] = Trajectory::HMM::Item{ h.input_id(), h.input() };
+        h.shift();
+      }
+    }
+  });
+  return data;
+}
+unsigned int nb_diff( const Trajectory::HMM::Data& d1, const Trajectory::HMM::Data& d2 )
+{
+  unsigned int nb = 0;
+  for( unsigned int i = 0; i < d1.size(); ++i) {
+    if( d1[i].id_s != d2[i].id_s or d1[i].id_o != d2[i].id_o ) ++nb;
+  }
+  return nb;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  std::cout << "__JUMP" << std::endl;
+  {
+    utils::random::Stream r1( 42, 3 ), r2( 42, 3 );
+    for( unsigned int i = 0; i < 1000; ++i) r1.next();
+    r2.jump( 1000 );
+    std::cout << "  same=" << (r1.next() == r2.next()) << std::endl;
+  }
+
+  std::cout << "__MOMENTS" << std::endl;
+  std::vector<double> buf( NB_DRAW );
+  double mean, var;
+  utils::random::Stream rnd( 1, 0 );
+  auto start = std::chrono::steady_clock::now();
+  rnd.fill_uniform( buf.data(), NB_DRAW );
+  double t_fill = elapsed( start );
+  mean_var( buf, mean, var );
+  std::cout << "  uniform mean=" << mean << " var=" << var << " (1/12=" << 1.0/12.0 << ")";
+  std::cout << " (" << t_fill << " ms)" << std::endl;
+  start = std::chrono::steady_clock::now();
+  rnd.fill_normal( buf.data(), NB_DRAW );
+  t_fill = elapsed( start );
+  mean_var( buf, mean, var );
+  std::cout << "  normal  mean=" << mean << " var=" << var;
+  std::cout << " (" << t_fill << " ms)" << std::endl;
+  start = std::chrono::steady_clock::now();
+  for( unsigned int i = 0; i < NB_DRAW; ++i) buf[i] = bica::random::uniform( 0.0, 1.0 );
+  std::cout << "  std::rand uniform (" << elapsed( start ) << " ms)" << std::endl;
+
+  std::cout << "__SAMPLER::HMM 1 vs 4 threads" << std::endl;
+  std::string expr = "+ [ AB , .5 C , .5 DE ] & ! .1 | .3 *A .4 EF";
+  start = std::chrono::steady_clock::now();
+  Trajectory::HMM::Data seq = closure_trajs( expr, 1 );
+  std::cout << "  1 thread  (" << elapsed( start ) << " ms)" << std::endl;
+  start = std::chrono::steady_clock::now();
+  Trajectory::HMM::Data par = closure_trajs( expr, 4 );
+  std::cout << "  4 threads (" << elapsed( start ) << " ms)" << std::endl;
+  std::cout << "  diff=" << nb_diff( seq, par ) << std::endl;
+
+  std::cout << "__SAMPLER::GENERATE 1 vs 4 threads" << std::endl;
+  bica::hmm::Table table = bica::hmm::compile( expr );
+  start = std::chrono::steady_clock::now();
+  bica::sampler::generate( table, NB_TRAJ, LENGTH, 1, seq, 1 );
+  std::cout << "  1 thread  (" << elapsed( start ) << " ms)" << std::endl;
+  start = std::chrono::steady_clock::now();
+  bica::sampler::generate( table, NB_TRAJ, LENGTH, 1, par, 4 );
+  std::cout << "  4 threads (" << elapsed( start ) << " ms)" << std::endl;
+  std::cout << "  diff=" << nb_diff( seq, par ) << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,91 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste bica::hmm::Forward, viterbi et evaluate (hmm_forward.hpp).
+ *  - HMM déterministe : prédiction parfaite, états retrouvés
+ *  - HMM stochastiques : MSE bayésienne vs prédire o_t (persistance)
+ *  - évaluation de plusieurs trajectoires : 1 vs 4 threads
+ *  - trajectoire relue d'un fichier (précision du texte)
+ */
+
+#include <iostream>                  // std::cout
+#include <sstream>                   // std::stringstream
+#include <chrono>                    // std::chrono
+
+#include <supelec/hmm_forward.hpp>
+
+// ***************************************************************************
+#define LENGTH  20000
+#define NB_TRAJ 8
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** MSE de o_{t+1} ~ o_t */
+double mse_persistence( const Trajectory::HMM::Data& data )
+{
+  double mse = 0.0;
+  for( unsigned int t = 0; t+1 < data.size(); ++t) {
+    mse += (data[t+1].id_o - data[t].id_o) * (data[t+1].id_o - data[t].id_o);
+  }
+  return mse / (data.size() - 1);
+}
+void print( const std::string& name, const bica::hmm::Baseline& res )
+{
+  std::cout << "  " << name << " : mse=" << res.mse << " mse_test=" << res.mse_test;
+  std::cout << " loglik/T=" << res.loglik / res.length;
+  std::cout << " acc_filter=" << res.acc_filter << " acc_viterbi=" << res.acc_viterbi;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  std::cout << "__BASELINE single trajectories" << std::endl;
+  std::vector<std::string> l_expr = {
+    "ABCDEF", "| .1 AB .2 DEF", "[ AC , .3 BD , .5 EFE ]",
+    "+ c & < .3 A , .5 F >", "! .1 ABCD", "+ [ AB , .5 C , .5 DE ] & ! .1 | .3 *A .4 EF" };
+  for( auto& expr: l_expr ) {
+    bica::hmm::Table table = bica::hmm::compile( expr );
+    Trajectory::HMM::Data data;
+    bica::sampler::generate( table, 1, LENGTH, 1, data );
+    auto res = bica::hmm::evaluate( table, data, 100 );
+    print( expr, res );
+    std::cout << " (persistence mse=" << mse_persistence( data ) << ")" << std::endl;
+  }
+
+  std::cout << "__BASELINE " << NB_TRAJ << " trajectories 1 vs 4 threads" << std::endl;
+  std::string expr = "+ [ AB , .5 C , .5 DE ] & ! .1 | .3 *A .4 EF";
+  bica::hmm::Table table = bica::hmm::compile( expr );
+  std::vector<Trajectory::HMM::Data> l_data( NB_TRAJ );
+  for( unsigned int k = 0; k < NB_TRAJ; ++k) {
+    bica::sampler::generate( table, 1, LENGTH, k, l_data[k] );
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto l_seq = bica::hmm::evaluate( table, l_data, 100, 1 );
+  std::cout << "  1 thread  (" << elapsed( start ) << " ms)" << std::endl;
+  start = std::chrono::steady_clock::now();
+  auto l_par = bica::hmm::evaluate( table, l_data, 100, 4 );
+  std::cout << "  4 threads (" << elapsed( start ) << " ms)" << std::endl;
+  unsigned int nb_diff = 0;
+  for( unsigned int k = 0; k < NB_TRAJ; ++k) {
+    if( l_seq[k].mse != l_par[k].mse or l_seq[k].loglik != l_par[k].loglik ) ++nb_diff;
+  }
+  std::cout << "  diff=" << nb_diff << std::endl;
+
+  std::cout << "__BASELINE saved trajectory" << std::endl;
+  {
+    bica::hmm::Table table = bica::hmm::compile( "| .1 ABC .2 *D" );
+    Trajectory::HMM::Data data, read_data;
+    bica::sampler::generate( table, 1, LENGTH, 3, data );
+    std::stringstream ss;
+    Trajectory::HMM::save( ss, data );
+    Trajectory::HMM::read( ss, read_data );
+    print( "generated", bica::hmm::evaluate( table, data ));
+    std::cout << std::endl;
+    print( "read     ", bica::hmm::evaluate( table, read_data ));
+    std::cout << std::endl;
+  }
+
+  return 0;
+}
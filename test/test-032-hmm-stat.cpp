@@ -0,0 +1,68 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste bica::hmm::stats (hmm_stat.hpp).
+ *  - pi vs fréquences d'états d'une longue trajectoire
+ *  - bornes sur h_O vs -log P(o_0..o_T)/T (Forward, Shannon-McMillan)
+ *  - temps de calcul vs simulation
+ */
+
+#include <iostream>                  // std::cout
+#include <chrono>                    // std::chrono
+#include <cmath>                     // std::fabs, std::log
+
+#include <supelec/hmm_stat.hpp>
+#include <supelec/hmm_forward.hpp>
+#include <utils.hpp>                 // utils::str_vec
+
+// ***************************************************************************
+#define LENGTH 1000000
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  std::vector<std::string> l_expr = {
+    "ABCD", "| .1 AB .2 DEF", "[ AC , .3 BD , .5 EFE ]",
+    "+ c & < .3 A , .5 F >", "+ [ AB , .5 C , .5 DE ] & | .3 AA .4 EF",
+    "! .1 ABCD" };
+  for( auto& expr: l_expr ) {
+    std::cout << "__" << expr << std::endl;
+    bica::hmm::Table table = bica::hmm::compile( expr );
+    auto start = std::chrono::steady_clock::now();
+    auto st = bica::hmm::stats( table, 12 );
+    double t_stat = elapsed( start );
+
+    start = std::chrono::steady_clock::now();
+    Trajectory::HMM::Data data;
+    bica::sampler::generate( table, 1, LENGTH, 1, data );
+    std::vector<double> freq( table.nb_states(), 0.0 );
+    for( auto& item: data ) freq[item.id_s] += 1.0 / LENGTH;
+    double loglik = bica::hmm::evaluate( table, data ).loglik;
+    double t_simu = elapsed( start );
+
+    double err_pi = 0.0;
+    for( unsigned int s = 0; s < freq.size(); ++s) {
+      err_pi = std::max( err_pi, std::fabs( freq[s] - st.pi[s] ));
+    }
+    std::cout << "  pi=" << utils::str_vec( st.pi ) << " max|freq-pi|=" << err_pi;
+    std::cout << " cesaro=" << st.cesaro << std::endl;
+    std::cout << "  h_S=" << st.h_states << " H(pi)=" << st.h_pi << std::endl;
+    if( st.discrete ) {
+      unsigned int n = std::min( st.h_lower.size(), st.h_upper.size() ) - 1;
+      std::cout << "  H(O)=" << st.h_obs;
+      std::cout << " h_O in [" << st.h_lower[n] << ", " << st.h_upper[n] << "] (n=" << n+1 << ")";
+      std::cout << " E>=" << st.e_lower.back() << std::endl;
+      std::cout << "  simulated h_O=" << -loglik / LENGTH / std::log( 2.0 ) << std::endl;
+    }
+    else {
+      std::cout << "  O not discrete" << std::endl;
+    }
+    std::cout << "  stats " << t_stat << " ms, simulation " << t_simu << " ms" << std::endl;
+  }
+  return 0;
+}
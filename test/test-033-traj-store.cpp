@@ -0,0 +1,169 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste le format binaire des trajectoires (traj_store.hpp).
+ *  - HMM : taille et temps texte vs binaire (ouverture, parcours), égalité,
+ *    observations discrètes (DICT) ou continues ('*')
+ *  - POMDP (BatchSimulator) : aller-retour, bits par colonne
+ *  - fichier texte, ou POMDP lu comme HMM : std::runtime_error
+ *  - colonne DICT corrompue (taille < 8 octets, indice hors du
+ *    dictionnaire) : std::runtime_error
+ */
+
+#include <iostream>                  // std::cout
+#include <fstream>                   // std::ofstream
+#include <sstream>                   // std::stringstream
+#include <cstring>                   // std::memcpy
+#include <chrono>                    // std::chrono
+#include <cstdio>                    // std::remove
+#include <stdexcept>                 // std::runtime_error
+
+#include <traj_store.hpp>
+#include <supelec/hmm_table.hpp>
+#include <pomdp/gridworld.hpp>
+#include <pomdp/simulator.hpp>
+
+// ***************************************************************************
+#define LENGTH   1000000
+#define TXT_FILE "test-033.data"
+#define BIN_FILE "test-033.bin"
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+long file_size( const std::string& filename )
+{
+  std::ifstream ifile( filename, std::ios::binary | std::ios::ate );
+  return ifile.tellg();
+}
+/** Ouvre 'content' comme HMMStore et lit tout, message de l'erreur éventuelle */
+std::string try_store( const std::string& content )
+{
+  {
+    std::ofstream bfile( BIN_FILE, std::ios::binary );
+    bfile << content;
+  }
+  try {
+    Trajectory::HMMStore store( BIN_FILE );
+    double sum = 0.0;
+    for( auto item: store ) sum += item.id_o;
+    return "ok";
+  }
+  catch( std::runtime_error& e ) {
+    return e.what();
+  }
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  for( std::string expr: { "+ [ AB , .5 C , .5 DE ] & | .3 AA .4 EF",
+                           "+ [ AB , .5 C , .5 DE ] & | .3 *A .4 EF" } ) {
+    std::cout << "__HMM " << expr << " " << LENGTH << " items" << std::endl;
+    Trajectory::HMM::Data data;
+    bica::sampler::generate( bica::hmm::compile( expr ), 1, LENGTH, 1, data );
+    std::string meta = "## \"hmm_expr\": \"" + expr + "\",\n";
+    {
+      std::ofstream ofile( TXT_FILE );
+      ofile << meta;
+      Trajectory::HMM::save( ofile, data );
+      std::ofstream bfile( BIN_FILE, std::ios::binary );
+      Trajectory::HMMStore::write( bfile, data, meta );
+    }
+    std::cout << "  text=" << file_size( TXT_FILE ) / 1000 << " kB";
+    std::cout << " binary=" << file_size( BIN_FILE ) / 1000 << " kB" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    Trajectory::HMM::Data txt;
+    std::ifstream ifile( TXT_FILE );
+    Trajectory::HMM::read( ifile, txt );
+    std::cout << "  text read " << elapsed( start ) << " ms" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    Trajectory::HMMStore store( BIN_FILE );
+    std::cout << "  binary open " << elapsed( start ) << " ms";
+    start = std::chrono::steady_clock::now();
+    double sum = 0.0;
+    for( auto item: store ) sum += item.id_o;
+    std::cout << ", iterate " << elapsed( start ) << " ms (sum=" << sum << ")";
+    start = std::chrono::steady_clock::now();
+    Trajectory::HMM::Data bin = store.to_data();
+    std::cout << ", to_data " << elapsed( start ) << " ms" << std::endl;
+
+    unsigned int nb_diff = 0;
+    for( unsigned int i = 0; i < data.size(); ++i) {
+      if( bin[i].id_s != data[i].id_s or bin[i].id_o != data[i].id_o ) ++nb_diff;
+    }
+    std::cout << "  size=" << store.size() << " diff=" << nb_diff;
+    std::cout << " meta=" << store.meta();
+    std::cout << "  random access [12345].id_s=" << store[12345].id_s;
+    std::cout << " (" << data[12345].id_s << ")" << std::endl;
+  }
+
+  std::cout << "__POMDP" << std::endl;
+  {
+    Model::POMDP pomdp = Model::make_gridworld( Model::make_maze( 20, 20, 1 ), 0.8 );
+    Model::BatchSimulator simul( pomdp, 3 );
+    Trajectory::POMDP::Data data;
+    simul.run( 10, 10000, 0, data );
+    {
+      std::ofstream bfile( BIN_FILE, std::ios::binary );
+      Trajectory::POMDPStore::write( bfile, data );
+    }
+    Trajectory::POMDPStore store( BIN_FILE );
+    unsigned int nb_diff = 0;
+    auto it = store.begin();
+    for( auto& item: data ) {
+      auto read = *it++;
+      if( read.id_s != item.id_s or read.id_o != item.id_o or read.id_a != item.id_a
+          or read.id_next_s != item.id_next_s or read.id_next_o != item.id_next_o
+          or read.r != item.r ) ++nb_diff;
+    }
+    std::cout << "  states=" << pomdp._states.size() << " size=" << store.size();
+    std::cout << " diff=" << nb_diff;
+    std::cout << " bytes/item=" << (double) file_size( BIN_FILE ) / data.size() << std::endl;
+  }
+
+  std::cout << "__ERRORS" << std::endl;
+  std::cout << "  is_binary(text)=" << Trajectory::Binary::is_binary( TXT_FILE ) << std::endl;
+  try {
+    Trajectory::HMMStore store( TXT_FILE );
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "  " << e.what() << std::endl;
+  }
+  try {
+    Trajectory::HMMStore store( BIN_FILE );
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "  " << e.what() << std::endl;
+  }
+  {
+    // 5 observations => colonne 1 en DICT, indices sur 3 bits
+    Trajectory::HMM::Data data;
+    for( unsigned int i = 0; i < 1000; ++i) data.push_back( {0, (double) (i % 5)} );
+    std::stringstream bin;
+    Trajectory::HMMStore::write( bin, data );
+    const std::string valid = bin.str();
+    const size_t pos_desc = sizeof(Trajectory::Binary::Header) + sizeof(Trajectory::Binary::ColDesc);
+    Trajectory::Binary::ColDesc desc;
+    std::memcpy( &desc, valid.data() + pos_desc, sizeof(desc) );
+    std::cout << "  valid DICT (type=" << desc.type << ") : " << try_store( valid ) << std::endl;
+
+    std::string small = valid;
+    desc.size = 4;
+    std::memcpy( &small[pos_desc], &desc, sizeof(desc) );
+    std::cout << "  DICT of 4 bytes : " << try_store( small ) << std::endl;
+
+    // tous les indices à 7 (>= 5 valeurs)
+    std::string bad_index = valid;
+    size_t pos_index = desc.offset + sizeof(uint64_t) + 5 * sizeof(double);
+    for( size_t i = pos_index; i < bad_index.size(); ++i) bad_index[i] = (char) 0xFF;
+    std::cout << "  DICT index 7 : " << try_store( bad_index ) << std::endl;
+  }
+  std::remove( TXT_FILE );
+  std::remove( BIN_FILE );
+
+  return 0;
+}
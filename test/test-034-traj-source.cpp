@@ -0,0 +1,161 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste Trajectory::Source (traj_source.hpp).
+ *  - TableSource vs sampler::generate : mêmes Items, rewind rejoue
+ *  - Data, texte, binaire (open_hmm) : mêmes Items, temps de parcours
+ *  - DataSource / StoreSource sur [first, last) : learn + test = tout
+ *  - SimulatorSource vs BatchSimulator::run
+ *  - next_loop, ligne mal formée : std::runtime_error
+ */
+
+#include <iostream>                  // std::cout
+#include <fstream>                   // std::ofstream
+#include <chrono>                    // std::chrono
+#include <cstdio>                    // std::remove
+#include <stdexcept>                 // std::runtime_error
+
+#include <traj_source.hpp>
+#include <supelec/hmm_table.hpp>
+#include <pomdp/gridworld.hpp>
+#include <pomdp/simulator.hpp>
+
+// ***************************************************************************
+#define LENGTH   1000000
+#define TXT_FILE "test-034.data"
+#define BIN_FILE "test-034.bin"
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** Nb d'Items différents de 'data' (ou de longueur) en parcourant 'src' */
+template<typename Item, typename Data>
+unsigned int nb_diff( Trajectory::Source<Item>& src, const Data& data, double& t_ms )
+{
+  auto start = std::chrono::steady_clock::now();
+  unsigned int diff = 0;
+  size_t i = 0;
+  for( auto& item: src ) {
+    if( i >= data.size() or item.id_s != data[i].id_s or item.id_o != data[i].id_o ) ++diff;
+    ++i;
+  }
+  t_ms = elapsed( start );
+  return diff + (i != data.size());
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  double t_ms;
+  std::string expr = "+ [ AB , .5 C , .5 DE ] & | .3 AA .4 EF";
+  bica::hmm::Table table = bica::hmm::compile( expr );
+  Trajectory::HMM::Data data;
+  bica::sampler::generate( table, 2, LENGTH / 2, 1, data );
+
+  std::cout << "__TableSource " << expr << std::endl;
+  {
+    bica::sampler::TableSource src( table, 1, 1, LENGTH / 2 );
+    Trajectory::HMM::Data second( data.begin() + LENGTH / 2, data.end() );
+    std::cout << "  stream 1 diff=" << nb_diff( src, second, t_ms );
+    std::cout << " (" << t_ms << " ms)";
+    std::cout << " rewind diff=" << nb_diff( src, second, t_ms ) << std::endl;
+    bica::sampler::TableSource endless( table, 1 );
+    Trajectory::HMM::Item item;
+    for( unsigned int i = 0; i < LENGTH; ++i) endless.next( item );
+    std::cout << "  endless: " << LENGTH << " items, next=" << endless.next( item );
+    std::cout << " id_s=" << item.id_s << std::endl;
+  }
+
+  std::cout << "__Data / text / binary" << std::endl;
+  {
+    std::ofstream ofile( TXT_FILE );
+    ofile << "## \"hmm_expr\": \"" << expr << "\"," << std::endl;
+    Trajectory::HMM::save( ofile, data );
+    std::ofstream bfile( BIN_FILE, std::ios::binary );
+    Trajectory::HMMStore::write( bfile, data );
+  }
+  Trajectory::DataSource<Trajectory::HMM::Data> d_src( data );
+  std::cout << "  data diff=" << nb_diff( d_src, data, t_ms );
+  std::cout << " (" << t_ms << " ms)" << std::endl;
+  auto t_src = Trajectory::open_hmm( TXT_FILE );
+  std::cout << "  text diff=" << nb_diff( *t_src, data, t_ms );
+  std::cout << " (" << t_ms << " ms)" << std::endl;
+  std::cout << "  text rewind diff=" << nb_diff( *t_src, data, t_ms ) << std::endl;
+  auto b_src = Trajectory::open_hmm( BIN_FILE );
+  std::cout << "  binary diff=" << nb_diff( *b_src, data, t_ms );
+  std::cout << " (" << t_ms << " ms)" << std::endl;
+
+  std::cout << "__[first, last)" << std::endl;
+  {
+    const size_t split = LENGTH - 1000;
+    Trajectory::HMM::Data learn( data.begin(), data.begin() + split );
+    Trajectory::HMM::Data test( data.begin() + split, data.end() );
+    Trajectory::DataSource<Trajectory::HMM::Data> d_learn( data, 0, split );
+    Trajectory::DataSource<Trajectory::HMM::Data> d_test( data, split, LENGTH + 10 );
+    std::cout << "  data learn diff=" << nb_diff( d_learn, learn, t_ms );
+    std::cout << " test diff=" << nb_diff( d_test, test, t_ms );
+    std::cout << " sizes=" << d_learn.size() << "+" << d_test.size() << std::endl;
+    Trajectory::StoreSource<Trajectory::HMMStore> b_learn( BIN_FILE, 0, split );
+    Trajectory::StoreSource<Trajectory::HMMStore> b_test( BIN_FILE, split );
+    std::cout << "  binary learn diff=" << nb_diff( b_learn, learn, t_ms );
+    std::cout << " test diff=" << nb_diff( b_test, test, t_ms );
+    std::cout << " sizes=" << b_learn.size() << "+" << b_test.size() << std::endl;
+  }
+
+  std::cout << "__next_loop" << std::endl;
+  {
+    Trajectory::HMM::Data small( data.begin(), data.begin() + 3 );
+    Trajectory::DataSource<Trajectory::HMM::Data> src( small );
+    Trajectory::HMM::Item item;
+    std::cout << " ";
+    for( unsigned int i = 0; i < 7; ++i) {
+      src.next_loop( item );
+      std::cout << " " << item.id_s << (item.id_s == small[i % 3].id_s ? "" : "!");
+    }
+    std::cout << std::endl;
+    Trajectory::HMM::Data empty;
+    Trajectory::DataSource<Trajectory::HMM::Data> e_src( empty );
+    std::cout << "  empty next_loop=" << e_src.next_loop( item ) << std::endl;
+  }
+
+  std::cout << "__SimulatorSource" << std::endl;
+  {
+    Model::POMDP pomdp = Model::make_gridworld( Model::make_maze( 20, 20, 1 ), 0.8 );
+    Model::BatchSimulator simul( pomdp, 3 );
+    Trajectory::POMDP::Data p_data;
+    simul.run( 10, 1000, 0, p_data );
+    Model::SimulatorSource src( simul, 10, 1000 );
+    unsigned int diff = 0;
+    size_t i = 0;
+    for( auto& item: src ) {
+      const auto& ref = p_data[i++];
+      if( item.id_s != ref.id_s or item.id_o != ref.id_o or item.id_a != ref.id_a
+          or item.id_next_s != ref.id_next_s or item.r != ref.r ) ++diff;
+    }
+    std::cout << "  size=" << i << "/" << p_data.size() << " diff=" << diff << std::endl;
+  }
+
+  std::cout << "__ERRORS" << std::endl;
+  {
+    std::ofstream ofile( TXT_FILE );
+    ofile << "0\t0.5" << std::endl << "1" << std::endl;
+  }
+  try {
+    auto src = Trajectory::open_hmm( TXT_FILE );
+    for( auto& item: *src ) std::cout << "  read " << item.id_s << std::endl;
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "  " << e.what() << std::endl;
+  }
+  try {
+    Trajectory::TextSource<Trajectory::HMM> src( "not_a_file" );
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "  " << e.what() << std::endl;
+  }
+  std::remove( TXT_FILE );
+  std::remove( BIN_FILE );
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste MinMaxPyramid (minmax_pyramid.hpp), sans OpenGL.
+ *  - chaque bucket de chaque niveau vs min/max calculés directement
+ *  - un pic isolé est présent à tous les niveaux
+ *  - temps d'ajout par Sample, niveau choisi pour 800 pixels
+ */
+
+#include <iostream>                  // std::cout
+#include <vector>                    // std::vector
+#include <chrono>                    // std::chrono
+#include <cmath>                     // sin
+#include <random>                    // std::mt19937
+
+#include <minmax_pyramid.hpp>
+
+// ***************************************************************************
+using Sample = struct {
+  double x, y, z;
+};
+using Pyramid = MinMaxPyramid<Sample>;
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** Nb de buckets faux, tous niveaux confondus */
+unsigned int nb_error( const Pyramid& pyr, const std::vector<Sample>& data )
+{
+  unsigned int nb_err = 0;
+  for( size_t k = 1; k <= pyr.nb_level(); ++k) {
+    auto& lvl = pyr.level( k );
+    size_t nb_bucket = (data.size() + lvl.bucket_size - 1) / lvl.bucket_size;
+    if( lvl.data.size() != 2 * nb_bucket ) {
+      ++nb_err;
+      continue;
+    }
+    for( size_t b = 0; b < nb_bucket; ++b) {
+      size_t i_min = b * lvl.bucket_size, i_max = i_min;
+      for( size_t i = b * lvl.bucket_size;
+           i < std::min( (b+1) * lvl.bucket_size, data.size() ); ++i) {
+        if( data[i].y < data[i_min].y ) i_min = i;
+        if( data[i].y > data[i_max].y ) i_max = i;
+      }
+      auto& first = lvl.data[2*b];
+      auto& second = lvl.data[2*b+1];
+      if( first.x > second.x ) ++nb_err;
+      if( std::min( first.y, second.y ) != data[i_min].y ) ++nb_err;
+      if( std::max( first.y, second.y ) != data[i_max].y ) ++nb_err;
+    }
+  }
+  return nb_err;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  std::mt19937 gen( 1 );
+  std::normal_distribution<double> noise( 0.0, 0.1 );
+
+  std::cout << "__CHECK" << std::endl;
+  for( size_t n: {1, 3, 4, 5, 17, 1000, 65537} ) {
+    Pyramid pyr;
+    std::vector<Sample> data;
+    for( size_t i = 0; i < n; ++i) {
+      Sample s{ (double) i, sin( i / 100.0 ) + noise( gen ), 0.0 };
+      data.push_back( s );
+      pyr.add( s );
+    }
+    std::cout << "  n=" << n << " levels=" << pyr.nb_level();
+    std::cout << " errors=" << nb_error( pyr, data ) << std::endl;
+  }
+
+  std::cout << "__SPIKE" << std::endl;
+  {
+    Pyramid pyr;
+    for( size_t i = 0; i < 100000; ++i) {
+      pyr.add( {(double) i, i == 54321 ? 10.0 : 0.0, 0.0} );
+    }
+    unsigned int nb_seen = 0;
+    for( size_t k = 1; k <= pyr.nb_level(); ++k) {
+      for( auto& s: pyr.level( k ).data ) {
+        if( s.y == 10.0 and s.x == 54321 ) {
+          ++nb_seen;
+          break;
+        }
+      }
+    }
+    std::cout << "  spike in " << nb_seen << "/" << pyr.nb_level() << " levels" << std::endl;
+  }
+
+  std::cout << "__TIME" << std::endl;
+  {
+    const size_t n = 10000000;
+    std::vector<Sample> data( n );
+    for( size_t i = 0; i < n; ++i) {
+      data[i] = {(double) i, sin( i / 1000.0 ) + noise( gen ), 0.0};
+    }
+    Pyramid pyr;
+    auto start = std::chrono::steady_clock::now();
+    for( auto& s: data ) pyr.add( s );
+    double t_add = elapsed( start );
+    std::cout << "  " << n << " add in " << t_add << " ms (";
+    std::cout << t_add * 1e6 / n << " ns/sample), levels=" << pyr.nb_level() << std::endl;
+    size_t k = pyr.level_for( (double) n / 800.0 );
+    std::cout << "  800 pixels : level " << k << ", bucket=" << pyr.level( k ).bucket_size;
+    std::cout << ", " << pyr.level( k ).data.size() << " vertices" << std::endl;
+    std::cout << "  1 sample/pixel : level " << pyr.level_for( 1.0 ) << std::endl;
+  }
+  return 0;
+}
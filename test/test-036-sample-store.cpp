@@ -0,0 +1,210 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste SampleStore et SlidingMinMax (sample_store.hpp), sans OpenGL.
+ *  - push_back/pop_front aléatoires vs std::deque, mémoire <= 2*capacité
+ *  - SlidingMinMax vs min/max calculés directement
+ *  - MinMaxPyramid avec capacité : seuls les buckets de la fenêtre
+ *    restent, le premier ne contient que des Samples de la fenêtre,
+ *    nb de niveaux borné par la capacité, rebuild
+ *  - Curve avec capacité : _bbox de la fenêtre, temps d'ajout
+ */
+
+#include <iostream>                  // std::cout
+#include <deque>                     // std::deque
+#include <chrono>                    // std::chrono
+#include <cmath>                     // sin
+#include <random>                    // std::mt19937
+
+#include <sample_store.hpp>
+#include <minmax_pyramid.hpp>
+#include <curve.hpp>
+
+// ***************************************************************************
+using Sample = Curve::Sample;
+
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** Nb de différences entre 'store' et 'ref' */
+unsigned int nb_diff( const SampleStore<int>& store, const std::deque<int>& ref )
+{
+  unsigned int diff = (store.size() != ref.size());
+  size_t i = 0;
+  for( auto& v: store ) {
+    if( i >= ref.size() or v != ref[i] ) ++diff;
+    ++i;
+  }
+  return diff;
+}
+/** Nb de buckets faux de 'pyr' vs min/max de la fenêtre 'window' */
+unsigned int nb_bucket_error( const MinMaxPyramid<Sample>& pyr,
+                              const SampleStore<Sample>& window )
+{
+  unsigned int nb_err = 0;
+  size_t first = window.first_index();
+  size_t last = first + window.size() - 1;
+  for( size_t k = 1; k <= pyr.nb_level(); ++k) {
+    auto& lvl = pyr.level( k );
+    // premier bucket : celui de 'first', tous gardés jusqu'au dernier
+    size_t b_first = first / lvl.bucket_size;
+    size_t b_last = last / lvl.bucket_size;
+    if( lvl.first_bucket != b_first or
+        lvl.data.size() != 2 * (b_last - b_first + 1) ) {
+      ++nb_err;
+      continue;
+    }
+    for( size_t b = b_first; b <= b_last; ++b) {
+      size_t i_begin = std::max( b * lvl.bucket_size, first ) - first;
+      size_t i_end = std::min( (b+1) * lvl.bucket_size, last + 1 ) - first;
+      size_t i_min = i_begin, i_max = i_begin;
+      for( size_t i = i_begin; i < i_end; ++i) {
+        if( window[i].y < window[i_min].y ) i_min = i;
+        if( window[i].y > window[i_max].y ) i_max = i;
+      }
+      auto& a = lvl.data[2 * (b - b_first)];
+      auto& c = lvl.data[2 * (b - b_first) + 1];
+      if( a.x > c.x or a.x < window.front().x ) ++nb_err;
+      if( std::min( a.y, c.y ) != window[i_min].y ) ++nb_err;
+      if( std::max( a.y, c.y ) != window[i_max].y ) ++nb_err;
+    }
+  }
+  return nb_err;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  std::mt19937 gen( 1 );
+  std::uniform_real_distribution<double> unif( 0.0, 1.0 );
+
+  std::cout << "__SampleStore" << std::endl;
+  for( size_t capacity: {0, 1, 7, 1000} ) {
+    SampleStore<int> store( capacity );
+    std::deque<int> ref;
+    unsigned int diff = 0;
+    size_t max_storage = 0, nb_push = 0;
+    for( int i = 0; i < 100000; ++i) {
+      if( unif( gen ) < 0.3 ) {
+        size_t n = unif( gen ) * 5;
+        store.pop_front( n );
+        for( ; n > 0 and not ref.empty(); --n) ref.pop_front();
+      }
+      else {
+        store.push_back( i );
+        ref.push_back( i );
+        ++nb_push;
+        if( capacity > 0 and ref.size() > capacity ) ref.pop_front();
+      }
+      // index absolu de front
+      if( store.first_index() + store.size() != nb_push ) ++diff;
+      max_storage = std::max( max_storage, store.storage_size() );
+    }
+    diff += nb_diff( store, ref );
+    std::cout << "  capacity=" << capacity << " size=" << store.size();
+    std::cout << " diff=" << diff << " max_storage=" << max_storage << std::endl;
+  }
+
+  std::cout << "__SlidingMinMax" << std::endl;
+  {
+    const size_t width = 50;
+    std::vector<double> val;
+    SlidingMinMax win;
+    unsigned int nb_err = 0;
+    for( size_t i = 0; i < 10000; ++i) {
+      val.push_back( unif( gen ) );
+      win.push( i, val.back() );
+      size_t first = i + 1 > width ? i + 1 - width : 0;
+      win.evict( first );
+      double v_min = val[first], v_max = val[first];
+      for( size_t j = first; j <= i; ++j) {
+        v_min = std::min( v_min, val[j] );
+        v_max = std::max( v_max, val[j] );
+      }
+      if( win.min() != v_min or win.max() != v_max ) ++nb_err;
+    }
+    std::cout << "  width=" << width << " errors=" << nb_err << std::endl;
+  }
+
+  std::cout << "__MinMaxPyramid with capacity" << std::endl;
+  {
+    const size_t n = 200000, capacity = 30000;
+    SampleStore<Sample> window( capacity );
+    MinMaxPyramid<Sample> pyr;
+    pyr.set_capacity( capacity );
+    unsigned int nb_err = 0;
+    for( size_t i = 0; i < n; ++i) {
+      // pentes : les extrema du premier bucket sont souvent évincés
+      Sample s{ (double) i, (i / 5000) % 2 ? -(double) i : unif( gen ), 0.0 };
+      window.push_back( s );
+      pyr.add( s );
+      pyr.evict( window );
+      if( i % 997 == 0 or i == n-1 ) {
+        pyr.trim( window );
+        nb_err += nb_bucket_error( pyr, window );
+      }
+    }
+    std::cout << "  levels=" << pyr.nb_level();
+    std::cout << " (coarsest bucket=" << pyr.level( pyr.nb_level() ).bucket_size;
+    std::cout << ") errors=" << nb_err << std::endl;
+    MinMaxPyramid<Sample> other;
+    other.set_capacity( capacity );
+    other.rebuild( window );
+    std::cout << "  rebuild : levels=" << other.nb_level();
+    std::cout << " errors=" << nb_bucket_error( other, window ) << std::endl;
+    window.set_capacity( 1000 );
+    pyr.set_capacity( 1000 );
+    pyr.evict( window );
+    pyr.trim( window );
+    std::cout << "  capacity=1000 : levels=" << pyr.nb_level();
+    std::cout << " errors=" << nb_bucket_error( pyr, window ) << std::endl;
+  }
+
+  std::cout << "__Curve with capacity" << std::endl;
+  {
+    const size_t capacity = 10000;
+    Curve curve;
+    curve.set_capacity( capacity );
+    unsigned int nb_err = 0;
+    for( size_t i = 0; i < 100000; ++i) {
+      curve.add_sample( {(double) i, sin( i / 1000.0 ) + unif( gen ), 0.0} );
+      if( i % 997 == 0 ) {
+        auto& samples = curve.get_samples();
+        BoundingBox bbox = {samples[0].x, samples[0].x, samples[0].y, samples[0].y};
+        for( auto& s: samples ) {
+          bbox.y_min = std::min( bbox.y_min, s.y );
+          bbox.y_max = std::max( bbox.y_max, s.y );
+          bbox.x_max = s.x;
+        }
+        auto cb = curve.get_bbox();
+        if( cb.x_min != bbox.x_min or cb.x_max != bbox.x_max or
+            cb.y_min != bbox.y_min or cb.y_max != bbox.y_max ) ++nb_err;
+      }
+    }
+    std::cout << "  size=" << curve.get_samples().size();
+    std::cout << " bbox=" << curve.get_bbox() << " errors=" << nb_err << std::endl;
+    // add_data : x quelconques
+    for( size_t i = 0; i < 2 * capacity; ++i) {
+      curve.add_data( {unif( gen ), unif( gen ) - 5.0, 0.0} );
+    }
+    std::cout << "  add_data bbox=" << curve.get_bbox() << std::endl;
+
+    const size_t n = 10000000;
+    std::vector<Sample> data( n );
+    for( size_t i = 0; i < n; ++i) {
+      data[i] = {(double) i, sin( i / 1000.0 ) + unif( gen ), 0.0};
+    }
+    for( size_t cap: {(size_t) 0, capacity} ) {
+      Curve big;
+      big.set_capacity( cap );
+      auto start = std::chrono::steady_clock::now();
+      for( auto& s: data ) big.add_sample( s );
+      double t_add = elapsed( start );
+      std::cout << "  capacity=" << cap << " : " << n << " add in " << t_add << " ms (";
+      std::cout << t_add * 1e6 / n << " ns/sample), size=" << big.get_samples().size();
+      std::cout << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,102 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste write_png et PngQueue (png_queue.hpp), sans OpenGL.
+ *  - image relue avec libpng : mêmes pixels, lignes dans le bon sens
+ *  - temps d'écriture directe vs temps de push dans la PngQueue
+ *  - file bornée : tout est écrit, erreurs comptées
+ */
+
+#include <iostream>                  // std::cout
+#include <sstream>                   // std::stringstream
+#include <chrono>                    // std::chrono
+#include <cmath>                     // sin
+#include <cstdio>                    // std::remove
+
+#include <png_queue.hpp>
+
+// ***************************************************************************
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** Fond blanc, une sinusoïde, en bas à gauche un pixel rouge */
+utils::Image make_plot( unsigned int width, unsigned int height, double phase )
+{
+  utils::Image img;
+  img.width = width;
+  img.height = height;
+  img.rgb.assign( 3 * width * height, 255 );
+  for( unsigned int x = 0; x < width; ++x) {
+    unsigned int y = (unsigned int) ((0.5 + 0.4 * sin( x / 50.0 + phase )) * height);
+    for( unsigned int c = 0; c < 3; ++c) img.rgb[3 * (y * width + x) + c] = 0;
+  }
+  img.rgb[0] = 255; img.rgb[1] = 0; img.rgb[2] = 0;
+  return img;
+}
+/** Nb de pixels différents entre 'img' et le fichier (-1 si illisible) */
+int nb_diff( const std::string& filename, const utils::Image& img )
+{
+  png_image png;
+  png.version = PNG_IMAGE_VERSION;
+  png.opaque = NULL;
+  if( not png_image_begin_read_from_file( &png, filename.c_str() )) return -1;
+  png.format = PNG_FORMAT_RGB;
+  std::vector<unsigned char> buf( PNG_IMAGE_SIZE( png ));
+  if( not png_image_finish_read( &png, NULL, buf.data(), 0, NULL )) return -1;
+  if( png.width != img.width or png.height != img.height ) return -1;
+  int diff = 0;
+  // fichier de haut en bas, img de bas en haut
+  for( unsigned int y = 0; y < img.height; ++y) {
+    for( unsigned int i = 0; i < 3 * img.width; ++i) {
+      if( buf[3 * img.width * (img.height - 1 - y) + i] != img.rgb[3 * img.width * y + i] ) {
+        ++diff;
+      }
+    }
+  }
+  return diff;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  const unsigned int nb_image = 20;
+
+  std::cout << "__write_png" << std::endl;
+  utils::Image ref = make_plot( 800, 350, 0.0 );
+  auto start = std::chrono::steady_clock::now();
+  bool ok = utils::write_png( "test-037-ref.png", ref );
+  std::cout << "  ok=" << ok << " in " << elapsed( start ) << " ms, diff=";
+  std::cout << nb_diff( "test-037-ref.png", ref ) << std::endl;
+
+  std::cout << "__PngQueue" << std::endl;
+  // push n'attend que si la file est pleine
+  for( unsigned int max_pending: {2u, nb_image + 1} ) {
+    utils::PngQueue queue( max_pending );
+    double t_push = 0.0;
+    auto start_all = std::chrono::steady_clock::now();
+    for( unsigned int i = 0; i < nb_image; ++i) {
+      utils::Image img = make_plot( 800, 350, i );
+      std::stringstream filename;
+      filename << "test-037-" << i << ".png";
+      auto start_push = std::chrono::steady_clock::now();
+      queue.push( filename.str(), std::move( img ) );
+      t_push += elapsed( start_push );
+    }
+    queue.push( "no_such_dir/test-037.png", make_plot( 10, 10, 0.0 ) );
+    queue.flush();
+    std::cout << "  max_pending=" << max_pending << ", " << nb_image << " images, push ";
+    std::cout << t_push / nb_image;
+    std::cout << " ms/image, total " << elapsed( start_all ) << " ms" << std::endl;
+    std::cout << "  written=" << queue.nb_written() << " error=" << queue.nb_error();
+    std::cout << " diff(last)=" << nb_diff( "test-037-19.png", make_plot( 800, 350, 19 ) );
+    std::cout << std::endl;
+  }
+  std::remove( "test-037-ref.png" );
+  for( unsigned int i = 0; i < nb_image; ++i) {
+    std::stringstream filename;
+    filename << "test-037-" << i << ".png";
+    std::remove( filename.str().c_str() );
+  }
+  return 0;
+}
@@ -0,0 +1,173 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Teste SoftWindow et SoftCanvas (soft_window.hpp), sans display ni OpenGL.
+ *  - Figure (sans Window) avec Curve, CurveMean, ScatterPlotter, ImgPlotter,
+ *    texte et RDSOMViewer : pixels attendus dans le SoftCanvas
+ *  - bbox vide, vertex infinis ou NaN : rien d'invalide n'est dessiné
+ *  - render_all : plusieurs figures en parallèle, fichiers PNG écrits
+ */
+
+#include <iostream>                  // std::cout
+#include <sstream>                   // std::stringstream
+#include <chrono>                    // std::chrono
+#include <cmath>                     // sin
+#include <cstdio>                    // std::remove
+#include <list>                      // std::list
+#include <limits>                    // std::numeric_limits
+
+#include <soft_window.hpp>
+#include <figure.hpp>
+#include <curve.hpp>
+#include <scatter.hpp>
+#include <img_plotter.hpp>
+#include <dsom/rdsom1D_viewer.hpp>
+
+// ***************************************************************************
+double elapsed( std::chrono::steady_clock::time_point start )
+{
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+/** Nb de pixels de couleur (r,g,b) */
+unsigned int nb_pixel( const SoftCanvas& canvas, unsigned char r,
+                       unsigned char g, unsigned char b )
+{
+  auto& img = canvas.get_image();
+  unsigned int nb = 0;
+  for( size_t i = 0; i < img.rgb.size(); i += 3) {
+    if( img.rgb[i] == r and img.rgb[i+1] == g and img.rgb[i+2] == b ) ++nb;
+  }
+  return nb;
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  std::cout << "__SoftCanvas" << std::endl;
+  {
+    SoftCanvas canvas( 100, 100 );
+    canvas.ortho( 0.0, 10.0, 0.0, 10.0 );
+    canvas.color( 1.0, 0.0, 0.0 );
+    canvas.begin( SoftCanvas::TRIANGLES );
+    canvas.vertex( 0.0, 0.0 ); canvas.vertex( 10.0, 0.0 ); canvas.vertex( 0.0, 10.0 );
+    canvas.end();
+    canvas.color( 0.0, 0.0, 1.0 );
+    canvas.begin( SoftCanvas::LINES );
+    canvas.vertex( 0.0, 9.95 ); canvas.vertex( 10.0, 9.95 );
+    canvas.end();
+    canvas.color( 0.0, 0.0, 0.0 );
+    canvas.push_matrix();
+    canvas.translate( 5.0, 5.0 );
+    canvas.scale( 0.1, 0.1 );
+    canvas.text( "I" );
+    canvas.pop_matrix();
+    std::cout << "  red=" << nb_pixel( canvas, 255, 0, 0 ) << " (~5000)";
+    std::cout << " blue=" << nb_pixel( canvas, 0, 0, 255 ) << " (~100)";
+    std::cout << " black=" << nb_pixel( canvas, 0, 0, 0 ) << " ('I' : 11)";
+    std::cout << " text_width(abc)=" << SoftCanvas::text_width( "abc" ) << std::endl;
+  }
+
+  std::cout << "__Degenerate" << std::endl;
+  {
+    const double inf = std::numeric_limits<double>::infinity();
+    SoftCanvas canvas( 100, 100 );
+    // bbox vide : range unité autour de (5,3)
+    canvas.ortho( 5.0, 5.0, 3.0, 3.0 );
+    canvas.color( 1.0, 0.0, 0.0 );
+    canvas.begin( SoftCanvas::LINE_STRIP );
+    canvas.vertex( 4.5, 3.0 ); canvas.vertex( 5.5, 3.0 );
+    canvas.vertex( NAN, 3.0 ); canvas.vertex( inf, -inf );
+    canvas.end();
+    canvas.begin( SoftCanvas::TRIANGLES );
+    canvas.vertex( 0.0, 0.0 ); canvas.vertex( inf, 0.0 ); canvas.vertex( 0.0, 1.0 );
+    canvas.end();
+    canvas.ortho( NAN, 1.0, 0.0, inf );
+    std::cout << "  red=" << nb_pixel( canvas, 255, 0, 0 ) << " (~100)" << std::endl;
+  }
+
+  std::cout << "__Figure" << std::endl;
+  Curve curve;
+  curve.set_color( {1.0, 0.0, 0.0} );
+  CurveMean curve_mean;
+  curve_mean.set_color( {0.0, 0.0, 1.0} );
+  for( unsigned int i = 0; i < 100000; ++i) {
+    double x = i / 10000.0;
+    curve.add_sample( {x, sin( x ), 0.0} );
+    curve_mean.add_sample( {x, 0.5 * sin( 3.0 * x ), 0.0} );
+  }
+  curve_mean.set_mean_mode( true );
+  curve_mean.recompute_means();
+  Curve points;
+  for( unsigned int i = 0; i < 10; ++i) points.add_sample( {(double) i, -0.8, 0.0} );
+  ScatterPlotter scatter( points );
+  scatter.set_color( {0.0, 0.5, 0.0} );
+  std::vector<double> img_data;
+  for( unsigned int i = 0; i < 16; ++i) img_data.push_back( i );
+  ImgPlotter<std::vector<double>> img( img_data, 4, 4, 7.0, 9.0, 0.2, 0.9 );
+
+  SoftWindow win( 800, 350 );
+  Figure fig( "SoftWindow" );
+  fig.add_plotter( &curve );
+  fig.add_plotter( &curve_mean );
+  fig.add_plotter( &scatter );
+  fig.add_plotter( &img );
+  fig.add_text( "text", 1.0, 0.8 );
+  win.add_plotter( &fig );
+  win.update_bbox();
+  auto start = std::chrono::steady_clock::now();
+  win.render();
+  std::cout << "  render in " << elapsed( start ) << " ms" << std::endl;
+  auto& canvas = win.get_canvas();
+  std::cout << "  white=" << nb_pixel( canvas, 255, 255, 255 );
+  std::cout << " red(curve)=" << nb_pixel( canvas, 255, 0, 0 );
+  std::cout << " blue(mean)=" << nb_pixel( canvas, 0, 0, 255 );
+  std::cout << " green(scatter)=" << nb_pixel( canvas, 0, 128, 0 );
+  std::cout << " black(axes,text)=" << nb_pixel( canvas, 0, 0, 0 );
+  // premier pixel de l'image : couleur de la valeur min
+  std::cout << " img(min)=" << nb_pixel( canvas, (unsigned char) (img._img[0] * 255.0 + 0.5),
+                                         (unsigned char) (img._img[1] * 255.0 + 0.5),
+                                         (unsigned char) (img._img[2] * 255.0 + 0.5) );
+  std::cout << std::endl;
+
+  std::cout << "__RDSOMViewer" << std::endl;
+  {
+    RDSOM rdsom( 1, 20, -1 );
+    std::list<unsigned int> queue = {0, 5, 10, 15};
+    RDSOMViewer viewer( rdsom, queue );
+    SoftWindow win_rdsom( 450, 450 );
+    Figure fig_rdsom;
+    fig_rdsom.set_draw_axes( false );
+    fig_rdsom.add_plotter( &viewer );
+    win_rdsom.add_plotter( &fig_rdsom );
+    win_rdsom.update_bbox();
+    win_rdsom.render();
+    std::cout << "  non white=" << 450 * 450 - nb_pixel( win_rdsom.get_canvas(), 255, 255, 255 );
+    std::cout << std::endl;
+  }
+
+  std::cout << "__render_all" << std::endl;
+  {
+    const unsigned int nb_fig = 8;
+    std::vector<std::unique_ptr<SoftWindow>> wins;
+    std::vector<std::unique_ptr<Figure>> figs;
+    std::vector<SoftWindow::Job> jobs;
+    for( unsigned int i = 0; i < nb_fig; ++i) {
+      wins.emplace_back( new SoftWindow( 800, 350 ) );
+      figs.emplace_back( new Figure( "Fig" ) );
+      figs.back()->add_plotter( &curve );
+      figs.back()->add_plotter( &scatter );
+      wins.back()->add_plotter( figs.back().get() );
+      std::stringstream filename;
+      filename << "test-038-" << i << ".png";
+      jobs.push_back( {wins.back().get(), filename.str()} );
+    }
+    for( unsigned int nb_thread: {1u, utils::parallel::nb_hardware_thread()} ) {
+      auto start = std::chrono::steady_clock::now();
+      bool ok = SoftWindow::render_all( jobs, nb_thread );
+      std::cout << "  " << nb_thread << " thread(s) : " << nb_fig << " figures in ";
+      std::cout << elapsed( start ) << " ms, ok=" << ok << std::endl;
+    }
+    for( auto& job: jobs ) std::remove( job.second.c_str() );
+  }
+  return 0;
+}
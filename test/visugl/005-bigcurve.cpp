@@ -0,0 +1,111 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * 005-bigcurve.cpp
+ *
+ * VisuGL example.
+ * Window + Figure with a Curve and a CurveMean that grow by 'NB_ADD'
+ * samples at each frame, up to 'NB_MAX' samples. Only new samples are
+ * uploaded to the Vertex Buffer. The Curve is drawn from its min/max pyramid
+ * (about 2 vertices per pixel). Frames per second are printed every second.
+ *
+ * 'W' or 'w' -> switch between "normal" and "mean" mode
+ * 'S' or 's' -> save drawing as "005-bigcurve.png"
+ */
+
+#include <string>
+#include <stdlib.h>
+#include <iostream>
+#include <math.h>
+
+#include <window.hpp>
+#include <figure.hpp>
+#include <curve.hpp>
+
+#define NB_ADD 10000
+#define NB_MAX 2000000
+
+/** Window, Figure and Plotters */
+Window* _win;
+Figure* _fig;
+Curve*  _curve;
+CurveMean* _curve_mean;
+
+//******************************************************************************
+/**
+ * Callback for keyboard events
+ */
+static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+  if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, GL_TRUE);
+  }
+  // S or s : save window
+  else if (key == GLFW_KEY_S && action == GLFW_PRESS) {
+    _win->save( "005-bigcurve.png" );
+  }
+  // W or w : switch _curve_mean_mode
+  else if ( key == GLFW_KEY_W && action == GLFW_PRESS) {
+    _curve_mean->set_mean_mode( not _curve_mean->get_mean_mode() );
+    if( _curve_mean->get_mean_mode() ) {
+      _curve_mean->recompute_means();
+    }
+  }
+}
+// ******************************************************************** render
+void update_and_render()
+{
+  unsigned int nb_sample = 0;
+  unsigned int nb_frame = 0;
+  glfwSetTime(0.0);
+  double last_time = 0.0;
+  while( !glfwWindowShouldClose(_win->_window) ) {
+    // add data to the curves
+    for( unsigned int i = 0; i < NB_ADD and nb_sample < NB_MAX; ++i, ++nb_sample) {
+      double x = nb_sample;
+      double y = x / NB_MAX + 0.1 * sin( x / 1000.0 ) + 0.05 * sin( x / 7.0 );
+      _curve->add_sample( {x, y, 0.0} );
+      _curve_mean->add_sample( {x, y + 0.2, 0.0} );
+    }
+    _win->update_bbox();
+    _win->render();
+
+    ++nb_frame;
+    double time = glfwGetTime();
+    if( time - last_time > 1.0 ) {
+      std::cout << nb_sample << " samples, ";
+      std::cout << nb_frame / (time - last_time) << " fps" << std::endl;
+      nb_frame = 0;
+      last_time = time;
+    }
+  }
+}
+//******************************************************************************
+int main( int argc, char *argv[] )
+{
+  glfwSetErrorCallback(Window::error_callback);
+  if (!glfwInit())
+    exit(EXIT_FAILURE);
+
+  _curve = new Curve(); // default is red thin line
+  _curve_mean = new CurveMean();
+  _curve_mean->set_color( {0.0, 0.0, 1.0} );
+
+  _win = new Window( "Big Curve", 800, 400 );
+  _fig = new Figure( *_win, "Big Curve    [ESC:quit, W:Mean ON/OFF, S:save]" );
+  _fig->_update_axes_x = true;
+  _win->add_plotter( _fig );
+  _fig->add_plotter( _curve_mean );
+  _fig->add_plotter( _curve );
+  _win->update_bbox();
+
+  update_and_render();
+
+  delete _curve;
+  delete _curve_mean;
+  delete _fig;
+  delete _win;
+  glfwTerminate();
+
+  return 0;
+}
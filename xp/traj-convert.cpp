@@ -0,0 +1,149 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * Convert trajectories between the text format (Trajectory::HMM::read,
+ * Trajectory::POMDP::read) and the binary columnar format (traj_store.hpp).
+ * The direction is given by the input file : binary -> text, text -> binary.
+ * The '#' lines of a text file are kept as metadata.
+ *
+ * traj-convert traj_p05ABCB.data traj_p05ABCB.bin
+ * traj-convert --pomdp traj_cheese.bin traj_cheese.data
+ */
+
+#include <iostream>                // std::cout
+#include <fstream>                 // std::ofstream
+#include <sstream>                 // std::stringstream
+#include <string>                  // std::string
+
+#include <traj_store.hpp>
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+// ******************************************************************** Global
+std::string _opt_input;
+std::string _opt_output;
+bool        _opt_pomdp = false;
+bool        _opt_verb  = false;
+// ***************************************************************************
+// ******************************************************************* options
+// ***************************************************************************
+void setup_options(int argc, char **argv)
+{
+  po::options_description desc("Options");
+  desc.add_options()
+    ("help,h", "produce help message")
+    ("pomdp", "Trajectory::POMDP (default is Trajectory::HMM)")
+    ("input", po::value<std::string>(&_opt_input)->required(), "input file")
+    ("output", po::value<std::string>(&_opt_output)->required(), "output file")
+    ("verb,v", "verbose" )
+    ;
+
+  po::positional_options_description pod;
+  pod.add( "input", 1);
+  pod.add( "output", 1);
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).
+              options(desc).positional(pod).run(), vm);
+
+    if (vm.count("help")) {
+      std::cout << "Usage: " << argv[0] << " [options] input output" << std::endl;
+      std::cout << desc << std::endl;
+      exit(1);
+    }
+
+    po::notify(vm);
+  }
+  catch(po::error& e)  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    std::cerr << desc << std::endl;
+    exit(2);
+  }
+
+  if( vm.count("pomdp") ) {
+    _opt_pomdp = true;
+  }
+  if( vm.count("verb") ) {
+    _opt_verb = true;
+  }
+}
+// ***************************************************************************
+/**
+ * '#' lines before the first item in meta (except the length line,
+ * rewritten by HMM::save), the rest in data.
+ */
+void split_text( const std::string& filename, std::string& meta, std::stringstream& data )
+{
+  std::ifstream ifile( filename );
+  if( ifile.fail() ) {
+    std::cerr << "traj-convert: NOT FOUND " << filename << std::endl;
+    exit(1);
+  }
+  std::string line;
+  bool header = true;
+  while( std::getline( ifile, line )) {
+    if( header and not line.empty() and line.front() == '#' ) {
+      if( line.compare( 0, 11, "## \"length\"" ) != 0 ) meta += line + "\n";
+    }
+    else {
+      header = false;
+      data << line << std::endl;
+    }
+  }
+}
+// ***************************************************************************
+// ********************************************************************** main
+// ***************************************************************************
+int main(int argc, char *argv[])
+{
+  setup_options( argc, argv );
+
+  try {
+    std::ofstream ofile;
+    if( Trajectory::Binary::is_binary( _opt_input )) {
+      // binary -> text
+      ofile.open( _opt_output );
+      if( _opt_pomdp ) {
+        Trajectory::POMDPStore store( _opt_input );
+        ofile << store.meta();
+        for( auto item: store ) {
+          ofile << item.id_s << "\t" << item.id_o << "\t" << item.id_a << "\t";
+          ofile << item.id_next_s << "\t" << item.id_next_o << "\t" << item.r << std::endl;
+        }
+        if( _opt_verb ) std::cout << store.size() << " items" << std::endl;
+      }
+      else {
+        Trajectory::HMMStore store( _opt_input );
+        ofile << store.meta();
+        Trajectory::HMM::save( ofile, store.to_data() );
+        if( _opt_verb ) std::cout << store.size() << " items" << std::endl;
+      }
+    }
+    else {
+      // text -> binary
+      std::string meta;
+      std::stringstream data;
+      split_text( _opt_input, meta, data );
+      ofile.open( _opt_output, std::ios::binary );
+      if( _opt_pomdp ) {
+        Trajectory::POMDP::Data traj;
+        Trajectory::POMDP::read( data, traj );
+        Trajectory::POMDPStore::write( ofile, traj, meta );
+        if( _opt_verb ) std::cout << traj.size() << " items" << std::endl;
+      }
+      else {
+        Trajectory::HMM::Data traj;
+        Trajectory::HMM::read( data, traj );
+        Trajectory::HMMStore::write( ofile, traj, meta );
+        if( _opt_verb ) std::cout << traj.size() << " items" << std::endl;
+      }
+    }
+  }
+  catch( std::runtime_error& e ) {
+    std::cerr << "traj-convert: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
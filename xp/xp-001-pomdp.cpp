@@ -15,6 +15,7 @@
 #include <fstream>                 // std::ofstream
 #include <string>                  // std::string
 #include <sstream>                 // std::stringdtream
+#include <memory>                  // std::unique_ptr
 #include <rapidjson/document.h>    // rapidjson's DOM-style API
 #include <json_wrapper.hpp>        // JSON::IStreamWrapper
 
@@ -22,6 +23,8 @@
 
 #include <pomdp/pomdp.hpp>
 #include <pomdp/trajectory.hpp>
+#include <traj_source.hpp>         // Trajectory::StoreSource, DataSource
+#include <pomdp/simulator.hpp>     // Model::BatchSimulator
 
 #include <reservoir.hpp>
 #include <layer.hpp>
@@ -57,11 +60,13 @@ double                 _noise_level;
 
 Model::POMDP*          _pomdp = nullptr;
 unsigned int           _length;
-Trajectory::POMDP::Data _traj_data;
-Trajectory::POMDP::Data _learn_data;
+unsigned int           _nb_episode;
+unsigned int           _nb_thread;
+Trajectory::POMDP::Data _traj_data;            // fichier texte seulement
+std::unique_ptr<Trajectory::POMDPSource> _learn_src;
 
 unsigned int           _test_length;
-Trajectory::POMDP::Data _test_data;
+std::unique_ptr<Trajectory::POMDPSource> _test_src;
 
 Reservoir*             _res = nullptr;
 Layer*                 _lay = nullptr;
@@ -76,7 +81,6 @@ bool                    _verb;
 // Fonction valeur
 Algorithms::TVal _vQ;
 
-gsl_rng*               _rnd = gsl_rng_alloc( gsl_rng_taus );
 // ****************************************************************** free_mem
 void free_mem()
 {
@@ -105,6 +109,8 @@ void setup_options(int argc, char **argv)
     ("load_pomdp,p", po::value<std::string>(), "load POMDP from JSON file")
     ("gene_traj", po::value<std::string>(), "gene Trajectory into file")
     ("traj_length", po::value<unsigned int>(&_length)->default_value(10), "generate Traj of length ")
+    ("nb_episode", po::value<unsigned int>(&_nb_episode)->default_value(1), "nb of episodes of Traj to generate")
+    ("nb_thread", po::value<unsigned int>(&_nb_thread)->default_value(1), "nb of threads to generate Traj")
     ("gene_esn", po::value<std::string>(), "gene ESN into file")
     ("res_size", po::value<unsigned int>(&_res_size)->default_value(10), "reservoir size")
     ("res_scaling", po::value<double>(&_res_scaling)->default_value(1.0), "reservoir input scaling")
@@ -187,19 +193,16 @@ void load_pomdp()
   // free pomdp
   if( _pomdp ) delete _pomdp;
   
-  // Read from file
-  // std::cout << "UNSERIALZE" << std::endl;
+  // Read from file (streaming, without DOM)
   std::ifstream pfile( *_filename_pomdp );
-  // Wrapper pour lire document
-  JSON::IStreamWrapper instream(pfile);
-  // Parse into a document
-  rj::Document read_doc;
-  read_doc.ParseStream( instream );
+  _pomdp = new Model::POMDP( pfile, "pomdp" );
   pfile.close();
-
-  _pomdp = new Model::POMDP( read_doc["pomdp"] );
 }
 // *************************************************************** gene_traj
+/**
+ * _nb_episode episodes of _length steps from state 0, with random actions.
+ * Episodes are simulated in parallel, each with its own random stream.
+ */
 void gene_traj()
 {
   std::ofstream* ofile = nullptr;
@@ -209,62 +212,61 @@ void gene_traj()
   
   // Generate seed
   unsigned int seed = utils::random::rnd_int<unsigned int>();
-  gsl_rng_set( _rnd, seed );
   
   // inform traj
   if( ofile ) {
     *ofile << "## \"pomdp_name\": \"" << *_filename_pomdp << "\"," << std::endl;
-    *ofile << "## \"seed\": " << seed << ", \"length\": " << _length << std::endl;
-      }
+    *ofile << "## \"seed\": " << seed << ", \"length\": " << _length;
+    *ofile << ", \"nb_episode\": " << _nb_episode << std::endl;
+  }
 
   // Generate
-  const std::vector<Model::Node>& list_action = _pomdp->actions();
-  // Current state, obs
-  unsigned int idx_state = _pomdp->cur_state()._id;
-  unsigned int idx_obs = _pomdp->cur_obs()._id;
-  for( unsigned int i = 0; i < _length; ++i) {
-    // random action
-    const Model::Node& act = list_action[gsl_rng_uniform_int( _rnd, list_action.size() )];
-
-    unsigned int idx_next_state = _pomdp->simul_trans( act )._id;
-    unsigned int idx_next_obs = _pomdp->simul_obs()._id;
-    double reward = _pomdp->cur_reward();
-    
-    // std::cout << idx_state << "\t" << idx_obs << "\t" << act._id << "\t" << idx_next_state << "\t" << idx_next_obs << "\t" << reward << std::endl;
+  Model::BatchSimulator simul( *_pomdp, seed );
+  Trajectory::POMDP::Data traj;
+  simul.run( _nb_episode, _length, 0 /* start_state */, traj, _nb_thread );
 
-    if( ofile ) {
-      *ofile << idx_state << "\t" << idx_obs << "\t" << act._id << "\t" << idx_next_state << "\t" << idx_next_obs << "\t" << reward << std::endl;
-    }
-    
-    idx_state = idx_next_state;
-    idx_obs = idx_next_obs;
+  if( ofile ) {
+    Model::BatchSimulator::write( *ofile, traj, _length );
+    delete ofile;
   }
-
-  if( ofile ) delete ofile;
 }
 // ***************************************************************** read_traj
+/**
+ * learn = tout sauf les _test_length derniers Item, test = ces derniers.
+ * Un fichier binaire est lu par mmap, sans copie ; un fichier texte est
+ * lu une fois dans _traj_data.
+ */
 void read_traj( const std::string& filename )
 {
-  std::ifstream ifile( filename );
-  Trajectory::POMDP::read( ifile, _traj_data);
-  ifile.close();
-
-  // Check that _traj_data size is bigger than _test_length
-  // before creating learn and test Data
-  if( _traj_data.size() >= _test_length ) {
-    _learn_data = Trajectory::POMDP::Data( _traj_data.begin(),
-					   _traj_data.end() - _test_length );
-    _test_data = Trajectory::POMDP::Data( _traj_data.end() - _test_length,
-					  _traj_data.end() );
-
-    //std::cout << "__READ_TRAJ : learn = " << _learn_data.size() << std::endl;
-    //std::cout << "              test  = " << _test_data.size() << std::endl;
+  bool binary = Trajectory::Binary::is_binary( filename );
+  size_t size;
+  if( binary ) {
+    size = Trajectory::POMDPStore( filename ).size();
   }
   else {
+    std::ifstream ifile( filename );
+    Trajectory::POMDP::read( ifile, _traj_data);
+    ifile.close();
+    size = _traj_data.size();
+  }
+
+  // Check that the trajectory is bigger than _test_length
+  // before creating learn and test Sources
+  if( size < _test_length ) {
     std::cerr << "__Read_Traj : error _test_length (" << _test_length << ")";
-    std::cerr << " > _traj_data.size() (" << _traj_data.size() << ")" << std::endl;
+    std::cerr << " > traj size (" << size << ")" << std::endl;
     exit(2);
   }
+  if( binary ) {
+    using Source = Trajectory::StoreSource<Trajectory::POMDPStore>;
+    _learn_src.reset( new Source( filename, 0, size - _test_length ));
+    _test_src.reset( new Source( filename, size - _test_length, size ));
+  }
+  else {
+    using Source = Trajectory::DataSource<Trajectory::POMDP::Data>;
+    _learn_src.reset( new Source( _traj_data, 0, size - _test_length ));
+    _test_src.reset( new Source( _traj_data, size - _test_length, size ));
+  }
 }
 // ****************************************************************** gene_esn
 void gene_esn( const std::string& filename,
@@ -400,7 +402,7 @@ void learn( double regul )
 {
   // Preparation des donnees d'apprentissage et de test
   _data.clear();
-  for( auto& item: _learn_data ) {
+  for( auto& item: *_learn_src ) {
     RidgeRegression::Tinput samp_in;//( _res->input_size()+_res->output_size()+1, 0.0 );
     //DEBUG std::cout << "samp_ini=" << utils::str_vec( samp_in ) << std::endl;
 	
@@ -505,7 +507,7 @@ void learn( double regul )
 std::vector<RidgeRegression::Toutput>
 predict( Reservoir& res,
 	 Layer& lay,
-	 const Trajectory::POMDP::Data& traj )
+	 Trajectory::POMDPSource& traj )
 {
   // un vecteur de output
   std::vector<RidgeRegression::Toutput> result;
@@ -640,7 +642,7 @@ int main( int argc, char *argv[] )
     // Prediction de la suite de la trajectoire
     if( _verb )
       std::cout << "___ predict()" << std::endl;
-    std::vector<RidgeRegression::Toutput> result_test = predict( *_res, *_lay, _test_data );
+    std::vector<RidgeRegression::Toutput> result_test = predict( *_res, *_lay, *_test_src );
     					 
     // // Premiere prediction a partir de l'etat du reseau appris
     // if( _verb ) 
@@ -699,7 +701,7 @@ int main( int argc, char *argv[] )
       ofile << std::endl;
       // Data
       idx_out = 0;
-      for( auto& item: _test_data ) { 
+      for( auto& item: *_test_src ) { 
 	// target
 	for( auto& var: target_from(item)) {
 	  ofile << var << "\t";
@@ -749,7 +751,7 @@ int main( int argc, char *argv[] )
       ofile << std::endl;
       // Data
       idx_out = 0;
-      for( auto& item: _learn_data ) { 
+      for( auto& item: *_learn_src ) { 
 	// target
 	for( auto& var: target_from(item)) {
 	  ofile << var << "\t";
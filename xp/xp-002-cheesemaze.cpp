@@ -2,13 +2,22 @@
 
 /** 
  * Generate Cheeze-Maze POMDP.
+ * With --map or --maze, generate a (large) gridworld POMDP instead
+ * (see pomdp/gridworld.hpp), stored sparse.
+ * With --solve, reference values: Perseus (point-based) and QMDP policies
+ * from a uniform belief.
  */
 
 #include <pomdp/pomdp.hpp>
+#include <pomdp/prog_dynamique.hpp>  // compute_Q
+#include <pomdp/point_based.hpp>     // Algorithms::PointBasedSolver
+#include <pomdp/gridworld.hpp>       // Model::make_gridworld
 
 #include <iostream>                // std::cout
 #include <fstream>                 // std::ofstream
 #include <string>                  // std::string
+#include <chrono>                  // std::chrono
+#include <cstdio>                  // sscanf
 #include "rapidjson/document.h"         // rapidjson's DOM-style API
 
 // Parsing command line options
@@ -25,6 +34,13 @@ using namespace utils::rj;
 double _proba;
 unsigned int _length;
 std::string*           _filename = nullptr;
+bool _solve = false;
+double _gamma;
+unsigned int _nb_belief;
+unsigned int _nb_thread;
+std::string*           _map_name = nullptr;
+unsigned int _maze_w = 0, _maze_h = 0;
+unsigned int _seed;
 void setup_options(int argc, char **argv)
 {
   po::options_description desc("Options");
@@ -33,6 +49,13 @@ void setup_options(int argc, char **argv)
     ("prob,p", po::value<double>(&_proba)->default_value(1.0), "Proba of successful transition ")
     ("length,l", po::value<unsigned int>(&_length)->default_value(1), "Corridor length") 
     ("file,f",  po::value<std::string>(), "Save into that file")
+    ("solve", "Solve with Perseus and QMDP")
+    ("gamma", po::value<double>(&_gamma)->default_value(0.95), "Discount factor for --solve")
+    ("nb_belief", po::value<unsigned int>(&_nb_belief)->default_value(500), "Nb of belief points for --solve")
+    ("nb_thread", po::value<unsigned int>(&_nb_thread)->default_value(1), "nb of threads for --solve")
+    ("map", po::value<std::string>(), "Gridworld from map file ('#' wall, 'G' goal)")
+    ("maze", po::value<std::string>(), "Random gridworld maze of WxH cells")
+    ("seed", po::value<unsigned int>(&_seed)->default_value(0), "Seed for --maze and --solve (0: random)")
     ;
 
   // Options en ligne de commande
@@ -59,6 +82,19 @@ void setup_options(int argc, char **argv)
   if (vm.count("file")) {
     _filename = new std::string(vm["file"].as< std::string>());
   }
+  if (vm.count("solve")) {
+    _solve = true;
+  }
+  if (vm.count("map")) {
+    _map_name = new std::string(vm["map"].as< std::string>());
+  }
+  if (vm.count("maze")) {
+    std::string size = vm["maze"].as< std::string>();
+    if( sscanf( size.c_str(), "%ux%u", &_maze_w, &_maze_h ) != 2 ) {
+      std::cerr << "--maze expects WxH, got " << size << std::endl;
+      exit(1);
+    }
+  }
 }
 // ********************************************************** make_cheese_maze
 Model::POMDP make_cheese_maze( const double prob_success = 1.0,
@@ -184,6 +220,43 @@ Model::POMDP make_cheese_maze( const double prob_success = 1.0,
   return pomdp;
 }
 
+// ********************************************************************* solve
+void solve( const Model::POMDP& pomdp, unsigned int seed )
+{
+  using Solver = Algorithms::PointBasedSolver;
+  Solver::Belief prior( pomdp._states.size(), 1.0 / pomdp._states.size() );
+
+  auto start = std::chrono::steady_clock::now();
+  Solver solver( pomdp, _gamma, Solver::Method::PERSEUS, _nb_thread );
+  solver.collect_beliefs( prior, _nb_belief, seed );
+  solver.solve( 1000, 1e-4, seed );
+  auto end = std::chrono::steady_clock::now();
+  std::cout << "*** Perseus: " << solver.get_beliefs().size() << " beliefs, ";
+  std::cout << solver.get_alphas().size() << " alpha, ";
+  std::cout << solver.get_nb_ite() << " ite in ";
+  std::cout << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+  // Expected return from a uniform belief (before the first observation)
+  unsigned int length = (unsigned int) (log( 1e-3 ) / log( _gamma )) + 1;
+  std::cout << "    return=" << solver.evaluate( prior, 1000, length, seed+1 ) << std::endl;
+
+  // QMDP : argmax_a sum_s b(s) Q(s,a)
+  Algorithms::TVal vQ = Algorithms::compute_Q( pomdp, _gamma, 1e-6 );
+  auto qmdp = [&vQ] (const Solver::Belief& b) {
+    unsigned int best = 0;
+    double best_q = std::numeric_limits<double>::lowest();
+    for( unsigned int a = 0; a < vQ[0].size(); ++a) {
+      double q = 0.0;
+      for( unsigned int s = 0; s < b.size(); ++s) q += b[s] * vQ[s][a];
+      if( q > best_q ) {
+        best_q = q;
+        best = a;
+      }
+    }
+    return best;
+  };
+  std::cout << "*** QMDP return=" << solver.evaluate( prior, 1000, length, seed+1, qmdp ) << std::endl;
+}
 //******************************************************************************
 int main( int argc, char *argv[] )
 {
@@ -194,8 +267,25 @@ int main( int argc, char *argv[] )
   
   setup_options( argc, argv );
   
+  if( _seed != 0 ) seed = _seed;
+
   Model::POMDP pomdp = make_cheese_maze( _proba, _length);
-  std::cout << pomdp.str_dump() << std::endl;
+  if( _map_name ) {
+    std::ifstream ifile( *_map_name );
+    pomdp = Model::make_gridworld( Model::read_map( ifile ), _proba );
+  }
+  else if( _maze_w > 0 ) {
+    pomdp = Model::make_gridworld( Model::make_maze( _maze_w, _maze_h, seed ), _proba );
+  }
+  // large models : only the sizes
+  if( pomdp._states.size() <= 100 ) {
+    std::cout << pomdp.str_dump() << std::endl;
+  }
+  else {
+    std::cout << "*** POMDP: " << pomdp._states.size() << " states, ";
+    std::cout << pomdp._obs.size() << " obs, ";
+    std::cout << pomdp._actions.size() << " actions" << std::endl;
+  }
 
   if( _filename ) {
     std::string fullname = *_filename + ".json";
@@ -209,5 +299,8 @@ int main( int argc, char *argv[] )
     ofile << str_obj(doc) << std::endl;
     ofile.close();
   }
+  if( _solve ) {
+    solve( pomdp, seed );
+  }
   return 0;
 }
@@ -28,7 +28,11 @@
 
 #include <hmm-json.hpp>
 #include <input.hpp>
+#include <hmm_table.hpp>
+#include <hmm_forward.hpp>
+#include <hmm_stat.hpp>
 #include <hmm_trajectory.hpp>
+#include <traj_store.hpp>          // Trajectory::HMMStore
 
 #include <reservoir.hpp>
 #include <layer.hpp>
@@ -51,12 +55,15 @@ using Problem = struct {
   bica::hmm::T t;
   bica::hmm::O o;
   unsigned int nb_states;
+  bica::hmm::Table table;         // T,O explicites, pour create_traj
 };
 std::unique_ptr<Problem> _pb = nullptr;
 
 // Trajectory
 using Traj = Trajectory::HMM::Data;
 std::unique_ptr<Traj>    _data = nullptr;
+// binary Traj, read in place (mmap) : no copy in _data
+std::unique_ptr<Trajectory::HMMStore> _store = nullptr;
 
 // ESN
 using PtrReservoir =   std::unique_ptr<Reservoir>;
@@ -98,6 +105,10 @@ std::unique_ptr<std::string> _opt_fileload_noise     = nullptr;
 double                       _opt_regul              = 1.0;
 unsigned int                 _opt_test_length        = 10;
 std::unique_ptr<std::string> _opt_file_result        = nullptr;
+std::unique_ptr<std::vector<std::string>> _opt_baseline = nullptr;
+unsigned int                 _opt_nb_thread          = 1;
+bool                         _opt_stat               = false;
+unsigned int                 _opt_stat_depth         = 10;
 std::unique_ptr<std::string> _opt_filesave_learned   = nullptr;
 bool                         _opt_graph              = false;
 bool                         _opt_verb               = false;
@@ -115,6 +126,8 @@ void setup_options(int argc, char **argv)
     ("create_hmm", po::value<std::string>(), "create an HMM from string")
     ("save_hmm", po::value<std::string>(), "save HMM in filename")
     ("load_hmm,m", po::value<std::string>(), "load HMM from filename")
+    ("stat", "print stationary distribution and entropy rates of HMM")
+    ("stat_depth", po::value<unsigned int>(&_opt_stat_depth)->default_value(_opt_stat_depth), "max length of O sequences for entropy bounds")
 
     ("length_traj", po::value<unsigned int>(&_opt_traj_length)->default_value(_opt_traj_length), "create a Traj with length")
     ("save_traj", po::value<std::string>(), "save Traj in filename")
@@ -139,6 +152,8 @@ void setup_options(int argc, char **argv)
     ("test_length,l", po::value<unsigned int>(&_opt_test_length)->default_value(_opt_test_length), "Length of test")
     
     ("output,o",  po::value<std::string>(), "Output file for results")
+    ("baseline", po::value<std::vector<std::string>>()->multitoken()->zero_tokens(), "Bayes predictor on Traj files (default: loaded Traj)")
+    ("nb_thread", po::value<unsigned int>(&_opt_nb_thread)->default_value(_opt_nb_thread), "nb of threads for baseline")
     ("save_learned,s",  po::value<std::string>(), "Save Resulting ESN")
     ("graph,g", "graphics" )
     ("verb,v", "verbose" )
@@ -212,6 +227,9 @@ void setup_options(int argc, char **argv)
   if (vm.count("output")) {
     _opt_file_result = make_unique<std::string>(vm["output"].as< std::string>());
   }
+  if (vm.count("baseline")) {
+    _opt_baseline = make_unique<std::vector<std::string>>(vm["baseline"].as< std::vector<std::string>>());
+  }
   // Save learned ESN
   if (vm.count("save_learned")) {
     _opt_filesave_learned = make_unique<std::string>(vm["save_learned"].as< std::string>());
@@ -227,6 +245,9 @@ void setup_options(int argc, char **argv)
   if( vm.count("verb") ) {
     _opt_verb = true;
   }
+  if( vm.count("stat") ) {
+    _opt_stat = true;
+  }
   if( vm.count("graph") ) {
     _opt_graph = true;
   }
@@ -243,9 +264,34 @@ Problem create_hmm( const std::string& expr = "ABCD" )
   auto hmm = bica::hmm::make(expr);
   std::tie(pb.t, pb.o) = hmm.first;
   pb.nb_states = hmm.second;
+  pb.table = bica::hmm::compile(expr);
 
   return pb;
 }
+// ****************************************************************** stat_hmm
+/**
+ * Statistiques analytiques du HMM (cf hmm_stat.hpp), pour choisir la
+ * longueur des trajectoires sans en générer.
+ */
+void stat_hmm( const Problem& pb, unsigned int depth )
+{
+  auto st = bica::hmm::stats( pb.table, depth );
+  std::cout << "## \"hmm_exp\": \"" << pb.expr << "\"," << std::endl;
+  std::cout << "pi     = " << utils::str_vec( st.pi ) << " (" << st.nb_ite << " ite)" << std::endl;
+  std::cout << "cesaro = " << st.cesaro << " steps (TV(freq(S), pi) < 0.01)" << std::endl;
+  std::cout << "h_S    = " << st.h_states << " bits/step" << std::endl;
+  std::cout << "H(pi)  = " << st.h_pi << " bits (>= predictive information)" << std::endl;
+  if( not st.discrete ) {
+    std::cout << "O not discrete (noise or *): no bounds on h_O" << std::endl;
+    return;
+  }
+  std::cout << "H(O)   = " << st.h_obs << " bits" << std::endl;
+  std::cout << "n\th_lower\th_upper\tE_lower" << std::endl;
+  for( unsigned int n = 0; n < st.h_upper.size() and n < st.h_lower.size(); ++n) {
+    std::cout << n+1 << "\t" << st.h_lower[n] << "\t" << st.h_upper[n];
+    std::cout << "\t" << st.e_lower[n] << std::endl;
+  }
+}
 // ****************************************************************** save_hmm
 void save_hmm( const std::string& filename, const std::string hmm_expr )
 {
@@ -289,15 +335,10 @@ void print_hmm(const std::string& name, bica::sampler::HMM& h, int nb)
 Traj create_traj( const unsigned int length, const Problem& pb )
 {
 
-  Traj traj;
-  // Sampler pour le HMM
-  bica::sampler::HMM hmm( pb.t, pb.o);
-
-  traj.clear();
-  for( unsigned int i = 0; i < length; ++i) {
-    traj.push_back( Trajectory::HMM::Item{ hmm.input_id(), hmm.input()} );
-    hmm.shift();
-  }
+  Traj traj( length );
+  // Sampler pour le HMM (tables), graine tirée de std::rand (cf --seed)
+  bica::sampler::TableHMM hmm( pb.table, std::rand() );
+  hmm.generate( length, traj.data() );
 
   return traj;
 };
@@ -306,16 +347,26 @@ void save_traj( const std::string& filename,
 		const Traj& data,
 		const std::string hmm_expr)
 {
-  auto ofile = std::ofstream( filename );
-
   // header
-  ofile << "## \"hmm_expr\": \"" << hmm_expr << "\"," << std::endl;
+  std::stringstream header;
+  header << "## \"hmm_expr\": \"" << hmm_expr << "\"," << std::endl;
+
+  // binary if filename ends with ".bin"
+  if( filename.size() > 4 and filename.compare( filename.size()-4, 4, ".bin" ) == 0 ) {
+    auto ofile = std::ofstream( filename, std::ios::binary );
+    Trajectory::HMMStore::write( ofile, data, header.str() );
+    ofile.close();
+    return;
+  }
+  auto ofile = std::ofstream( filename );
+  ofile << header.str();
 
   Trajectory::HMM::save( ofile, data );
   
   ofile.close();
 };
 // ***************************************************************** load_traj
+/** Text file only : a binary file is opened as a Trajectory::HMMStore */
 Traj load_traj( const std::string& filename )
 {
   Traj traj;
@@ -455,9 +506,10 @@ void push_noise( const ESN& esn,
 /**
  * Make LayerData : a sequence of [1.0; res->forward( [1.0; input] ) ]
  */
+template<typename TrajIterator>
 LayerData
-compute_lay_input( const Traj::iterator& it_traj_begin,
-		   const Traj::iterator& it_traj_end,
+compute_lay_input( const TrajIterator& it_traj_begin,
+		   const TrajIterator& it_traj_end,
 		   ESN& esn )
 {
   LayerData result;
@@ -484,11 +536,12 @@ compute_lay_input( const Traj::iterator& it_traj_begin,
 // ***************************************************************************
 // ********************************************************************* learn
 // ***************************************************************************
+template<typename TrajIterator>
 void learn( ESN& esn,
 	    const LayerData::iterator& it_input_begin,
 	    const LayerData::iterator& it_input_end,
-	    const Traj::iterator& it_target_begin,
-	    const Traj::iterator& it_target_end,
+	    const TrajIterator& it_target_begin,
+	    const TrajIterator& it_target_end,
 	    const double regul )
 {
   // learn data
@@ -618,8 +671,9 @@ void learn( ESN& esn,
 // ***************************************************************************
 // ******************************************************************* graph
 // ***************************************************************************
+template<typename TrajIterator>
 void graph( const std::string& title,
-	    const Traj::iterator& target_begin, const Traj::iterator& target_end,
+	    const TrajIterator& target_begin, const TrajIterator& target_end,
 	    const std::vector<RidgeRegression::Toutput>::iterator& out_begin,
 	    const std::vector<RidgeRegression::Toutput>::iterator& out_end,
 	    const unsigned int test_length )
@@ -662,6 +716,226 @@ void graph( const std::string& title,
   plot.show();
 }
 // ***************************************************************************
+// ****************************************************************** baseline
+/**
+ * Prédicteur bayésien optimal (forward sur les tables du HMM) sur chaque
+ * trajectoire de 'l_name' ("" : la Traj chargée), une par thread.
+ * Chaque thread ouvre ses trajectoires (binaire : lue en place), une
+ * seule à la fois.
+ * Résultats dans <output>_bayes (à côté de _learn et _test) ou sur cout.
+ */
+void baseline( const Problem& pb, const std::vector<std::string>& l_name )
+{
+  std::vector<std::string> l_traj = l_name;
+  if( l_traj.empty() and _opt_fileload_traj ) l_traj.push_back( *_opt_fileload_traj );
+  std::vector<bica::hmm::Baseline> l_res( l_traj.size() );
+  utils::parallel::for_range( 0, l_traj.size(), _opt_nb_thread,
+			      [&] (unsigned int begin, unsigned int end) {
+    for( unsigned int i = begin; i < end; ++i) {
+      if( Trajectory::Binary::is_binary( l_traj[i] )) {
+	Trajectory::HMMStore store( l_traj[i] );
+	l_res[i] = bica::hmm::evaluate( pb.table, store, _opt_test_length );
+      }
+      else {
+	l_res[i] = bica::hmm::evaluate( pb.table, load_traj( l_traj[i] ), _opt_test_length );
+      }
+    }
+  });
+
+  std::ofstream ofile;
+  if( _opt_file_result ) {
+    ofile.open( *_opt_file_result + "_bayes" );
+  }
+  std::ostream& os = _opt_file_result ? ofile : std::cout;
+  os << "## \"hmm_exp\": \"" << pb.expr << "\"," << std::endl;
+  os << "## \"test_length\": " << _opt_test_length << "," << std::endl;
+  os << "traj\tlength\tmse\tmse_test\tloglik\tacc_filter\tacc_viterbi" << std::endl;
+  for( unsigned int i = 0; i < l_res.size(); ++i) {
+    os << l_traj[i] << "\t" << l_res[i].length << "\t";
+    os << l_res[i].mse << "\t" << l_res[i].mse_test << "\t" << l_res[i].loglik << "\t";
+    os << l_res[i].acc_filter << "\t" << l_res[i].acc_viterbi << std::endl;
+  }
+  if( _opt_verb ) {
+    for( unsigned int i = 0; i < l_res.size(); ++i) {
+      std::cout << "  => Bayes " << l_traj[i] << " MSE=" << l_res[i].mse;
+      std::cout << "  MSE_test =" << l_res[i].mse_test << std::endl;
+    }
+  }
+}
+// ***************************************************************************
+// ***************************************************************** learn_esn
+// ***************************************************************************
+/** Learn, errors and results of the ESN on 'data' (Traj or HMMStore) */
+template<typename Data>
+void learn_esn( const Data& data )
+{
+  if( _opt_verb )
+    std::cout << "__LEARN" << std::endl;
+  if( _noise ) {
+    if( _opt_verb )
+      std::cout << "  + WNoise" << std::endl;
+    push_noise( *_esn, _noise->begin(), _noise->end() );
+  }
+  // Compute and save RES internal state (ie. layer input)
+  _data_lay_in = compute_lay_input( data.begin(), data.end(), *_esn );
+  // DEBUG
+  //std::cout << "       RES: " << _esn->res->str_display();
+  //std::cout << " LAY: " << _esn->lay->str_display() << std::endl;
+  learn( *_esn,
+         _data_lay_in.begin(), _data_lay_in.end()-1-_opt_test_length, // input
+         data.begin()+1, data.end()-_opt_test_length,             // target
+         _opt_regul );
+
+  // Save learned ESN
+  if( _opt_filesave_learned ) {
+    if( _opt_verb )
+      std::cout << "__SAVE Learned ESN to " << *_opt_filesave_learned << std::endl;
+    save_esn( *_opt_filesave_learned, *_esn);
+  }
+  
+  // Erreur d'apprentissage
+  std::vector<RidgeRegression::Toutput> result_learn;
+  for( const auto& pred_in: _data_lay_in) {
+    auto pred_out = _esn->lay->forward( pred_in );
+    //std::cout << "IN: " << utils::str_vec(pred_in);
+    //std::cout << " --> " << utils::str_vec(pred_out) << std::endl;
+    result_learn.push_back( pred_out );
+  }
+  // Compute squared_sum of weights : along the first row of weights
+  auto penalized_weights = 0.0;
+  auto lay_w = _esn->lay->weights();
+  for( unsigned int i = 1; i < lay_w->size2; ++i) {
+    penalized_weights += gsl_matrix_get( lay_w, 0, i) * gsl_matrix_get( lay_w, 0, i);
+  }
+  penalized_weights = penalized_weights * _opt_regul;
+  // Compute MSE for learning
+  auto idx_sample = 0;
+  auto mse_learn = 0.0;
+  for (auto it = data.begin()+1; it != data.end()-_opt_test_length; ++it) {
+    mse_learn += (it->id_o - result_learn[idx_sample][0])
+      * (it->id_o - result_learn[idx_sample][0]);
+    idx_sample++;
+  }
+  mse_learn = mse_learn / (data.size() - _opt_test_length );
+  // and testing
+  auto mse_test = 0.0;
+  // Keep going one with the next values of idx_sample
+  for (auto it = data.end()-_opt_test_length; it != data.end(); ++it) {
+    mse_test += (it->id_o - result_learn[idx_sample][0])
+      * (it->id_o - result_learn[idx_sample][0]);
+    idx_sample++;
+  }
+  mse_test = mse_test / (_opt_test_length);
+  if( _opt_verb ) {
+    std::cout << "  => MSE_learn =" << mse_learn;
+    std::cout << "  MSE_test =" << mse_test << std::endl;
+    std::cout << "  => PErr_learn=" << mse_learn+penalized_weights;
+    std::cout << "  PErr_test=" << mse_test+penalized_weights;
+    std::cout << "  PWeights= " << penalized_weights << std::endl;
+  }
+  
+  // to file ____________________
+  auto idx_out = 0;
+  //DEBUG
+  // for (auto it = data.begin(); it != data.end()-1; ++it) {
+  //   std::cout << "IN: " << data[idx_out].id_o ;
+  //   std::cout << " TAR: " << data[idx_out+1].id_o;
+  //   std::cout << " OUT: " << utils::str_vec(result_learn[idx_out]) << std::endl;
+
+  //   idx_out ++;
+  // }
+  if( _opt_file_result ) {
+     // Results on learn
+     std::stringstream filename_learn;
+     filename_learn << *_opt_file_result;
+     filename_learn << "_learn";
+     auto ofile = std::ofstream( filename_learn.str() );
+
+     // Header comments
+     ofile << "## \"hmm_exp\": \"" << _pb->expr << "\"," << std::endl;
+     ofile << "## \"traj_name\" : \"" << *_opt_fileload_traj << "\"," << std::endl;
+     ofile << "## \"esn_name\": \"" << *_opt_fileload_esn << "\"," << std::endl;
+     ofile << "## \"regul\": " << _opt_regul << "," << std::endl;
+     ofile << "## \"test_length\": " << _opt_test_length << "," << std::endl;
+     // Header ColNames
+     // target
+     for( unsigned int i = 0; i < _esn->lay->output_size(); ++i) {
+      ofile << "ta_" << i << "\t";
+     }
+     // after learn
+     for( unsigned int i = 0; i < _esn->lay->output_size(); ++i) {
+      ofile << "le_" << i << "\t";
+     }
+     ofile << std::endl;
+
+     // Data
+     idx_out = 0;
+     for (auto it = data.begin()+1; it != data.end()-_opt_test_length; ++it) {
+       // TAR
+       ofile << it->id_o << "\t";
+       // RES
+       for( auto& var: result_learn[idx_out]) {
+         ofile << var << "\t";
+       }
+       ofile << std::endl;
+       
+       idx_out++;
+     }
+       
+     ofile.close();
+
+     // Results on test
+     std::stringstream filename_test;
+     filename_test << *_opt_file_result;
+     filename_test << "_test";
+     ofile = std::ofstream( filename_test.str() );
+
+     // Header comments
+     ofile << "## \"hmm_exp\": \"" << _pb->expr << "\"," << std::endl;
+     ofile << "## \"traj_name\" : \"" << *_opt_fileload_traj << "\"," << std::endl;
+     ofile << "## \"esn_name\": \"" << *_opt_fileload_esn << "\"," << std::endl;
+     if( _opt_fileload_noise ) {
+       ofile << "## \"noise_name\": " << *_opt_fileload_noise << "," << std::endl;
+     }
+     ofile << "## \"regul\": " << _opt_regul << "," << std::endl;
+     ofile << "## \"test_length\": " << _opt_test_length << "," << std::endl;
+     // Header ColNames
+     // target
+     for( unsigned int i = 0; i < _esn->lay->output_size(); ++i) {
+      ofile << "ta_" << i << "\t";
+     }
+     // after learn
+     for( unsigned int i = 0; i < _esn->lay->output_size(); ++i) {
+      ofile << "le_" << i << "\t";
+     }
+     ofile << std::endl;
+
+     // Data
+     // Keep going one with the next values of idx_out
+     for (auto it = data.end()-_opt_test_length; it != data.end(); ++it) {
+       // TAR
+       ofile << it->id_o << "\t";
+       // RES
+       for( auto& var: result_learn[idx_out]) {
+         ofile << var << "\t";
+       }
+       ofile << std::endl;
+       
+       idx_out++;
+     }
+       
+     ofile.close();
+  }
+
+  // graphic
+  if( _opt_graph ) {
+    graph( "Predict O_{t+1} = f( h(o_i) )",
+           data.begin()+1, data.end(),
+           result_learn.begin(), result_learn.end(),
+           _opt_test_length );
+  }
+  
+}
 // ********************************************************************** test
 // ***************************************************************************
 void test()
@@ -731,6 +1005,9 @@ int main(int argc, char *argv[])
      if( _opt_verb )
        std::cout << "__" << _pb->expr << "__ with " << _pb->nb_states << " states" << std::endl;
    }
+   if( _pb and _opt_stat ) {
+     stat_hmm( *_pb, _opt_stat_depth );
+   }
    if( _pb and _opt_filesave_hmm ) {
      if( _opt_verb )
        std::cout << "__SAVE HMM to " << *_opt_filesave_hmm << std::endl;
@@ -749,7 +1026,10 @@ int main(int argc, char *argv[])
    if( _opt_fileload_traj ) {
      if( _opt_verb )
        std::cout << "__LOAD Traj from " << *_opt_fileload_traj << std::endl;
-     _data = make_unique<Traj>( load_traj( *_opt_fileload_traj ) );
+     if( Trajectory::Binary::is_binary( *_opt_fileload_traj ))
+       _store = make_unique<Trajectory::HMMStore>( *_opt_fileload_traj );
+     else
+       _data = make_unique<Traj>( load_traj( *_opt_fileload_traj ) );
    }
 
    // ESN ________________________
@@ -787,172 +1067,15 @@ int main(int argc, char *argv[])
    
   // Learn_________________________
   if( _opt_fileload_hmm and _opt_fileload_traj and _opt_fileload_esn ) {
-    if( _opt_verb )
-      std::cout << "__LEARN" << std::endl;
-    if( _noise ) {
-      if( _opt_verb )
-	std::cout << "  + WNoise" << std::endl;
-      push_noise( *_esn, _noise->begin(), _noise->end() );
-    }
-    // Compute and save RES internal state (ie. layer input)
-    _data_lay_in = compute_lay_input( _data->begin(), _data->end(), *_esn );
-    // DEBUG
-    //std::cout << "       RES: " << _esn->res->str_display();
-    //std::cout << " LAY: " << _esn->lay->str_display() << std::endl;
-    learn( *_esn,
-	   _data_lay_in.begin(), _data_lay_in.end()-1-_opt_test_length, // input
-	   _data->begin()+1, _data->end()-_opt_test_length,             // target
-	   _opt_regul );
-
-    // Save learned ESN
-    if( _opt_filesave_learned ) {
-      if( _opt_verb )
-	std::cout << "__SAVE Learned ESN to " << *_opt_filesave_learned << std::endl;
-      save_esn( *_opt_filesave_learned, *_esn);
-    }
-    
-    // Erreur d'apprentissage
-    std::vector<RidgeRegression::Toutput> result_learn;
-    for( const auto& pred_in: _data_lay_in) {
-      auto pred_out = _esn->lay->forward( pred_in );
-      //std::cout << "IN: " << utils::str_vec(pred_in);
-      //std::cout << " --> " << utils::str_vec(pred_out) << std::endl;
-      result_learn.push_back( pred_out );
-    }
-    // Compute squared_sum of weights : along the first row of weights
-    auto penalized_weights = 0.0;
-    auto lay_w = _esn->lay->weights();
-    for( unsigned int i = 1; i < lay_w->size2; ++i) {
-      penalized_weights += gsl_matrix_get( lay_w, 0, i) * gsl_matrix_get( lay_w, 0, i);
-    }
-    penalized_weights = penalized_weights * _opt_regul;
-    // Compute MSE for learning
-    auto idx_sample = 0;
-    auto mse_learn = 0.0;
-    for (auto it = _data->begin()+1; it != _data->end()-_opt_test_length; ++it) {
-      mse_learn += (it->id_o - result_learn[idx_sample][0])
-	* (it->id_o - result_learn[idx_sample][0]);
-      idx_sample++;
-    }
-    mse_learn = mse_learn / (_data->size() - _opt_test_length );
-    // and testing
-    auto mse_test = 0.0;
-    // Keep going one with the next values of idx_sample
-    for (auto it = _data->end()-_opt_test_length; it != _data->end(); ++it) {
-      mse_test += (it->id_o - result_learn[idx_sample][0])
-	* (it->id_o - result_learn[idx_sample][0]);
-      idx_sample++;
-    }
-    mse_test = mse_test / (_opt_test_length);
-    if( _opt_verb ) {
-      std::cout << "  => MSE_learn =" << mse_learn;
-      std::cout << "  MSE_test =" << mse_test << std::endl;
-      std::cout << "  => PErr_learn=" << mse_learn+penalized_weights;
-      std::cout << "  PErr_test=" << mse_test+penalized_weights;
-      std::cout << "  PWeights= " << penalized_weights << std::endl;
-    }
-    
-    // to file ____________________
-    auto idx_out = 0;
-    //DEBUG
-    // for (auto it = _data->begin(); it != _data->end()-1; ++it) {
-    //   std::cout << "IN: " << (*_data)[idx_out].id_o ;
-    //   std::cout << " TAR: " << (*_data)[idx_out+1].id_o;
-    //   std::cout << " OUT: " << utils::str_vec(result_learn[idx_out]) << std::endl;
-
-    //   idx_out ++;
-    // }
-    if( _opt_file_result ) {
-       // Results on learn
-       std::stringstream filename_learn;
-       filename_learn << *_opt_file_result;
-       filename_learn << "_learn";
-       auto ofile = std::ofstream( filename_learn.str() );
-
-       // Header comments
-       ofile << "## \"hmm_exp\": \"" << _pb->expr << "\"," << std::endl;
-       ofile << "## \"traj_name\" : \"" << *_opt_fileload_traj << "\"," << std::endl;
-       ofile << "## \"esn_name\": \"" << *_opt_fileload_esn << "\"," << std::endl;
-       ofile << "## \"regul\": " << _opt_regul << "," << std::endl;
-       ofile << "## \"test_length\": " << _opt_test_length << "," << std::endl;
-       // Header ColNames
-       // target
-       for( unsigned int i = 0; i < _esn->lay->output_size(); ++i) {
-     	ofile << "ta_" << i << "\t";
-       }
-       // after learn
-       for( unsigned int i = 0; i < _esn->lay->output_size(); ++i) {
-     	ofile << "le_" << i << "\t";
-       }
-       ofile << std::endl;
-
-       // Data
-       idx_out = 0;
-       for (auto it = _data->begin()+1; it != _data->end()-_opt_test_length; ++it) {
-	 // TAR
-	 ofile << it->id_o << "\t";
-	 // RES
-	 for( auto& var: result_learn[idx_out]) {
-	   ofile << var << "\t";
-	 }
-	 ofile << std::endl;
-	 
-	 idx_out++;
-       }
-	 
-       ofile.close();
-
-       // Results on test
-       std::stringstream filename_test;
-       filename_test << *_opt_file_result;
-       filename_test << "_test";
-       ofile = std::ofstream( filename_test.str() );
-
-       // Header comments
-       ofile << "## \"hmm_exp\": \"" << _pb->expr << "\"," << std::endl;
-       ofile << "## \"traj_name\" : \"" << *_opt_fileload_traj << "\"," << std::endl;
-       ofile << "## \"esn_name\": \"" << *_opt_fileload_esn << "\"," << std::endl;
-       if( _opt_fileload_noise ) {
-	 ofile << "## \"noise_name\": " << *_opt_fileload_noise << "," << std::endl;
-       }
-       ofile << "## \"regul\": " << _opt_regul << "," << std::endl;
-       ofile << "## \"test_length\": " << _opt_test_length << "," << std::endl;
-       // Header ColNames
-       // target
-       for( unsigned int i = 0; i < _esn->lay->output_size(); ++i) {
-     	ofile << "ta_" << i << "\t";
-       }
-       // after learn
-       for( unsigned int i = 0; i < _esn->lay->output_size(); ++i) {
-     	ofile << "le_" << i << "\t";
-       }
-       ofile << std::endl;
-
-       // Data
-       // Keep going one with the next values of idx_out
-       for (auto it = _data->end()-_opt_test_length; it != _data->end(); ++it) {
-	 // TAR
-	 ofile << it->id_o << "\t";
-	 // RES
-	 for( auto& var: result_learn[idx_out]) {
-	   ofile << var << "\t";
-	 }
-	 ofile << std::endl;
-	 
-	 idx_out++;
-       }
-	 
-       ofile.close();
-    }
+    if( _store ) learn_esn( *_store );
+    else learn_esn( *_data );
+  }
 
-    // graphic
-    if( _opt_graph ) {
-      graph( "Predict O_{t+1} = f( h(o_i) )",
-	     _data->begin()+1, _data->end(),
-	     result_learn.begin(), result_learn.end(),
-	     _opt_test_length );
-    }
-    
+  // Baseline______________________
+  if( _pb and _opt_baseline ) {
+    if( _opt_verb )
+      std::cout << "__BASELINE" << std::endl;
+    baseline( *_pb, *_opt_baseline );
   }
   
   return 0;
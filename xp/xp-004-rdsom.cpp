@@ -11,6 +11,9 @@
  *  - graphic
  *  - batch learning
  *  - batch testing with rdsom and traj
+ *  - block learning (--batch_size, --nb_thread)
+ *  - Traj read lazily (text or binary), or drawn on the fly from the HMM
+ *    (--generate): memory does not grow with learn_length
  *
  * INTERFACE
  *  - ESC : end
@@ -28,6 +31,7 @@
 #include <fstream>                 // std::ofstream
 #include <string>                  // std::string
 #include <sstream>                 // std::stringdtream
+#include <memory>                  // std::unique_ptr
 #include <rapidjson/document.h>    // rapidjson's DOM-style API
 #include <json_wrapper.hpp>        // JSON::IStreamWrapper
 #include <chrono>
@@ -36,10 +40,13 @@
 #include <hmm-json.hpp>
 #include <input.hpp>
 #include <hmm_trajectory.hpp>
+#include <traj_source.hpp>         // Trajectory::HMMSource
+#include <hmm_table.hpp>           // bica::sampler::TableSource
 #include <dsom/r_network.hpp>
 
 #include <window.hpp>
 #include <figure.hpp>
+#include <soft_window.hpp>          // SoftWindow, without display
 #include <fixedqueue.hpp>
 #include <dsom/rdsom1D_viewer.hpp>
 
@@ -71,24 +78,26 @@ std::unique_ptr<Problem> _pb = nullptr;
 // Iteration counter
 unsigned int _ite_cur = 0;
 
-// Trajectory
-using Traj = Trajectory::HMM::Data;
-std::unique_ptr<Traj>    _data = nullptr;
+// Trajectory, learning (looped over) and test (whole) sources
+using Traj = Trajectory::HMMSource;
+std::unique_ptr<Traj>    _learn_src = nullptr;
+std::unique_ptr<Traj>    _test_src = nullptr;
+std::string              _traj_name = "";
 
 // RDSOM
 using RDSOM = Model::DSOM::RNetwork;
 std::unique_ptr<RDSOM>     _rdsom;
 using TInput = Model::DSOM::RNeuron::TWeight;
 using TParam = Model::DSOM::RNeuron::TNumber;
-Traj::iterator _ite_step;
 
 // Log some errors and data
 // => updated in step_test
 std::vector<double> _v_in, _v_winner_w_in, _v_pred_winner_w, _v_err_input, _v_err_rec, _v_err_pred;     
 std::vector<unsigned int> _v_winner, _v_pred_winner;
 // => updated in step_learn
-std::vector<double> _vl_in, _vl_winner_w_in, _vl_pred_winner_w, _vl_err_input, _vl_err_rec, _vl_err_pred;
-std::vector<unsigned int> _vl_winner, _vl_pred_winner;
+// errors in learning, streamed to "_errors" file when open
+std::ofstream _vl_ofile;
+unsigned int _vl_idx = 0;
 
 // Graphic
 Window*                    _win_rdsom = nullptr;
@@ -129,6 +138,9 @@ unsigned int _learn_length_multiplier = 1;
 enum class TypeNet { SOM, DSOM };
 std::unique_ptr<std::string> _opt_fileload_hmm       = nullptr;
 std::unique_ptr<std::string> _opt_fileload_traj      = nullptr;
+bool                         _opt_generate           = false;
+uint64_t                     _opt_seed               = 0;
+unsigned int                 _opt_test_length        = 1000;
 int                          _opt_rdsom_size           = 10;
 std::unique_ptr<std::string> _opt_filesave_rdsom     = nullptr;
 std::unique_ptr<std::string> _opt_fileload_rdsom     = nullptr;
@@ -142,7 +154,14 @@ TParam                       _opt_sig_som            = 0.1;
 TParam                       _opt_eps                = 0.1;
 TParam                       _opt_ela                = 0.2;
 TParam                       _opt_ela_rec            = 0.2;
+TParam                       _opt_hn_eps             = 0.0;
+bool                         _opt_local_search       = false;
+int                          _opt_local_radius       = 10;
+unsigned int                 _opt_batch_size         = 1;
+unsigned int                 _opt_nb_thread          = 1;
+bool                         _opt_symbol_cache       = false;
 bool                         _opt_graph              = false;
+bool                         _opt_headless           = false;
 bool                         _opt_figerror           = false;
 unsigned int                 _opt_queue_size         = 5;
 unsigned int                 _opt_hist_size          = 50;
@@ -157,6 +176,17 @@ unsigned int                 _opt_seqlog_size        = 6;
 unsigned int                 _opt_seqlog_nb          = 10;
 
 // ******************************************************** forward references
+/** A Figure to save in a PNG file, with the Plotters it owns */
+struct FigureJob {
+  std::unique_ptr<Figure> fig;
+  std::vector<std::unique_ptr<Plotter>> plotters;
+  int width, height;
+  std::string filename;
+};
+void save_figures( std::vector<FigureJob>& jobs );
+FigureJob figseq_job( const std::string& filename );
+FigureJob figweight_job( const std::string& filename );
+FigureJob figerror_job( const std::string& filename );
 void save_figseq( const std::string& filename,
                   const std::string& title,
                   bool verb);
@@ -167,14 +197,12 @@ void save_figerror( const std::string& filename,
                     const std::string& title,
                     bool verb);
 void update_graphic();
-void learn( RDSOM& rdsom,
-	    const Traj::iterator& input_begin,
-	    const Traj::iterator& input_end);
+void learn( RDSOM& rdsom, Traj& traj );
 void step_learn( RDSOM& rdsom,
-		 const Traj::iterator::difference_type& length,
-		 const Traj::iterator& input_begin,
-		 const Traj::iterator& input_end,
+		 unsigned int length,
+		 Traj& traj,
                  const bool learning=true);
+void learn_batch( RDSOM& rdsom );
 std::string str_queue();
 // ***************************************************************************
 // ******************************************************************* options
@@ -186,6 +214,9 @@ void setup_options(int argc, char **argv)
     ("help,h", "produce help message")
     ("load_hmm,m", po::value<std::string>(), "load HMM from filename")
     ("load_traj,t", po::value<std::string>(), "load Traj from filename")
+    ("generate", "draw Traj on the fly from the HMM (no load_traj)")
+    ("seed", po::value<uint64_t>(&_opt_seed)->default_value(_opt_seed), "seed of generated Traj")
+    ("test_length", po::value<unsigned int>(&_opt_test_length)->default_value(_opt_test_length), "length of generated test Traj")
     ("rdsom_size", po::value<int>(&_opt_rdsom_size)->default_value(_opt_rdsom_size),"rdsom size")
     ("save_rdsom", po::value<std::string>(), "save RDSOM in filename")
     ("load_rdsom,d", po::value<std::string>(), "load RDSOM from filename")
@@ -198,7 +229,14 @@ void setup_options(int argc, char **argv)
     ("dsom_eps", po::value<TParam>(&_opt_eps)->default_value(_opt_eps), "dsom epsilon")
     ("dsom_ela", po::value<TParam>(&_opt_ela)->default_value(_opt_ela), "dsom elasticity")
     ("dsom_ela_rec", po::value<TParam>(&_opt_ela_rec)->default_value(_opt_ela_rec), "dsom elasticity recurrent")
+    ("hn_eps", po::value<TParam>(&_opt_hn_eps)->default_value(_opt_hn_eps), "neighbourhood coef under which neurons are not updated")
+    ("local_search", "search winner around predicted winner")
+    ("local_radius", po::value<int>(&_opt_local_radius)->default_value(_opt_local_radius), "max radius of local search before full scan")
+    ("batch_size", po::value<unsigned int>(&_opt_batch_size)->default_value(_opt_batch_size), "nb of steps learned as one block (1: online)")
+    ("nb_thread", po::value<unsigned int>(&_opt_nb_thread)->default_value(_opt_nb_thread), "nb of threads for block learning and headless figures")
+    ("symbol_cache", "cache input similarities and test steps of each input symbol")
     ("graph,g", "graphics" )
+    ("headless", "save figures without display (software rendering)")
     ("figerror", "fig with errors at end")
     ("queue_size", po::value<unsigned int>(&_opt_queue_size)->default_value(_opt_queue_size), "Length of Queue for Graph")
     ("history_size", po::value<unsigned int>(&_opt_hist_size)->default_value(_opt_hist_size), "Length of Queue for History")
@@ -249,6 +287,9 @@ void setup_options(int argc, char **argv)
   if (vm.count("load_traj")) {
     _opt_fileload_traj = make_unique<std::string>(vm["load_traj"].as< std::string>());
   }
+  if (vm.count("generate")) {
+    _opt_generate = true;
+  }
   // RDSOM
   if (vm.count("save_rdsom")) {
     _opt_filesave_rdsom = make_unique<std::string>(vm["save_rdsom"].as< std::string>());
@@ -278,9 +319,23 @@ void setup_options(int argc, char **argv)
   if( vm.count("graph") ) {
     _opt_graph = true;
   }
+  // without display, figures are rendered by the CPU
+  if( vm.count("headless") or not Window::has_display() ) {
+    _opt_headless = true;
+    if( _opt_graph ) {
+      std::cerr << "No display : --graph ignored" << std::endl;
+      _opt_graph = false;
+    }
+  }
   if( vm.count("figerror") ) {
     _opt_figerror = true;
   }
+  if( vm.count("local_search") ) {
+    _opt_local_search = true;
+  }
+  if( vm.count("symbol_cache") ) {
+    _opt_symbol_cache = true;
+  }
   
   if( vm.count("testing") ) {
     _opt_test = true;
@@ -313,22 +368,20 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
   //     if( _opt_verb ) {
   // 	std::cout << "__LEARN" << std::endl;
   //     }
-  //     learn( *_rdsom, _data->begin(), _data->end() );
-  //     _nb_step += _data->size();
+  //     learn( *_rdsom, *_learn_src );
 
   //     update_graphic();
   //   }
   // }
   // Run 'n' learning steps
   else if (key == GLFW_KEY_S && action == GLFW_PRESS) {
-    if( _opt_fileload_traj and _opt_fileload_rdsom ) {
+    if( _learn_src and _opt_fileload_rdsom ) {
       // if( _opt_verb ) {
       // 	std::cout << "__STEP" << std::endl;
       // }
       auto learn_length = _opt_queue_size * _learn_length_multiplier;
       if( learn_length == 0 ) learn_length = 1;
-      step_learn( *_rdsom, learn_length,
-		  _data->begin(), _data->end(),
+      step_learn( *_rdsom, learn_length, *_learn_src,
                   (!_opt_test) );
       _ite_cur += learn_length;
       
@@ -386,9 +439,11 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
     std::stringstream count;
     count << std::setw(6) << std::setfill('0') <<  _ite_cur << ".png";
     
-    save_figseq( "key_figseq"+count.str(), "KEY figseq", false);
-    save_figweight( "key_figweight"+count.str(), "KEY figweight", false);
-    save_figerror( "key_figerror"+count.str(), "KEY figerror", false);
+    std::vector<FigureJob> jobs;
+    jobs.push_back( figseq_job( "key_figseq"+count.str() ));
+    jobs.push_back( figweight_job( "key_figweight"+count.str() ));
+    jobs.push_back( figerror_job( "key_figerror"+count.str() ));
+    save_figures( jobs );
   }
 }
 // ************************************************************ update_graphic
@@ -460,19 +515,20 @@ Problem load_hmm( const std::string& filename )
   auto expr = bica::hmm::unserialize( read_doc["hmm"] );
   return create_hmm( expr );
 }
-// ***************************************************************** load_traj
-Traj load_traj( const std::string& filename )
+// ***************************************************************** open_traj
+/**
+ * Items are read when needed: text file line by line, binary file
+ * through mmap (cf traj_source.hpp).
+ */
+std::unique_ptr<Traj> open_traj( const std::string& filename )
 {
-  Traj traj;
-  auto pfile = std::ifstream( filename );
-  if( pfile.fail() ) {
-    std::cout << "load_traj: NOT FOUND " << filename << std::endl;
+  try {
+    return Trajectory::open_hmm( filename );
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "open_traj: " << e.what() << std::endl;
     exit(1);
   }
-  Trajectory::HMM::read( pfile, traj );
-  pfile.close();
-
-  return traj;
 }
 // ************************************************************** create_rdsom
 RDSOM create_rdsom(int input_dim=1, int rdsom_size=10, int rdsom_nb_link=-1,
@@ -539,15 +595,64 @@ void save_seqlog( const std::string& filename, const SequenceMap& smap )
   ofile.close();
 }
 
+// ***************************************************************************
+// ************************************************************** save_figures
+// ***************************************************************************
+/**
+ * Render each Figure (created without Window) in its PNG file : reused
+ * offscreen Window, written in the background, or SoftWindow if headless,
+ * _opt_nb_thread Figures at a time.
+ */
+void save_figures( std::vector<FigureJob>& jobs )
+{
+  if( _opt_headless ) {
+    std::vector<std::unique_ptr<SoftWindow>> wins;
+    std::vector<SoftWindow::Job> soft_jobs;
+    for( auto& job: jobs ) {
+      wins.emplace_back( new SoftWindow( job.width, job.height ) );
+      wins.back()->add_plotter( job.fig.get() );
+      soft_jobs.push_back( {wins.back().get(), job.filename} );
+    }
+    if( not SoftWindow::render_all( soft_jobs, _opt_nb_thread ) ) {
+      std::cerr << "ERROR: some figures could not be saved" << std::endl;
+    }
+  }
+  else {
+    for( auto& job: jobs ) {
+      Window& win = Window::offscreen( job.width, job.height );
+      job.fig->set_font( win._font );
+      win.add_plotter( job.fig.get() );
+      win.update_bbox();
+      win.render();
+      win.save( job.filename, true /*deferred*/ );
+      // 'job.fig' does not outlive the job
+      win.clear_plotters();
+    }
+  }
+}
+void save_figure( FigureJob&& job )
+{
+  std::vector<FigureJob> jobs;
+  jobs.push_back( std::move( job ) );
+  save_figures( jobs );
+}
 // ***************************************************************************
 // *************************************************************** save_figseq
 // ***************************************************************************
 /**
- * Save a PNJ image of the last _opt_queue_size neurons, using circles and
+ * PNJ image of the last _opt_queue_size neurons, using circles and
  * arrows on a nearly cirle for linear position of neurons.
  *
  * GLOBAL : _rdsom, _winner_queue
  */
+FigureJob figseq_job( const std::string& filename )
+{
+  FigureJob job{ std::unique_ptr<Figure>( new Figure() ), {}, 450, 450, filename };
+  job.plotters.emplace_back( new RDSOMViewer( *_rdsom, *_winner_queue ) );
+  job.fig->add_plotter( job.plotters.back().get() );
+  job.fig->set_draw_axes( false );
+  return job;
+}
 void save_figseq( const std::string& filename,
                   const std::string& title,
                   bool verb)
@@ -556,44 +661,26 @@ void save_figseq( const std::string& filename,
   if( verb ) {
     std::cout << "  Saving PNG file=" << filename << std::endl;
   }
-
-  Window* win_rdsom = new Window( title, 450, 450, true /*offscreen */ );
-  Figure* fig_rdsom = new Figure( *win_rdsom );
-  win_rdsom->add_plotter( fig_rdsom );
-  
-  RDSOMViewer* rdsom_viewer = new RDSOMViewer( *_rdsom, *_winner_queue );
-  fig_rdsom->add_plotter( rdsom_viewer );
-  fig_rdsom->set_draw_axes( false );
-  
-  win_rdsom->update_bbox();
-  win_rdsom->render();
-  // std::this_thread::sleep_for(std::chrono::seconds(1));
-  win_rdsom->save( filename );
-  // std::this_thread::sleep_for(std::chrono::seconds(5));
-  delete rdsom_viewer;
-  delete fig_rdsom;
-  delete win_rdsom;
-
+  save_figure( figseq_job( filename ));
 }
 /**
- * Save a PNJ image of the weights, input (black) and recurrent (blue).
+ * PNJ image of the weights, input (black) and recurrent (blue).
  *
  * GLOBAL : _rdsom
  */
-void save_figweight( const std::string& filename,
-                     const std::string& title,
-                     bool verb)
+FigureJob figweight_job( const std::string& filename )
 {
-  Window* win_weight = new Window( title, 800, 350, true /*offscreen*/, 800, 50 );
-  Figure* fig_weight = new Figure( *win_weight, "",
-                                   {0.0, (double) _rdsom->v_neur.size(),10,2},
-                                   {0.0, 1.0, 10, 2} );
-  win_weight->add_plotter( fig_weight );
-  
+  FigureJob job{ std::unique_ptr<Figure>(
+                   new Figure( "",
+                               {0.0, (double) _rdsom->v_neur.size(),10,2},
+                               {0.0, 1.0, 10, 2} )),
+                 {}, 800, 350, filename };
   Curve* c_weight = new Curve();
+  job.plotters.emplace_back( c_weight );
   c_weight->set_color( {0.0, 0.0, 0.0} );
   c_weight->set_width( 1 );
   Curve* c_rweight = new Curve();
+  job.plotters.emplace_back( c_rweight );
   c_rweight->set_color( {0.0, 0.0, 1.0} );
   c_rweight->set_width( 1 );
   for( unsigned int i = 0; i < _rdsom->v_neur.size(); ++i) {
@@ -601,72 +688,51 @@ void save_figweight( const std::string& filename,
     c_rweight->add_sample( {(double)i, _rdsom->v_neur[i]->r_weights(0), 0.0} ); 
   }
 
-  fig_weight->add_plotter( c_weight );
-  fig_weight->add_plotter( c_rweight );
-
-  win_weight->update_bbox();
-  win_weight->render();
-  win_weight->save( filename );
-
-  delete c_weight;
-  delete c_rweight;
-  delete fig_weight;
-  delete win_weight;
+  job.fig->add_plotter( c_weight );
+  job.fig->add_plotter( c_rweight );
+  return job;
+}
+void save_figweight( const std::string& filename,
+                     const std::string& title,
+                     bool verb)
+{
+  save_figure( figweight_job( filename ));
 }
 /**
- * Save a PNJ image of errors: input (black), recurrent (blue), pred(red).
+ * PNJ image of errors: input (black), recurrent (blue), pred(red).
  *
- * GLOBAL : _rdsom, _c_error_input, _c_error_rec, _c_error_pred
+ * GLOBAL : _c_error_input, _c_error_rec, _c_error_pred
  */
+FigureJob figerror_job( const std::string& filename )
+{
+  FigureJob job{ std::unique_ptr<Figure>(
+                   new Figure( "",
+                               {0.0, 100 ,10,2},
+                               {0.0, 1.2, 10, 2} )),
+                 {}, 800, 350, filename };
+  for( CurveMean* c_error: {_c_error_input, _c_error_rec, _c_error_pred} ) {
+    CurveMean* c_copy = new CurveMean( *c_error );
+    job.plotters.emplace_back( c_copy );
+    if( c_copy->get_mean_mode() == false ) {
+      c_copy->set_mean_mode( true );
+      c_copy->recompute_means();
+    }
+    job.fig->add_plotter( c_copy );
+  }
+  return job;
+}
 void save_figerror( const std::string& filename,
                     const std::string& title,
                     bool verb)
 {
-  Window* win_error = new Window( title, 800, 350, true /*offscreen*/, 400, 430 );
-  Figure* fig_error = new Figure( *win_error, "",
-                                  {0.0, 100 ,10,2},
-                                  {0.0, 1.2, 10, 2});
-  win_error->add_plotter( fig_error );
-
-  CurveMean* c_error_input = new CurveMean( *_c_error_input );
-  if( c_error_input->get_mean_mode() == false ) {
-    c_error_input->set_mean_mode( true );
-    c_error_input->recompute_means();
-  }
-  CurveMean* c_error_rec = new CurveMean( *_c_error_rec );
-  if( c_error_rec->get_mean_mode() == false ) {
-    c_error_rec->set_mean_mode( true );
-    c_error_rec->recompute_means();
-  }
-  CurveMean* c_error_pred = new CurveMean( *_c_error_pred );
-  if( c_error_pred->get_mean_mode() == false ) {
-    c_error_pred->set_mean_mode( true );
-    c_error_pred->recompute_means();
-  }
-  
-  fig_error->add_plotter( c_error_input );
-  fig_error->add_plotter( c_error_rec );
-  fig_error->add_plotter( c_error_pred );
-
-  win_error->update_bbox();
-  win_error->render();
-  // std::this_thread::sleep_for(std::chrono::seconds(1));
-  win_error->save( filename );
-  // std::this_thread::sleep_for(std::chrono::seconds(5));
-  delete c_error_input;
-  delete c_error_rec;
-  delete c_error_pred;
-  delete fig_error;
-  delete win_error;
+  save_figure( figerror_job( filename ));
 }
 // ***************************************************************************
 // ********************************************************************* learn
 // ***************************************************************************
-void learn( RDSOM& rdsom,
-            const Traj::iterator& input_begin,
-            const Traj::iterator& input_end)
+void learn( RDSOM& rdsom, Traj& traj )
 {
-  for( auto it = input_begin; it != input_end; ++it ) {
+  for( auto it = traj.begin(); it != traj.end(); ++it ) {
     // Forward new input and update network
     Eigen::VectorXd input(1);
     input << (double) it->id_o;
@@ -695,28 +761,27 @@ void learn( RDSOM& rdsom,
 }
 /**
  * step_learn: (usually called before graphic update)
- * learns with 'length' learning data considered as a circular array,
- * begin at '_ite_step' and come back to 'input_start' after 'input_end'. 
- *
- * :Global: : _ite_step, iterator on the learning data.
+ * learns with the 'length' next items of 'traj', which restarts from
+ * its beginning when exhausted (circular).
  *
  * Can be used to test without learning
  */
 void step_learn( RDSOM& rdsom,
-		 const Traj::iterator::difference_type& length,
-		 const Traj::iterator& input_start,
-		 const Traj::iterator& input_end,
+		 unsigned int length,
+		 Traj& traj,
                  const bool learning )
 {
+  Trajectory::HMM::Item item;
+
   // DEBUG
   FixedQueue<unsigned int>  winqueue(_opt_seqlog_size);
   _seqmap_learn.clear();
   // DEBUG
   
-  for( unsigned int i = 0; i < length; ++i) {
+  for( unsigned int i = 0; i < length and traj.next_loop( item ); ++i) {
     // Forward new input and update network
     Eigen::VectorXd input(1);
-    input << (double) _ite_step->id_o;
+    input << (double) item.id_o;
     if( _opt_verb ) {
       std::cout << "__STEP LEARN _nb_step=" << _nb_step;
       std::cout << " learning=" << learning << std::endl;
@@ -728,7 +793,13 @@ void step_learn( RDSOM& rdsom,
       if (_opt_verb) {
         std::cout << "  should learn" << std::endl;
       }
-      if (_opt_typenet == TypeNet::DSOM) {
+      if (_opt_batch_size > 1) {
+        rdsom.batch_push( input );
+        if (rdsom.batch_size() >= _opt_batch_size) {
+          learn_batch( rdsom );
+        }
+      }
+      else if (_opt_typenet == TypeNet::DSOM) {
         rdsom.deltaW( input, _opt_eps, _opt_ela, _opt_ela_rec, _opt_verb);
       }
       else {
@@ -761,20 +832,13 @@ void step_learn( RDSOM& rdsom,
       _c_error_pred->add_sample( {(double)_nb_step, rdsom.get_winner_dist_pred(), 0.0} );
     }
     // Add errors to log
-    _vl_in.push_back( (double) _ite_step->id_o );
-    _vl_winner.push_back( rdsom.get_winner() );
-    _vl_winner_w_in.push_back( rdsom.v_neur[rdsom.get_winner()]->weights[0] );
-    _vl_pred_winner.push_back( rdsom.get_pred_winner() );
-    _vl_pred_winner_w.push_back( rdsom.v_neur[rdsom.get_pred_winner()]->weights[0] );
-    _vl_err_input.push_back( rdsom.get_winner_dist_input() );
-    _vl_err_rec.push_back( rdsom.get_winner_dist_rec() );
-    _vl_err_pred.push_back( rdsom.get_winner_dist_pred() );
-    
-    // update iterator
-    ++ _ite_step;
-    if( _ite_step == input_end ) {
-      _ite_step = input_start;
+    if( _vl_ofile.is_open() ) {
+      _vl_ofile << _vl_idx++ << "\t";
+      _vl_ofile << rdsom.get_winner_dist_input() << "\t";
+      _vl_ofile << rdsom.get_winner_dist_rec() << "\t";
+      _vl_ofile << rdsom.get_winner_dist_pred() << "\n";
     }
+    
     // update nb step
     ++ _nb_step;
 
@@ -782,6 +846,23 @@ void step_learn( RDSOM& rdsom,
       std::cout << str_queue() << std::endl;
     }
   }
+  // learn what remains of the block
+  if( learning ) {
+    learn_batch( rdsom );
+  }
+}
+/**
+ * learn_batch: learn the steps stored in rdsom as one block
+ * (mean of the deltas : same _opt_eps as online learning)
+ */
+void learn_batch( RDSOM& rdsom )
+{
+  if (_opt_typenet == TypeNet::DSOM) {
+    rdsom.deltaWBatch( _opt_eps, _opt_ela, _opt_ela_rec, _opt_nb_thread );
+  }
+  else {
+    rdsom.deltaWSOMBatch( _opt_eps, _opt_sig_som, _opt_nb_thread );
+  }
 }
 /**
  * step_test:
@@ -791,9 +872,7 @@ void step_learn( RDSOM& rdsom,
  *      increase sequence frequency in map
  * output first _opt_seqlog_nb frequence sequences
  */
-void step_test( RDSOM& rdsom,
-		const Traj::iterator& input_start,
-		const Traj::iterator& input_end)
+void step_test( RDSOM& rdsom, Traj& traj )
 {
   // Model::DSOM::RNetwork::TNumber err_input = 0;
   // Model::DSOM::RNetwork::TNumber err_rec = 0;
@@ -805,7 +884,7 @@ void step_test( RDSOM& rdsom,
   if( _opt_verb ) {
     std::cout << "__STEP TEST " << std::endl;
   }
-  for (auto it = input_start; it != input_end; ++it) {
+  for (auto it = traj.begin(); it != traj.end(); ++it) {
     // Forward new input BUT do not update network
     Eigen::VectorXd input(1);
     input << (double) it->id_o;
@@ -898,12 +977,28 @@ int main(int argc, char *argv[])
   // Traj_______________________
   if( _opt_fileload_traj ) {
     if( _opt_verb )
-      std::cout << "__LOAD Traj from " << *_opt_fileload_traj << std::endl;
-    _data = make_unique<Traj>( load_traj( *_opt_fileload_traj ) );
-    _ite_step = _data->begin();
+      std::cout << "__OPEN Traj from " << *_opt_fileload_traj << std::endl;
+    _learn_src = open_traj( *_opt_fileload_traj );
+    _test_src = open_traj( *_opt_fileload_traj );
+    _traj_name = *_opt_fileload_traj;
     _nb_step = 0;
+  }
+  else if( _opt_generate ) {
+    if( not _pb ) {
+      std::cerr << "--generate needs an HMM (--load_hmm)" << std::endl;
+      exit(1);
+    }
     if( _opt_verb )
-      std::cout << "  data read" << std::endl;
+      std::cout << "__GENERATE Traj with seed=" << _opt_seed << std::endl;
+    // endless stream (seed,0) for learning, test on (seed,1)
+    auto table = bica::hmm::compile( _pb->expr );
+    _learn_src = make_unique<bica::sampler::TableSource>( table, _opt_seed, 0 );
+    _test_src = make_unique<bica::sampler::TableSource>( table, _opt_seed, 1,
+                                                         _opt_test_length );
+    std::stringstream name;
+    name << "hmm:" << _pb->expr << " seed=" << _opt_seed;
+    _traj_name = name.str();
+    _nb_step = 0;
   }
   // RDSOM _____________________
   if( _opt_filesave_rdsom ) {
@@ -919,6 +1014,9 @@ int main(int argc, char *argv[])
     if( _opt_verb )
       std::cout << "__LOAD RDSOM from " << *_opt_fileload_rdsom << std::endl;
     _rdsom = make_unique<RDSOM>( load_rdsom( *_opt_fileload_rdsom ));
+    _rdsom->set_hn_epsilon( _opt_hn_eps );
+    _rdsom->set_local_search( _opt_local_search, _opt_local_radius );
+    _rdsom->set_symbol_cache( _opt_symbol_cache );
      
     // test
     if( _opt_verb )
@@ -1046,8 +1144,7 @@ int main(int argc, char *argv[])
       if( _run_update ) {
         auto learn_length = _opt_queue_size * _learn_length_multiplier;
         if( learn_length == 0 ) learn_length = 1;
-        step_learn( *_rdsom, learn_length,
-                    _data->begin(), _data->end(),
+        step_learn( *_rdsom, learn_length, *_learn_src,
                     (!_opt_test) /*learning*/ );
         _ite_cur += learn_length;
 
@@ -1080,18 +1177,32 @@ int main(int argc, char *argv[])
     save_figweight( *_opt_filesave_result+"_figweight_"+count.str(),
                     "FigWeight", false );
 
-    // clean logs for error in learning
-    _vl_in.clear();
-    _vl_winner.clear();
-    _vl_winner_w_in.clear();
-    _vl_pred_winner.clear();
-    _vl_pred_winner_w.clear();
-    _vl_err_input.clear();
-    _vl_err_rec.clear();
-    _vl_err_pred.clear();
+    // errors in learning are streamed to file
+    std::stringstream filename_error;
+    filename_error << *_opt_filesave_result;
+    filename_error << "_errors";
+    _vl_ofile.open( filename_error.str() );
+
+    // Header comments
+    _vl_ofile << "## \"traj_name\" : \"" << _traj_name << "\"," << std::endl;
+    _vl_ofile << "## \"rdsom_name\": \"" << *_opt_fileload_rdsom << "\"," << std::endl;
+    _vl_ofile << "## \"typenet\": \"" << *_opt_typenet_str << "\"," << std::endl;
+    // @todo: parameters
+    _vl_ofile << "## \"beta\"; \"" << _opt_beta << "\"," << std::endl;
+    _vl_ofile << "## \"sigma_input\"; \"" << _opt_sig_input << "\"," << std::endl;
+    _vl_ofile << "## \"sigma_recur\"; \"" << _opt_sig_recur << "\"," << std::endl;
+    _vl_ofile << "## \"sigma_convo\"; \"" << _opt_sig_convo << "\"," << std::endl;
+    _vl_ofile << "## \"epsilon\"; \"" << _opt_eps << "\"," << std::endl;
+    _vl_ofile << "## \"ela_input\"; \"" << _opt_ela << "\"," << std::endl;
+    _vl_ofile << "## \"ela_rec\"; \"" << _opt_ela_rec << "\"," << std::endl;
+    _vl_ofile << "## \"sig_som\"; \"" << _opt_sig_som << "\"," << std::endl;
+    _vl_ofile << "## \"hn_eps\"; \"" << _opt_hn_eps << "\"," << std::endl;
+    _vl_ofile << "## \"batch_size\"; \"" << _opt_batch_size << "\"," << std::endl;
+    // Header col names
+    _vl_ofile << "ite\terr_in\terr_rec\terr_pred" << std::endl;
+    _vl_idx = 0;
     while( _ite_cur < _opt_learn_length ) {
-      step_learn( *_rdsom, _opt_period_save,
-                  _data->begin(), _data->end(),
+      step_learn( *_rdsom, _opt_period_save, *_learn_src,
                   true /* learning */ );
 	   
       _ite_cur += _opt_period_save;
@@ -1099,7 +1210,7 @@ int main(int argc, char *argv[])
       // Test a copy of rdsom on all data
       RDSOM tmp_rdsom{ *_rdsom };
       tmp_rdsom.reset();
-      step_test( tmp_rdsom, _data->begin(), _data->end() );
+      step_test( tmp_rdsom, *_test_src );
 	   
       std::cout << "  IT=" << _ite_cur << ", saving..." << std::endl;
       // std::cout << "  err_in=" << _v_err_input.back() << std::endl;
@@ -1137,37 +1248,9 @@ int main(int argc, char *argv[])
       // 	// Some kind of criteria
     }
 
-    // At the end, save errors
+    // At the end, errors are saved
     std::cout << "  END IT=" << _ite_cur << ", saving..." << std::endl;
-    std::stringstream filename_error;
-    filename_error << *_opt_filesave_result;
-    filename_error << "_errors";
-    auto ofile = std::ofstream( filename_error.str() );
-	 
-    // Header comments
-    ofile << "## \"traj_name\" : \"" << *_opt_fileload_traj << "\"," << std::endl;
-    ofile << "## \"rdsom_name\": \"" << *_opt_fileload_rdsom << "\"," << std::endl;
-    ofile << "## \"typenet\": \"" << *_opt_typenet_str << "\"," << std::endl;
-    // @todo: parameters
-    ofile << "## \"beta\"; \"" << _opt_beta << "\"," << std::endl;
-    ofile << "## \"sigma_input\"; \"" << _opt_sig_input << "\"," << std::endl;
-    ofile << "## \"sigma_recur\"; \"" << _opt_sig_recur << "\"," << std::endl;
-    ofile << "## \"sigma_convo\"; \"" << _opt_sig_convo << "\"," << std::endl;
-    ofile << "## \"epsilon\"; \"" << _opt_eps << "\"," << std::endl;
-    ofile << "## \"ela_input\"; \"" << _opt_ela << "\"," << std::endl;
-    ofile << "## \"ela_rec\"; \"" << _opt_ela_rec << "\"," << std::endl;
-    ofile << "## \"sig_som\"; \"" << _opt_sig_som << "\"," << std::endl;
-    // Header col names
-    ofile << "ite\terr_in\terr_rec\terr_pred" << std::endl;
-    // Data
-    _ite_cur = 0;
-    for( unsigned int idx = 0; idx < _vl_in.size(); ++idx) {
-        ofile << idx << "\t";
-        ofile << _vl_err_input[idx] << "\t";
-        ofile << _vl_err_rec[idx] << "\t";
-        ofile << _vl_err_pred[idx];
-        ofile << std::endl;
-      }  
+    _vl_ofile.close();
     // while( _ite_cur < _opt_learn_length ) {
     //   _ite_cur += _opt_period_save;
     //   std::cout << "__SAVING for ite="<< _ite_cur << " idx=" << idx << std::endl;
@@ -1179,7 +1262,6 @@ int main(int argc, char *argv[])
        
     //   ++idx;
     // }
-    ofile.close();
 
     // Seqlog most frequent
      
@@ -1188,13 +1270,16 @@ int main(int argc, char *argv[])
     // Fig with weights is saved at start
     std::stringstream count_end;
     count_end << std::setw(6) << std::setfill('0') <<  _ite_cur << ".png";
-    save_figweight( *_opt_filesave_result+"_figweight_"+count_end.str(),
-                    "FigWeight", false );
-    save_figseq( *_opt_filesave_result+"_figseq_"+count_end.str(),
-                 "FigSeq", false );
-    save_figerror( *_opt_filesave_result+"_figerror_"+count_end.str(),
-                   "FigError", false );
-
+    std::vector<FigureJob> jobs;
+    jobs.push_back( figweight_job( *_opt_filesave_result+"_figweight_"+count_end.str() ));
+    jobs.push_back( figseq_job( *_opt_filesave_result+"_figseq_"+count_end.str() ));
+    jobs.push_back( figerror_job( *_opt_filesave_result+"_figerror_"+count_end.str() ));
+    save_figures( jobs );
+
+    if( _opt_local_search ) {
+      std::cout << "  local search hit rate=" << _rdsom->get_local_hit_rate();
+      std::cout << " on " << _rdsom->get_nb_local_search() << " steps" << std::endl;
+    }
     // DEBUG write queue
     std::cout << str_queue() << std::endl;
      
@@ -1215,7 +1300,7 @@ int main(int argc, char *argv[])
       _v_err_rec.clear();
       _v_err_pred.clear();
       
-      step_test( *_rdsom, _data->begin(), _data->end() );
+      step_test( *_rdsom, *_test_src );
 
       //After iteration, save logs
       std::stringstream filename_logs;
@@ -1226,7 +1311,7 @@ int main(int argc, char *argv[])
       auto ofile = std::ofstream( filename_logs.str() );
 	 
       // Header comments
-      ofile << "## \"traj_name\" : \"" << *_opt_fileload_traj << "\"," << std::endl;
+      ofile << "## \"traj_name\" : \"" << _traj_name << "\"," << std::endl;
       ofile << "## \"rdsom_name\": \"" << *_opt_fileload_rdsom << "\"," << std::endl;
       ofile << "## \"typenet\": \"" << *_opt_typenet_str << "\"," << std::endl;
       // @todo: parameters
@@ -1263,7 +1348,7 @@ int main(int argc, char *argv[])
     // auto ofile = std::ofstream( filename_error.str() );
 	 
     // // Header comments
-    // ofile << "## \"traj_name\" : \"" << *_opt_fileload_traj << "\"," << std::endl;
+    // ofile << "## \"traj_name\" : \"" << _traj_name << "\"," << std::endl;
     // ofile << "## \"rdsom_name\": \"" << *_opt_fileload_rdsom << "\"," << std::endl;
     // // @todo: parameters
     // ofile << "## \"beta\"; \"" << _opt_beta << "\"," << std::endl;
@@ -1287,6 +1372,10 @@ int main(int argc, char *argv[])
     // }
     // ofile.close();
 
+    if( _opt_local_search ) {
+      std::cout << "  local search hit rate=" << _rdsom->get_local_hit_rate();
+      std::cout << " on " << _rdsom->get_nb_local_search() << " steps" << std::endl;
+    }
     // OFFSCREEN saving
     // And save a PNG image of the last _opt_queue_size neurons
     std::stringstream filename_png;
@@ -1295,6 +1384,8 @@ int main(int argc, char *argv[])
     save_figseq( filename_png.str(), "FigSeq", false );
     	 
   }
+  // pending PNG written, before GLFW is gone
+  Window::release_offscreen();
   return 0;
 }
 
@@ -0,0 +1,304 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * XP with a population of recurrent DSOM (no graphic).
+ *  - load Traj
+ *  - load a list of replica parameters (JSON)
+ *  - create replicas from their seed, or copy a loaded RDSOM (no seed
+ *    nor repeat then)
+ *  - learn all replicas on the same Traj, in parallel
+ *  - every period_save: test, save errors and checkpoint of each replica
+ *
+ * Replaces launching one xp-004-rdsom process per parameter/repeat.
+ * Param file: {"replicas": [ {"seed": 1, "typenet": "DSOM", "eps": 0.1,
+ *                             "repeat": 5}, ... ]}
+ */
+
+#include <iostream>                // std::cout
+#include <iomanip>                 // std::setw
+#include <fstream>                 // std::ofstream
+#include <string>                  // std::string
+#include <sstream>                 // std::stringdtream
+#include <rapidjson/document.h>    // rapidjson's DOM-style API
+#include <json_wrapper.hpp>        // JSON::IStreamWrapper
+
+#include <hmm_trajectory.hpp>
+#include <traj_source.hpp>         // Trajectory::open_hmm
+#include <dsom/r_network.hpp>
+#include <dsom/population.hpp>
+
+// Parsing command line options
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <utils.hpp>                  // various str_xxx
+using namespace utils::rj;
+
+// ******************************************************************** Global
+// Trajectory
+// read block by block (binary : mmap), never copied as a whole
+using Traj = Trajectory::HMMSource;
+std::unique_ptr<Traj>    _learn_src = nullptr;
+std::unique_ptr<Traj>    _test_src = nullptr;
+
+// Population of RDSOM
+using RDSOM = Model::DSOM::RNetwork;
+using Population = Model::DSOM::Population;
+std::unique_ptr<Population> _pop = nullptr;
+
+// ******************************************************************* Options
+std::unique_ptr<std::string> _opt_fileload_traj      = nullptr;
+std::unique_ptr<std::string> _opt_fileload_param     = nullptr;
+std::unique_ptr<std::string> _opt_fileload_rdsom     = nullptr;
+std::unique_ptr<std::string> _opt_filesave_result    = nullptr;
+int                          _opt_rdsom_size         = 10;
+unsigned int                 _opt_learn_length       = 100;
+unsigned int                 _opt_period_save        = 50;
+unsigned int                 _opt_nb_thread          = 1;
+bool                         _opt_checkpoint         = false;
+bool                         _opt_symbol_cache       = false;
+bool                         _opt_verb               = false;
+
+// ***************************************************************************
+// ******************************************************************* options
+// ***************************************************************************
+void setup_options(int argc, char **argv)
+{
+  po::options_description desc("Options");
+  desc.add_options()
+    ("help,h", "produce help message")
+    ("load_traj,t", po::value<std::string>(), "load Traj from filename")
+    ("load_param,p", po::value<std::string>(), "load replica parameters from filename")
+    ("load_rdsom,d", po::value<std::string>(), "all replicas copied from RDSOM in filename")
+    ("rdsom_size", po::value<int>(&_opt_rdsom_size)->default_value(_opt_rdsom_size),"rdsom size (if not loaded)")
+    ("save_result", po::value<std::string>(), "save RESULTS in filename_NNN")
+    ("learn_length", po::value<unsigned int>(&_opt_learn_length)->default_value(_opt_learn_length), "Learning Length")
+    ("period_save", po::value<unsigned int>(&_opt_period_save)->default_value(_opt_period_save), "Saving Period")
+    ("nb_thread", po::value<unsigned int>(&_opt_nb_thread)->default_value(_opt_nb_thread), "nb of threads")
+    ("checkpoint", "save every replica at every period")
+    ("symbol_cache", "cache input similarities and test steps of each input symbol")
+    ("verb,v", "verbose" )
+    ;
+
+  // Parse
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+
+    if (vm.count("help")) {
+      std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
+      std::cout << desc << std::endl;
+      exit(1);
+    }
+
+    po::notify(vm);
+  }
+  catch(po::error& e)  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    std::cerr << desc << std::endl;
+    exit(2);
+  }
+
+  if (vm.count("load_traj")) {
+    _opt_fileload_traj = make_unique<std::string>(vm["load_traj"].as< std::string>());
+  }
+  if (vm.count("load_param")) {
+    _opt_fileload_param = make_unique<std::string>(vm["load_param"].as< std::string>());
+  }
+  if (vm.count("load_rdsom")) {
+    _opt_fileload_rdsom = make_unique<std::string>(vm["load_rdsom"].as< std::string>());
+  }
+  if (vm.count("save_result")) {
+    _opt_filesave_result = make_unique<std::string>(vm["save_result"].as< std::string>());
+  }
+  if( vm.count("checkpoint") ) {
+    _opt_checkpoint = true;
+  }
+  if( vm.count("symbol_cache") ) {
+    _opt_symbol_cache = true;
+  }
+  if( vm.count("verb") ) {
+    _opt_verb = true;
+  }
+}
+// ***************************************************************************
+// ********************************************************************** Load
+// ***************************************************************************
+std::unique_ptr<Traj> open_traj( const std::string& filename )
+{
+  try {
+    return Trajectory::open_hmm( filename );
+  }
+  catch( std::runtime_error& e ) {
+    std::cout << "open_traj: " << e.what() << std::endl;
+    exit(1);
+  }
+}
+/**
+ * Next 'length' inputs of src in block (less at the end if not loop),
+ * from the start again at the end if loop.
+ */
+void read_block( Traj& src, unsigned int length, bool loop,
+                 std::vector<Eigen::VectorXd>& block )
+{
+  block.clear();
+  Traj::Item item;
+  for( unsigned int i = 0; i < length; ++i) {
+    if( not (loop ? src.next_loop( item ) : src.next( item )) ) break;
+    Eigen::VectorXd input(1);
+    input << (double) item.id_o;
+    block.push_back( input );
+  }
+}
+std::vector<Population::Param> load_param( const std::string& filename )
+{
+  auto pfile = std::ifstream( filename );
+  if( pfile.fail() ) {
+    std::cout << "load_param: NOT FOUND " << filename << std::endl;
+    exit(1);
+  }
+  // Wrapper pour lire document
+  JSON::IStreamWrapper instream(pfile);
+  // Parse into a document
+  rj::Document read_doc;
+  read_doc.ParseStream( instream );
+  pfile.close();
+
+  return Model::DSOM::unserialize_params( read_doc );
+}
+RDSOM load_rdsom( const std::string& filename )
+{
+  std::ifstream ifile( filename );
+  if( ifile.fail() ) {
+    std::cout << "load_rdsom: NOT FOUND " << filename << std::endl;
+    exit(1);
+  }
+  RDSOM net_read( ifile );
+  ifile.close();
+
+  return net_read;
+}
+void save_rdsom( const std::string& filename, RDSOM& rdsom )
+{
+  auto ofile = std::ofstream( filename );
+
+  rapidjson::Document doc;
+  rapidjson::Value obj = rdsom.serialize( doc );
+  ofile << str_obj( obj ) << std::endl;
+  ofile.close();
+}
+/** filename_NNN for replica idx */
+std::string replica_name( const std::string& filename, unsigned int idx )
+{
+  std::stringstream name;
+  name << filename << "_" << std::setw(3) << std::setfill('0') << idx;
+  return name.str();
+}
+// ***************************************************************************
+// ********************************************************************** main
+// ***************************************************************************
+int main(int argc, char *argv[])
+{
+  setup_options( argc, argv );
+  if( not _opt_fileload_traj or not _opt_fileload_param ) {
+    std::cerr << "ERROR: need --load_traj and --load_param" << std::endl;
+    exit(2);
+  }
+
+  // Traj_______________________
+  if( _opt_verb )
+    std::cout << "__OPEN Traj from " << *_opt_fileload_traj << std::endl;
+  _learn_src = open_traj( *_opt_fileload_traj );
+  _test_src = open_traj( *_opt_fileload_traj );
+
+  // Population _________________
+  auto params = load_param( *_opt_fileload_param );
+  if( _opt_fileload_rdsom ) {
+    try {
+      _pop = make_unique<Population>( params, load_rdsom( *_opt_fileload_rdsom ));
+    }
+    catch( std::runtime_error& e ) {
+      std::cout << "Population: " << e.what() << std::endl;
+      exit(1);
+    }
+  }
+  else {
+    _pop = make_unique<Population>( params, 1, _opt_rdsom_size, -1, 0.0, 1.0 );
+  }
+  for( unsigned int k = 0; k < _pop->size(); ++k) {
+    _pop->get_net( k ).set_symbol_cache( _opt_symbol_cache );
+  }
+  if( _opt_verb )
+    std::cout << _pop->str_dump() << std::endl;
+
+  // Error files, one per replica
+  std::vector<std::ofstream> v_ofile;
+  if( _opt_filesave_result ) {
+    for( unsigned int k = 0; k < _pop->size(); ++k) {
+      v_ofile.emplace_back( replica_name( *_opt_filesave_result, k )+"_errors" );
+      std::ofstream& ofile = v_ofile.back();
+      ofile << "## \"traj_name\" : \"" << *_opt_fileload_traj << "\"," << std::endl;
+      if( _opt_fileload_rdsom )
+        ofile << "## \"rdsom_name\": \"" << *_opt_fileload_rdsom << "\"," << std::endl;
+      ofile << "## \"param\": \"" << _pop->str_param( k ) << "\"," << std::endl;
+      ofile << "ite\terr_in\terr_rec\terr_pred\ttest_in\ttest_rec\ttest_pred" << std::endl;
+    }
+  }
+
+  // Learn_________________________
+  std::cout << "__LEARN " << _pop->size() << " replicas" << std::endl;
+  unsigned int ite = 0;
+  std::vector<Eigen::VectorXd> block;
+  while( ite < _opt_learn_length ) {
+    // next period of the trajectory, as a circular array
+    read_block( *_learn_src, _opt_period_save, true, block );
+    if( block.empty() ) {
+      std::cerr << "ERROR: empty Traj " << *_opt_fileload_traj << std::endl;
+      exit(1);
+    }
+    _pop->reset_errors();
+    _pop->run( block, true /* learning */, _opt_nb_thread );
+    ite += _opt_period_save;
+
+    // Test copies of every replica on all data, block by block
+    _pop->start_test();
+    _test_src->rewind();
+    for( read_block( *_test_src, _opt_period_save, false, block );
+         not block.empty();
+         read_block( *_test_src, _opt_period_save, false, block )) {
+      _pop->test_block( block, _opt_nb_thread );
+    }
+    auto test = _pop->get_test_errors();
+    std::cout << "  IT=" << ite << ", saving..." << std::endl;
+
+    for( unsigned int k = 0; k < _pop->size(); ++k) {
+      auto err = _pop->get_mean_errors( k );
+      if( _opt_verb ) {
+        std::cout << "    [" << k << "] err_in=" << err.input;
+        std::cout << " err_rec=" << err.rec << " err_pred=" << err.pred << std::endl;
+      }
+      if( _opt_filesave_result ) {
+        v_ofile[k] << ite << "\t" << err.input << "\t" << err.rec << "\t" << err.pred;
+        v_ofile[k] << "\t" << test[k].input / test[k].nb;
+        v_ofile[k] << "\t" << test[k].rec / test[k].nb;
+        v_ofile[k] << "\t" << test[k].pred / test[k].nb << std::endl;
+        if( _opt_checkpoint ) {
+          std::stringstream f_rdsomsave;
+          f_rdsomsave << replica_name( *_opt_filesave_result, k );
+          f_rdsomsave << "_rdsom_" << ite;
+          save_rdsom( f_rdsomsave.str(), _pop->get_net( k ) );
+        }
+      }
+    }
+  }
+
+  // Final networks
+  if( _opt_filesave_result ) {
+    for( unsigned int k = 0; k < _pop->size(); ++k) {
+      v_ofile[k].close();
+      save_rdsom( replica_name( *_opt_filesave_result, k )+"_rdsom", _pop->get_net( k ) );
+    }
+  }
+
+  return 0;
+}